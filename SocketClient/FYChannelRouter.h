@@ -0,0 +1,156 @@
+//
+//  FYChannelRouter.h
+//  SocketClient
+//
+//  Created by agent on 17.10.26.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+/** @refs
+//  [27] http://svn.cometd.com/trunk/bayeux/bayeux.html#toc_27
+*/
+
+#import <Foundation/Foundation.h>
+
+
+/**
+ Callback to enumerate matches of a concrete channel in an <FYChannelRouter>.
+ */
+typedef void(^FYChannelRouterMatchBlock)(NSString *pattern, id object);
+
+
+/**
+ Routes messages of concrete channels to the objects registered for channel names and channel patterns.
+ 
+ Registered channels are kept in a segment trie, whose edges are labeled by interned segments. A concrete channel
+ like ```/prices/eur/usd``` is resolved by one single walk along its segments, which collects on its way the exact
+ match and all [wildcard matches][27]:
+ 
+ - ```/prices/eur/usd```  matches exactly
+ - ```/prices/eur/⁠*```    matches exactly one further segment
+ - ```/prices/⁠**```       matches one or more further segments
+ 
+ The cost of a lookup is proportional to the count of segments of the concrete channel and does not grow with the
+ count of registered channels.
+ 
+ The router is persistent: snapshot returns an immutable version, which shares all nodes with the router, and later
+ writes copy only the nodes along their path. The router itself is not thread-safe, but its snapshots can be read
+ concurrently. FYClient publishes a snapshot after each write.
+ */
+// Used \U+2060 to silent warning "'/*' within block comment" on '/⁠*' by Xcode.
+@interface FYChannelRouter : NSObject <NSCopying>
+
+/**
+ Count of registered channel names and channel patterns.
+ */
+@property (nonatomic, assign, readonly) NSUInteger count;
+
+/**
+ All registered channel names and channel patterns.
+ */
+@property (nonatomic, copy, readonly) NSArray *allChannels;
+
+/**
+ Get an immutable snapshot of the current registrations in constant time.
+ 
+ The snapshot shares all nodes with the receiver. Further writes to the receiver copy the nodes along the path of the
+ written channel, before they are changed, so the snapshot is never affected. Copies made by NSCopying are mutable.
+ */
+- (FYChannelRouter *)snapshot;
+
+/**
+ Whether the receiver is an immutable snapshot, which must not be written.
+ */
+- (BOOL)isSnapshot;
+
+/**
+ Get the object registered for exactly the given channel name or channel pattern.
+ 
+ @param channel  A channel name or a channel pattern.
+ */
+- (id)objectForChannel:(NSString *)channel;
+
+/**
+ Register an object for a channel name or a channel pattern. An existing registration will be replaced.
+ 
+ @param object   The object to register, must not be nil.
+ 
+ @param channel  A channel name or a channel pattern. Wildcards ```*``` and ```**``` are only allowed as last segment.
+ */
+- (void)setObject:(id)object forChannel:(NSString *)channel;
+
+/**
+ Remove the registration of a channel name or a channel pattern.
+ 
+ @param channel  A channel name or a channel pattern.
+ */
+- (void)removeObjectForChannel:(NSString *)channel;
+
+/**
+ Remove the registrations of multiple channel names or channel patterns.
+ 
+ @param channels  An array of channel names and channel patterns.
+ */
+- (void)removeObjectsForChannels:(NSArray *)channels;
+
+/**
+ Remove all registrations.
+ */
+- (void)removeAllObjects;
+
+/**
+ Enumerate all objects whose channel name or channel pattern matches a concrete channel.
+ 
+ @param channel  A concrete channel without wildcards, e.g. the channel of a received message.
+ 
+ @param block    Called once for each match with the matching registered channel and its object.
+ 
+ @return Whether there was atleast one match.
+ */
+- (BOOL)enumerateObjectsMatchingChannel:(NSString *)channel usingBlock:(FYChannelRouterMatchBlock)block;
+
+/**
+ Check whether any channel name or channel pattern matches a concrete channel.
+ 
+ @param channel  A concrete channel without wildcards, e.g. the channel of a received message.
+ */
+- (BOOL)hasObjectsMatchingChannel:(NSString *)channel;
+
+/**
+ Enumerate all registrations.
+ 
+ @param block  Called once for each registered channel name or channel pattern with its object.
+ */
+- (void)enumerateChannelsAndObjectsUsingBlock:(void(^)(NSString *channel, id object, BOOL *stop))block;
+
+/**
+ Support for subscripting syntax. Same as objectForChannel:.
+ */
+- (id)objectForKeyedSubscript:(NSString *)channel;
+
+/**
+ Support for subscripting syntax. Same as setObject:forChannel:, but a nil object removes the registration.
+ */
+- (void)setObject:(id)object forKeyedSubscript:(NSString *)channel;
+
+@end
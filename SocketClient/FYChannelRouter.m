@@ -0,0 +1,509 @@
+//
+//  FYChannelRouter.m
+//  SocketClient
+//
+//  Created by agent on 17.10.26.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import <stdatomic.h>
+#import "FYChannelRouter.h"
+
+
+static NSString *const FYChannelRouterWildcard = @"*";
+static NSString *const FYChannelRouterGlobbing = @"**";
+
+/*
+ Source of edit generations. A router mutates only nodes of its own generation in place. All other nodes may be shared
+ with snapshots or copies, so they are copied on write.
+ */
+static atomic_uint_fast64_t FYChannelRouterLastGeneration = 0;
+
+static inline uint64_t FYChannelRouterNextGeneration(void) {
+    return atomic_fetch_add_explicit(&FYChannelRouterLastGeneration, 1, memory_order_relaxed) + 1;
+}
+
+
+/*
+ A node of the segment trie. Its children are keyed by interned segments. Wildcard and globbing patterns can only be
+ used as last segment of a channel pattern, so they don't need child nodes and are stored as slots of their parent.
+ */
+@interface FYChannelRouterNode : NSObject {
+  @package
+    CFMutableDictionaryRef _children;
+    NSString *_channel;
+    id _object;
+    id _wildcardObject;
+    id _globbingObject;
+    uint64_t _generation;
+}
+
+- (id)initWithChannel:(NSString *)channel generation:(uint64_t)generation;
+- (FYChannelRouterNode *)copyWithGeneration:(uint64_t)generation;
+- (FYChannelRouterNode *)childForSegment:(NSString *)segment;
+- (void)setChild:(FYChannelRouterNode *)child forSegment:(NSString *)segment;
+- (void)removeChildForSegment:(NSString *)segment;
+- (BOOL)isEmpty;
+
+@end
+
+
+@implementation FYChannelRouterNode
+
+- (id)initWithChannel:(NSString *)channel generation:(uint64_t)generation {
+    self = [super init];
+    if (self) {
+        _channel    = channel;
+        _generation = generation;
+    }
+    return self;
+}
+
+- (void)dealloc {
+    if (_children) {
+        CFRelease(_children);
+    }
+}
+
+- (FYChannelRouterNode *)copyWithGeneration:(uint64_t)generation {
+    // Shallow copy: children are shared until they are written themselves.
+    FYChannelRouterNode *copy = [[FYChannelRouterNode alloc] initWithChannel:_channel generation:generation];
+    if (_children) {
+        copy->_children = CFDictionaryCreateMutableCopy(NULL, 0, _children);
+    }
+    copy->_object         = _object;
+    copy->_wildcardObject = _wildcardObject;
+    copy->_globbingObject = _globbingObject;
+    return copy;
+}
+
+- (FYChannelRouterNode *)childForSegment:(NSString *)segment {
+    if (!_children) {
+        return nil;
+    }
+    return (__bridge FYChannelRouterNode *)CFDictionaryGetValue(_children, (__bridge CFStringRef)segment);
+}
+
+- (void)setChild:(FYChannelRouterNode *)child forSegment:(NSString *)segment {
+    if (!_children) {
+        _children = CFDictionaryCreateMutable(NULL, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+    }
+    CFDictionarySetValue(_children, (__bridge CFStringRef)segment, (__bridge const void *)child);
+}
+
+- (void)removeChildForSegment:(NSString *)segment {
+    if (_children) {
+        CFDictionaryRemoveValue(_children, (__bridge CFStringRef)segment);
+    }
+}
+
+- (BOOL)isEmpty {
+    return !_object && !_wildcardObject && !_globbingObject && (!_children || CFDictionaryGetCount(_children) == 0);
+}
+
+@end
+
+
+
+@interface FYChannelRouter () {
+    // Nodes of this generation are owned by the receiver and may be mutated in place
+    uint64_t _generation;
+    
+    // Interned segments with the count of edges, which are labeled by them. Snapshots have none, they are never written.
+    CFMutableDictionaryRef _segmentCounts;
+}
+
+@property (nonatomic, assign, readwrite) NSUInteger count;
+@property (nonatomic, retain) FYChannelRouterNode *root;
+
+// Initializer for snapshots
+- (id)initWithRoot:(FYChannelRouterNode *)root count:(NSUInteger)count;
+
+// Trie helper
+- (NSArray *)segmentsOfChannel:(NSString *)channel;
+- (FYChannelRouterNode *)ownedRoot;
+- (FYChannelRouterNode *)ownedChildOfNode:(FYChannelRouterNode *)node segment:(NSString *)segment create:(BOOL)create;
+- (NSString *)internSegment:(NSString *)segment;
+- (void)releaseSegment:(NSString *)segment;
+- (void)countSegmentsOfNode:(FYChannelRouterNode *)node;
+- (NSUInteger)internedSegmentCount;
+
+@end
+
+
+@implementation FYChannelRouter
+
+- (id)init {
+    self = [super init];
+    if (self) {
+        _generation    = FYChannelRouterNextGeneration();
+        _segmentCounts = CFDictionaryCreateMutable(NULL, 0, &kCFTypeDictionaryKeyCallBacks, NULL);
+        self.root      = [[FYChannelRouterNode alloc] initWithChannel:@"" generation:_generation];
+    }
+    return self;
+}
+
+- (id)initWithRoot:(FYChannelRouterNode *)root count:(NSUInteger)count {
+    self = [super init];
+    if (self) {
+        // Generation 0 is never handed out, so no node is ever owned by a snapshot.
+        _generation = 0;
+        self.root   = root;
+        self.count  = count;
+    }
+    return self;
+}
+
+- (void)dealloc {
+    if (_segmentCounts) {
+        CFRelease(_segmentCounts);
+    }
+}
+
+- (id)copyWithZone:(NSZone *)zone {
+    FYChannelRouter *copy = [[self.class allocWithZone:zone] init];
+    copy.root  = self.root;
+    copy.count = self.count;
+    if (self.isSnapshot) {
+        [copy countSegmentsOfNode:self.root];
+    } else {
+        CFRelease(copy->_segmentCounts);
+        copy->_segmentCounts = CFDictionaryCreateMutableCopy(NULL, 0, _segmentCounts);
+        
+        // All nodes are shared from now on
+        _generation = FYChannelRouterNextGeneration();
+    }
+    return copy;
+}
+
+- (FYChannelRouter *)snapshot {
+    if (self.isSnapshot) {
+        return self;
+    }
+    FYChannelRouter *snapshot = [[self.class alloc] initWithRoot:self.root count:self.count];
+    
+    // All nodes are shared from now on
+    _generation = FYChannelRouterNextGeneration();
+    return snapshot;
+}
+
+- (BOOL)isSnapshot {
+    return _segmentCounts == NULL;
+}
+
+- (NSString *)description {
+    NSMutableDictionary *objects = [[NSMutableDictionary alloc] initWithCapacity:self.count];
+    [self enumerateChannelsAndObjectsUsingBlock:^(NSString *channel, id object, BOOL *stop) {
+        objects[channel] = object;
+     }];
+    return [NSString stringWithFormat:@"<%@: %p> %@", self.class, self, objects];
+}
+
+
+#pragma mark - Registration
+
+- (NSArray *)allChannels {
+    NSMutableArray *channels = [[NSMutableArray alloc] initWithCapacity:self.count];
+    [self enumerateChannelsAndObjectsUsingBlock:^(NSString *channel, id object, BOOL *stop) {
+        [channels addObject:channel];
+     }];
+    return channels;
+}
+
+- (id)objectForChannel:(NSString *)channel {
+    NSArray *segments = [self segmentsOfChannel:channel];
+    NSString *lastSegment = segments.lastObject;
+    BOOL isWildcard = [lastSegment isEqualToString:FYChannelRouterWildcard];
+    BOOL isGlobbing = [lastSegment isEqualToString:FYChannelRouterGlobbing];
+    NSUInteger depth = isWildcard || isGlobbing ? segments.count - 1 : segments.count;
+    
+    FYChannelRouterNode *node = self.root;
+    for (NSUInteger i=0; node && i<depth; i++) {
+        node = [node childForSegment:segments[i]];
+    }
+    if (!node) {
+        return nil;
+    }
+    return isWildcard ? node->_wildcardObject : isGlobbing ? node->_globbingObject : node->_object;
+}
+
+- (void)setObject:(id)object forChannel:(NSString *)channel {
+    NSParameterAssert(object);
+    NSParameterAssert(channel);
+    NSAssert(!self.isSnapshot, @"Snapshots must not be mutated.");
+    
+    NSArray *segments = [self segmentsOfChannel:channel];
+    NSUInteger count = segments.count;
+    NSAssert(count > 0, @"A valid channel or channel pattern needs atleast one segment.");
+    
+    // Only the nodes along the path are copied, if they are shared.
+    FYChannelRouterNode *node = self.ownedRoot;
+    for (NSUInteger i=0; i<count-1; i++) {
+        NSString *segment = segments[i];
+        NSAssert(![segment isEqualToString:FYChannelRouterWildcard] && ![segment isEqualToString:FYChannelRouterGlobbing],
+                 @"Wildcards are only allowed as last segment of a channel pattern, but got '%@'.", channel);
+        node = [self ownedChildOfNode:node segment:segment create:YES];
+    }
+    
+    NSString *lastSegment = segments.lastObject;
+    BOOL added;
+    if ([lastSegment isEqualToString:FYChannelRouterWildcard]) {
+        added = !node->_wildcardObject;
+        node->_wildcardObject = object;
+    } else if ([lastSegment isEqualToString:FYChannelRouterGlobbing]) {
+        added = !node->_globbingObject;
+        node->_globbingObject = object;
+    } else {
+        node = [self ownedChildOfNode:node segment:lastSegment create:YES];
+        added = !node->_object;
+        node->_object = object;
+    }
+    
+    if (added) {
+        self.count++;
+    }
+}
+
+- (void)removeObjectForChannel:(NSString *)channel {
+    NSAssert(!self.isSnapshot, @"Snapshots must not be mutated.");
+    if (![self objectForChannel:channel]) {
+        return;
+    }
+    
+    NSArray *segments = [self segmentsOfChannel:channel];
+    NSString *lastSegment = segments.lastObject;
+    BOOL isWildcard = [lastSegment isEqualToString:FYChannelRouterWildcard];
+    BOOL isGlobbing = [lastSegment isEqualToString:FYChannelRouterGlobbing];
+    NSUInteger depth = isWildcard || isGlobbing ? segments.count - 1 : segments.count;
+    
+    // Walk down and remember the path to prune empty nodes afterwards. The path exists, because the channel is
+    // registered.
+    NSMutableArray *path = [[NSMutableArray alloc] initWithCapacity:depth + 1];
+    FYChannelRouterNode *node = self.ownedRoot;
+    [path addObject:node];
+    for (NSUInteger i=0; i<depth; i++) {
+        node = [self ownedChildOfNode:node segment:segments[i] create:NO];
+        [path addObject:node];
+    }
+    
+    if (isWildcard) {
+        node->_wildcardObject = nil;
+    } else if (isGlobbing) {
+        node->_globbingObject = nil;
+    } else {
+        node->_object = nil;
+    }
+    self.count--;
+    
+    // Prune empty nodes bottom-up, but never the root.
+    for (NSUInteger i=depth; i>0; i--) {
+        FYChannelRouterNode *child = path[i];
+        if (!child.isEmpty) {
+            break;
+        }
+        [path[i-1] removeChildForSegment:segments[i-1]];
+        [self releaseSegment:segments[i-1]];
+    }
+}
+
+- (void)removeObjectsForChannels:(NSArray *)channels {
+    for (NSString *channel in channels) {
+        [self removeObjectForChannel:channel];
+    }
+}
+
+- (void)removeAllObjects {
+    NSAssert(!self.isSnapshot, @"Snapshots must not be mutated.");
+    CFDictionaryRemoveAllValues(_segmentCounts);
+    self.root = [[FYChannelRouterNode alloc] initWithChannel:@"" generation:_generation];
+    self.count = 0;
+}
+
+
+#pragma mark - Lookup
+
+- (BOOL)enumerateObjectsMatchingChannel:(NSString *)channel usingBlock:(FYChannelRouterMatchBlock)block {
+    NSArray *segments = [self segmentsOfChannel:channel];
+    NSUInteger count = segments.count;
+    BOOL matched = NO;
+    
+    FYChannelRouterNode *node = self.root;
+    for (NSUInteger i=0; node && i<=count; i++) {
+        if (i < count && node->_globbingObject) {
+            if (!block) {
+                return YES;
+            }
+            block([node->_channel stringByAppendingString:@"/**"], node->_globbingObject);
+            matched = YES;
+        }
+        
+        if (i+1 == count && node->_wildcardObject) {
+            if (!block) {
+                return YES;
+            }
+            block([node->_channel stringByAppendingString:@"/*"], node->_wildcardObject);
+            matched = YES;
+        }
+        
+        if (i == count) {
+            if (node->_object) {
+                if (block) {
+                    block(channel, node->_object);
+                }
+                matched = YES;
+            }
+            break;
+        }
+        
+        node = [node childForSegment:segments[i]];
+    }
+    
+    return matched;
+}
+
+- (BOOL)hasObjectsMatchingChannel:(NSString *)channel {
+    return [self enumerateObjectsMatchingChannel:channel usingBlock:nil];
+}
+
+- (void)enumerateChannelsAndObjectsUsingBlock:(void(^)(NSString *channel, id object, BOOL *stop))block {
+    // Enumerate the current nodes as if they were a snapshot, so the block may mutate the receiver.
+    if (!self.isSnapshot) {
+        _generation = FYChannelRouterNextGeneration();
+    }
+    
+    NSMutableArray *stack = [NSMutableArray arrayWithObject:self.root];
+    BOOL stop = NO;
+    while (!stop && stack.count > 0) {
+        FYChannelRouterNode *node = stack.lastObject;
+        [stack removeLastObject];
+        
+        if (node->_object) {
+            block(node->_channel, node->_object, &stop);
+        }
+        if (!stop && node->_wildcardObject) {
+            block([node->_channel stringByAppendingString:@"/*"], node->_wildcardObject, &stop);
+        }
+        if (!stop && node->_globbingObject) {
+            block([node->_channel stringByAppendingString:@"/**"], node->_globbingObject, &stop);
+        }
+        if (node->_children) {
+            [stack addObjectsFromArray:[(__bridge NSDictionary *)node->_children allValues]];
+        }
+    }
+}
+
+
+#pragma mark - Subscripting
+
+- (id)objectForKeyedSubscript:(NSString *)channel {
+    return [self objectForChannel:channel];
+}
+
+- (void)setObject:(id)object forKeyedSubscript:(NSString *)channel {
+    if (object) {
+        [self setObject:object forChannel:channel];
+    } else {
+        [self removeObjectForChannel:channel];
+    }
+}
+
+
+#pragma mark - Trie helper
+
+- (NSArray *)segmentsOfChannel:(NSString *)channel {
+    NSArray *components = [channel componentsSeparatedByString:@"/"];
+    // A valid channel begins with a slash, so the first component is always empty.
+    return [components subarrayWithRange:NSMakeRange(1, components.count - 1)];
+}
+
+- (FYChannelRouterNode *)ownedRoot {
+    if (self.root->_generation != _generation) {
+        self.root = [self.root copyWithGeneration:_generation];
+    }
+    return self.root;
+}
+
+- (FYChannelRouterNode *)ownedChildOfNode:(FYChannelRouterNode *)node segment:(NSString *)segment create:(BOOL)create {
+    // The given node has to be owned already, so a copied child can be linked into it.
+    FYChannelRouterNode *child = [node childForSegment:segment];
+    if (!child) {
+        if (!create) {
+            return nil;
+        }
+        NSString *interned = [self internSegment:segment];
+        NSString *channel = [NSString stringWithFormat:@"%@/%@", node->_channel, interned];
+        child = [[FYChannelRouterNode alloc] initWithChannel:channel generation:_generation];
+        [node setChild:child forSegment:interned];
+    } else if (child->_generation != _generation) {
+        child = [child copyWithGeneration:_generation];
+        CFDictionaryReplaceValue(node->_children, (__bridge CFStringRef)segment, (__bridge const void *)child);
+    }
+    return child;
+}
+
+- (NSString *)internSegment:(NSString *)segment {
+    const void *interned = NULL;
+    uintptr_t count = 0;
+    NSString *copy = nil;
+    if (CFDictionaryGetKeyIfPresent(_segmentCounts, (__bridge CFStringRef)segment, &interned)) {
+        count = (uintptr_t)CFDictionaryGetValue(_segmentCounts, interned);
+    } else {
+        copy = [segment copy];
+        interned = (__bridge const void *)copy;
+    }
+    CFDictionarySetValue(_segmentCounts, interned, (const void *)(count + 1));
+    return (__bridge NSString *)interned;
+}
+
+- (void)releaseSegment:(NSString *)segment {
+    // Segments are released with the last edge labeled by them, so churn of channels doesn't grow the table.
+    uintptr_t count = (uintptr_t)CFDictionaryGetValue(_segmentCounts, (__bridge CFStringRef)segment);
+    if (count > 1) {
+        CFDictionarySetValue(_segmentCounts, (__bridge CFStringRef)segment, (const void *)(count - 1));
+    } else {
+        CFDictionaryRemoveValue(_segmentCounts, (__bridge CFStringRef)segment);
+    }
+}
+
+- (void)countSegmentsOfNode:(FYChannelRouterNode *)node {
+    if (!node->_children) {
+        return;
+    }
+    CFIndex count = CFDictionaryGetCount(node->_children);
+    const void **segments = malloc(count * sizeof(void *));
+    const void **children = malloc(count * sizeof(void *));
+    CFDictionaryGetKeysAndValues(node->_children, segments, children);
+    for (CFIndex i=0; i<count; i++) {
+        [self internSegment:(__bridge NSString *)segments[i]];
+        [self countSegmentsOfNode:(__bridge FYChannelRouterNode *)children[i]];
+    }
+    free(segments);
+    free(children);
+}
+
+- (NSUInteger)internedSegmentCount {
+    return _segmentCounts ? (NSUInteger)CFDictionaryGetCount(_segmentCounts) : 0;
+}
+
+@end
@@ -34,6 +34,10 @@
 #import "FYClientDelegate.h"
 #import "FYError.h"
 #import "FYMessage.h"
+#import "FYMetrics.h"
+#import "FYOfflineQueue.h"
+#import "FYReconnectPolicy.h"
+#import "FYSubscriptionOptions.h"
 #import "SRWebSocket.h"
 
 
@@ -52,13 +56,23 @@ const struct FYMetaChannels {
  Relevant Bayeux connection types
  */
 const struct FYConnectionTypes {
-    __unsafe_unretained NSString *LongPolling;      // Fallback - should be implemented, is actually not
+    __unsafe_unretained NSString *LongPolling;      // Fallback - implemented
     __unsafe_unretained NSString *CallbackPolling;  // Not implemented
     __unsafe_unretained NSString *WebSocket;        // Implemented
 } FYConnectionTypes;
 
 extern NSArray *FYSupportedConnectionTypes();
 
+/**
+ Encodings of messages on the web socket connection
+ */
+const struct FYPayloadEncodings {
+    __unsafe_unretained NSString *JSON;             // Text frames - always supported
+    __unsafe_unretained NSString *MessagePack;      // Binary frames - agreed by the handshake
+} FYPayloadEncodings;
+
+extern NSArray *FYSupportedPayloadEncodings();
+
 /**
  Default reconnect interval on `message.attempt.reconnect = retry` if no "interval" attempt was given by the server.
  */
@@ -70,6 +84,47 @@ extern const NSTimeInterval FYClientRetryTimeInterval;
  */
 extern const NSTimeInterval FYClientReconnectTimeInterval;
 
+/**
+ Default time interval, which outgoing messages are held back to be coalesced with further messages into one frame.
+ */
+extern const NSTimeInterval FYClientBatchTimeInterval;
+
+/**
+ Default maximum count of messages, which are coalesced into one frame.
+ */
+extern const NSUInteger FYClientMaximumBatchMessageCount;
+
+/**
+ Default maximum size in bytes of serialized messages, which are coalesced into one frame.
+ */
+extern const NSUInteger FYClientMaximumBatchSize;
+
+/**
+ Default time interval, after which a publish, which was not acknowledged by the server, is failed.
+ */
+extern const NSTimeInterval FYClientPublishTimeInterval;
+
+/**
+ Default maximum count of publishes, which are sent but not yet acknowledged by the server.
+ */
+extern const NSUInteger FYClientMaximumUnacknowledgedPublishCount;
+
+/**
+ Default maximum count of publishes, which are held back while the client is connecting or reconnecting.
+ */
+extern const NSUInteger FYClientMaximumOfflinePublishCount;
+
+/**
+ Default maximum size in bytes of serialized publishes, which are held back while the client is connecting or
+ reconnecting.
+ */
+extern const NSUInteger FYClientMaximumOfflinePublishSize;
+
+/**
+ Time interval, which is added to the advised timeout of the server to get the timeout of a long-polling request.
+ */
+extern const NSTimeInterval FYClientLongPollingTimeoutMargin;
+
 /**
  Callback for successful connection.
  */
@@ -80,6 +135,22 @@ typedef void(^FYClientConnectSuccessBlock)(FYClient *);
  */
 typedef void(^FYMessageCallback)(NSDictionary *userInfo);
 
+/**
+ Callback for user-defined channel subscriptions, which receives the payloads of several messages at once in the order
+ they were received.
+ */
+typedef void(^FYMessageBatchCallback)(NSArray *userInfos);
+
+/**
+ Callback for the acknowledgement of a publish. The error is nil, if the server acknowledged it as successful.
+ */
+typedef void(^FYPublishCompletionBlock)(NSError *error);
+
+/**
+ Callback for periodic reports of the metrics of a client.
+ */
+typedef void(^FYClientMetricsHandler)(FYClientMetrics *metrics);
+
 
 /**
  The FYClient object is used to setup and manage requests to servers using the Bayeux protocol.
@@ -123,6 +194,23 @@ typedef void(^FYMessageCallback)(NSDictionary *userInfo);
  */
 @property (nonatomic, assign) BOOL awaitOnlyHandshake;
 
+/**
+ Connection types, which the client may use, in the order of preference. Must be a subset of
+ FYSupportedConnectionTypes(). If FYConnectionTypes.WebSocket is not included, no web socket connection is opened.
+ 
+ Default is FYSupportedConnectionTypes().
+ */
+@property (nonatomic, copy) NSArray *connectionTypes;
+
+/**
+ Connection type, which was chosen on handshake for the current session.
+ 
+ If the server supports several of the allowed connectionTypes, the one with the lower measured latency is chosen. A web
+ socket connection is preferred, as long as it is not known to be slower. If a web socket connection can't be opened,
+ the client falls back to long-polling.
+ */
+@property (nonatomic, retain, readonly) NSString *connectionType;
+
 /**
  Check if client is connected
  */
@@ -145,11 +233,189 @@ typedef void(^FYMessageCallback)(NSDictionary *userInfo);
 @property (nonatomic, assign) NSTimeInterval retryTimeInterval;
 
 /**
- Reconnect interval on web socket connection lost. This time is waited by default until a new connect try occurs.
- A negative value will disable all reconnect tries when connection was lost.
+ Reconnect interval on web socket connection lost. This time is waited until a new connect try occurs, if no
+ reconnectPolicy is set. A negative value will disable all reconnect tries when connection was lost.
  */
 @property (nonatomic, assign) NSTimeInterval reconnectTimeInterval;
 
+/**
+ Policy, which decides how long to wait before a new connect try occurs, when the connection was lost.
+ 
+ Default is an <FYBackoffReconnectPolicy> bounded by 1 second and FYClientReconnectTimeInterval, so that clients don't
+ reconnect all at the same instant, when a server was restarted. Set to nil to wait always reconnectTimeInterval.
+ */
+@property (nonatomic, retain) id<FYReconnectPolicy> reconnectPolicy;
+
+/**
+ Estimated offset in seconds, which has to be added to the local clock to get the server's clock.
+ 
+ The offset is estimated from the round trips, which the server answers without holding them: the handshake and the
+ first /meta/connect of each session, which asks the server by `advice` not to hold it. Only responses, which were
+ stamped by the server with a `timestamp`, are taken. Is 0 until such a response was received.
+ 
+ Must not be called on the client's internal queues, e.g. not from an actor.
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval serverClockOffset;
+
+/**
+ Estimated one-way latency in seconds to the server, taken from the shortest recent round trip, which the server
+ didn't hold, see serverClockOffset.
+ 
+ Is 0 until a response to a handshake was received.
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval latency;
+
+/**
+ Time interval, which outgoing messages are held back to be coalesced with further messages into one web socket frame.
+ 
+ The Bayeux protocol allows to send an array of messages in one frame. Messages which are sent within this interval are
+ serialized into one frame, which saves frames, syscalls and masking passes of the web socket implementation under
+ bursty publishing. A value of 0 will coalesce only the messages, which were sent while the previous frame was built,
+ and adds no further latency.
+ 
+ Default is FYClientBatchTimeInterval.
+ */
+@property (nonatomic, assign) NSTimeInterval batchTimeInterval;
+
+/**
+ Maximum count of messages, which are coalesced into one frame. If it is reached, the frame is sent immediately.
+ 
+ Default is FYClientMaximumBatchMessageCount.
+ */
+@property (nonatomic, assign) NSUInteger maximumBatchMessageCount;
+
+/**
+ Maximum size in bytes of serialized messages, which are coalesced into one frame. If it is reached, the frame is sent
+ immediately.
+ 
+ Default is FYClientMaximumBatchSize.
+ */
+@property (nonatomic, assign) NSUInteger maximumBatchSize;
+
+/**
+ Time interval, after which a publish, which was not acknowledged by the server, is failed with an error of code
+ FYErrorPublishTimedOut. A value lower or equal to zero disables the timeout.
+ 
+ Default is FYClientPublishTimeInterval.
+ */
+@property (nonatomic, assign) NSTimeInterval publishTimeInterval;
+
+/**
+ Maximum count of publishes, which are sent but not yet acknowledged by the server.
+ 
+ Further publishes are held back in order until the acknowledgement of a prior publish was received or timed out. This
+ allows to pipeline publishes without overrunning the server. A value of 0 doesn't limit the count.
+ 
+ Default is FYClientMaximumUnacknowledgedPublishCount.
+ */
+@property (nonatomic, assign) NSUInteger maximumUnacknowledgedPublishCount;
+
+/**
+ Maximum count of publishes, which are held back while the client is connecting or reconnecting. A value of 0 doesn't
+ limit the count.
+ 
+ Publishes, which are sent while the socket connection is not open, are held back in order and are sent as soon as the
+ Bayeux session is established again. Publishes of an explicitly disconnected client are failed instead.
+ 
+ Default is FYClientMaximumOfflinePublishCount.
+ */
+@property (nonatomic, assign) NSUInteger maximumOfflinePublishCount;
+
+/**
+ Maximum size in bytes of serialized publishes, which are held back while the client is connecting or reconnecting.
+ A value of 0 doesn't limit the size.
+ 
+ Default is FYClientMaximumOfflinePublishSize.
+ */
+@property (nonatomic, assign) NSUInteger maximumOfflinePublishSize;
+
+/**
+ Policy, which decides which publishes are dropped, when the held back publishes would exceed their limits. Dropped
+ publishes are completed with an error of code FYErrorPublishDropped.
+ 
+ Default is FYOfflineQueueOverflowPolicyDropOldest.
+ */
+@property (nonatomic, assign) FYOfflineQueueOverflowPolicy offlinePublishOverflowPolicy;
+
+/**
+ Smoothed time interval in seconds between sending a publish and receiving its acknowledgement.
+ 
+ Is 0 until the first publish was acknowledged.
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval publishLatency;
+
+/**
+ Time interval, which payloads for batch callbacks are collected, before they are delivered. A value of 0 delivers
+ the payloads of each received frame at once.
+ 
+ Default is 0.
+ */
+@property (nonatomic, assign) NSTimeInterval batchDeliveryTimeInterval;
+
+/**
+ Flag for delivery of received messages to callbacks.
+ 
+ If property's value is YES, all callbacks for the messages of a received frame are executed in one dispatch on the
+ callbackQueue, instead of one dispatch per message. This saves the scheduling cost per message under high message
+ rates, but delays the first callback until the whole frame was decoded.
+ 
+ Default is NO.
+ */
+@property (nonatomic, assign) BOOL deliversFramesInSingleDispatch;
+
+/**
+ Encodings of messages on the web socket connection, which the client offers to the server in the `ext` of the
+ handshake, in the order of preference. Must be a subset of FYSupportedPayloadEncodings().
+ 
+ FYPayloadEncodings.MessagePack is carried in binary frames and is much faster to encode and to decode and smaller on
+ the wire for numeric-heavy payloads. It requires the matching extension of the server, see Server/faye_msgpack.coffee.
+ If the server doesn't agree to any offered encoding, the client falls back to JSON. Changes take effect on the next
+ handshake.
+ 
+ Default is only FYPayloadEncodings.JSON.
+ */
+@property (nonatomic, copy) NSArray *payloadEncodings;
+
+/**
+ Encoding of messages, which was agreed with the server on handshake for the current session.
+ 
+ This is FYPayloadEncodings.JSON, if the server didn't agree to any other offered encoding or if the connection type
+ is long-polling.
+ */
+@property (nonatomic, retain, readonly) NSString *payloadEncoding;
+
+/**
+ Snapshot of the metrics of the client, which were counted since its initialization.
+ 
+ Metrics are always recorded by atomic counters, so taking a snapshot is cheap and can be done on any thread.
+ */
+@property (nonatomic, retain, readonly) FYClientMetrics *metrics;
+
+/**
+ Handler, which is called periodically with a snapshot of the metrics on callbackQueue.
+ */
+@property (nonatomic, copy) FYClientMetricsHandler metricsHandler;
+
+/**
+ Time interval in which metricsHandler is called. A value of 0 disables periodic reports.
+ 
+ Default is 0.
+ */
+@property (nonatomic, assign) NSTimeInterval metricsReportingTimeInterval;
+
+/**
+ Fraction of received messages between 0 and 1, whose way from receipt of their frame to the end of their callback is
+ traced. Messages, which are delivered through batches or delivery queues, are traced until they were routed.
+ 
+ Default is 0, which disables tracing.
+ */
+@property (nonatomic, assign) double traceSamplingRate;
+
+/**
+ Latencies of traced messages as <FYMessageTraceReport> by channel.
+ */
+@property (nonatomic, copy, readonly) NSDictionary *traceReports;
+
 /**
  Delegate to handle state transitions and errors, should be set direct after initialization of an <FYClient>
  object.
@@ -166,6 +432,14 @@ typedef void(^FYMessageCallback)(NSDictionary *userInfo);
  */
 @property (nonatomic) dispatch_queue_t callbackQueue;
 
+/**
+ Concurrent dispatch queue, which is targeted by the serial lanes of subscriptions with a
+ [lane]([FYSubscriptionOptions lane]).
+ 
+ Default is the global dispatch queue of default priority.
+ */
+@property (nonatomic) dispatch_queue_t laneTargetQueue;
+
 /**
  All subscripted channels
  */
@@ -379,6 +653,21 @@ typedef void(^FYMessageCallback)(NSDictionary *userInfo);
  */
 - (void)subscribeChannel:(NSString *)channel callback:(FYMessageCallback)callback extension:(NSDictionary *)extension;
 
+/**
+ Register interest in a channel and request that messages published to that channel are delivered to receiver through
+ a bounded delivery queue.
+ 
+ @param channel    Subscribe to a channel name or a channel pattern
+ 
+ @param callback   Will be called on receive of a message on given `channel` on callbackQueue
+ 
+ @param extension  An extension as an arbitrary JSON encodeable object according to [`ext` documentation][45].
+ 
+ @param options    Options, which configure the delivery queue, e.g. FYSubscriptionOptions.latestValueOptions.
+ */
+- (void)subscribeChannel:(NSString *)channel callback:(FYMessageCallback)callback extension:(NSDictionary *)extension
+                 options:(FYSubscriptionOptions *)options;
+
 /**
  Register interest in a channel and request that messages published to that channel are delivered to receiver.
  
@@ -399,6 +688,61 @@ typedef void(^FYMessageCallback)(NSDictionary *userInfo);
  */
 - (void)subscribeChannels:(NSArray *)channels callback:(FYMessageCallback)callback extension:(NSDictionary *)extension;
 
+/**
+ Register interest in channels and request that messages published to that channels are delivered to receiver through
+ a bounded delivery queue per channel.
+ 
+ @param channels   Subscribe to an array of channel names and channel patterns
+ 
+ @param callback   Will be called on receive of a message on given 'channels' on callbackQueue
+ 
+ @param extension  An extension as an arbitrary JSON encodeable object according to [`ext` documentation][45].
+ 
+ @param options    Options, which configure the delivery queues, e.g. FYSubscriptionOptions.latestValueOptions.
+ */
+- (void)subscribeChannels:(NSArray *)channels callback:(FYMessageCallback)callback extension:(NSDictionary *)extension
+                  options:(FYSubscriptionOptions *)options;
+
+/**
+ Register interest in a channel and request that messages published to that channel are delivered to receiver in
+ batches.
+ 
+ @param channel        Subscribe to a channel name or a channel pattern
+ 
+ @param batchCallback  Will be called with the payloads of all messages on given `channel`, which were received in one
+ frame or within batchDeliveryTimeInterval, on callbackQueue
+ */
+- (void)subscribeChannel:(NSString *)channel batchCallback:(FYMessageBatchCallback)batchCallback;
+
+/**
+ Register interest in channels and request that messages published to that channels are delivered to receiver in
+ batches.
+ 
+ @param channels       Subscribe to an array of channel names and channel patterns
+ 
+ @param batchCallback  Will be called with the payloads of all messages on given `channels`, which were received in
+ one frame or within batchDeliveryTimeInterval, on callbackQueue
+ 
+ @param extension      An extension as an arbitrary JSON encodeable object according to [`ext` documentation][45].
+ */
+- (void)subscribeChannels:(NSArray *)channels batchCallback:(FYMessageBatchCallback)batchCallback
+                extension:(NSDictionary *)extension;
+
+/**
+ Register interest in channels and request that messages published to that channels are delivered to receiver in
+ batches through a bounded delivery queue per channel. Each batch contains the payloads queued since the last batch.
+ 
+ @param channels       Subscribe to an array of channel names and channel patterns
+ 
+ @param batchCallback  Will be called with the payloads queued for given `channels` on callbackQueue
+ 
+ @param extension      An extension as an arbitrary JSON encodeable object according to [`ext` documentation][45].
+ 
+ @param options        Options, which configure the delivery queues.
+ */
+- (void)subscribeChannels:(NSArray *)channels batchCallback:(FYMessageBatchCallback)batchCallback
+                extension:(NSDictionary *)extension options:(FYSubscriptionOptions *)options;
+
 /**
  Cancel interest in a channel and request that messages published to that channel are not delivered.
  
@@ -442,4 +786,53 @@ typedef void(^FYMessageCallback)(NSDictionary *userInfo);
  */
 - (void)publish:(NSDictionary *)userInfo onChannel:(NSString *)channel withExtension:(NSDictionary *)extension;
 
+/**
+ Publish events on a channel by sending event messages and get notified about their acknowledgement.
+ 
+ A publish message COULD with this implementation NOT be sent from an unconnected client.
+ 
+ @param userInfo    The message as an arbitrary JSON encodeable object
+ 
+ @param channel     Subscribe to a channel name or a channel pattern
+ 
+ @param completion  Will be called once, when the server acknowledged the publish, or with an error if it failed or
+ timed out. Will be executed on callbackQueue.
+ */
+- (void)publish:(NSDictionary *)userInfo onChannel:(NSString *)channel completion:(FYPublishCompletionBlock)completion;
+
+/**
+ Publish events on a channel by sending event messages with an extension object and get notified about their
+ acknowledgement.
+ 
+ A publish message COULD with this implementation NOT be sent from an unconnected client.
+ 
+ @param userInfo    The message as an arbitrary JSON encodeable object
+ 
+ @param channel     Subscribe to a channel name or a channel pattern
+ 
+ @param extension   An extension as an arbitrary JSON encodeable object according to [`ext` documentation][45].
+ 
+ @param completion  Will be called once, when the server acknowledged the publish, or with an error if it failed or
+ timed out. Will be executed on callbackQueue.
+ */
+- (void)publish:(NSDictionary *)userInfo onChannel:(NSString *)channel withExtension:(NSDictionary *)extension
+     completion:(FYPublishCompletionBlock)completion;
+
+/**
+ Send all outgoing messages, which are held back to be coalesced, immediately in one frame.
+ 
+ See batchTimeInterval.
+ */
+- (void)flush;
+
+/**
+ Smoothed time interval in seconds between sending a request and receiving its response on a given connection type.
+ Measured by acknowledgements of publishes and by handshakes.
+ 
+ @param connectionType  One of FYConnectionTypes.
+ 
+ @return A time interval in seconds, or 0 if no request was measured on this connection type.
+ */
+- (NSTimeInterval)latencyOfConnectionType:(NSString *)connectionType;
+
 @end
@@ -27,24 +27,53 @@
 //  THE SOFTWARE.
 //
 
-#import <CFNetwork/CFNetwork.h>
-#import <objc/runtime.h>
-#import <SystemConfiguration/SystemConfiguration.h>
+#import <pthread.h>
+#import <stdatomic.h>
 #import <sys/errno.h>
-#import <UIKit/UIKit.h>
 #import "FYClient.h"
 #import "FYActor.h"
+#import "FYChannelRouter.h"
+#import "FYDeliveryQueue.h"
 #import "FYDelegateProxy.h"
+#import "FYHTTPTransport.h"
+#import "FYMessageDecoder.h"
+#import "FYMessagePack.h"
+#import "FYMessageTemplate.h"
+#import "FYMetricsRecorder.h"
+#import "FYPerMessageDeflate.h"
+#import "FYReachability.h"
+#import "FYSubscriptionReconciler.h"
+#import "FYTimerWheel.h"
+#import "FYTimestamp.h"
 #import "NSURL+FYHelper.h"
 #import "SocketClient_Private.h"
 
+#if FY_OBSERVES_APPLICATION_STATE
+    #import <UIKit/UIKit.h>
+#endif
+
 
 
 const NSTimeInterval FYClientRetryTimeInterval     = 45;
 const NSTimeInterval FYClientReconnectTimeInterval = 45;
+const NSTimeInterval FYClientBatchTimeInterval     = 0;
+const NSTimeInterval FYClientPublishTimeInterval   = 10;
+const NSTimeInterval FYClientLongPollingTimeoutMargin = 10;
+
+const NSUInteger FYClientMaximumBatchMessageCount  = 100;
+const NSUInteger FYClientMaximumBatchSize          = 16 * 1024;
+const NSUInteger FYClientMaximumUnacknowledgedPublishCount = 64;
+const NSUInteger FYClientMaximumOfflinePublishCount = 1000;
+const NSUInteger FYClientMaximumOfflinePublishSize  = 256 * 1024;
+
+// Size in bytes, below which outgoing messages are sent uncompressed, e.g. keep-alive connects
+static const NSUInteger FYClientCompressionThreshold = 256;
 
 NSString *const FYWorkerQueueName = @"com.paij.SocketClient.FYClient";
 
+// Domain of errors, by which SRWebSocket reports a rejected upgrade, like an unexpected HTTP status or a protocol error
+NSString *const FYWebSocketErrorDomain = @"SRWebSocketErrorDomain";
+
 const struct FYMetaChannels FYMetaChannels = {
     .Handshake   = @"/meta/handshake",
     .Connect     = @"/meta/connect",
@@ -60,7 +89,16 @@ const struct FYConnectionTypes FYConnectionTypes = {
 };
 
 NSArray *FYSupportedConnectionTypes() {
-    return @[FYConnectionTypes.WebSocket];
+    return @[FYConnectionTypes.WebSocket, FYConnectionTypes.LongPolling];
+}
+
+const struct FYPayloadEncodings FYPayloadEncodings = {
+    .JSON                   = @"json",
+    .MessagePack            = @"msgpack",
+};
+
+NSArray *FYSupportedPayloadEncodings() {
+    return @[FYPayloadEncodings.MessagePack, FYPayloadEncodings.JSON];
 }
 
 const NSUInteger FYClientStateSetIsConnecting = (1<<2);
@@ -74,19 +112,6 @@ typedef NS_ENUM(NSUInteger, FYClientState) {
 
 
 
-/*
- Adapt SystemConfiguration rechability's callback as C function pointer to ObjC blocks to pass an inline block handler.
- This has the advantage that the code don't has to be scattered over the whole file.
- */
-typedef void(^FYReachabilityBlock)(SCNetworkReachabilityRef target, SCNetworkReachabilityFlags flags);
-
-static void FYReachabilityCallback(SCNetworkReachabilityRef target, SCNetworkReachabilityFlags flags, void *info) {
-    FYReachabilityBlock handler = ((__bridge_transfer typeof(FYReachabilityBlock))info);
-    handler(target, flags);
-};
-
-
-
 /**
  Blocks needs to be copied, when stored. Because you can use one single block as callback for multiple subscripted
  channels and we don't want to copy the block for each channel, use a wrapper object, which copy the block once and
@@ -100,6 +125,31 @@ static void FYReachabilityCallback(SCNetworkReachabilityRef target, SCNetworkRea
  */
 @property (nonatomic, copy) FYMessageCallback callback;
 
+/**
+ Wrapped block callback, which receives batches of payloads. Either this or callback is set.
+ */
+@property (nonatomic, copy) FYMessageBatchCallback batchCallback;
+
+/**
+ Payloads, which were received for batchCallback, but not delivered yet. Only accessed on the workerQueue.
+ */
+@property (nonatomic, retain) NSMutableArray *pendingPayloads;
+
+/**
+ Options, which configure the delivery queues. If nil, received payloads are dispatched without queueing.
+ */
+@property (nonatomic, copy) FYSubscriptionOptions *options;
+
+/**
+ Delivery queues by channel name or channel pattern, if options are given.
+ */
+@property (nonatomic, retain) NSMutableDictionary *deliveryQueues;
+
+/**
+ Lane, on which the callback is executed. If nil, the client's callbackQueue is used.
+ */
+@property (nonatomic, retain) FYCallbackLane *lane;
+
 /**
  Channel extension used to subscribe.
  */
@@ -132,15 +182,297 @@ static void FYReachabilityCallback(SCNetworkReachabilityRef target, SCNetworkRea
 
 
 
-FYDefineDelegateProxy(FYClientDelegate);
-FYDefineDelegateProxy(SRWebSocketDelegate);
+/**
+ A publish, which awaits to be sent or to be acknowledged by the server.
+ */
+@interface FYPendingPublish : NSObject
+
+/**
+ The complete publish message including its id. The clientId is set, when it is sent.
+ */
+@property (nonatomic, retain) NSMutableDictionary *message;
+
+/**
+ Block, which is called once, when the publish was acknowledged or failed.
+ */
+@property (nonatomic, copy) FYPublishCompletionBlock completion;
+
+/**
+ System uptime, when the publish was sent. Is 0 while the publish is held back.
+ */
+@property (nonatomic, assign) NSTimeInterval sentUptime;
+
+/**
+ Timer, which fails the publish, if it isn't acknowledged in time. Is cancelled, when the publish is finished.
+ */
+@property (nonatomic, retain) FYTimer *timeoutTimer;
+
+/**
+ The message without its id and clientId, which was serialized once, when the publish was held back. The id and the
+ current clientId are spliced in, when it is sent. Is nil, if it was never held back.
+ */
+@property (nonatomic, retain) FYMessageTemplate *template;
+
+/**
+ Length of the serialized message without its id and clientId, which is accounted against the limits of the offline
+ queue.
+ */
+@property (nonatomic, assign) NSUInteger size;
+
+/**
+ Initializer
+ 
+ @param message     The complete publish message including its id.
+ 
+ @param completion  Block, which is called once, when the publish was acknowledged or failed.
+ */
+- (id)initWithMessage:(NSMutableDictionary *)message completion:(FYPublishCompletionBlock)completion;
+
+@end
+
+
+@implementation FYPendingPublish
+
+- (id)initWithMessage:(NSMutableDictionary *)message completion:(FYPublishCompletionBlock)completion {
+    self = [super init];
+    if (self) {
+        self.message = message;
+        self.completion = completion;
+    }
+    return self;
+}
+
+@end
+
+
+
+/**
+ Dispatches calls to the delegate of a FYClient. Implemented methods are looked up once when the delegate is set.
+ */
+@interface FYClientDelegateProxy : FYDelegateProxy <FYClientDelegate> {
+    struct {
+        unsigned int clientConnected:1;
+        unsigned int subscriptionSucceedToChannel:1;
+        unsigned int receivedUnexpectedMessage:1;
+        unsigned int reachedHighWatermark:1;
+        unsigned int disconnectedWithMessage:1;
+        unsigned int failedWithError:1;
+        unsigned int wasAdvisedToRetry:1;
+        unsigned int wasAdvisedToHandshake:1;
+    } _respondsTo;
+}
+
+@property (nonatomic, weak) id<NSObject,FYClientDelegate> proxiedObject;
+
+/**
+ Check if the delegate handles unexpected messages, so that their payloads have to be decoded.
+ */
+@property (nonatomic, assign, readonly) BOOL respondsToReceivedUnexpectedMessage;
+
+/**
+ Let the delegate customize the retry interval. The reply is executed on the given queue, which is never blocked.
+ */
+- (void)clientWasAdvisedToRetry:(FYClient *)client retryInterval:(NSTimeInterval)interval
+                   replyOnQueue:(dispatch_queue_t)queue reply:(void(^)(NSTimeInterval interval))reply;
+
+/**
+ Ask the delegate, whether to retry by a handshake. The reply is executed on the given queue, which is never blocked.
+ */
+- (void)clientWasAdvisedToHandshake:(FYClient *)client replyOnQueue:(dispatch_queue_t)queue
+                              reply:(void(^)(BOOL retry))reply;
+
+@end
+
+
+@implementation FYClientDelegateProxy
+
+@dynamic proxiedObject;
+
+- (void)proxiedObjectDidChange {
+    id<NSObject,FYClientDelegate> delegate = self.proxiedObject;
+    _respondsTo.clientConnected              = [delegate respondsToSelector:@selector(clientConnected:)];
+    _respondsTo.subscriptionSucceedToChannel = [delegate respondsToSelector:@selector(client:subscriptionSucceedToChannel:)];
+    _respondsTo.receivedUnexpectedMessage    = [delegate respondsToSelector:@selector(client:receivedUnexpectedMessage:)];
+    _respondsTo.reachedHighWatermark         = [delegate respondsToSelector:@selector(client:deliveryQueueOfChannel:reachedHighWatermark:)];
+    _respondsTo.disconnectedWithMessage      = [delegate respondsToSelector:@selector(client:disconnectedWithMessage:error:)];
+    _respondsTo.failedWithError              = [delegate respondsToSelector:@selector(client:failedWithError:)];
+    _respondsTo.wasAdvisedToRetry            = [delegate respondsToSelector:@selector(clientWasAdvisedToRetry:retryInterval:)];
+    _respondsTo.wasAdvisedToHandshake        = [delegate respondsToSelector:@selector(clientWasAdvisedToHandshake:shouldRetry:)];
+}
+
+- (BOOL)respondsToReceivedUnexpectedMessage {
+    return _respondsTo.receivedUnexpectedMessage;
+}
+
+- (void)clientConnected:(FYClient *)client {
+    if (_respondsTo.clientConnected) {
+        [self dispatchAsync:^(id<FYClientDelegate> delegate) {
+            [delegate clientConnected:client];
+         }];
+    }
+}
+
+- (void)client:(FYClient *)client subscriptionSucceedToChannel:(NSString *)channel {
+    if (_respondsTo.subscriptionSucceedToChannel) {
+        [self dispatchAsync:^(id<FYClientDelegate> delegate) {
+            [delegate client:client subscriptionSucceedToChannel:channel];
+         }];
+    }
+}
+
+- (void)client:(FYClient *)client receivedUnexpectedMessage:(FYMessage *)message {
+    if (_respondsTo.receivedUnexpectedMessage) {
+        [self dispatchAsync:^(id<FYClientDelegate> delegate) {
+            [delegate client:client receivedUnexpectedMessage:message];
+         }];
+    }
+}
+
+- (void)client:(FYClient *)client deliveryQueueOfChannel:(NSString *)channel reachedHighWatermark:(NSUInteger)count {
+    if (_respondsTo.reachedHighWatermark) {
+        [self dispatchAsync:^(id<FYClientDelegate> delegate) {
+            [delegate client:client deliveryQueueOfChannel:channel reachedHighWatermark:count];
+         }];
+    }
+}
+
+- (void)client:(FYClient *)client disconnectedWithMessage:(FYMessage *)message error:(NSError *)error {
+    if (_respondsTo.disconnectedWithMessage) {
+        [self dispatchAsync:^(id<FYClientDelegate> delegate) {
+            [delegate client:client disconnectedWithMessage:message error:error];
+         }];
+    }
+}
+
+- (void)client:(FYClient *)client failedWithError:(NSError *)error {
+    if (_respondsTo.failedWithError) {
+        [self dispatchAsync:^(id<FYClientDelegate> delegate) {
+            [delegate client:client failedWithError:error];
+         }];
+    }
+}
+
+- (void)clientWasAdvisedToRetry:(FYClient *)client retryInterval:(NSTimeInterval)interval
+                   replyOnQueue:(dispatch_queue_t)queue reply:(void(^)(NSTimeInterval interval))reply {
+    if (!_respondsTo.wasAdvisedToRetry) {
+        reply(interval);
+        return;
+    }
+    __block NSTimeInterval customInterval = interval;
+    [self dispatchAsync:^(id<FYClientDelegate> delegate) {
+        [delegate clientWasAdvisedToRetry:client retryInterval:&customInterval];
+     } replyOnQueue:queue reply:^{
+        reply(customInterval);
+     }];
+}
+
+- (void)clientWasAdvisedToHandshake:(FYClient *)client replyOnQueue:(dispatch_queue_t)queue
+                              reply:(void(^)(BOOL retry))reply {
+    if (!_respondsTo.wasAdvisedToHandshake) {
+        reply(NO);
+        return;
+    }
+    __block BOOL retry = NO;
+    [self dispatchAsync:^(id<FYClientDelegate> delegate) {
+        [delegate clientWasAdvisedToHandshake:client shouldRetry:&retry];
+     } replyOnQueue:queue reply:^{
+        reply(retry);
+     }];
+}
+
+@end
+
+
+
+/**
+ Dispatches calls of a SRWebSocket to the client on its workerQueue, if the socket has no own dispatch queue support.
+ */
+@interface SRWebSocketDelegateProxy : FYDelegateProxy <SRWebSocketDelegate>
+
+@property (nonatomic, weak) id<NSObject,SRWebSocketDelegate> proxiedObject;
+
+@end
+
+
+@implementation SRWebSocketDelegateProxy
+
+@dynamic proxiedObject;
+
+- (void)webSocketDidOpen:(SRWebSocket *)webSocket {
+    [self dispatchAsync:^(id<SRWebSocketDelegate> delegate) {
+        [delegate webSocketDidOpen:webSocket];
+     }];
+}
+
+- (void)webSocket:(SRWebSocket *)webSocket didReceiveMessage:(id)message {
+    [self dispatchAsync:^(id<SRWebSocketDelegate> delegate) {
+        [delegate webSocket:webSocket didReceiveMessage:message];
+     }];
+}
+
+- (void)webSocket:(SRWebSocket *)webSocket didFailWithError:(NSError *)error {
+    [self dispatchAsync:^(id<SRWebSocketDelegate> delegate) {
+        [delegate webSocket:webSocket didFailWithError:error];
+     }];
+}
+
+- (void)webSocket:(SRWebSocket *)webSocket didCloseWithCode:(NSInteger)code reason:(NSString *)reason
+         wasClean:(BOOL)wasClean {
+    [self dispatchAsync:^(id<SRWebSocketDelegate> delegate) {
+        [delegate webSocket:webSocket didCloseWithCode:code reason:reason wasClean:wasClean];
+     }];
+}
+
+@end
+
+
+
+/**
+ A serial dispatch queue, on which the callbacks of subscriptions with the same lane name are executed in order.
+ */
+@interface FYCallbackLane : NSObject
+
+/**
+ The serial queue of the lane.
+ */
+@property (nonatomic, readonly) dispatch_queue_t queue;
+
+/**
+ Initializer
+ 
+ @param  name         Name of the lane.
+ 
+ @param  targetQueue  Queue, on which the lane is executed.
+ */
+- (id)initWithName:(NSString *)name targetQueue:(dispatch_queue_t)targetQueue;
+
+@end
+
+
+@implementation FYCallbackLane
+
+- (id)initWithName:(NSString *)name targetQueue:(dispatch_queue_t)targetQueue {
+    self = [super init];
+    if (self) {
+        NSString *queueName = [FYWorkerQueueName stringByAppendingFormat:@".lane.%@", name];
+        _queue = dispatch_queue_create([queueName cStringUsingEncoding:NSASCIIStringEncoding], NULL);
+        dispatch_set_target_queue(_queue, targetQueue);
+    }
+    return self;
+}
+
+- (void)dealloc {
+    fy_dispatch_release(_queue);
+}
+
+@end
 
 
 
 /*
  Private interface
  */
-@interface FYClient () <SRWebSocketDelegate, NSURLConnectionDataDelegate>
+@interface FYClient () <SRWebSocketDelegate, FYHTTPTransportDelegate, FYMessageDecoderDelegate>
 
 // External readonly properties redefined as readwrite
 @property (nonatomic, retain, readwrite) NSURL *baseURL;
@@ -151,80 +483,218 @@ FYDefineDelegateProxy(SRWebSocketDelegate);
 
 // URL with NSURLConnection-compatible scheme
 @property (nonatomic, retain) NSURL *httpBaseURL;
+@property (nonatomic, retain) FYHTTPTransport *httpTransport;
 
 // Internal used properties only
 @property (nonatomic, retain) NSMutableDictionary *metaChannelActors;
 
 @property (nonatomic, assign) FYClientState state;
 @property (nonatomic, assign) BOOL shouldReconnectOnDidBecomeActive;
+@property (nonatomic, retain) FYReachability *reachability;
 
-@property (nonatomic, retain) NSString *connectionType;
+@property (nonatomic, retain, readwrite) NSString *connectionType;
+@property (nonatomic, retain, readwrite) NSString *payloadEncoding;
 @property (nonatomic, retain) NSDictionary *connectionExtension;
-@property (nonatomic, retain, readwrite) NSMutableDictionary *channels;
+
+// Transport selection and long-polling parameters
+@property (nonatomic, retain) NSSet *serverConnectionTypes;
+@property (nonatomic, retain) NSMutableDictionary *connectionTypeLatencies;
+@property (nonatomic, retain) NSString *handshakeConnectionType;
+@property (nonatomic, assign) NSTimeInterval handshakeSentUptime;
+@property (nonatomic, assign) NSTimeInterval advisedTimeout;
+@property (nonatomic, assign) NSTimeInterval advisedPollInterval;
+
+// Pre-encoded meta channel messages: handshake template is fixed, the others are valid for one session
+@property (nonatomic, retain) FYMessageTemplate *handshakeTemplate;
+@property (nonatomic, retain) NSMutableDictionary *sessionTemplates;
+
+// Subscribed channels are written to the draft under the routing lock and published as immutable routing snapshots
+@property (nonatomic, retain, readonly) FYChannelRouter *channels;
+@property (nonatomic, retain) FYChannelRouter *routingDraft;
+@property (nonatomic, assign) BOOL routingPublishScheduled;
+
+// Deliveries, which are collected while a frame is decoded, to be dispatched at once
+@property (nonatomic, retain) NSMutableArray *pendingCallbackWrappers;
+@property (nonatomic, retain) NSMutableArray *pendingCallbackPayloads;
+@property (nonatomic, retain) NSMutableArray *pendingCallbackTraces;
+@property (nonatomic, retain) NSMutableArray *pendingBatchWrappers;
+@property (nonatomic, assign, getter=isBatchDeliveryScheduled) BOOL batchDeliveryScheduled;
+
+// Metrics, which are recorded with atomic counters and reported periodically on workerQueue
+@property (nonatomic, retain) FYMetricsRecorder *metricsRecorder;
+@property (nonatomic, assign, getter=isMetricsReportScheduled) BOOL metricsReportScheduled;
+@property (nonatomic, retain) FYMessageTracer *messageTracer;
+@property (nonatomic, assign) NSTimeInterval frameReceivedUptime;
+
+// Serial lanes for callbacks by name, guarded by synchronization on itself
+@property (nonatomic, retain) NSMutableDictionary *callbackLanes;
+
+// Subscriptions, which should be sent to the server, are reconciled in batches on workerQueue
+@property (nonatomic, retain) FYSubscriptionReconciler *subscriptionReconciler;
+@property (nonatomic, assign, getter=isSubscriptionFlushScheduled) BOOL subscriptionFlushScheduled;
 
 @property (nonatomic, retain) FYClientDelegateProxy *clientDelegateProxy;
 @property (nonatomic, retain) SRWebSocketDelegateProxy *webSocketDelegateProxy;
+@property (nonatomic, retain) FYPerMessageDeflate *messageCodec;
+
+// Compression by permessage-deflate (RFC 7692) is only offered, if SocketRocket supports message codecs. The pinned
+// version doesn't, so these are not public yet.
+@property (nonatomic, assign) BOOL compressesMessages;
+@property (nonatomic, assign) NSUInteger compressionThreshold;
+@property (nonatomic, assign) BOOL compressesWithContextTakeover;
+@property (nonatomic, retain) FYMessageDecoder *messageDecoder;
+
+// Clock offset and latency estimation by round trips, which the server doesn't hold
+@property (nonatomic, retain) FYClockOffsetEstimator *clockOffsetEstimator;
+@property (nonatomic, assign) NSTimeInterval clockSampleSentTime;
+@property (nonatomic, assign) NSTimeInterval clockSampleSentUptime;
+@property (nonatomic, assign) BOOL unheldConnectSent;
+@property (nonatomic, assign) NSTimeInterval connectSentUptime;
+
+// Input for the reconnect policy
+@property (nonatomic, assign) NSTimeInterval advisedReconnectInterval;
+@property (nonatomic, assign) NSTimeInterval sessionEstablishedUptime;
 @property (nonatomic) dispatch_queue_t workerQueue;
 
+// Timers on the shared timer wheel, scheduling one replaces the outstanding one of the same kind
+@property (nonatomic, retain) FYTimer *keepAliveTimer;
+@property (nonatomic, retain) FYTimer *reconnectTimer;
+
+// Serialized messages, which are held back to be coalesced into one frame
+@property (nonatomic, retain) NSMutableArray *outboundMessages;
+@property (nonatomic, assign) NSUInteger outboundMessagesSize;
+@property (nonatomic, assign) NSUInteger outboundBatchGeneration;
+@property (nonatomic, assign, getter=isFlushScheduled) BOOL flushScheduled;
+
+// Publishes, which were sent and await their acknowledgement, by message id, and publishes held back by the window
+@property (nonatomic, retain) NSMutableDictionary *pendingPublishes;
+@property (nonatomic, retain) NSMutableArray *deferredPublishes;
+
+// Publishes held back while the client is connecting or reconnecting
+@property (nonatomic, retain) FYOfflineQueue *offlinePublishes;
+@property (nonatomic, assign, readwrite) NSTimeInterval publishLatency;
+
 // TODO: Enumerate hosts
 //@property (nonatomic, retain) NSMutableArray *alternateHosts;
 //@property (nonatomic, retain) NSMutableArray *triedHosts;
 
 // UIApplication state notification handler
+#if FY_OBSERVES_APPLICATION_STATE
 - (void)applicationWillResignActive:(NSNotification *)note;
 - (void)applicationDidBecomeActive:(NSNotification *)note;
+#endif
 
 // Protected connection status methods
 - (void)handshake;
 - (void)scheduleKeepAlive;
 - (BOOL)isConnecting;
+- (void)establishSession;
+
+// Transport selection
+- (BOOL)isLongPolling;
+- (BOOL)isTransportOpen;
+- (NSString *)preferredConnectionTypeOf:(NSSet *)connectionTypes;
+- (void)addLatencySample:(NSTimeInterval)latency forConnectionType:(NSString *)connectionType;
+- (BOOL)isRejectedUpgradeError:(NSError *)error;
+- (void)fallBackToLongPolling;
+- (BOOL)sendsPackedMessages;
+- (NSString *)agreedPayloadEncodingOfMessage:(FYMessage *)message;
+- (void)switchToPayloadEncoding:(NSString *)payloadEncoding;
 
 // Channel subscription helper
 - (void)validateChannel:(NSString *)channel;
+- (void)scheduleSubscriptionFlush;
+- (void)flushSubscriptions;
+- (void)subscribeChannels:(NSArray *)channels wrapper:(FYMessageCallbackWrapper *)wrapper;
+- (void)updateChannelsUsingBlock:(void(^)(FYChannelRouter *channels))block;
+- (void)publishRoutingSnapshot;
 
 // SRWebSocket facade methods
 - (void)openSocketConnection;
+- (FYPerMessageDeflate *)makeMessageCodec;
 - (void)closeSocketConnection;
 - (void)sendSocketMessage:(NSDictionary *)message;
+- (void)sendSocketData:(NSData *)message;
+- (void)enqueueSocketMessage:(NSData *)message;
+- (void)flushSocketMessages;
+- (void)dropSocketMessages:(NSArray *)messages withError:(NSError *)error;
 
 // NSURLConnection facade methods
-- (void)sendHTTPMessage:(NSDictionary *)message;
+- (void)sendHTTPData:(NSData *)message;
 
 // Communication helper functions
 - (void)handlePOSIXError:(NSError *)error;
-- (void)sendMessage:(NSDictionary *)message;
+- (void)scheduleReconnect;
+- (NSTimeInterval)nextReconnectDelay;
+- (void)sendMessageData:(NSData *)message;
+- (void)sendData:(NSData *)message;
 - (NSString *)generateMessageId;
 
 // Bayeux protocol functions
+- (void)updateHandshakeTemplate;
+- (FYMessageTemplate *)sessionTemplateForChannel:(NSString *)channel;
+- (void)stampClockSample;
+- (void)addClockSampleWithServerTime:(NSTimeInterval)serverTime;
 - (void)sendHandshake;
 - (void)sendConnect;
 - (void)sendDisconnect;
 - (void)sendSubscribe:(id)channel withExtension:(NSDictionary *)extension;
 - (void)sendUnsubscribe:(id)channel;
-- (void)sendPublish:(NSDictionary *)userInfo onChannel:(NSString *)channel withExtension:(NSDictionary *)extension;
+- (void)sendPublish:(NSDictionary *)userInfo onChannel:(NSString *)channel withExtension:(NSDictionary *)extension
+         completion:(FYPublishCompletionBlock)completion;
+- (void)sendPendingPublish:(FYPendingPublish *)publish;
+- (void)finishPendingPublish:(FYPendingPublish *)publish withError:(NSError *)error;
+- (void)sendDeferredPublishes;
+- (void)failPendingPublishesWithError:(NSError *)error;
+- (BOOL)shouldHoldBackPublishes;
+- (void)holdBackPublish:(FYPendingPublish *)publish;
+- (void)sendOfflinePublishes;
+- (void)dropOfflinePublishes;
 
 // Bayeux protocol responses handlers
 - (void)handleResponse:(NSString *)message;
+- (void)handleResponseData:(NSData *)data;
+- (void)handleResponseBytes:(const char *)bytes length:(NSUInteger)length;
+- (void)handlePackedResponseData:(NSData *)data;
+- (void)handleResponseBytes:(const char *)bytes length:(NSUInteger)length packed:(BOOL)packed;
+- (void)handleMessage:(NSDictionary *)userInfo;
+- (void)deliverPayload:(NSDictionary *)payload channel:(NSString *)channel pattern:(NSString *)pattern
+             toWrapper:(FYMessageCallbackWrapper *)wrapper trace:(FYMessageTrace *)trace;
+- (void)drainDeliveryQueue:(FYDeliveryQueue *)deliveryQueue ofWrapper:(FYMessageCallbackWrapper *)wrapper;
+- (FYCallbackLane *)callbackLaneNamed:(NSString *)name;
+- (void)scheduleMetricsReport;
+- (dispatch_queue_t)callbackQueueOfWrapper:(FYMessageCallbackWrapper *)wrapper;
+- (void)drainDeliveries;
+- (void)drainBatchDeliveries;
 - (void)client:(FYClient *)client receivedHandshakeMessage:(FYMessage *)message;
 - (void)client:(FYClient *)client receivedConnectMessage:(FYMessage *)message;
 - (void)client:(FYClient *)client receivedDisconnectMessage:(FYMessage *)message;
 - (void)client:(FYClient *)client receivedSubscribeMessage:(FYMessage *)message;
 - (void)client:(FYClient *)client receivedUnsubscribeMessage:(FYMessage *)message;
+- (void)client:(FYClient *)client receivedPublishMessage:(FYMessage *)message;
 
-// JSON serialization & deserialization
-- (NSString *)stringBySerializingObject:(NSObject *)object;
+// Serialization
 - (NSData *)dataBySerializingObject:(NSObject *)object;
-- (id)deserializeString:(NSString *)string;
-- (id)deserializeData:(NSData *)data;
 
 // General helper
 - (void)performBlock:(void(^)(FYClient *))block afterDelay:(NSTimeInterval)delay;
+- (FYTimer *)scheduleTimerWithDelay:(NSTimeInterval)delay block:(void(^)(FYClient *))block;
+- (void)scheduleReconnectUsingBlock:(void(^)(FYClient *))block;
 - (void)chainActorForMetaChannel:(NSString *)channel onceWithActorBlock:(FYActorBlock)block;
 
 @end
 
 
-@implementation FYClient
+@implementation FYClient {
+    // Counter for message ids, incremented atomically, because ids are generated from any thread
+    _Atomic(uint64_t) _messageIdCounter;
+    
+    // Current routing snapshot as retained FYChannelRouter, which is swapped atomically on the workerQueue
+    _Atomic(void *) _routingSnapshot;
+    
+    // Serializes writers of the routing draft
+    pthread_mutex_t _routingLock;
+}
 
 // Exclude properties from automatic synthesization
 @dynamic connected;
@@ -241,11 +711,21 @@ FYDefineDelegateProxy(SRWebSocketDelegate);
 - (void)dealloc {
     // Explicitly assign nil to provoke memory management
     self.callbackQueue = nil;
+    self.laneTargetQueue = nil;
     self.delegateQueue = nil;
     self.workerQueue   = nil;
     
     // Remove observations
     [NSNotificationCenter.defaultCenter removeObserver:self];
+    [self.reachability cancel];
+    
+    // Free the slots of the shared timer wheel
+    [self.keepAliveTimer cancel];
+    [self.reconnectTimer cancel];
+    
+    // Release the last routing snapshot
+    CFBridgingRelease(atomic_load(&_routingSnapshot));
+    pthread_mutex_destroy(&_routingLock);
 }
 
 - (id)initWithURL:(NSURL *)baseURL {
@@ -264,19 +744,52 @@ FYDefineDelegateProxy(SRWebSocketDelegate);
             : [baseURL URLWithScheme:[scheme isEqualToString:@"wss"] ? @"https" : @"http" host:baseURL.host];
         
         // This must be done before delegateQueue was set.
-        self.clientDelegateProxy = [FYClientDelegateProxy alloc]; // yes - there is no init ;)
+        self.clientDelegateProxy = [FYClientDelegateProxy new];
         
         // Init worker queue
         NSString *workerQueueName = [FYWorkerQueueName stringByAppendingFormat:@"_%d", (int)self];
         const char *workerQueueChars = [workerQueueName cStringUsingEncoding:NSASCIIStringEncoding];
         self.workerQueue = dispatch_queue_create(workerQueueChars, NULL);
         
+        // Init HTTP transport, which runs on the worker queue
+        self.httpTransport = [[FYHTTPTransport alloc] initWithURL:self.httpBaseURL queue:self.workerQueue];
+        self.httpTransport.delegate = self;
+        
         // Init returning queues
         self.delegateQueue = dispatch_get_main_queue();
         self.callbackQueue = dispatch_get_main_queue();
+        self.laneTargetQueue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+        
+        // Init channel router and subscriptions
+        pthread_mutex_init(&_routingLock, NULL);
+        self.routingDraft = [FYChannelRouter new];
+        atomic_init(&_routingSnapshot, (__bridge_retained void *)[self.routingDraft snapshot]);
+        self.subscriptionReconciler = [FYSubscriptionReconciler new];
+        
+        // Init delivery of received messages
+        self.pendingCallbackWrappers = [NSMutableArray new];
+        self.pendingCallbackPayloads = [NSMutableArray new];
+        self.pendingCallbackTraces   = [NSMutableArray new];
+        self.pendingBatchWrappers    = [NSMutableArray new];
+        self.callbackLanes           = [NSMutableDictionary new];
+        
+        // Init metrics
+        self.metricsRecorder = [FYMetricsRecorder new];
+        self.messageTracer = [FYMessageTracer new];
+        
+        // Init incremental decoder for received frames
+        self.messageDecoder = [[FYMessageDecoder alloc] initWithDelegate:self];
+        
+        // Init message templates, the handshake template is built with the connection types
+        self.sessionTemplates = [NSMutableDictionary new];
         
-        // Init channel collection
-        self.channels = [NSMutableDictionary new];
+        // Init transport selection
+        self.connectionTypes         = FYSupportedConnectionTypes();
+        self.connectionTypeLatencies = [NSMutableDictionary new];
+        self.advisedTimeout          = FYClientRetryTimeInterval;
+        
+        // Init clock offset estimation
+        self.clockOffsetEstimator = [FYClockOffsetEstimator new];
         
         // Init state properties
         self.state = FYClientStateDisconnected;
@@ -285,9 +798,37 @@ FYDefineDelegateProxy(SRWebSocketDelegate);
         // Init connection parameters
         self.retryTimeInterval     = FYClientRetryTimeInterval;
         self.reconnectTimeInterval = FYClientReconnectTimeInterval;
+        self.reconnectPolicy       = [[FYBackoffReconnectPolicy alloc] initWithMinimumInterval:1
+                                                                         maximumInterval:FYClientReconnectTimeInterval];
         self.maySendHandshakeAsync = YES;
         self.awaitOnlyHandshake    = YES;
         
+        // Init outgoing message coalescing
+        self.outboundMessages         = [NSMutableArray new];
+        self.batchTimeInterval        = FYClientBatchTimeInterval;
+        self.maximumBatchMessageCount = FYClientMaximumBatchMessageCount;
+        self.maximumBatchSize         = FYClientMaximumBatchSize;
+        
+        // Init publish acknowledgement tracking
+        self.pendingPublishes                  = [NSMutableDictionary new];
+        self.deferredPublishes                 = [NSMutableArray new];
+        self.publishTimeInterval               = FYClientPublishTimeInterval;
+        self.maximumUnacknowledgedPublishCount = FYClientMaximumUnacknowledgedPublishCount;
+        
+        // Init offline queue
+        self.offlinePublishes = [FYOfflineQueue new];
+        self.maximumOfflinePublishCount = FYClientMaximumOfflinePublishCount;
+        self.maximumOfflinePublishSize  = FYClientMaximumOfflinePublishSize;
+        
+        // Init web socket compression
+        self.compressesMessages            = YES;
+        self.compressionThreshold          = FYClientCompressionThreshold;
+        self.compressesWithContextTakeover = YES;
+        
+        // Init payload encoding, binary encodings are only used if offered explicitly
+        self.payloadEncodings = @[FYPayloadEncodings.JSON];
+        self.payloadEncoding  = FYPayloadEncodings.JSON;
+        
         // Bind own message handler selectors dynamically to meta channel names
         id<FYActor>(^makeActor)(SEL) = ^id<FYActor>(SEL selector){
             return [[FYSelTargetActor alloc] initWithTarget:self selector:selector];
@@ -301,10 +842,12 @@ FYDefineDelegateProxy(SRWebSocketDelegate);
              FYMetaChannels.Unsubscribe: makeActor(@selector(client:receivedUnsubscribeMessage:)),
          }.mutableCopy;
         
+        #if FY_OBSERVES_APPLICATION_STATE
         // Observe UIApplication notifications
         NSNotificationCenter *center = NSNotificationCenter.defaultCenter;
         [center addObserver:self selector:@selector(applicationWillResignActive:) name:UIApplicationWillResignActiveNotification object:nil];
         [center addObserver:self selector:@selector(applicationDidBecomeActive:)  name:UIApplicationDidBecomeActiveNotification  object:nil];
+        #endif
     }
     return self;
 }
@@ -334,6 +877,47 @@ FYDefineDelegateProxy(SRWebSocketDelegate);
 }
 
 
+#pragma mark - Session state setters, which invalidate message templates
+
+// These have to be called on workerQueue, where the templates are built and cached.
+
+- (void)setClientId:(NSString *)clientId {
+    _clientId = clientId;
+    [self.sessionTemplates removeAllObjects];
+}
+
+- (void)setConnectionType:(NSString *)connectionType {
+    _connectionType = connectionType;
+    [self.sessionTemplates removeAllObjects];
+}
+
+- (void)setConnectionExtension:(NSDictionary *)connectionExtension {
+    _connectionExtension = connectionExtension;
+    [self.sessionTemplates removeAllObjects];
+}
+
+- (void)setConnectionTypes:(NSArray *)connectionTypes {
+    NSParameterAssert(connectionTypes.count > 0);
+    NSAssert([[NSSet setWithArray:connectionTypes] isSubsetOfSet:[NSSet setWithArray:FYSupportedConnectionTypes()]],
+             @"Connection types %@ are not supported.", connectionTypes);
+    _connectionTypes = connectionTypes.copy;
+    [self updateHandshakeTemplate];
+}
+
+- (void)setPayloadEncodings:(NSArray *)payloadEncodings {
+    NSParameterAssert(payloadEncodings.count > 0);
+    NSAssert([[NSSet setWithArray:payloadEncodings] isSubsetOfSet:[NSSet setWithArray:FYSupportedPayloadEncodings()]],
+             @"Payload encodings %@ are not supported.", payloadEncodings);
+    _payloadEncodings = payloadEncodings.copy;
+    [self updateHandshakeTemplate];
+}
+
+- (void)setPayloadEncoding:(NSString *)payloadEncoding {
+    _payloadEncoding = payloadEncoding;
+    [self.sessionTemplates removeAllObjects];
+}
+
+
 #pragma mark - Compatiblity to versions below iOS 6.1, where ARC doesn't support automatic dispatch_retain & dispatch_release
 
 - (void)setCallbackQueue:(dispatch_queue_t)callbackQueue {
@@ -346,6 +930,23 @@ FYDefineDelegateProxy(SRWebSocketDelegate);
     _callbackQueue = callbackQueue;
 }
 
+- (void)setLaneTargetQueue:(dispatch_queue_t)laneTargetQueue {
+    if (laneTargetQueue) {
+        fy_dispatch_retain(laneTargetQueue);
+    }
+    if (_laneTargetQueue) {
+        fy_dispatch_release(_laneTargetQueue);
+    }
+    _laneTargetQueue = laneTargetQueue;
+    
+    // Retarget existing lanes
+    @synchronized(self.callbackLanes) {
+        for (FYCallbackLane *lane in self.callbackLanes.allValues) {
+            dispatch_set_target_queue(lane.queue, laneTargetQueue);
+        }
+    }
+}
+
 - (void)setWorkerQueue:(dispatch_queue_t)workerQueue {
     if (workerQueue) {
         fy_dispatch_retain(workerQueue);
@@ -359,6 +960,8 @@ FYDefineDelegateProxy(SRWebSocketDelegate);
 
 #pragma mark - UIApplication state notification handlers
 
+#if FY_OBSERVES_APPLICATION_STATE
+
 - (void)applicationWillResignActive:(NSNotification *)note {
     self.shouldReconnectOnDidBecomeActive = self.isConnected || self.isConnecting;
     [self disconnect];
@@ -372,6 +975,8 @@ FYDefineDelegateProxy(SRWebSocketDelegate);
     }
 }
 
+#endif
+
 
 #pragma mark - Public connection status methods
 
@@ -388,8 +993,6 @@ FYDefineDelegateProxy(SRWebSocketDelegate);
 }
 
 - (void)connectWithExtension:(NSDictionary *)extension onSuccess:(FYClientConnectSuccessBlock)block; {
-    self.connectionExtension = extension;
-    
     if (block) {
         NSString *channel = FYMetaChannels.Connect;
         if (self.awaitOnlyHandshake) {
@@ -423,12 +1026,13 @@ FYDefineDelegateProxy(SRWebSocketDelegate);
         [self chainActorForMetaChannel:channel onceWithActorBlock:actorBlock];
     }
     
-    // Connect now
+    // Connect now. The extension invalidates the session templates, which are owned by workerQueue.
     dispatch_async(self.workerQueue, ^{
+        self.connectionExtension = extension;
         [self openSocketConnection];
      });
     
-    if (self.maySendHandshakeAsync) {
+    if (self.maySendHandshakeAsync || ![self.connectionTypes containsObject:FYConnectionTypes.WebSocket]) {
         // Do the handshake parallel to opening socket connection on an own URL request
         dispatch_async(self.workerQueue, ^{
             [self handshake];
@@ -437,6 +1041,12 @@ FYDefineDelegateProxy(SRWebSocketDelegate);
 }
 
 - (void)disconnect {
+    [self.reconnectPolicy reset];
+    dispatch_async(self.workerQueue, ^{
+        // Timers are owned by workerQueue
+        [self.reconnectTimer cancel];
+        [self.keepAliveTimer cancel];
+     });
     self.reconnecting = NO;
     self.persist = nil;
     self.state = FYClientStateDisconnecting;
@@ -452,17 +1062,10 @@ FYDefineDelegateProxy(SRWebSocketDelegate);
 }
 
 - (void)reconnect {
-    // Save current channels
-    NSMutableDictionary *channels = self.channels.mutableCopy;
+    [self.metricsRecorder recordReconnect];
+    
+    // Channels are kept while reconnecting and re-subscribed in one batch, when the new session is established.
     [self connectWithExtension:self.connectionExtension onSuccess:self.isReconnecting ? nil : ^(FYClient *self) {
-        if (self.state >= FYClientStateConnecting) {
-            // Re-subscript to channels on server-side
-            self.channels = channels;
-            for (NSString *channel in channels) {
-                // Send subscribe directly, without unboxing and re-boxing FYMessageCallbacks
-                [self sendSubscribe:channel withExtension:[channels[channel] extension]];
-            }
-        }
         self.reconnecting = NO;
      }];
     self.reconnecting = YES;
@@ -477,7 +1080,56 @@ FYDefineDelegateProxy(SRWebSocketDelegate);
 }
 
 - (NSArray *)subscriptedChannels {
-    return self.channels.allKeys;
+    // Read the draft, which includes writes not published yet
+    pthread_mutex_lock(&_routingLock);
+    NSArray *channels = self.routingDraft.allChannels;
+    pthread_mutex_unlock(&_routingLock);
+    return channels;
+}
+
+- (NSTimeInterval)serverClockOffset {
+    // The estimator is updated on workerQueue
+    __block NSTimeInterval offset;
+    dispatch_sync(self.workerQueue, ^{
+        offset = self.clockOffsetEstimator.offset;
+     });
+    return offset;
+}
+
+- (NSTimeInterval)latency {
+    __block NSTimeInterval latency;
+    dispatch_sync(self.workerQueue, ^{
+        latency = self.clockOffsetEstimator.latency;
+     });
+    return latency;
+}
+
+- (NSTimeInterval)latencyOfConnectionType:(NSString *)connectionType {
+    return [self.connectionTypeLatencies[connectionType] doubleValue];
+}
+
+- (NSUInteger)maximumOfflinePublishCount {
+    return self.offlinePublishes.maximumCount;
+}
+
+- (void)setMaximumOfflinePublishCount:(NSUInteger)maximumOfflinePublishCount {
+    self.offlinePublishes.maximumCount = maximumOfflinePublishCount;
+}
+
+- (NSUInteger)maximumOfflinePublishSize {
+    return self.offlinePublishes.maximumSize;
+}
+
+- (void)setMaximumOfflinePublishSize:(NSUInteger)maximumOfflinePublishSize {
+    self.offlinePublishes.maximumSize = maximumOfflinePublishSize;
+}
+
+- (FYOfflineQueueOverflowPolicy)offlinePublishOverflowPolicy {
+    return self.offlinePublishes.overflowPolicy;
+}
+
+- (void)setOfflinePublishOverflowPolicy:(FYOfflineQueueOverflowPolicy)offlinePublishOverflowPolicy {
+    self.offlinePublishes.overflowPolicy = offlinePublishOverflowPolicy;
 }
 
 
@@ -489,19 +1141,48 @@ FYDefineDelegateProxy(SRWebSocketDelegate);
     [self sendHandshake];
 }
 
-- (void)scheduleKeepAlive {
+- (void)establishSession {
+    self.state = FYClientStateConnected;
+    
+    // Schedule the first keep-alive connect, which isn't held by the server.
+    self.unheldConnectSent = NO;
+    [self scheduleKeepAlive];
+    
+    self.sessionEstablishedUptime = NSProcessInfo.processInfo.systemUptime;
+    [self flushSubscriptions];
+    [self sendOfflinePublishes];
+    [self.clientDelegateProxy clientConnected:self];
+}
+
+- (void)scheduleKeepAlive {
+    // Has to be called on workerQueue. The keep-alive is scheduled on each connect response and on each socket open,
+    // so the outstanding one is replaced to keep at most one per session.
+    [self.keepAliveTimer cancel];
+    self.keepAliveTimer = nil;
+    
+    if (self.isLongPolling) {
+        // The server holds the connect until it has messages to deliver, so poll again after the advised interval.
+        self.keepAliveTimer = [self scheduleTimerWithDelay:self.advisedPollInterval block:^(FYClient *client) {
+            if (client.state == FYClientStateConnected && client.clientId && client.isLongPolling
+                && !client.httpTransport.isPolling) {
+                [client sendConnect];
+            }
+         }];
+        return;
+    }
+    
     FYLog(@"Scheduled a keep-alive connect in %.3f.", self.retryTimeInterval);
     if (self.retryTimeInterval > 0) {
         // Schedule the next keep-alive connect.
-        [self performBlock:^(FYClient *client) {
+        self.keepAliveTimer = [self scheduleTimerWithDelay:self.retryTimeInterval block:^(FYClient *client) {
             // Check if the client is still connected, or if we may received an advice, which caused a handshake or
             // a disconnect. So we prevent unnecessary connect messages and especially connect message without
             // clientIds which would cause an exception.
-            if (client.state == FYClientStateConnected && self.clientId) {
+            if (client.state == FYClientStateConnected && client.clientId) {
                 FYLog(@"Send scheduled keep-alive connect at: %.3f.", [NSDate.date timeIntervalSince1970]);
                 [client sendConnect];
             }
-        } afterDelay:self.retryTimeInterval];
+         }];
     }
 }
 
@@ -512,6 +1193,37 @@ FYDefineDelegateProxy(SRWebSocketDelegate);
     NSAssert([channel hasPrefix:@"/"], @"A valid channel or channel pattern has to begin with a slash.");
 }
 
+- (void)scheduleSubscriptionFlush {
+    // Has to be called on workerQueue
+    if (self.isSubscriptionFlushScheduled) {
+        return;
+    }
+    
+    // Coalesce all changes, which are already enqueued on the workerQueue
+    self.subscriptionFlushScheduled = YES;
+    dispatch_async(self.workerQueue, ^{
+        self.subscriptionFlushScheduled = NO;
+        [self flushSubscriptions];
+     });
+}
+
+- (void)flushSubscriptions {
+    // Has to be called on workerQueue
+    if (self.state != FYClientStateConnected || !self.clientId) {
+        // Changes are kept until the session is established
+        return;
+    }
+    
+    [self.subscriptionReconciler dequeueChangesUsingBlock:^(NSArray *channels, NSDictionary *extension, BOOL subscribe) {
+        id subscription = channels.count == 1 ? channels[0] : channels;
+        if (subscribe) {
+            [self sendSubscribe:subscription withExtension:extension];
+        } else {
+            [self sendUnsubscribe:subscription];
+        }
+     }];
+}
+
 
 #pragma mark - Channel subscription
 
@@ -521,9 +1233,12 @@ FYDefineDelegateProxy(SRWebSocketDelegate);
 }
 
 - (void)subscribeChannel:(NSString *)channel callback:(FYMessageCallback)callback extension:(NSDictionary *)extension {
-    [self validateChannel:channel];
-    self.channels[channel] = [[FYMessageCallbackWrapper alloc] initWithCallback:callback extension:extension];
-    [self sendSubscribe:channel withExtension:extension];
+    [self subscribeChannels:@[channel] callback:callback extension:extension];
+}
+
+- (void)subscribeChannel:(NSString *)channel callback:(FYMessageCallback)callback extension:(NSDictionary *)extension
+                 options:(FYSubscriptionOptions *)options {
+    [self subscribeChannels:@[channel] callback:callback extension:extension options:options];
 }
 
 - (void)subscribeChannels:(NSArray *)channels callback:(FYMessageCallback)callback {
@@ -532,42 +1247,207 @@ FYDefineDelegateProxy(SRWebSocketDelegate);
 
 - (void)subscribeChannels:(NSArray *)channels callback:(FYMessageCallback)callback extension:(NSDictionary *)extension {
     FYMessageCallbackWrapper *wrapper = [[FYMessageCallbackWrapper alloc] initWithCallback:callback extension:extension];
+    [self subscribeChannels:channels wrapper:wrapper];
+}
+
+- (void)subscribeChannel:(NSString *)channel batchCallback:(FYMessageBatchCallback)batchCallback {
+    [self subscribeChannels:@[channel] batchCallback:batchCallback extension:nil];
+}
+
+- (void)subscribeChannels:(NSArray *)channels batchCallback:(FYMessageBatchCallback)batchCallback
+                extension:(NSDictionary *)extension {
+    [self subscribeChannels:channels batchCallback:batchCallback extension:extension options:nil];
+}
+
+- (void)subscribeChannels:(NSArray *)channels callback:(FYMessageCallback)callback extension:(NSDictionary *)extension
+                  options:(FYSubscriptionOptions *)options {
+    FYMessageCallbackWrapper *wrapper = [[FYMessageCallbackWrapper alloc] initWithCallback:callback extension:extension];
+    wrapper.options = options;
+    [self subscribeChannels:channels wrapper:wrapper];
+}
+
+- (void)subscribeChannels:(NSArray *)channels batchCallback:(FYMessageBatchCallback)batchCallback
+                extension:(NSDictionary *)extension options:(FYSubscriptionOptions *)options {
+    FYMessageCallbackWrapper *wrapper = [[FYMessageCallbackWrapper alloc] initWithCallback:nil extension:extension];
+    wrapper.batchCallback = batchCallback;
+    wrapper.options = options;
+    [self subscribeChannels:channels wrapper:wrapper];
+}
+
+- (void)subscribeChannels:(NSArray *)channels wrapper:(FYMessageCallbackWrapper *)wrapper {
+    if (wrapper.options) {
+        wrapper.deliveryQueues = [[NSMutableDictionary alloc] initWithCapacity:channels.count];
+    }
+    if (wrapper.options.lane) {
+        wrapper.lane = [self callbackLaneNamed:wrapper.options.lane];
+    }
     for (NSString *channel in channels) {
         [self validateChannel:channel];
-        self.channels[channel] = wrapper;
+        if (wrapper.options) {
+            wrapper.deliveryQueues[channel] = [[FYDeliveryQueue alloc] initWithOptions:wrapper.options];
+        }
     }
-    [self sendSubscribe:channels withExtension:extension];
+    [self updateChannelsUsingBlock:^(FYChannelRouter *router) {
+        for (NSString *channel in channels) {
+            router[channel] = wrapper;
+        }
+     }];
+    dispatch_async(self.workerQueue, ^{
+        for (NSString *channel in channels) {
+            [self.subscriptionReconciler addChannel:channel extension:wrapper.extension];
+        }
+        [self scheduleSubscriptionFlush];
+     });
 }
 
 - (void)unsubscribeChannel:(NSString *)channel {
-    [self validateChannel:channel];
-    [self.channels removeObjectForKey:channel];
-    [self sendUnsubscribe:channel];
+    [self unsubscribeChannels:@[channel]];
 }
 
 - (void)unsubscribeChannels:(NSArray *)channels {
     for (NSString *channel in channels) {
         [self validateChannel:channel];
     }
-    [self.channels removeObjectsForKeys:channels];
-    [self sendUnsubscribe:channels];
+    [self updateChannelsUsingBlock:^(FYChannelRouter *router) {
+        [router removeObjectsForChannels:channels];
+     }];
+    dispatch_async(self.workerQueue, ^{
+        for (NSString *channel in channels) {
+            [self.subscriptionReconciler removeChannel:channel];
+        }
+        [self scheduleSubscriptionFlush];
+     });
 }
 
 - (void)unsubscribeAll {
-    for (NSString *channelName in self.channels) {
-        [self sendUnsubscribe:channelName];
+    [self updateChannelsUsingBlock:^(FYChannelRouter *router) {
+        [router removeAllObjects];
+     }];
+    dispatch_async(self.workerQueue, ^{
+        [self.subscriptionReconciler removeAllChannels];
+        [self scheduleSubscriptionFlush];
+     });
+}
+
+
+#pragma mark - Routing snapshots
+
+- (FYChannelRouter *)channels {
+    // Lock-free read of the current snapshot. Snapshots are replaced and released only on the workerQueue, so this has
+    // to be called there.
+    return (__bridge FYChannelRouter *)atomic_load_explicit(&_routingSnapshot, memory_order_acquire);
+}
+
+- (void)updateChannelsUsingBlock:(void(^)(FYChannelRouter *channels))block {
+    // Writes only touch the draft, which copies the nodes along their paths once per published snapshot
+    pthread_mutex_lock(&_routingLock);
+    block(self.routingDraft);
+    BOOL schedulesPublish = !self.routingPublishScheduled;
+    self.routingPublishScheduled = YES;
+    pthread_mutex_unlock(&_routingLock);
+    
+    if (schedulesPublish) {
+        // Writes, which happen until then, are published together. Blocks, which are dispatched to the workerQueue after
+        // a write, like subscription requests, always see it.
+        dispatch_async(self.workerQueue, ^{
+            [self publishRoutingSnapshot];
+         });
+    }
+}
+
+- (void)publishRoutingSnapshot {
+    // Has to be called on workerQueue
+    pthread_mutex_lock(&_routingLock);
+    FYChannelRouter *snapshot = [self.routingDraft snapshot];
+    self.routingPublishScheduled = NO;
+    pthread_mutex_unlock(&_routingLock);
+    
+    void *expected = atomic_load_explicit(&_routingSnapshot, memory_order_relaxed);
+    void *previous = atomic_exchange_explicit(&_routingSnapshot, (__bridge_retained void *)snapshot,
+                                              memory_order_acq_rel);
+    NSAssert(previous == expected, @"Routing snapshots must only be replaced on the workerQueue.");
+    
+    // Readers run on the workerQueue as well, so none of them can still hold the previous snapshot.
+    CFBridgingRelease(previous);
+}
+
+
+#pragma mark - Metrics
+
+- (FYClientMetrics *)metrics {
+    return [self.metricsRecorder snapshot];
+}
+
+- (void)setMetricsHandler:(FYClientMetricsHandler)metricsHandler {
+    _metricsHandler = [metricsHandler copy];
+    dispatch_async(self.workerQueue, ^{
+        [self scheduleMetricsReport];
+     });
+}
+
+- (void)setMetricsReportingTimeInterval:(NSTimeInterval)metricsReportingTimeInterval {
+    _metricsReportingTimeInterval = metricsReportingTimeInterval;
+    dispatch_async(self.workerQueue, ^{
+        [self scheduleMetricsReport];
+     });
+}
+
+- (void)setTraceSamplingRate:(double)traceSamplingRate {
+    // Read on workerQueue, a stale value for the next messages doesn't matter
+    self.messageTracer.samplingRate = MIN(MAX(traceSamplingRate, 0), 1);
+}
+
+- (double)traceSamplingRate {
+    return self.messageTracer.samplingRate;
+}
+
+- (NSDictionary *)traceReports {
+    return [self.messageTracer reports];
+}
+
+- (void)scheduleMetricsReport {
+    // Has to be called on workerQueue
+    if (self.isMetricsReportScheduled || !self.metricsHandler || self.metricsReportingTimeInterval <= 0) {
+        return;
     }
+    self.metricsReportScheduled = YES;
+    [self performBlock:^(FYClient *client) {
+        client.metricsReportScheduled = NO;
+        FYClientMetricsHandler metricsHandler = client.metricsHandler;
+        if (metricsHandler) {
+            FYClientMetrics *metrics = client.metrics;
+            dispatch_async(client.callbackQueue, ^{
+                metricsHandler(metrics);
+             });
+        }
+        [client scheduleMetricsReport];
+     } afterDelay:self.metricsReportingTimeInterval];
 }
 
 
 #pragma mark - Publish on channel
 
 - (void)publish:(NSDictionary *)userInfo onChannel:(NSString *)channel {
-    [self sendPublish:userInfo onChannel:channel withExtension:nil];
+    [self sendPublish:userInfo onChannel:channel withExtension:nil completion:nil];
 }
 
 - (void)publish:(NSDictionary *)userInfo onChannel:(NSString *)channel withExtension:(NSDictionary *)extension {
-    [self sendPublish:userInfo onChannel:channel withExtension:extension];
+    [self sendPublish:userInfo onChannel:channel withExtension:extension completion:nil];
+}
+
+- (void)publish:(NSDictionary *)userInfo onChannel:(NSString *)channel completion:(FYPublishCompletionBlock)completion {
+    [self sendPublish:userInfo onChannel:channel withExtension:nil completion:completion];
+}
+
+- (void)publish:(NSDictionary *)userInfo onChannel:(NSString *)channel withExtension:(NSDictionary *)extension
+     completion:(FYPublishCompletionBlock)completion {
+    [self sendPublish:userInfo onChannel:channel withExtension:extension completion:completion];
+}
+
+- (void)flush {
+    dispatch_async(self.workerQueue, ^{
+        [self flushSocketMessages];
+     });
 }
 
 
@@ -576,21 +1456,58 @@ FYDefineDelegateProxy(SRWebSocketDelegate);
 - (void)openSocketConnection {
     // Reset existing connection state information
     self.clientId = nil;
-    [self.channels removeAllObjects];
+    self.connectionType = nil;
+    [self.httpTransport cancel];
+    if (!self.isReconnecting) {
+        [self updateChannelsUsingBlock:^(FYChannelRouter *router) {
+            [router removeAllObjects];
+         }];
+        [self.subscriptionReconciler removeAllChannels];
+    }
+    
+    // Subscriptions of the previous session have to be restored on the new session
+    [self.subscriptionReconciler reset];
+    
+    // The path to the server may have changed
+    [self.clockOffsetEstimator reset];
+    self.clockSampleSentUptime = 0;
+    self.connectSentUptime = 0;
+    
+    // Drop messages, which were held back for the previous connection
+    [self.outboundMessages removeAllObjects];
+    self.outboundMessagesSize = 0;
+    
+    // Publishes of the previous connection will never be acknowledged
+    [self failPendingPublishesWithError:[NSError errorWithDomain:FYErrorDomain code:FYErrorPublishInterrupted userInfo:@{
+         NSLocalizedDescriptionKey:        @"The connection was reset before the publish was acknowledged.",
+     }]];
     
     // Clean up any existing socket
     self.webSocket.delegate = nil;
     [self.webSocket close];
+    self.webSocket = nil;
+    
+    if (![self.connectionTypes containsObject:FYConnectionTypes.WebSocket]) {
+        // Only the state was reset, the session will be established by long-polling.
+        return;
+    }
     
     // Init a new socket
     self.webSocket = [[SRWebSocket alloc] initWithURLRequest:[NSURLRequest requestWithURL:self.baseURL]];
     self.webSocket.delegate = self;
     
+    // Offer compression, if the socket can transform messages. Each connection negotiates its own context.
+    self.messageCodec = nil;
+    if (self.compressesMessages && [self.webSocket respondsToSelector:@selector(setMessageCodec:)]) {
+        self.messageCodec = [self makeMessageCodec];
+        [self.webSocket performSelector:@selector(setMessageCodec:) withObject:self.messageCodec];
+    }
+    
     // Let's respond the socket on our workerQueue, we will dispatch on our delegate / callback queues for our own.
     if ([self.webSocket respondsToSelector:@selector(setDelegateDispatchQueue:)]) {
         [self.webSocket performSelector:@selector(setDelegateDispatchQueue:) withObject:(id)self.workerQueue];
     } else {
-        self.webSocketDelegateProxy = [SRWebSocketDelegateProxy alloc];
+        self.webSocketDelegateProxy = [SRWebSocketDelegateProxy new];
         self.webSocketDelegateProxy.delegateQueue = self.workerQueue;
         self.webSocketDelegateProxy.proxiedObject = self;
         self.webSocket.delegate = self.webSocketDelegateProxy;
@@ -599,26 +1516,161 @@ FYDefineDelegateProxy(SRWebSocketDelegate);
     [self.webSocket open];
 }
 
+- (FYPerMessageDeflate *)makeMessageCodec {
+    FYPerMessageDeflate *codec = [FYPerMessageDeflate new];
+    codec.compressionThreshold    = self.compressionThreshold;
+    codec.clientNoContextTakeover = !self.compressesWithContextTakeover;
+    codec.serverNoContextTakeover = !self.compressesWithContextTakeover;
+    codec.metricsRecorder         = self.metricsRecorder;
+    return codec;
+}
+
 - (void)closeSocketConnection {
     [self.webSocket close];
 }
 
 - (void)sendSocketMessage:(NSDictionary *)message {
     dispatch_async(self.workerQueue, ^{
-        NSString *serializedMessage = [self stringBySerializingObject:message];
-        if (serializedMessage) {
-            if (self.webSocket.readyState == SR_OPEN) {
-                FYLog(@"Send: %@", message);
-                [self.webSocket send:serializedMessage];
-            } else {
-                NSError *error = [NSError errorWithDomain:FYErrorDomain code:FYErrorSocketNotOpen userInfo:@{
-                     NSLocalizedDescriptionKey:        @"The socket connection is not open, but required to be opened.",
-                     NSLocalizedFailureReasonErrorKey: [NSString stringWithFormat:@"Could not send message %@", message],
-                 }];
-                [self.clientDelegateProxy client:self failedWithError:error];
+        [self sendSocketData:[self dataBySerializingObject:message]];
+     });
+}
+
+- (void)sendSocketData:(NSData *)message {
+    // Has to be called on workerQueue
+    if (!message) {
+        return;
+    }
+    if (self.webSocket.readyState == SR_OPEN) {
+        FYLog(@"Send: %@", self.sendsPackedMessages ? message
+              : [[NSString alloc] initWithData:message encoding:NSUTF8StringEncoding]);
+        [self enqueueSocketMessage:message];
+    } else {
+        [self.metricsRecorder recordDroppedSendCount:1];
+        NSError *error = [NSError errorWithDomain:FYErrorDomain code:FYErrorSocketNotOpen userInfo:@{
+             NSLocalizedDescriptionKey:        @"The socket connection is not open, but required to be opened.",
+             NSLocalizedFailureReasonErrorKey: [NSString stringWithFormat:@"Could not send message %@",
+                                                [[NSString alloc] initWithData:message encoding:NSUTF8StringEncoding]],
+         }];
+        [self.clientDelegateProxy client:self failedWithError:error];
+    }
+}
+
+- (void)enqueueSocketMessage:(NSData *)message {
+    [self.outboundMessages addObject:message];
+    self.outboundMessagesSize += message.length;
+    
+    if (self.outboundMessages.count >= self.maximumBatchMessageCount
+        || self.outboundMessagesSize >= self.maximumBatchSize) {
+        [self flushSocketMessages];
+    } else if (!self.isFlushScheduled) {
+        // Flush the current batch after the coalescing window, if it was not flushed before because a limit was
+        // reached or because of an explicit flush.
+        self.flushScheduled = YES;
+        NSUInteger generation = self.outboundBatchGeneration;
+        [self performBlock:^(FYClient *client) {
+            if (client.outboundBatchGeneration == generation) {
+                [client flushSocketMessages];
             }
+         } afterDelay:self.batchTimeInterval];
+    }
+}
+
+- (void)flushSocketMessages {
+    NSArray *messages = self.outboundMessages;
+    NSUInteger size = self.outboundMessagesSize;
+    
+    self.flushScheduled = NO;
+    self.outboundBatchGeneration++;
+    if (messages.count == 0) {
+        return;
+    }
+    self.outboundMessages = [NSMutableArray new];
+    self.outboundMessagesSize = 0;
+    
+    if (self.webSocket.readyState != SR_OPEN) {
+        [self dropSocketMessages:messages withError:[NSError errorWithDomain:FYErrorDomain code:FYErrorSocketNotOpen userInfo:@{
+             NSLocalizedDescriptionKey:        @"The socket connection is not open, but required to be opened.",
+             NSLocalizedFailureReasonErrorKey: [NSString stringWithFormat:@"Could not send %d held back messages.",
+                                                (int)messages.count],
+         }]];
+        return;
+    }
+    
+    if (self.sendsPackedMessages) {
+        // Join already packed messages to one MessagePack array, which is sent as binary frame. Its header only
+        // contains the count, so the messages follow as they are.
+        NSMutableData *frame = [[NSMutableData alloc] initWithCapacity:size + 5];
+        [FYMessagePack appendArrayHeaderWithCount:messages.count toData:frame];
+        for (NSData *message in messages) {
+            [frame appendData:message];
         }
-     });
+        
+        FYLog(@"Send binary frame with %d messages and %d bytes.", (int)messages.count, (int)frame.length);
+        [self.metricsRecorder recordFrameSentWithLength:frame.length];
+        [self.webSocket send:frame];
+        return;
+    }
+    
+    // Join already serialized messages to one JSON array, without deserializing them again. The frame is
+    // built in a single buffer, which is handed over to the string without copying it.
+    NSUInteger length = size + messages.count + 1;
+    char *frame = malloc(length);
+    if (!frame) {
+        [self dropSocketMessages:messages withError:[NSError errorWithDomain:FYErrorDomain code:FYErrorSocketFramingFailed userInfo:@{
+             NSLocalizedDescriptionKey:        @"The held back messages couldn't be joined to one frame.",
+             NSLocalizedFailureReasonErrorKey: [NSString stringWithFormat:@"Could not allocate %d bytes.", (int)length],
+         }]];
+        return;
+    }
+    __block char *cursor = frame;
+    *cursor++ = '[';
+    [messages enumerateObjectsUsingBlock:^(NSData *message, NSUInteger idx, BOOL *stop) {
+        if (idx > 0) {
+            *cursor++ = ',';
+        }
+        memcpy(cursor, message.bytes, message.length);
+        cursor += message.length;
+     }];
+    *cursor++ = ']';
+    
+    FYLog(@"Send frame with %d messages and %d bytes.", (int)messages.count, (int)length);
+    NSString *text = [[NSString alloc] initWithBytesNoCopy:frame length:cursor - frame
+                                                  encoding:NSUTF8StringEncoding freeWhenDone:YES];
+    if (!text) {
+        free(frame);
+        [self dropSocketMessages:messages withError:[NSError errorWithDomain:FYErrorDomain code:FYErrorSocketFramingFailed userInfo:@{
+             NSLocalizedDescriptionKey:        @"The held back messages couldn't be joined to one frame.",
+             NSLocalizedFailureReasonErrorKey: @"The joined messages are not valid UTF-8.",
+         }]];
+        return;
+    }
+    [self.metricsRecorder recordFrameSentWithLength:cursor - frame];
+    [self.webSocket send:text];
+}
+
+- (void)dropSocketMessages:(NSArray *)messages withError:(NSError *)error {
+    // Has to be called on workerQueue. Messages were already serialized, so the ids of publishes are only read back
+    // on this rare path, to fail them now instead of after their timeout.
+    [self.metricsRecorder recordDroppedSendCount:messages.count];
+    BOOL failedPublishes = NO;
+    for (NSData *data in messages) {
+        NSDictionary *message = self.sendsPackedMessages
+            ? [FYMessagePack objectWithData:data error:NULL]
+            : [NSJSONSerialization JSONObjectWithData:data options:0 error:NULL];
+        NSString *messageId = [message isKindOfClass:NSDictionary.class] ? message[@"id"] : nil;
+        FYPendingPublish *publish = [messageId isKindOfClass:NSString.class] ? self.pendingPublishes[messageId] : nil;
+        if (publish) {
+            [self.pendingPublishes removeObjectForKey:messageId];
+            [self finishPendingPublish:publish withError:error];
+            failedPublishes = YES;
+        }
+    }
+    [self.clientDelegateProxy client:self failedWithError:error];
+    
+    if (failedPublishes) {
+        // Slots in the window of unacknowledged publishes were freed
+        [self sendDeferredPublishes];
+    }
 }
 
 
@@ -627,22 +1679,23 @@ FYDefineDelegateProxy(SRWebSocketDelegate);
 - (void)webSocketDidOpen:(SRWebSocket *)aWebSocket {
     if (self.maySendHandshakeAsync) {
         // Handshake was already sent.
-        if (self.state == FYClientStateConnecting) {
-            self.state = FYClientStateConnected;
-            
+        if (self.state == FYClientStateConnecting && !self.isLongPolling) {
             // Successful response to handshake was already received, but socket was not open, so we must schedule the
             // first connect here.
-            [self scheduleKeepAlive];
-            
-            [self.clientDelegateProxy clientConnected:self];
+            [self establishSession];
         }
     } else {
         [self handshake];
     }
 }
 
-- (void)webSocket:(SRWebSocket *)webSocket didReceiveMessage:(NSString *)message {
-    [self handleResponse:message];
+- (void)webSocket:(SRWebSocket *)webSocket didReceiveMessage:(id)message {
+    if ([message isKindOfClass:NSData.class]) {
+        // Binary frames carry messages in the agreed binary payload encoding
+        [self handlePackedResponseData:message];
+    } else {
+        [self handleResponse:message];
+    }
 }
 
 - (void)webSocket:(SRWebSocket *)webSocket didCloseWithCode:(NSInteger)code reason:(NSString *)reason wasClean:(BOOL)wasClean {
@@ -664,8 +1717,25 @@ FYDefineDelegateProxy(SRWebSocketDelegate);
 }
 
 - (void)webSocket:(SRWebSocket *)webSocket didFailWithError:(NSError *)error {
+    // Until the handshake was confirmed, assume that the server supports long-polling
+    NSSet *serverConnectionTypes = self.state == FYClientStateConnecting
+        ? self.serverConnectionTypes
+        : [NSSet setWithObject:FYConnectionTypes.LongPolling];
+    if (self.state & FYClientStateSetIsConnecting
+        && [self isRejectedUpgradeError:error]
+        && [serverConnectionTypes containsObject:FYConnectionTypes.LongPolling]
+        && [self.connectionTypes containsObject:FYConnectionTypes.LongPolling]) {
+        // Web socket upgrade may be blocked by a proxy, so try long-polling instead of reconnecting.
+        FYLog(@"Web socket upgrade was rejected with %@, fall back to long-polling.", error);
+        [self fallBackToLongPolling];
+        return;
+    }
+    
     if ([error.domain isEqualToString:NSPOSIXErrorDomain]) {
         [self handlePOSIXError:error];
+    } else if (self.state & FYClientStateSetIsConnecting) {
+        // Neither a network error nor an upgrade, which could be replaced by long-polling, so try again later
+        [self scheduleReconnect];
     }
     [self.clientDelegateProxy client:self failedWithError:error];
 }
@@ -673,71 +1743,127 @@ FYDefineDelegateProxy(SRWebSocketDelegate);
 
 #pragma mark - NSURLConnection facade
 
-- (void)sendHTTPMessage:(NSDictionary *)message {
+- (void)sendHTTPData:(NSData *)message {
     dispatch_async(self.workerQueue, ^{
-        NSData *serializedMessage = [self dataBySerializingObject:@[message]];
-        if (serializedMessage) {
-            FYLog(@"Send: %@", message);
-            
-            // Initialize a new URL request
-            NSMutableURLRequest *request = [NSMutableURLRequest requestWithURL:self.httpBaseURL];
-            request.HTTPMethod  = @"POST";
-            request.HTTPBody    = serializedMessage;
-            
-            // Set HTTP headers
-            NSDictionary *headers = @{
-                @"Accept":          @"application/json",
-                @"Accept-Encoding": @"gzip",
-                @"Content-Type":    @"application/json",
-             };
-            // TODO: Add here a delegate method to further initialize requests header fields for authorization
-            // with inout &headers
-            for (NSString *headerField in headers) {
-                [request addValue:headers[headerField] forHTTPHeaderField:headerField];
-            }
-            
-            // Configure request options
-            request.HTTPShouldUsePipelining = YES;
-            request.cachePolicy             = NSURLRequestReloadIgnoringLocalCacheData;
-            // Implicitly needed defaults
-            //request.allowsCellularAccess    = YES;
-            //request.HTTPShouldHandleCookies = YES;
-            
-            // Send request
-            NSURLConnection *connection;
-            connection = [[NSURLConnection alloc] initWithRequest:request delegate:self startImmediately:NO];
-            [connection scheduleInRunLoop:NSRunLoop.mainRunLoop forMode:NSDefaultRunLoopMode];
-            [connection start];
+        if (message) {
+            FYLog(@"Send: %@", [[NSString alloc] initWithData:message encoding:NSUTF8StringEncoding]);
+            [self.metricsRecorder recordFrameSentWithLength:message.length];
+            [self.httpTransport sendMessage:message];
         }
     });
 }
 
-#pragma mark - NSURLConnectionDataDelegate's implementation
 
-- (void)connection:(NSURLConnection *)connection didReceiveResponse:(NSURLResponse *)response {
-    NSAssert([response isKindOfClass:NSHTTPURLResponse.class], @"Expected only HTTP responses!");
-    objc_setAssociatedObject(connection, (__bridge const void *)(NSHTTPURLResponse.class), response, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+#pragma mark - FYHTTPTransportDelegate's implementation
+
+- (void)transport:(FYHTTPTransport *)transport receivedData:(NSData *)data {
+    [self handleResponseData:data];
 }
 
-- (void)connection:(NSURLConnection *)connection didReceiveData:(NSData *)data {
-    dispatch_async(self.workerQueue, ^{
-        NSString *message = [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
-        NSHTTPURLResponse *response = objc_getAssociatedObject(connection, (__bridge const void *)(NSHTTPURLResponse.class));
-        if (response.statusCode != 200) {
-            NSError *error = [NSError errorWithDomain:FYErrorDomain code:FYErrorHTTPUnexpectedStatusCode userInfo:@{
-                NSLocalizedDescriptionKey:        @"The HTTP request returned with an unexpected status code.",
-                NSLocalizedFailureReasonErrorKey: [NSString stringWithFormat:@"Received unexpected response with "
-                                                   "status code %d with content: %@.", response.statusCode, message]
-             }];
-            [self.clientDelegateProxy client:self failedWithError:error];
-        } else {
-            [self handleResponse:message];
+- (void)transport:(FYHTTPTransport *)transport failedWithError:(NSError *)error {
+    [self.clientDelegateProxy client:self failedWithError:error];
+    
+    if (self.state == FYClientStateHandshaking) {
+        // The handshake request failed, e.g. because the server is down. A web socket, which is opened in parallel,
+        // fails on its own, but only one reconnect is outstanding.
+        [self scheduleReconnect];
+    } else if (self.isLongPolling && self.state == FYClientStateConnected && self.reconnectTimeInterval >= 0
+        && !self.isReconnecting) {
+        // The long-polling session is lost without a hanging connect
+        [self scheduleReconnectUsingBlock:^(FYClient *client) {
+            if (client.state != FYClientStateDisconnected && !client.httpTransport.isPolling) {
+                [client reconnect];
+            }
+         }];
+    }
+}
+
+
+#pragma mark - Transport selection
+
+- (BOOL)isLongPolling {
+    return [self.connectionType isEqualToString:FYConnectionTypes.LongPolling];
+}
+
+- (BOOL)isTransportOpen {
+    if (self.isLongPolling) {
+        return self.state == FYClientStateConnected && self.clientId;
+    }
+    return self.webSocket.readyState == SR_OPEN;
+}
+
+- (NSString *)preferredConnectionTypeOf:(NSSet *)connectionTypes {
+    BOOL webSocket = [connectionTypes containsObject:FYConnectionTypes.WebSocket]
+        && self.webSocket && self.webSocket.readyState <= SR_OPEN;
+    BOOL longPolling = [connectionTypes containsObject:FYConnectionTypes.LongPolling];
+    
+    if (webSocket && longPolling) {
+        // Prefer web socket, until it is known to be slower
+        NSNumber *webSocketLatency   = self.connectionTypeLatencies[FYConnectionTypes.WebSocket];
+        NSNumber *longPollingLatency = self.connectionTypeLatencies[FYConnectionTypes.LongPolling];
+        if (webSocketLatency && longPollingLatency && longPollingLatency.doubleValue < webSocketLatency.doubleValue) {
+            return FYConnectionTypes.LongPolling;
         }
-     });
+        return FYConnectionTypes.WebSocket;
+    }
+    return webSocket ? FYConnectionTypes.WebSocket : longPolling ? FYConnectionTypes.LongPolling : nil;
 }
 
-- (void)connection:(NSURLConnection *)connection didFailWithError:(NSError *)error {
-    [self.clientDelegateProxy client:self failedWithError:error];
+- (void)addLatencySample:(NSTimeInterval)latency forConnectionType:(NSString *)connectionType {
+    if (!connectionType) {
+        return;
+    }
+    NSNumber *previous = self.connectionTypeLatencies[connectionType];
+    if (previous) {
+        latency = previous.doubleValue + (latency - previous.doubleValue) / 8;
+    }
+    self.connectionTypeLatencies[connectionType] = @(latency);
+}
+
+- (BOOL)isRejectedUpgradeError:(NSError *)error {
+    // Network errors would hit long-polling in the same way, only a rejected upgrade could be avoided by it
+    return [error.domain isEqualToString:FYWebSocketErrorDomain];
+}
+
+- (void)fallBackToLongPolling {
+    // Has to be called on workerQueue
+    self.webSocket.delegate = nil;
+    [self.webSocket close];
+    self.webSocket = nil;
+    
+    if (self.state == FYClientStateConnecting) {
+        // Handshake was already confirmed
+        self.connectionType = FYConnectionTypes.LongPolling;
+        [self switchToPayloadEncoding:FYPayloadEncodings.JSON];
+        [self establishSession];
+    }
+    // Otherwise the handshake response will choose long-polling, because there is no socket
+}
+
+- (BOOL)sendsPackedMessages {
+    // Binary frames are only available on the web socket connection
+    return !self.isLongPolling && [self.payloadEncoding isEqualToString:FYPayloadEncodings.MessagePack];
+}
+
+- (NSString *)agreedPayloadEncodingOfMessage:(FYMessage *)message {
+    // The server answers the offer of the handshake with the encoding it agreed to, or ignores it.
+    NSDictionary *extension = (NSDictionary *)message.ext;
+    NSString *payloadEncoding = [extension isKindOfClass:NSDictionary.class] ? extension[@"payloadEncoding"] : nil;
+    if (self.isLongPolling || ![payloadEncoding isKindOfClass:NSString.class]
+        || ![self.payloadEncodings containsObject:payloadEncoding]) {
+        return FYPayloadEncodings.JSON;
+    }
+    return payloadEncoding;
+}
+
+- (void)switchToPayloadEncoding:(NSString *)payloadEncoding {
+    // Has to be called on workerQueue
+    if ([payloadEncoding isEqualToString:self.payloadEncoding]) {
+        return;
+    }
+    // Messages, which were already encoded, must not be coalesced with messages in the new encoding into one frame.
+    [self flushSocketMessages];
+    self.payloadEncoding = payloadEncoding;
 }
 
 
@@ -759,36 +1885,30 @@ FYDefineDelegateProxy(SRWebSocketDelegate);
             case EHOSTDOWN:      // Host is down
             case EHOSTUNREACH:   // No route to host
             {
-                // Use SystemConfiguration to await a network connection
+                // Await a network connection, previous watchers are replaced
                 __weak FYClient *client = self;
-                __block SCNetworkReachabilityRef ref = SCNetworkReachabilityCreateWithName(NULL, self.baseURL.host.UTF8String);
-                SCNetworkReachabilityContext context = {
-                    .info = (__bridge_retained void *)[^(SCNetworkReachabilityRef target, SCNetworkReachabilityFlags flags){
-                        if (!(flags & kSCNetworkReachabilityFlagsReachable)
-                            || (   flags & kSCNetworkReachabilityFlagsConnectionRequired
-                                && flags & kSCNetworkReachabilityFlagsTransientConnection
-                            )) {
-                            return;
+                [self.reachability cancel];
+                self.reachability = [[FYReachability alloc] initWithHost:self.baseURL.host];
+                BOOL watching = [self.reachability notifyWhenReachableOnQueue:self.workerQueue handler:^{
+                    client.reachability = nil;
+                    
+                    // Try to reconnect
+                    if (!client.isReconnecting && client.reconnectTimeInterval > 0) {
+                        if (client && client.state != FYClientStateDisconnected) {
+                            // Reconnect if client was not disconnected meanwhile
+                            [client reconnect];
                         }
-                        
-                        // Tear down
-                        SCNetworkReachabilitySetCallback(ref, NULL, NULL);
-                        SCNetworkReachabilitySetDispatchQueue(ref, NULL);
-                        CFRelease(ref);
-                        ref = nil;
-                        
-                        // Try to reconnect
-                        if (!client.isReconnecting && client.reconnectTimeInterval > 0) {
-                            if (client && client.state != FYClientStateDisconnected) {
-                                // Reconnect if client was not disconnected meanwhile
-                                [client reconnect];
-                            }
-                        }
-                     } copy],
-                 };
+                    }
+                }];
+                if (watching) {
+                    break;
+                }
                 
-                SCNetworkReachabilitySetCallback(ref, FYReachabilityCallback, &context);
-                SCNetworkReachabilitySetDispatchQueue(ref, self.workerQueue);
+                // Reachability can't be observed on this platform, so try to reconnect after the usual delay
+                self.reachability = nil;
+                [self scheduleReconnectUsingBlock:^(FYClient *client) {
+                    [client reconnect];
+                 }];
                 break;
             }
                 
@@ -797,142 +1917,494 @@ FYDefineDelegateProxy(SRWebSocketDelegate);
             case ETIMEDOUT:      // Operation timed out
             case ECONNREFUSED:   // Connection refused
                 // Try to reconnect
-                [self performBlock:^(FYClient *client) {
-                    [self reconnect];
-                 } afterDelay:self.reconnectTimeInterval];
+                [self scheduleReconnect];
                 break;
         }
     }
 }
 
-- (void)sendMessage:(NSDictionary *)message {
+- (void)scheduleReconnect {
+    // Has to be called on workerQueue
+    if (self.reconnectTimeInterval < 0) {
+        return;
+    }
+    [self scheduleReconnectUsingBlock:^(FYClient *client) {
+        if (client.state != FYClientStateDisconnected) {
+            [client reconnect];
+        }
+     }];
+}
+
+- (NSTimeInterval)nextReconnectDelay {
+    if (!self.reconnectPolicy) {
+        return self.reconnectTimeInterval;
+    }
+    
+    NSTimeInterval sessionDuration = 0;
+    if (self.sessionEstablishedUptime > 0) {
+        sessionDuration = NSProcessInfo.processInfo.systemUptime - self.sessionEstablishedUptime;
+        self.sessionEstablishedUptime = 0;
+    }
+    NSTimeInterval delay = [self.reconnectPolicy reconnectDelayWithAdvisedInterval:self.advisedReconnectInterval
+                                                                  sessionDuration:sessionDuration];
+    FYLog(@"Reconnect in %.3f after a session of %.3f.", delay, sessionDuration);
+    return delay;
+}
+
+- (void)sendMessageData:(NSData *)message {
+    // Has to be called on workerQueue
     if (self.webSocket.readyState == SR_OPEN) {
-        [self sendSocketMessage:message];
+        [self sendSocketData:message];
+    } else {
+        [self sendHTTPData:message];
+    }
+}
+
+- (void)sendData:(NSData *)message {
+    // Has to be called on workerQueue
+    if (self.isLongPolling) {
+        if (message) {
+            FYLog(@"Send: %@", [[NSString alloc] initWithData:message encoding:NSUTF8StringEncoding]);
+            [self.metricsRecorder recordFrameSentWithLength:message.length];
+            [self.httpTransport sendMessage:message];
+        }
     } else {
-        [self sendHTTPMessage:message];
+        [self sendSocketData:message];
     }
 }
 
 - (NSString *)generateMessageId {
-    return [NSString stringWithFormat:@"msg_%.5f_%d", [NSDate.date timeIntervalSince1970], 0];
+    // Ids have only to be unique within the connection, a counter is sufficient and never collides.
+    uint64_t messageId = atomic_fetch_add_explicit(&_messageIdCounter, 1, memory_order_relaxed) + 1;
+    return [NSString stringWithFormat:@"%llx", (unsigned long long)messageId];
 }
 
 
 #pragma mark - Bayeux procotol functions
 
-- (void)sendHandshake {
-    [self sendMessage:@{
+- (void)updateHandshakeTemplate {
+    NSMutableDictionary *message = @{
         @"channel":                  FYMetaChannels.Handshake,
         @"version":                  @"1.0",
         @"minimumVersion":           @"1.0beta",
-        @"supportedConnectionTypes": FYSupportedConnectionTypes(),
-     }];
+        @"supportedConnectionTypes": self.connectionTypes,
+     }.mutableCopy;
+    if (self.payloadEncodings && ![self.payloadEncodings isEqualToArray:@[FYPayloadEncodings.JSON]]) {
+        // Offer binary encodings to the server. The handshake itself is always JSON, as nothing is agreed yet.
+        message[@"ext"] = @{ @"payloadEncodings": self.payloadEncodings };
+    }
+    self.handshakeTemplate = [[FYMessageTemplate alloc] initWithMessage:message];
+}
+
+- (FYMessageTemplate *)sessionTemplateForChannel:(NSString *)channel {
+    // Has to be called on workerQueue
+    FYMessageTemplate *template = self.sessionTemplates[channel];
+    if (!template) {
+        NSMutableDictionary *message = [NSMutableDictionary new];
+        message[@"channel"] = channel;
+        if (self.clientId) {
+            message[@"clientId"] = self.clientId;
+        }
+        if ([channel isEqualToString:FYMetaChannels.Connect]) {
+            if (self.connectionType) {
+                message[@"connectionType"] = self.connectionType;
+            }
+            if (self.connectionExtension) {
+                message[@"ext"] = self.connectionExtension;
+            }
+        }
+        template = [[FYMessageTemplate alloc] initWithMessage:message packed:self.sendsPackedMessages];
+        self.sessionTemplates[channel] = template;
+    }
+    return template;
+}
+
+- (void)stampClockSample {
+    // Has to be called on workerQueue, right after a round trip, which the server answers immediately, was written.
+    self.clockSampleSentTime   = FYTimestampNow();
+    self.clockSampleSentUptime = NSProcessInfo.processInfo.systemUptime;
+}
+
+- (void)addClockSampleWithServerTime:(NSTimeInterval)serverTime {
+    // Has to be called on workerQueue. Only one sampled round trip is outstanding at a time.
+    if (self.clockSampleSentUptime <= 0) {
+        return;
+    }
+    NSTimeInterval roundTripTime = NSProcessInfo.processInfo.systemUptime - self.clockSampleSentUptime;
+    [self.clockOffsetEstimator addSampleWithRoundTripTime:roundTripTime
+                                                 sentTime:self.clockSampleSentTime
+                                               serverTime:serverTime];
+    self.clockSampleSentUptime = 0;
+}
+
+- (void)sendHandshake {
+    dispatch_async(self.workerQueue, ^{
+        // The payload encoding is agreed again by the handshake
+        [self switchToPayloadEncoding:FYPayloadEncodings.JSON];
+        
+        NSData *message = [self.handshakeTemplate dataWithMessageId:[self generateMessageId]];
+        if (self.webSocket.readyState == SR_OPEN) {
+            // Write it without waiting for the coalescing window, as its round trip is sampled
+            self.handshakeConnectionType = FYConnectionTypes.WebSocket;
+            [self sendSocketData:message];
+            [self flushSocketMessages];
+        } else {
+            self.handshakeConnectionType = FYConnectionTypes.LongPolling;
+            FYLog(@"Send: %@", [[NSString alloc] initWithData:message encoding:NSUTF8StringEncoding]);
+            [self.metricsRecorder recordFrameSentWithLength:message.length];
+            [self.httpTransport sendMessage:message];
+        }
+        
+        // Remember when the handshake was written to measure the latency of the connection type and the clock offset
+        self.handshakeSentUptime = NSProcessInfo.processInfo.systemUptime;
+        [self stampClockSample];
+     });
 }
 
 - (void)sendConnect {
-    [self sendSocketMessage:@{
-        @"channel":        FYMetaChannels.Connect,
-        @"clientId":       self.clientId,
-        @"connectionType": self.connectionType,
-        @"ext":            self.connectionExtension ?: NSNull.null,
-     }];
+    dispatch_async(self.workerQueue, ^{
+        // The server holds connects until it has messages to deliver or its timeout elapsed, so their round trips
+        // don't tell anything about the clock offset. Only the first connect of a session asks not to be held.
+        BOOL unheld = !self.unheldConnectSent;
+        FYMessageTemplate *template = [self sessionTemplateForChannel:FYMetaChannels.Connect];
+        NSData *message = unheld
+            ? [template dataWithMessageId:[self generateMessageId] fields:@{ @"advice": @{ @"timeout": @0 } }]
+            : [template dataWithMessageId:[self generateMessageId]];
+        if (self.isLongPolling) {
+            // Hang on an own request, while other messages are pipelined alongside
+            [self.metricsRecorder recordFrameSentWithLength:message.length];
+            [self.httpTransport pollWithMessage:message
+                                timeoutInterval:self.advisedTimeout + FYClientLongPollingTimeoutMargin];
+        } else {
+            [self sendSocketData:message];
+            if (unheld) {
+                [self flushSocketMessages];
+            }
+        }
+        
+        // Remember when the connect was written to measure its round trip. Only one connect is outstanding at a time.
+        self.connectSentUptime = NSProcessInfo.processInfo.systemUptime;
+        if (unheld) {
+            self.unheldConnectSent = YES;
+            [self stampClockSample];
+        }
+     });
 }
 
 - (void)sendDisconnect {
-    [self sendSocketMessage:@{
-        @"channel":        FYMetaChannels.Disconnect,
-        @"clientId":       self.clientId,
-     }];
+    dispatch_async(self.workerQueue, ^{
+        FYMessageTemplate *template = [self sessionTemplateForChannel:FYMetaChannels.Disconnect];
+        [self sendData:[template dataWithMessageId:[self generateMessageId]]];
+     });
 }
 
 - (void)sendSubscribe:(id)channel withExtension:(NSDictionary *)extension {
-    [self sendSocketMessage:@{
-        @"channel":      FYMetaChannels.Subscribe,
-        @"clientId":     self.clientId,
-        @"subscription": channel,
-        @"ext":          extension ?: NSNull.null
-     }];
+    dispatch_async(self.workerQueue, ^{
+        NSMutableDictionary *fields = [NSMutableDictionary new];
+        fields[@"subscription"] = channel;
+        if (extension) {
+            fields[@"ext"] = extension;
+        }
+        FYMessageTemplate *template = [self sessionTemplateForChannel:FYMetaChannels.Subscribe];
+        [self sendData:[template dataWithMessageId:[self generateMessageId] fields:fields]];
+     });
 }
 
 - (void)sendUnsubscribe:(id)channel {
-    [self sendSocketMessage:@{
-        @"channel":      FYMetaChannels.Unsubscribe,
-        @"clientId":     self.clientId,
-        @"subscription": channel,
-     }];
+    dispatch_async(self.workerQueue, ^{
+        FYMessageTemplate *template = [self sessionTemplateForChannel:FYMetaChannels.Unsubscribe];
+        [self sendData:[template dataWithMessageId:[self generateMessageId] fields:@{ @"subscription": channel }]];
+     });
 }
 
-- (void)sendPublish:(NSDictionary *)userInfo onChannel:(NSString *)channel withExtension:(NSDictionary *)extension {
-    [self sendSocketMessage:@{
-        @"channel":  channel,
-        @"clientId": self.clientId,
-        @"data":     userInfo,
-        @"id":       [self generateMessageId],
-        @"ext":      extension ?: NSNull.null
-     }];
+- (void)sendPublish:(NSDictionary *)userInfo onChannel:(NSString *)channel withExtension:(NSDictionary *)extension
+         completion:(FYPublishCompletionBlock)completion {
+    NSString *messageId = [self generateMessageId];
+    dispatch_async(self.workerQueue, ^{
+        NSMutableDictionary *message = [NSMutableDictionary new];
+        message[@"channel"] = channel;
+        message[@"data"] = userInfo;
+        message[@"id"] = messageId;
+        if (extension) {
+            message[@"ext"] = extension;
+        }
+        
+        FYPendingPublish *publish = [[FYPendingPublish alloc] initWithMessage:message completion:completion];
+        if (self.maximumUnacknowledgedPublishCount > 0
+            && (self.deferredPublishes.count > 0
+                || self.pendingPublishes.count >= self.maximumUnacknowledgedPublishCount)) {
+            // Window is full, hold back until a prior publish was acknowledged
+            [self.deferredPublishes addObject:publish];
+        } else {
+            [self sendPendingPublish:publish];
+        }
+     });
+}
+
+- (void)sendPendingPublish:(FYPendingPublish *)publish {
+    // Has to be called on workerQueue
+    NSString *messageId = publish.message[@"id"];
+    if (!self.isTransportOpen && self.shouldHoldBackPublishes) {
+        [self holdBackPublish:publish];
+        return;
+    }
+    
+    // The publish may have been held back over a new handshake
+    NSData *data;
+    if (self.clientId) {
+        publish.message[@"clientId"] = self.clientId;
+    }
+    if (publish.template && publish.template.isPacked == self.sendsPackedMessages) {
+        // Held back publishes were serialized already
+        data = [publish.template dataWithMessageId:messageId fields:self.clientId ? @{ @"clientId": self.clientId } : nil];
+    } else {
+        data = [self dataBySerializingObject:publish.message];
+    }
+    if (!data) {
+        [self finishPendingPublish:publish withError:[NSError errorWithDomain:FYErrorDomain code:FYErrorMalformedObjectData userInfo:@{
+             NSLocalizedDescriptionKey: @"Can't serialize malformed data.",
+         }]];
+        return;
+    }
+    
+    if (!self.isTransportOpen) {
+        // Report the error to the delegate, too
+        [self sendSocketData:data];
+        [self finishPendingPublish:publish withError:[NSError errorWithDomain:FYErrorDomain code:FYErrorSocketNotOpen userInfo:@{
+             NSLocalizedDescriptionKey: @"The socket connection is not open, but required to be opened.",
+         }]];
+        return;
+    }
+    
+    publish.sentUptime = NSProcessInfo.processInfo.systemUptime;
+    self.pendingPublishes[messageId] = publish;
+    
+    if (self.publishTimeInterval > 0) {
+        publish.timeoutTimer = [self scheduleTimerWithDelay:self.publishTimeInterval block:^(FYClient *client) {
+            if (client.pendingPublishes[messageId] == publish) {
+                [client.pendingPublishes removeObjectForKey:messageId];
+                [client finishPendingPublish:publish withError:[NSError errorWithDomain:FYErrorDomain code:FYErrorPublishTimedOut userInfo:@{
+                     NSLocalizedDescriptionKey:        @"The publish was not acknowledged in time.",
+                     NSLocalizedFailureReasonErrorKey: [NSString stringWithFormat:@"No response to publish with id "
+                                                        "'%@' within %.3f seconds.", messageId,
+                                                        client.publishTimeInterval],
+                 }]];
+                [client sendDeferredPublishes];
+            }
+         }];
+    }
+    
+    [self sendData:data];
+}
+
+- (void)finishPendingPublish:(FYPendingPublish *)publish withError:(NSError *)error {
+    // Has to be called on workerQueue
+    [publish.timeoutTimer cancel];
+    publish.timeoutTimer = nil;
+    FYPublishCompletionBlock completion = publish.completion;
+    publish.completion = nil;
+    if (completion) {
+        dispatch_async(self.callbackQueue, ^{
+            completion(error);
+         });
+    }
+}
+
+- (void)sendDeferredPublishes {
+    // Has to be called on workerQueue
+    while (self.deferredPublishes.count > 0
+           && (self.maximumUnacknowledgedPublishCount == 0
+               || self.pendingPublishes.count < self.maximumUnacknowledgedPublishCount)) {
+        FYPendingPublish *publish = self.deferredPublishes[0];
+        [self.deferredPublishes removeObjectAtIndex:0];
+        [self sendPendingPublish:publish];
+    }
+}
+
+- (void)failPendingPublishesWithError:(NSError *)error {
+    // Has to be called on workerQueue
+    NSArray *publishes = self.pendingPublishes.allValues;
+    [self.pendingPublishes removeAllObjects];
+    for (FYPendingPublish *publish in publishes) {
+        [self finishPendingPublish:publish withError:error];
+    }
+    
+    // Publishes, which were not sent yet, can be sent after reconnect
+    NSArray *deferredPublishes = self.deferredPublishes.copy;
+    [self.deferredPublishes removeAllObjects];
+    for (FYPendingPublish *publish in deferredPublishes) {
+        if (self.shouldHoldBackPublishes) {
+            [self holdBackPublish:publish];
+        } else {
+            [self finishPendingPublish:publish withError:error];
+        }
+    }
+}
+
+- (BOOL)shouldHoldBackPublishes {
+    // Publishes are held back while connecting or reconnecting, but not if the client was explicitly disconnected.
+    return self.isConnecting || self.isReconnecting || self.state == FYClientStateConnected;
+}
+
+- (void)holdBackPublish:(FYPendingPublish *)publish {
+    // Has to be called on workerQueue. The message is serialized once to measure its size, and reused when it is sent.
+    if (!publish.template) {
+        NSMutableDictionary *fields = [publish.message mutableCopy];
+        [fields removeObjectsForKeys:@[@"id", @"clientId"]];
+        NSData *data = [self dataBySerializingObject:fields];
+        publish.template = data ? [[FYMessageTemplate alloc] initWithData:data packed:self.sendsPackedMessages] : nil;
+        if (!publish.template) {
+            [self finishPendingPublish:publish withError:[NSError errorWithDomain:FYErrorDomain code:FYErrorMalformedObjectData userInfo:@{
+                 NSLocalizedDescriptionKey: @"Can't serialize malformed data.",
+             }]];
+            return;
+        }
+        publish.size = data.length;
+    }
+    
+    NSArray *droppedPublishes = [self.offlinePublishes enqueueObject:publish size:publish.size
+                                                                 key:publish.message[@"channel"]];
+    [self.metricsRecorder recordDroppedSendCount:droppedPublishes.count];
+    for (FYPendingPublish *droppedPublish in droppedPublishes) {
+        [self finishPendingPublish:droppedPublish withError:[NSError errorWithDomain:FYErrorDomain code:FYErrorPublishDropped userInfo:@{
+             NSLocalizedDescriptionKey:        @"The publish was dropped, while the client was offline.",
+             NSLocalizedFailureReasonErrorKey: [NSString stringWithFormat:@"Offline queue overflowed with %d "
+                                                "publishes of %d bytes.", (int)self.offlinePublishes.count,
+                                                (int)self.offlinePublishes.size],
+         }]];
+    }
+}
+
+- (void)sendOfflinePublishes {
+    // Has to be called on workerQueue
+    if (self.offlinePublishes.count == 0) {
+        return;
+    }
+    
+    // Held back publishes were published before any deferred publish, so keep their order
+    NSArray *publishes = [self.offlinePublishes dequeueAllObjects];
+    FYLog(@"Send %d publishes held back while offline.", (int)publishes.count);
+    [self.deferredPublishes replaceObjectsInRange:NSMakeRange(0, 0) withObjectsFromArray:publishes];
+    [self sendDeferredPublishes];
+}
+
+- (void)dropOfflinePublishes {
+    // Has to be called on workerQueue
+    NSArray *publishes = [self.offlinePublishes dequeueAllObjects];
+    [self.metricsRecorder recordDroppedSendCount:publishes.count];
+    for (FYPendingPublish *publish in publishes) {
+        [self finishPendingPublish:publish withError:[NSError errorWithDomain:FYErrorDomain code:FYErrorPublishDropped userInfo:@{
+             NSLocalizedDescriptionKey: @"The publish was dropped, because the client was disconnected.",
+         }]];
+    }
 }
 
 
 #pragma mark - Bayeux protocol responses handlers
 
 - (void)handleResponse:(NSString *)message {
-    id result = [self deserializeString:message];
-    if (![result isKindOfClass:NSArray.class]) {
+    // Decode the UTF-8 representation directly, without building an intermediate NSData object.
+    const char *bytes = message.UTF8String;
+    [self handleResponseBytes:bytes length:strlen(bytes)];
+}
+
+- (void)handleResponseData:(NSData *)data {
+    [self handleResponseBytes:data.bytes length:data.length];
+}
+
+- (void)handleResponseBytes:(const char *)bytes length:(NSUInteger)length {
+    [self handleResponseBytes:bytes length:length packed:NO];
+}
+
+- (void)handlePackedResponseData:(NSData *)data {
+    [self handleResponseBytes:data.bytes length:data.length packed:YES];
+}
+
+- (void)handleResponseBytes:(const char *)bytes length:(NSUInteger)length packed:(BOOL)packed {
+    // Messages are emitted by the decoder to handleMessage: as soon as each of them was decoded.
+    [self.metricsRecorder recordFrameReceivedWithLength:length];
+    NSTimeInterval parseStartUptime = NSProcessInfo.processInfo.systemUptime;
+    self.frameReceivedUptime = parseStartUptime;
+    NSError *error = nil;
+    BOOL decoded = packed
+        ? [self.messageDecoder decodePackedBytes:bytes length:length error:&error]
+        : [self.messageDecoder decodeBytes:bytes length:length error:&error];
+    [self.metricsRecorder recordParseTime:NSProcessInfo.processInfo.systemUptime - parseStartUptime];
+    if (!decoded) {
         // Response is malformed
-        NSError *error = [NSError errorWithDomain:FYErrorDomain code:FYErrorMalformedJSONData userInfo:@{
-            NSLocalizedDescriptionKey:        @"Response is malformed.",
-            NSLocalizedFailureReasonErrorKey: [NSString stringWithFormat:@"Expected an array of messages, but got: %@.",
-                                               result],
-         }];
         [self.clientDelegateProxy client:self failedWithError:error];
-        return;
     }
     
-    NSArray *messages = result;
-    for (NSDictionary *userInfo in messages) {
-        FYLog(@"handleResponse: %@", userInfo);
-        
-        // Box in message object to unserialize all fields
-        FYMessage *message = [[FYMessage alloc] initWithUserInfo:userInfo];
-        
-        BOOL handled = NO;
-        
-        // Handle advice before handling meta channel message, so the retryTimeInterval can be modified before the
-        // handshake occurs which will schedule the first connect message.
-        if (message.advice) {
-            if (message.advice[@"reconnect"]) {
-                [self handleReconnectAdviceOfMessage:message];
-            }
+    // Deliver everything, which was collected while the frame was decoded
+    [self drainDeliveries];
+}
+
+- (void)handleMessage:(NSDictionary *)userInfo {
+    FYLog(@"handleResponse: %@", userInfo);
+    
+    // Box in message object to unserialize all fields
+    FYMessage *message = [[FYMessage alloc] initWithUserInfo:userInfo];
+    [self.metricsRecorder recordMessageOnChannel:message.channel];
+    
+    BOOL handled = NO;
+    
+    // Handle advice before handling meta channel message, so the retryTimeInterval can be modified before the
+    // handshake occurs which will schedule the first connect message.
+    if (message.advice) {
+        // Timeout and interval are needed for long-polling, regardless whether the message was successful
+        if (message.advice[@"timeout"]) {
+            self.advisedTimeout = [message.advice[@"timeout"] doubleValue] / 1000.0;
         }
-        
-        // Check if its a meta channel message, which must be handled.
-        for (NSString *channel in self.metaChannelActors) {
-            if ([channel isEqualToString:message.channel]) {
-                id<FYActor> actor = self.metaChannelActors[channel];
-                [actor client:self receivedMessage:message];
-                handled = YES;
-                break;
-            }
+        if (message.advice[@"interval"]) {
+            self.advisedPollInterval = [message.advice[@"interval"] doubleValue] / 1000.0;
         }
-        
-        if (!handled) {
-            if ([message.channel hasPrefix:@"/meta"]) {
-                // Unhandled meta channel
-                NSError *error = [NSError errorWithDomain:FYErrorDomain code:FYErrorUnhandledMetaChannelMessage userInfo:@{
-                    NSLocalizedDescriptionKey:        @"Unhandled meta channel message",
-                    NSLocalizedFailureReasonErrorKey: [NSString stringWithFormat:@"Unhandled meta channel message on "
-                                                       "channel '%@'.", message.channel],
-                 }];
-                [self.clientDelegateProxy client:self failedWithError:error];
-            } else if (self.channels[message.channel]) {
-                // User-defined channel
+        if (message.advice[@"reconnect"]) {
+            [self handleReconnectAdviceOfMessage:message];
+        }
+    }
+    
+    // Check if its a meta channel message, which must be handled.
+    for (NSString *channel in self.metaChannelActors) {
+        if ([channel isEqualToString:message.channel]) {
+            id<FYActor> actor = self.metaChannelActors[channel];
+            [actor client:self receivedMessage:message];
+            handled = YES;
+            break;
+        }
+    }
+    
+    if (!handled) {
+        if ([message.channel hasPrefix:@"/meta"]) {
+            // Unhandled meta channel
+            NSError *error = [NSError errorWithDomain:FYErrorDomain code:FYErrorUnhandledMetaChannelMessage userInfo:@{
+                NSLocalizedDescriptionKey:        @"Unhandled meta channel message",
+                NSLocalizedFailureReasonErrorKey: [NSString stringWithFormat:@"Unhandled meta channel message on "
+                                                   "channel '%@'.", message.channel],
+             }];
+            [self.clientDelegateProxy client:self failedWithError:error];
+        } else if (message.successful && message.fayeId && self.pendingPublishes[message.fayeId]) {
+            // Acknowledgement of a publish
+            [self client:self receivedPublishMessage:message];
+        } else {
+            // User-defined channel, matched by its name or by channel patterns
+            FYMessageTrace *trace = [self.messageTracer sampleMessageOnChannel:message.channel
+                                                                receivedUptime:self.frameReceivedUptime];
+            if (trace && self.clockOffsetEstimator.isOffsetEstimated) {
+                // Without a known offset, the difference of the clocks would be taken as latency
+                trace.serverTime = message.timeIntervalSince1970 - self.clockOffsetEstimator.offset;
+            }
+            BOOL routed = [self.channels enumerateObjectsMatchingChannel:message.channel
+                                                             usingBlock:^(NSString *pattern, FYMessageCallbackWrapper *wrapper) {
+                if (trace && trace.routedUptime == 0) {
+                    trace.routedUptime = NSProcessInfo.processInfo.systemUptime;
+                }
                 if (message.data) {
-                    FYMessageCallbackWrapper *wrapper = self.channels[message.channel];
-                    dispatch_async(self.callbackQueue, ^{
-                        wrapper.callback(message.data);
-                     });
+                    [self deliverPayload:message.data channel:message.channel pattern:pattern toWrapper:wrapper
+                                   trace:trace];
                 }
-            } else {
+             }];
+            
+            if (!routed) {
                 // Unexpected channel
                 [self.clientDelegateProxy client:self receivedUnexpectedMessage:message];
             }
@@ -941,6 +2413,204 @@ FYDefineDelegateProxy(SRWebSocketDelegate);
 }
 
 
+#pragma mark - Delivery of received messages
+
+- (void)deliverPayload:(NSDictionary *)payload channel:(NSString *)channel pattern:(NSString *)pattern
+             toWrapper:(FYMessageCallbackWrapper *)wrapper trace:(FYMessageTrace *)trace {
+    // Has to be called on workerQueue
+    FYMetricsRecorder *metricsRecorder = self.metricsRecorder;
+    [metricsRecorder recordCallbacksDispatched:1];
+    
+    // Traces of payloads, which are delivered with others, end with their routing
+    FYMessageTracer *messageTracer = self.messageTracer;
+    if (trace && (wrapper.deliveryQueues[pattern] || wrapper.batchCallback)) {
+        [messageTracer recordRoutedTrace:trace];
+    }
+    
+    FYDeliveryQueue *deliveryQueue = wrapper.deliveryQueues[pattern];
+    if (deliveryQueue) {
+        // Bounded delivery: the overflow policy decides, if this blocks or drops payloads
+        BOOL reachedHighWatermark = NO;
+        NSUInteger droppedCount = deliveryQueue.droppedCount;
+        if ([deliveryQueue enqueuePayload:payload channel:channel reachedHighWatermark:&reachedHighWatermark]) {
+            dispatch_async([self callbackQueueOfWrapper:wrapper], ^{
+                [self drainDeliveryQueue:deliveryQueue ofWrapper:wrapper];
+             });
+        }
+        [metricsRecorder recordCallbacksExecuted:deliveryQueue.droppedCount - droppedCount];
+        if (reachedHighWatermark) {
+            [self.clientDelegateProxy client:self deliveryQueueOfChannel:pattern
+                        reachedHighWatermark:deliveryQueue.options.highWatermark];
+        }
+    } else if (wrapper.batchCallback) {
+        if (!wrapper.pendingPayloads) {
+            wrapper.pendingPayloads = [NSMutableArray new];
+            [self.pendingBatchWrappers addObject:wrapper];
+        }
+        [wrapper.pendingPayloads addObject:payload];
+    } else if (self.deliversFramesInSingleDispatch && !wrapper.lane) {
+        [self.pendingCallbackWrappers addObject:wrapper];
+        [self.pendingCallbackPayloads addObject:payload];
+        [self.pendingCallbackTraces addObject:trace ?: (id)NSNull.null];
+    } else if (trace) {
+        dispatch_async([self callbackQueueOfWrapper:wrapper], ^{
+            NSTimeInterval startUptime = NSProcessInfo.processInfo.systemUptime;
+            wrapper.callback(payload);
+            [messageTracer recordTrace:trace callbackStartUptime:startUptime
+                     callbackEndUptime:NSProcessInfo.processInfo.systemUptime];
+            [metricsRecorder recordCallbacksExecuted:1];
+         });
+    } else {
+        dispatch_async([self callbackQueueOfWrapper:wrapper], ^{
+            wrapper.callback(payload);
+            [metricsRecorder recordCallbacksExecuted:1];
+         });
+    }
+}
+
+- (void)drainDeliveries {
+    // Has to be called on workerQueue
+    if (self.batchDeliveryTimeInterval > 0) {
+        // Batches are delivered after the time window, which starts with the first collected payload
+        if (self.pendingBatchWrappers.count > 0 && !self.isBatchDeliveryScheduled) {
+            self.batchDeliveryScheduled = YES;
+            [self performBlock:^(FYClient *client) {
+                client.batchDeliveryScheduled = NO;
+                [client drainBatchDeliveries];
+             } afterDelay:self.batchDeliveryTimeInterval];
+        }
+    } else {
+        [self drainBatchDeliveries];
+    }
+    
+    if (self.pendingCallbackWrappers.count == 0) {
+        return;
+    }
+    NSArray *wrappers = self.pendingCallbackWrappers;
+    NSArray *payloads = self.pendingCallbackPayloads;
+    NSArray *traces   = self.pendingCallbackTraces;
+    self.pendingCallbackWrappers = [NSMutableArray new];
+    self.pendingCallbackPayloads = [NSMutableArray new];
+    self.pendingCallbackTraces   = [NSMutableArray new];
+    
+    FYMetricsRecorder *metricsRecorder = self.metricsRecorder;
+    FYMessageTracer *messageTracer = self.messageTracer;
+    dispatch_async(self.callbackQueue, ^{
+        [wrappers enumerateObjectsUsingBlock:^(FYMessageCallbackWrapper *wrapper, NSUInteger idx, BOOL *stop) {
+            FYMessageTrace *trace = traces[idx];
+            if (trace != (id)NSNull.null) {
+                NSTimeInterval startUptime = NSProcessInfo.processInfo.systemUptime;
+                wrapper.callback(payloads[idx]);
+                [messageTracer recordTrace:trace callbackStartUptime:startUptime
+                         callbackEndUptime:NSProcessInfo.processInfo.systemUptime];
+            } else {
+                wrapper.callback(payloads[idx]);
+            }
+         }];
+        [metricsRecorder recordCallbacksExecuted:payloads.count];
+     });
+}
+
+- (void)drainDeliveryQueue:(FYDeliveryQueue *)deliveryQueue ofWrapper:(FYMessageCallbackWrapper *)wrapper {
+    // Has to be called on callbackQueue
+    NSArray *payloads = [deliveryQueue dequeueAllPayloads];
+    if (wrapper.batchCallback) {
+        if (payloads.count > 0) {
+            wrapper.batchCallback(payloads);
+        }
+    } else {
+        for (NSDictionary *payload in payloads) {
+            wrapper.callback(payload);
+        }
+    }
+    [deliveryQueue finishDelivery];
+    [self.metricsRecorder recordCallbacksExecuted:payloads.count];
+}
+
+- (void)drainBatchDeliveries {
+    // Has to be called on workerQueue
+    if (self.pendingBatchWrappers.count == 0) {
+        return;
+    }
+    
+    // Detach the collected payloads from their wrappers, so that further payloads are collected for the next batch
+    NSArray *wrappers = self.pendingBatchWrappers;
+    NSMutableArray *batches = [[NSMutableArray alloc] initWithCapacity:wrappers.count];
+    for (FYMessageCallbackWrapper *wrapper in wrappers) {
+        [batches addObject:wrapper.pendingPayloads];
+        wrapper.pendingPayloads = nil;
+    }
+    self.pendingBatchWrappers = [NSMutableArray new];
+    
+    // All batches are delivered in one dispatch on the callbackQueue, but batches for lanes on their own lane
+    FYMetricsRecorder *metricsRecorder = self.metricsRecorder;
+    NSMutableIndexSet *laneIndexes = [NSMutableIndexSet new];
+    [wrappers enumerateObjectsUsingBlock:^(FYMessageCallbackWrapper *wrapper, NSUInteger idx, BOOL *stop) {
+        if (wrapper.lane) {
+            NSArray *batch = batches[idx];
+            dispatch_async(wrapper.lane.queue, ^{
+                wrapper.batchCallback(batch);
+                [metricsRecorder recordCallbacksExecuted:batch.count];
+             });
+            [laneIndexes addIndex:idx];
+        }
+     }];
+    if (laneIndexes.count == wrappers.count) {
+        return;
+    }
+    dispatch_async(self.callbackQueue, ^{
+        [wrappers enumerateObjectsUsingBlock:^(FYMessageCallbackWrapper *wrapper, NSUInteger idx, BOOL *stop) {
+            if (![laneIndexes containsIndex:idx]) {
+                wrapper.batchCallback(batches[idx]);
+                [metricsRecorder recordCallbacksExecuted:[batches[idx] count]];
+            }
+         }];
+     });
+}
+
+- (FYCallbackLane *)callbackLaneNamed:(NSString *)name {
+    // Lanes are kept for the lifetime of the client, so that resubscriptions keep their order.
+    @synchronized(self.callbackLanes) {
+        FYCallbackLane *lane = self.callbackLanes[name];
+        if (!lane) {
+            lane = [[FYCallbackLane alloc] initWithName:name targetQueue:self.laneTargetQueue];
+            self.callbackLanes[name] = lane;
+        }
+        return lane;
+    }
+}
+
+- (dispatch_queue_t)callbackQueueOfWrapper:(FYMessageCallbackWrapper *)wrapper {
+    return wrapper.lane ? wrapper.lane.queue : self.callbackQueue;
+}
+
+
+#pragma mark - FYMessageDecoderDelegate's implementation
+
+- (BOOL)decoder:(FYMessageDecoder *)decoder shouldDecodePayloadOfChannel:(NSString *)channel {
+    // Payloads of messages on channels without subscriber are only needed, if the delegate wants to handle them.
+    if (!channel || [channel hasPrefix:@"/meta/"] || self.clientDelegateProxy.respondsToReceivedUnexpectedMessage) {
+        return YES;
+    }
+    return [self.channels hasObjectsMatchingChannel:channel];
+}
+
+- (BOOL)decoder:(FYMessageDecoder *)decoder shouldEmitMessageOfChannel:(NSString *)channel
+     responseId:(NSString *)responseId {
+    // Only asked for messages on user-defined channels nobody is subscribed to, which would end up as unexpected
+    // messages without a delegate to receive them. Only acknowledgements of publishes are still of interest.
+    if (responseId && self.pendingPublishes[responseId]) {
+        return YES;
+    }
+    [self.metricsRecorder recordSkippedMessageOnChannel:channel];
+    return NO;
+}
+
+- (void)decoder:(FYMessageDecoder *)decoder decodedMessage:(NSDictionary *)userInfo {
+    [self handleMessage:userInfo];
+}
+
+
 #pragma mark - Advice handlers
 
 - (void)handleReconnectAdviceOfMessage:(FYMessage *)message {
@@ -956,22 +2626,24 @@ FYDefineDelegateProxy(SRWebSocketDelegate);
         if (message.advice[@"interval"]) {
             // Interval is given in milliseconds, NSTimeInterval is in seconds.
             delay = [message.advice[@"interval"] doubleValue] / 1000.0;
+            self.advisedReconnectInterval = delay;
         }
         
-        // Let delegate implementation customize given delay
-        [self.clientDelegateProxy clientWasAdvisedToRetry:self retryInterval:&delay];
-        
-        if (delay == 0) {
-            self.retryTimeInterval = FYClientRetryTimeInterval;
-        } else {
-            self.retryTimeInterval = delay;
-        }
+        // Let delegate implementation customize given delay, without waiting on the delegateQueue
+        [self.clientDelegateProxy clientWasAdvisedToRetry:self retryInterval:delay replyOnQueue:self.workerQueue
+                                                    reply:^(NSTimeInterval interval) {
+            if (interval == 0) {
+                self.retryTimeInterval = FYClientRetryTimeInterval;
+            } else {
+                self.retryTimeInterval = interval;
+            }
+         }];
     } else if ([reconnectAdvice isEqualToString:@"handshake"]) {
-        BOOL retry = NO;
-        [self.clientDelegateProxy clientWasAdvisedToHandshake:self shouldRetry:&retry];
-        if (retry) {
-            [self handshake];
-        }
+        [self.clientDelegateProxy clientWasAdvisedToHandshake:self replyOnQueue:self.workerQueue reply:^(BOOL retry) {
+            if (retry) {
+                [self handshake];
+            }
+         }];
     } else if ([reconnectAdvice isEqualToString:@"none"]) {
         if ([message.subscription isEqualToString:@"connection"]) {
             self.state = FYClientStateDisconnected;
@@ -998,42 +2670,51 @@ FYDefineDelegateProxy(SRWebSocketDelegate);
             return;
         }
         
+        // Measure the latency of the connection type, which was used for the handshake
+        if (self.handshakeSentUptime > 0) {
+            NSTimeInterval roundTripTime = NSProcessInfo.processInfo.systemUptime - self.handshakeSentUptime;
+            [self.metricsRecorder recordHandshakeRoundTripTime:roundTripTime];
+            [self addLatencySample:roundTripTime forConnectionType:self.handshakeConnectionType];
+            self.handshakeSentUptime = 0;
+        }
+        [self addClockSampleWithServerTime:message.timeIntervalSince1970];
+        
         // Choose connection type based on responded supportedConnectionTypes.
-        NSMutableSet *commonSupportedConnectionTypes = [[NSMutableSet alloc] initWithArray:FYSupportedConnectionTypes()];
-        [commonSupportedConnectionTypes intersectsSet:[[NSSet alloc] initWithArray:message.supportedConnectionTypes]];
+        self.serverConnectionTypes = [[NSSet alloc] initWithArray:message.supportedConnectionTypes];
+        NSMutableSet *commonSupportedConnectionTypes = [[NSMutableSet alloc] initWithArray:self.connectionTypes];
+        [commonSupportedConnectionTypes intersectSet:self.serverConnectionTypes];
+        NSString *connectionType = [self preferredConnectionTypeOf:commonSupportedConnectionTypes];
         
-        if (!commonSupportedConnectionTypes.count > 0) {
+        if (!connectionType) {
             // No common supported connection type.
             NSError *error = [NSError errorWithDomain:FYErrorDomain code:FYErrorNoCommonSupportedConnectionType userInfo:@{
                 NSLocalizedDescriptionKey:        [NSString stringWithFormat:@"Error while trying to connect with host "
                                                    "%@.", self.baseURL.absoluteString],
                 NSLocalizedFailureReasonErrorKey: [NSString stringWithFormat:@"No common supported connection type. "
                                                    "Server supports the following: %@. Required was one of: %@.",
-                                                   message.supportedConnectionTypes, FYSupportedConnectionTypes()]
+                                                   message.supportedConnectionTypes, self.connectionTypes]
              }];
             [self.clientDelegateProxy client:self disconnectedWithMessage:message error:error];
             return;
         }
         
         self.state = FYClientStateConnecting;
+        self.connectionType = connectionType;
+        [self switchToPayloadEncoding:[self agreedPayloadEncodingOfMessage:message]];
         
-        if ([commonSupportedConnectionTypes containsObject:FYConnectionTypes.WebSocket]) {
-            self.connectionType = FYConnectionTypes.WebSocket;
-            if (self.webSocket.readyState == SR_OPEN) {
-                self.state = FYClientStateConnected;
-                
-                // Schedule the first keep-alive connect.
-                // DON'T send this immediately. This would cause (at least with Faye 0.8.9) an exceeding of the retry
-                // interval, which will cause a timeout/disconnet.
-                [self scheduleKeepAlive];
-            }
-        } else {
-            NSAssert(@"The implementation of %@ does not handle all of the supported connection types "
-                     "(FYSupportedConnectionTypes()=%@)!", NSStringFromSelector(_cmd), FYSupportedConnectionTypes());
-        }
-        
-        if (self.state == FYClientStateConnected) {
-            [self.clientDelegateProxy clientConnected:self];
+        if (self.isLongPolling) {
+            // The socket is not needed anymore
+            self.webSocket.delegate = nil;
+            [self.webSocket close];
+            self.webSocket = nil;
+            
+            // The first connect is sent immediately and held by the server.
+            [self establishSession];
+        } else if (self.webSocket.readyState == SR_OPEN) {
+            // Schedule the first keep-alive connect.
+            // DON'T send this immediately. This would cause (at least with Faye 0.8.9) an exceeding of the retry
+            // interval, which will cause a timeout/disconnet.
+            [self establishSession];
         }
     } else {
         // Handshake failed.
@@ -1050,6 +2731,15 @@ FYDefineDelegateProxy(SRWebSocketDelegate);
     if ([message.successful boolValue]) {
         FYLog(@"Received successful connect at: %.3f.", [NSDate.date timeIntervalSince1970]);
         
+        if (self.connectSentUptime > 0) {
+            NSTimeInterval roundTripTime = NSProcessInfo.processInfo.systemUptime - self.connectSentUptime;
+            [self.metricsRecorder recordConnectRoundTripTime:roundTripTime];
+            self.connectSentUptime = 0;
+        }
+        
+        // Only the round trip of the first connect is sampled, whose response was not held
+        [self addClockSampleWithServerTime:message.timeIntervalSince1970];
+        
         if (self.state != FYClientStateConnected) { // TODO: This will never be true!
             // Initial connect.
             if (!self.awaitOnlyHandshake) {
@@ -1076,6 +2766,13 @@ FYDefineDelegateProxy(SRWebSocketDelegate);
     if ([message.successful boolValue]) {
         self.state = FYClientStateDisconnected;
         [self closeSocketConnection];
+        [self.httpTransport cancel];
+        
+        // The session is gone, so neither sent nor deferred publishes will be acknowledged
+        [self failPendingPublishesWithError:[NSError errorWithDomain:FYErrorDomain code:FYErrorPublishInterrupted userInfo:@{
+             NSLocalizedDescriptionKey: @"The client was disconnected before the publish was acknowledged.",
+         }]];
+        [self dropOfflinePublishes];
         [self.clientDelegateProxy client:self disconnectedWithMessage:message error:nil];
     } else {
         // Disconnection failed.
@@ -1089,41 +2786,102 @@ FYDefineDelegateProxy(SRWebSocketDelegate);
 }
 
 - (void)client:(FYClient *)client receivedSubscribeMessage:(FYMessage *)message {
+    // Batched subscriptions are answered with an array of channels
+    id subscription = message.userInfo[@"subscription"];
+    NSArray *channels = [subscription isKindOfClass:NSArray.class] ? subscription : @[subscription ?: @""];
+    
     if ([message.successful boolValue]) {
-        [self.clientDelegateProxy client:self subscriptionSucceedToChannel:message.subscription];
+        for (NSString *channel in channels) {
+            [self.subscriptionReconciler confirmSubscriptionOfChannel:channel];
+            [self.clientDelegateProxy client:self subscriptionSucceedToChannel:channel];
+        }
     } else {
         // Subscription failed.
-        NSError *error = [NSError errorWithDomain:FYErrorDomain code:FYErrorSubscribeFailed userInfo:@{
-            NSLocalizedDescriptionKey:        [NSString stringWithFormat:@"Error subscribing to channel '%@'.",
-                                               message.subscription],
-            NSLocalizedFailureReasonErrorKey: message.error ?: @"Unknown",
-         }];
-        [self.clientDelegateProxy client:self failedWithError:error];
+        for (NSString *channel in channels) {
+            [self.subscriptionReconciler failSubscriptionOfChannel:channel];
+            NSError *error = [NSError errorWithDomain:FYErrorDomain code:FYErrorSubscribeFailed userInfo:@{
+                NSLocalizedDescriptionKey:        [NSString stringWithFormat:@"Error subscribing to channel '%@'.",
+                                                   channel],
+                NSLocalizedFailureReasonErrorKey: message.error ?: @"Unknown",
+             }];
+            [self.clientDelegateProxy client:self failedWithError:error];
+        }
     }
+    
+    // Changes made while the request was in flight
+    [self scheduleSubscriptionFlush];
 }
 
 - (void)client:(FYClient *)client receivedUnsubscribeMessage:(FYMessage *)message {
+    id subscription = message.userInfo[@"subscription"];
+    NSArray *channels = [subscription isKindOfClass:NSArray.class] ? subscription : @[subscription ?: @""];
+    
     if ([message.successful boolValue]) {
-        [self.channels removeObjectForKey:message.subscription];
+        for (NSString *channel in channels) {
+            [self.subscriptionReconciler confirmUnsubscriptionOfChannel:channel];
+        }
     } else {
         // Unsubscription failed.
-        NSError *error = [NSError errorWithDomain:FYErrorDomain code:FYErrorUnsubscribeFailed userInfo:@{
-            NSLocalizedDescriptionKey:        [NSString stringWithFormat:@"Error unsubscribing from channel '%@'.",
-                                               message.subscription],
+        for (NSString *channel in channels) {
+            [self.subscriptionReconciler failUnsubscriptionOfChannel:channel];
+            NSError *error = [NSError errorWithDomain:FYErrorDomain code:FYErrorUnsubscribeFailed userInfo:@{
+                NSLocalizedDescriptionKey:        [NSString stringWithFormat:@"Error unsubscribing from channel '%@'.",
+                                                   channel],
+                NSLocalizedFailureReasonErrorKey: message.error ?: @"Unknown",
+             }];
+            [self.clientDelegateProxy client:self failedWithError:error];
+        }
+    }
+    
+    // Changes made while the request was in flight
+    [self scheduleSubscriptionFlush];
+}
+
+- (void)client:(FYClient *)client receivedPublishMessage:(FYMessage *)message {
+    FYPendingPublish *publish = self.pendingPublishes[message.fayeId];
+    [self.pendingPublishes removeObjectForKey:message.fayeId];
+    
+    // Smooth the acknowledgement latency like TCP smoothes its round trip time
+    NSTimeInterval latency = NSProcessInfo.processInfo.systemUptime - publish.sentUptime;
+    if (self.publishLatency == 0) {
+        self.publishLatency = latency;
+    } else {
+        self.publishLatency += (latency - self.publishLatency) / 8;
+    }
+    [self addLatencySample:latency forConnectionType:self.connectionType];
+    
+    if ([message.successful boolValue]) {
+        [self finishPendingPublish:publish withError:nil];
+    } else {
+        // Publish failed.
+        NSError *error = [NSError errorWithDomain:FYErrorDomain code:FYErrorPublishFailed userInfo:@{
+            NSLocalizedDescriptionKey:        [NSString stringWithFormat:@"Error publishing to channel '%@'.",
+                                               message.channel],
             NSLocalizedFailureReasonErrorKey: message.error ?: @"Unknown",
          }];
-        [self.clientDelegateProxy client:self failedWithError:error];
+        [self finishPendingPublish:publish withError:error];
     }
+    
+    // A slot in the window of unacknowledged publishes was freed
+    [self sendDeferredPublishes];
 }
 
 
-#pragma mark - JSON serialization & deserialization
-
-- (NSString *)stringBySerializingObject:(NSObject *)object {
-    return [[NSString alloc] initWithData:[self dataBySerializingObject:object] encoding:NSUTF8StringEncoding];
-}
+#pragma mark - Serialization
 
 - (NSData *)dataBySerializingObject:(NSObject *)object {
+    if (self.sendsPackedMessages) {
+        NSData *data = [FYMessagePack dataWithObject:object];
+        if (!data) {
+            // Object data was malformed.
+            NSError *fyError = [NSError errorWithDomain:FYErrorDomain code:FYErrorMalformedObjectData userInfo:@{
+                 NSLocalizedDescriptionKey: @"Can't serialize malformed data.",
+             }];
+            [self.clientDelegateProxy client:self failedWithError:fyError];
+        }
+        return data;
+    }
+    
     NSError *error = nil;
     NSJSONWritingOptions options = 0;
     #ifdef FYDebug
@@ -1142,27 +2900,6 @@ FYDefineDelegateProxy(SRWebSocketDelegate);
     return data;
 }
 
-- (id)deserializeString:(NSString *)string {
-    NSData *data = [string dataUsingEncoding:NSUTF8StringEncoding];
-    return [self deserializeData:data];
-}
-
-- (id)deserializeData:(NSData *)data {
-    NSError *error = nil;
-    id result = [NSJSONSerialization JSONObjectWithData:data options:NSJSONReadingAllowFragments error:&error];
-    if (error) {
-        // JSON string was malformed.
-        NSError *fyError = [NSError errorWithDomain:FYErrorDomain code:FYErrorMalformedJSONData userInfo:@{
-             NSLocalizedDescriptionKey: @"JSON data is malformed.",
-             NSUnderlyingErrorKey:      error,
-         }];
-        [self.clientDelegateProxy client:self failedWithError:fyError];
-        return nil;
-    } else {
-        return result;
-    }
-}
-
 
 #pragma mark - Generic helper
 
@@ -1174,6 +2911,20 @@ FYDefineDelegateProxy(SRWebSocketDelegate);
      });
 }
 
+- (FYTimer *)scheduleTimerWithDelay:(NSTimeInterval)delay block:(void(^)(FYClient *))block {
+    // Long delays of many clients are served by the shared wheel instead of an own dispatch source each
+    __weak FYClient *this = self;
+    return [FYTimerWheel.sharedTimerWheel scheduleTimerWithDelay:delay queue:self.workerQueue block:^{
+        block(this);
+     }];
+}
+
+- (void)scheduleReconnectUsingBlock:(void(^)(FYClient *))block {
+    // Has to be called on workerQueue. Only one reconnect is outstanding, the later one wins.
+    [self.reconnectTimer cancel];
+    self.reconnectTimer = [self scheduleTimerWithDelay:self.nextReconnectDelay block:block];
+}
+
 - (void)chainActorForMetaChannel:(NSString *)channel onceWithActorBlock:(FYActorBlock)block {
     self.metaChannelActors[channel] = [FYBlockActor chain:self.metaChannelActors[channel]
                                                      once:block
@@ -37,9 +37,9 @@
  The `FYClientDelegate` protocol is used to receive state information and intercept methods.
  All defined messages are optional to implement.
  
- In the internal used `FYDelegateProxy` the messages are invocated on the real delegate using
- <NSInvocation>. So it will in case of extension not possible to grasp the return value of
- non-void messages. Therefore `inout`-pointers are used.
+ In the internal used `FYDelegateProxy` the messages are dispatched asynchronously on the delegate queue.
+ So it will in case of extension not possible to grasp the return value of non-void messages. Therefore
+ `inout`-pointers are used. Messages with `inout`-pointers are dispatched synchronously.
  */
 @protocol FYClientDelegate<NSObject>
 
@@ -79,6 +79,21 @@
  */
 - (void)client:(FYClient *)client receivedUnexpectedMessage:(FYMessage *)message;
 
+/**
+ The delivery queue of a channel reached its high watermark.
+ 
+ This is sent when a subscription with a [highWatermark]([FYSubscriptionOptions highWatermark]) has queued as many
+ messages, which were not consumed yet by its callback. It is sent again, after the queue was drained. Use this to
+ detect slow callbacks.
+ 
+ @param client    The client, which queued the messages.
+ 
+ @param channel   The channel name or channel pattern as given on subscription.
+ 
+ @param count     Count of queued messages.
+ */
+- (void)client:(FYClient *)client deliveryQueueOfChannel:(NSString *)channel reachedHighWatermark:(NSUInteger)count;
+
 /**
  The client was disconnected.
  
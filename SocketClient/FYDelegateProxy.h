@@ -31,41 +31,15 @@
 
 
 /**
- Define a concrete FYDelegateProxy subclass.
+ An instance of a FYDelegateProxy subclass is used internally in FYClient to dispatch calls to its
+ [delegate]([FYClient delegate]).
  
- The subclass will be named: DelegateProtocol##Proxy.
- 
- The subclass implements the given protocol and forces it's proxiedObject to do the same. You will profit from using
- this macro with compile-time type safety and no warnings because of unimplemented, but required methods.
- 
- This macro is only to use in implementation files.
- */
-#define FYDefineDelegateProxy(DelegateProtocol) \
-    FYInterfaceDelegateProxy(DelegateProtocol)\
-    FYImplementDelegateProxy(DelegateProtocol) \
-
-#define FYInterfaceDelegateProxy(DelegateProtocol) \
-    @interface DelegateProtocol##Proxy : FYDelegateProxy <DelegateProtocol> \
-    @property (nonatomic, weak) id<NSObject,DelegateProtocol> proxiedObject; \
-    @end \
-
-#define FYImplementDelegateProxy(DelegateProtocol) \
-    _Pragma("clang diagnostic push") \
-    _Pragma("clang diagnostic ignored \"-Wprotocol\"") \
-    _Pragma("clang diagnostic ignored \"-Wincomplete-implementation\"") \
-    @implementation DelegateProtocol##Proxy \
-    @end \
-    _Pragma("clang diagnostic pop")
-
-
-/**
- An instance of FYDelegateProxy is used internally in FYClient to dispatch calls to its [delegate]([FYClient delegate]).
- 
- A `NSProxy` subclass `FYDelegateProxy` is used in `FYClient` as property [delegateProxy]([FYClient delegateProxy]) to
- dispatch calls to the delegate property. This is used to don't have to think about non-implemented optional protocol
- methods. All declared selectors could be invoked and are forwared to the real delegate implementation stored in
- `proxiedObject` property of `FYDelegateProxy`. So the getter and setter implementation of the property `delegate` of
- `FYClient` have to return / mutate ```self.clientDelegateProxy.proxiedObject```.
+ A FYDelegateProxy subclass `FYClientDelegateProxy` is used in `FYClient` as property
+ [delegateProxy]([FYClient delegateProxy]) to dispatch calls to the delegate property. This is used to don't have to
+ think about non-implemented optional protocol methods. All declared selectors could be invoked and are forwared to the
+ real delegate implementation stored in `proxiedObject` property of `FYDelegateProxy`. So the getter and setter
+ implementation of the property `delegate` of `FYClient` have to return / mutate
+ ```self.clientDelegateProxy.proxiedObject```.
  
  So instead of writing a lot of repeative code like:
  
@@ -77,9 +51,11 @@
  
     [self.clientDelegateProxy client:self didFoo:foo];
  
- This won't raise any "selector not found" exception, if this selector is optional and not implemented.
+ Subclasses implement the proxied protocol explicitly. They cache which methods are implemented by the proxied object,
+ when it is set, by overriding proxiedObjectDidChange, so that a call to a non-implemented method costs only a flag
+ test and no message forwarding, allocation or dispatch at all.
  */
-@interface FYDelegateProxy : NSProxy
+@interface FYDelegateProxy : NSObject
 
 /**
  Factory method for main queue delegate proxy.
@@ -96,4 +72,33 @@
  */
 @property (nonatomic, weak) id<NSObject> proxiedObject;
 
+/**
+ Called after proxiedObject was set. Subclasses should cache here which methods are implemented by the proxied object.
+ */
+- (void)proxiedObjectDidChange;
+
+/**
+ Execute a block asynchronously on delegateQueue with the proxied object.
+ 
+ The block is not executed, if the proxied object was released in the meanwhile.
+ 
+ @param  block  Block, which calls the proxied object.
+ */
+- (void)dispatchAsync:(void(^)(id proxiedObject))block;
+
+/**
+ Execute a block asynchronously on delegateQueue with the proxied object, and then a reply on another queue. This is
+ used for methods with `inout`-pointer arguments, whose results are needed by the caller, without blocking the
+ caller's queue on delegateQueue.
+ 
+ The reply is executed in any case, even if the proxied object was released in the meanwhile.
+ 
+ @param  block  Block, which calls the proxied object.
+ 
+ @param  queue  Queue, on which the reply is executed.
+ 
+ @param  reply  Block, which takes the results of the call.
+ */
+- (void)dispatchAsync:(void(^)(id proxiedObject))block replyOnQueue:(dispatch_queue_t)queue reply:(dispatch_block_t)reply;
+
 @end
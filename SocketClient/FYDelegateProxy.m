@@ -34,42 +34,57 @@
 @implementation FYDelegateProxy
 
 + (instancetype)new {
-    FYDelegateProxy *proxy = [self alloc];
+    FYDelegateProxy *proxy = [[self alloc] init];
     proxy.delegateQueue = dispatch_get_main_queue();
     return proxy;
 }
 
-- (NSMethodSignature*)methodSignatureForSelector:(SEL)selector {
-	NSMethodSignature *signature = [_proxiedObject.class instanceMethodSignatureForSelector:selector];
-	if (!signature) {
-        // methodSignatureForSelector: is called when a compiled definition for the selector cannot be found.
-        // If this method returns nil, a "selector not found" exception is raised.
-        // The string argument to signatureWithObjCTypes: outlines the return type and arguments to the message.
-        // To return a dud `NSMethodSignature`, pretty much any signature will suffice. Since the forwardInvocation:
-        // call will do nothing if the delegate does not respond to the selector, the dud `NSMethodSignature` simply
-        // gets us around the exception.
-        // @see http://borkware.com/rants/agentm/elegant-delegation/
-		signature = [NSMethodSignature signatureWithObjCTypes:"@^v^c"];
-	}
-	return signature;
+- (void)dealloc {
+    self.delegateQueue = nil;
 }
 
-- (void)forwardInvocation:(NSInvocation*)invocation {
-    // Because there seems a delay when dispatching invocations asynchronically by using GCD, the arguments need to be
-    // retained manually so that they don't get released before the invocation was forwarded. This would cause otherwise
-    // an EXC_BAD_ACCESS(code=2). This could also occur if you are debugging with breakpoints...
-    [invocation retainArguments];
-    
-    FYLog(@"[%@] %@", self.class, NSStringFromSelector(invocation.selector));
-    
-    if ([_proxiedObject respondsToSelector:invocation.selector]) {
-        if (_delegateQueue) {
-            dispatch_async(_delegateQueue, ^{
-                [invocation invokeWithTarget:self.proxiedObject];
-             });
-        } else {
-            [invocation invokeWithTarget:self.proxiedObject];
+- (void)setProxiedObject:(id<NSObject>)proxiedObject {
+    _proxiedObject = proxiedObject;
+    [self proxiedObjectDidChange];
+}
+
+- (void)proxiedObjectDidChange {
+    // Implemented by subclasses
+}
+
+- (void)dispatchAsync:(void(^)(id proxiedObject))block {
+    if (_delegateQueue) {
+        __weak id<NSObject> weakProxiedObject = _proxiedObject;
+        dispatch_async(_delegateQueue, ^{
+            id<NSObject> proxiedObject = weakProxiedObject;
+            if (proxiedObject) {
+                block(proxiedObject);
+            }
+         });
+    } else {
+        id<NSObject> proxiedObject = _proxiedObject;
+        if (proxiedObject) {
+            block(proxiedObject);
+        }
+    }
+}
+
+- (void)dispatchAsync:(void(^)(id proxiedObject))block replyOnQueue:(dispatch_queue_t)queue reply:(dispatch_block_t)reply {
+    if (_delegateQueue) {
+        __weak id<NSObject> weakProxiedObject = _proxiedObject;
+        dispatch_async(_delegateQueue, ^{
+            id<NSObject> proxiedObject = weakProxiedObject;
+            if (proxiedObject) {
+                block(proxiedObject);
+            }
+            dispatch_async(queue, reply);
+         });
+    } else {
+        id<NSObject> proxiedObject = _proxiedObject;
+        if (proxiedObject) {
+            block(proxiedObject);
         }
+        reply();
     }
 }
 
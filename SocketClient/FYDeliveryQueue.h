@@ -0,0 +1,89 @@
+//
+//  FYDeliveryQueue.h
+//  SocketClient
+//
+//  Created by agent on 17.10.26.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+#import "FYSubscriptionOptions.h"
+
+
+/**
+ A bounded queue of received payloads, which were not delivered yet to the callback of a subscribed channel.
+ 
+ Payloads are enqueued on the workerQueue and dequeued by drains on the callbackQueue. The queue is thread-safe.
+ */
+@interface FYDeliveryQueue : NSObject
+
+/**
+ Options, which configure capacity, overflow policy and high watermark.
+ */
+@property (nonatomic, copy, readonly) FYSubscriptionOptions *options;
+
+/**
+ Count of queued payloads.
+ */
+@property (nonatomic, assign, readonly) NSUInteger count;
+
+/**
+ Count of payloads, which were dropped by the overflow policy.
+ */
+@property (nonatomic, assign, readonly) NSUInteger droppedCount;
+
+/**
+ Initializer
+ 
+ @param  options  Options of the subscription.
+ */
+- (id)initWithOptions:(FYSubscriptionOptions *)options;
+
+/**
+ Append a payload and apply the overflow policy. With FYDeliveryOverflowPolicyBlock, this blocks the calling thread
+ until a drain made room.
+ 
+ @param  payload                The payload of a received message.
+ 
+ @param  channel                The channel on which the message was received.
+ 
+ @param  reachedHighWatermark   Is set to YES, if the queue reached its high watermark by this payload.
+ 
+ @return YES, if a drain has to be scheduled by the caller.
+ */
+- (BOOL)enqueuePayload:(NSDictionary *)payload channel:(NSString *)channel reachedHighWatermark:(BOOL *)reachedHighWatermark;
+
+/**
+ Remove all queued payloads for delivery. finishDelivery has to be called after they were delivered.
+ 
+ @return The removed payloads in the order they were queued.
+ */
+- (NSArray *)dequeueAllPayloads;
+
+/**
+ Mark the payloads of the last dequeueAllPayloads as delivered, which unblocks waiting enqueues.
+ */
+- (void)finishDelivery;
+
+@end
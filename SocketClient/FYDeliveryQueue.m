@@ -0,0 +1,137 @@
+//
+//  FYDeliveryQueue.m
+//  SocketClient
+//
+//  Created by agent on 17.10.26.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "FYDeliveryQueue.h"
+#import "FYOfflineQueue.h"
+
+
+@interface FYDeliveryQueue ()
+
+@property (nonatomic, copy, readwrite) FYSubscriptionOptions *options;
+@property (nonatomic, assign, readwrite) NSUInteger droppedCount;
+
+// Payloads and their accounting, guarded by the condition's lock
+@property (nonatomic, retain) FYOfflineQueue *queue;
+@property (nonatomic, retain) NSCondition *condition;
+@property (nonatomic, assign) NSUInteger deliveringCount;
+@property (nonatomic, assign, getter=isDrainScheduled) BOOL drainScheduled;
+@property (nonatomic, assign, getter=isHighWatermarkReached) BOOL highWatermarkReached;
+
+@end
+
+
+@implementation FYDeliveryQueue
+
+- (id)initWithOptions:(FYSubscriptionOptions *)options {
+    self = [super init];
+    if (self) {
+        self.options = options;
+        self.condition = [NSCondition new];
+        self.queue = [FYOfflineQueue new];
+        
+        // Blocking is done by the delivery queue itself, so the underlying queue is unbounded for this policy.
+        switch (options.overflowPolicy) {
+            case FYDeliveryOverflowPolicyBlock:
+                self.queue.maximumCount = 0;
+                break;
+            case FYDeliveryOverflowPolicyDropOldest:
+                self.queue.maximumCount = options.capacity;
+                self.queue.overflowPolicy = FYOfflineQueueOverflowPolicyDropOldest;
+                break;
+            case FYDeliveryOverflowPolicyConflate:
+                self.queue.maximumCount = options.capacity;
+                self.queue.overflowPolicy = FYOfflineQueueOverflowPolicyCoalesceByKey;
+                break;
+        }
+    }
+    return self;
+}
+
+- (NSUInteger)count {
+    [self.condition lock];
+    NSUInteger count = self.queue.count;
+    [self.condition unlock];
+    return count;
+}
+
+- (BOOL)enqueuePayload:(NSDictionary *)payload channel:(NSString *)channel reachedHighWatermark:(BOOL *)reachedHighWatermark {
+    NSString *key = nil;
+    if (self.options.overflowPolicy == FYDeliveryOverflowPolicyConflate) {
+        id value = self.options.conflationKey ? payload[self.options.conflationKey] : nil;
+        key = value ? [channel stringByAppendingFormat:@"\n%@", value] : channel;
+    }
+    
+    [self.condition lock];
+    
+    if (self.options.overflowPolicy == FYDeliveryOverflowPolicyBlock && self.options.capacity > 0) {
+        // A drain is always scheduled while the queue is full, so this wait will end.
+        while (self.queue.count + self.deliveringCount >= self.options.capacity) {
+            [self.condition wait];
+        }
+    }
+    
+    // The size isn't limited, so it isn't accounted
+    NSArray *droppedPayloads = [self.queue enqueueObject:payload size:0 key:key];
+    self.droppedCount += droppedPayloads.count;
+    
+    if (reachedHighWatermark) {
+        *reachedHighWatermark = NO;
+        if (self.options.highWatermark > 0 && !self.isHighWatermarkReached
+            && self.queue.count >= self.options.highWatermark) {
+            self.highWatermarkReached = YES;
+            *reachedHighWatermark = YES;
+        }
+    }
+    
+    BOOL shouldScheduleDrain = !self.isDrainScheduled;
+    self.drainScheduled = YES;
+    
+    [self.condition unlock];
+    
+    return shouldScheduleDrain;
+}
+
+- (NSArray *)dequeueAllPayloads {
+    [self.condition lock];
+    NSArray *payloads = [self.queue dequeueAllObjects];
+    self.deliveringCount = payloads.count;
+    self.drainScheduled = NO;
+    self.highWatermarkReached = NO;
+    [self.condition unlock];
+    return payloads;
+}
+
+- (void)finishDelivery {
+    [self.condition lock];
+    self.deliveringCount = 0;
+    [self.condition broadcast];
+    [self.condition unlock];
+}
+
+@end
@@ -84,6 +84,12 @@ typedef NS_ENUM(NSInteger, FYErrorCode) {
     /// The socket connection is not opened, but required to be open.
     FYErrorSocketNotOpen = FYErrorGroupWebSocket | 2,
     
+    /// A received message couldn't be decompressed by the negotiated permessage-deflate extension.
+    FYErrorSocketDecompressionFailed = FYErrorGroupWebSocket | 3,
+    
+    /// Queued messages couldn't be joined to one frame, e.g. because memory ran out.
+    FYErrorSocketFramingFailed = FYErrorGroupWebSocket | 4,
+    
     
     /// The HTTP request returned with an unexpected status code.
     FYErrorHTTPUnexpectedStatusCode = FYErrorGroupHTTP | 1,
@@ -95,6 +101,9 @@ typedef NS_ENUM(NSInteger, FYErrorCode) {
     /// The received JSON response was malformed. (deserialization)
     FYErrorMalformedJSONData = FYErrorGroupJSON | 2,
     
+    /// The received MessagePack response was malformed. (deserialization of the binary payload encoding)
+    FYErrorMalformedMessagePackData = FYErrorGroupJSON | 3,
+    
     
     /// The client received an unhandled meta channel message.
     FYErrorUnhandledMetaChannelMessage = FYErrorGroupBayeux | 1,
@@ -117,6 +126,18 @@ typedef NS_ENUM(NSInteger, FYErrorCode) {
     /// The channel unsubscribe failed.
     FYErrorUnsubscribeFailed = FYErrorGroupBayeux | 60,
     
+    /// The publish was not acknowledged as successful by the server.
+    FYErrorPublishFailed = FYErrorGroupBayeux | 70,
+    
+    /// The publish was not acknowledged by the server in time.
+    FYErrorPublishTimedOut = FYErrorPublishFailed | 1,
+    
+    /// The connection was reset before the publish was acknowledged by the server.
+    FYErrorPublishInterrupted = FYErrorPublishFailed | 2,
+    
+    /// The publish was dropped from the offline queue by its overflow policy or by a disconnect.
+    FYErrorPublishDropped = FYErrorPublishFailed | 3,
+    
     
     /// The server send advice 'reconnect' with value 'none'.
     FYErrorReceivedAdviceReconnectTypeNone = FYErrorGroupBayeuxAdvice | 7,
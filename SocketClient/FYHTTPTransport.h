@@ -0,0 +1,131 @@
+//
+//  FYHTTPTransport.h
+//  SocketClient
+//
+//  Created by agent on 17.10.26.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+
+@class FYHTTPTransport;
+
+
+/**
+ The `FYHTTPTransport` protocol is used by <FYHTTPTransport> to emit complete responses and errors.
+ */
+@protocol FYHTTPTransportDelegate <NSObject>
+
+/**
+ A response was received completely.
+ 
+ @param transport  The transport which received the response.
+ 
+ @param data       The complete body of the response, which is a JSON array of messages.
+ */
+- (void)transport:(FYHTTPTransport *)transport receivedData:(NSData *)data;
+
+/**
+ A request failed, either on the connection or with an unexpected status code.
+ 
+ @param transport  The transport whose request failed.
+ 
+ @param error      An error object describing what was going wrong.
+ */
+- (void)transport:(FYHTTPTransport *)transport failedWithError:(NSError *)error;
+
+@end
+
+
+/**
+ Sends Bayeux messages by HTTP POST requests without involving any run loop.
+ 
+ The transport limits itself to a small count of concurrent requests, so that the underlying keep-alive connections are
+ reused. Messages, which are sent while all connections are busy, are queued and coalesced into one POST request, as
+ soon as a connection becomes available. Responses are buffered until they were received completely.
+ 
+ All methods have to be called on the queue given on initialization, and delegate calls are executed on this queue.
+ */
+@interface FYHTTPTransport : NSObject
+
+/**
+ URL to which messages are posted.
+ */
+@property (nonatomic, retain, readonly) NSURL *URL;
+
+/**
+ Delegate to emit responses and errors to.
+ */
+@property (nonatomic, weak) id<FYHTTPTransportDelegate> delegate;
+
+/**
+ Maximum count of concurrent requests. Default is 2, as recommended by RFC 2616 for persistent connections.
+ */
+@property (nonatomic, assign) NSUInteger maximumConnectionCount;
+
+/**
+ Count of requests, which are currently running, without the poll request.
+ */
+@property (nonatomic, assign, readonly) NSUInteger activeConnectionCount;
+
+/**
+ Check if a poll request is currently running.
+ */
+@property (nonatomic, assign, readonly, getter=isPolling) BOOL polling;
+
+/**
+ Initializer
+ 
+ @param URL    URL to which messages are posted.
+ 
+ @param queue  Serial queue on which the transport is used and on which delegate calls are executed.
+ */
+- (id)initWithURL:(NSURL *)URL queue:(dispatch_queue_t)queue;
+
+/**
+ Send a message with the next request.
+ 
+ @param message  The UTF-8 encoded JSON object of a message.
+ */
+- (void)sendMessage:(NSData *)message;
+
+/**
+ Send a message, which is held by the server until it has messages to deliver, e.g. a long-polling /meta/connect.
+ 
+ The message is sent immediately in an own request, which doesn't count against maximumConnectionCount, so that
+ further messages are pipelined alongside on the other connections.
+ 
+ @param message          The UTF-8 encoded JSON object of a message.
+ 
+ @param timeoutInterval  Time interval in seconds, after which the request fails, if no response was received.
+ */
+- (void)pollWithMessage:(NSData *)message timeoutInterval:(NSTimeInterval)timeoutInterval;
+
+/**
+ Cancel all running requests and drop all queued messages.
+ */
+- (void)cancel;
+
+@end
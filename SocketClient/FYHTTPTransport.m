@@ -0,0 +1,236 @@
+//
+//  FYHTTPTransport.m
+//  SocketClient
+//
+//  Created by agent on 17.10.26.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "FYHTTPTransport.h"
+#import "FYError.h"
+#import "SocketClient_Private.h"
+
+
+@class FYHTTPTransportRequest;
+
+
+@interface FYHTTPTransport ()
+
+@property (nonatomic, retain, readwrite) NSURL *URL;
+@property (nonatomic) dispatch_queue_t queue;
+@property (nonatomic, retain) NSOperationQueue *connectionQueue;
+@property (nonatomic, retain) NSMutableArray *queuedMessages;
+@property (nonatomic, retain) NSMutableSet *requests;
+@property (nonatomic, retain) FYHTTPTransportRequest *pollRequest;
+
+- (void)sendQueuedMessages;
+- (FYHTTPTransportRequest *)startRequestWithMessages:(NSArray *)messages timeoutInterval:(NSTimeInterval)timeoutInterval;
+- (void)requestFinished:(FYHTTPTransportRequest *)request withData:(NSData *)data error:(NSError *)error;
+
+@end
+
+
+/*
+ Delegate of one NSURLConnection, which buffers the response
+ */
+@interface FYHTTPTransportRequest : NSObject <NSURLConnectionDataDelegate>
+
+@property (nonatomic, weak) FYHTTPTransport *transport;
+@property (nonatomic, retain) NSURLConnection *connection;
+@property (nonatomic, retain) NSHTTPURLResponse *response;
+@property (nonatomic, retain) NSMutableData *data;
+
+@end
+
+
+@implementation FYHTTPTransportRequest
+
+- (void)connection:(NSURLConnection *)connection didReceiveResponse:(NSURLResponse *)response {
+    NSAssert([response isKindOfClass:NSHTTPURLResponse.class], @"Expected only HTTP responses!");
+    self.response = (NSHTTPURLResponse *)response;
+    
+    // Chunked responses have no expected content length
+    long long length = response.expectedContentLength;
+    self.data = [[NSMutableData alloc] initWithCapacity:length > 0 ? (NSUInteger)length : 0];
+}
+
+- (void)connection:(NSURLConnection *)connection didReceiveData:(NSData *)data {
+    [self.data appendData:data];
+}
+
+- (void)connectionDidFinishLoading:(NSURLConnection *)connection {
+    NSError *error;
+    if (self.response.statusCode != 200) {
+        NSString *content = [[NSString alloc] initWithData:self.data encoding:NSUTF8StringEncoding];
+        error = [NSError errorWithDomain:FYErrorDomain code:FYErrorHTTPUnexpectedStatusCode userInfo:@{
+            NSLocalizedDescriptionKey:        @"The HTTP request returned with an unexpected status code.",
+            NSLocalizedFailureReasonErrorKey: [NSString stringWithFormat:@"Received unexpected response with "
+                                               "status code %d with content: %@.", (int)self.response.statusCode, content]
+         }];
+    }
+    [self.transport requestFinished:self withData:error ? nil : self.data error:error];
+}
+
+- (void)connection:(NSURLConnection *)connection didFailWithError:(NSError *)error {
+    [self.transport requestFinished:self withData:nil error:error];
+}
+
+@end
+
+
+@implementation FYHTTPTransport
+
+- (id)initWithURL:(NSURL *)URL queue:(dispatch_queue_t)queue {
+    self = [super init];
+    if (self) {
+        self.URL = URL;
+        self.queue = queue;
+        fy_dispatch_retain(queue);
+        self.maximumConnectionCount = 2;
+        self.queuedMessages = [NSMutableArray new];
+        self.requests = [NSMutableSet new];
+        
+        // Connection callbacks are executed on this queue instead of a run loop, and are forwarded to our queue.
+        self.connectionQueue = [NSOperationQueue new];
+        self.connectionQueue.maxConcurrentOperationCount = 1;
+    }
+    return self;
+}
+
+- (void)dealloc {
+    [self cancel];
+    fy_dispatch_release(_queue);
+}
+
+- (NSUInteger)activeConnectionCount {
+    return self.requests.count - (self.pollRequest ? 1 : 0);
+}
+
+- (BOOL)isPolling {
+    return self.pollRequest != nil;
+}
+
+- (void)sendMessage:(NSData *)message {
+    [self.queuedMessages addObject:message];
+    [self sendQueuedMessages];
+}
+
+- (void)cancel {
+    for (FYHTTPTransportRequest *request in self.requests) {
+        request.transport = nil;
+        [request.connection cancel];
+    }
+    [self.requests removeAllObjects];
+    [self.queuedMessages removeAllObjects];
+    self.pollRequest = nil;
+}
+
+- (void)pollWithMessage:(NSData *)message timeoutInterval:(NSTimeInterval)timeoutInterval {
+    NSAssert(!self.pollRequest, @"Only one poll request can be running at a time.");
+    self.pollRequest = [self startRequestWithMessages:@[message] timeoutInterval:timeoutInterval];
+}
+
+- (void)sendQueuedMessages {
+    if (self.queuedMessages.count == 0 || self.activeConnectionCount >= self.maximumConnectionCount) {
+        // Messages wait for a connection to become available
+        return;
+    }
+    
+    [self startRequestWithMessages:self.queuedMessages timeoutInterval:0];
+    self.queuedMessages = [NSMutableArray new];
+}
+
+- (FYHTTPTransportRequest *)startRequestWithMessages:(NSArray *)messages timeoutInterval:(NSTimeInterval)timeoutInterval {
+    // Join all messages to one JSON array
+    NSMutableData *body = [NSMutableData new];
+    [body appendBytes:"[" length:1];
+    [messages enumerateObjectsUsingBlock:^(NSData *message, NSUInteger idx, BOOL *stop) {
+        if (idx > 0) {
+            [body appendBytes:"," length:1];
+        }
+        [body appendData:message];
+     }];
+    [body appendBytes:"]" length:1];
+    FYLog(@"Send HTTP request with %d messages.", (int)messages.count);
+    
+    // Initialize a new URL request
+    NSMutableURLRequest *URLRequest = [NSMutableURLRequest requestWithURL:self.URL];
+    URLRequest.HTTPMethod  = @"POST";
+    URLRequest.HTTPBody    = body;
+    if (timeoutInterval > 0) {
+        URLRequest.timeoutInterval = timeoutInterval;
+    }
+    
+    // Set HTTP headers
+    NSDictionary *headers = @{
+        @"Accept":          @"application/json",
+        @"Accept-Encoding": @"gzip",
+        @"Connection":      @"keep-alive",
+        @"Content-Type":    @"application/json",
+     };
+    // TODO: Add here a delegate method to further initialize requests header fields for authorization
+    // with inout &headers
+    for (NSString *headerField in headers) {
+        [URLRequest addValue:headers[headerField] forHTTPHeaderField:headerField];
+    }
+    
+    // Configure request options
+    URLRequest.HTTPShouldUsePipelining = YES;
+    URLRequest.cachePolicy             = NSURLRequestReloadIgnoringLocalCacheData;
+    
+    // Send request without scheduling it in any run loop
+    FYHTTPTransportRequest *request = [FYHTTPTransportRequest new];
+    request.transport = self;
+    request.connection = [[NSURLConnection alloc] initWithRequest:URLRequest delegate:request startImmediately:NO];
+    [request.connection setDelegateQueue:self.connectionQueue];
+    [self.requests addObject:request];
+    [request.connection start];
+    return request;
+}
+
+- (void)requestFinished:(FYHTTPTransportRequest *)request withData:(NSData *)data error:(NSError *)error {
+    // Called on connectionQueue
+    dispatch_async(self.queue, ^{
+        if (![self.requests containsObject:request]) {
+            // Request was cancelled
+            return;
+        }
+        [self.requests removeObject:request];
+        request.connection = nil;
+        if (self.pollRequest == request) {
+            self.pollRequest = nil;
+        }
+        
+        if (error) {
+            [self.delegate transport:self failedWithError:error];
+        } else {
+            [self.delegate transport:self receivedData:data];
+        }
+        
+        // A connection became available
+        [self sendQueuedMessages];
+     });
+}
+
+@end
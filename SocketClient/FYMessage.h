@@ -128,6 +128,13 @@
  */
 @property (nonatomic, retain) NSDate *timestamp;
 
+/**
+ Sent time of the message as seconds since 1970.
+ 
+ Unlike timestamp, this doesn't create an NSDate. Is NAN if the message has no valid timestamp.
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval timeIntervalSince1970;
+
 /**
  An object that contains event information.
  
@@ -174,9 +181,17 @@
  */
 @property (nonatomic, retain) NSObject *ext;
 
+/**
+ The unserialized JSON message, which backs the fields of the receiver.
+ */
+@property (nonatomic, retain, readonly) NSDictionary *userInfo;
+
 /**
  Initializer
  
+ The given dictionary is neither copied nor filtered. Each field is read from it lazily on its first access, so
+ fields which are never read cost nothing.
+ 
  @param userInfo  contains unserialized JSON message
  */
 - (id)initWithUserInfo:(NSDictionary *)userInfo;
@@ -28,40 +28,64 @@
 //
 
 #import "FYMessage.h"
+#import "FYTimestamp.h"
 
 
-/**
- Internal category for 'FYMessage' to parse RFC3339 strings into 'NSDate'.
+/*
+ Fields of a message, which were already read from its userInfo or explicitly set.
  */
-@interface NSDate (Helper)
-
-/**
- Get a 'NSDate' instance by parsing a RFC3339 string by 'NSDateFormatter'.
- 
- @param  dateString  a RFC3339 string
+typedef NS_OPTIONS(NSUInteger, FYMessageField) {
+    FYMessageFieldChannel                  = (1<<0),
+    FYMessageFieldVersion                  = (1<<1),
+    FYMessageFieldMinimumVersion           = (1<<2),
+    FYMessageFieldSupportedConnectionTypes = (1<<3),
+    FYMessageFieldClientId                 = (1<<4),
+    FYMessageFieldAdvice                   = (1<<5),
+    FYMessageFieldFayeId                   = (1<<6),
+    FYMessageFieldTimestamp                = (1<<7),
+    FYMessageFieldData                     = (1<<8),
+    FYMessageFieldSuccessful               = (1<<9),
+    FYMessageFieldSubscription             = (1<<10),
+    FYMessageFieldError                    = (1<<11),
+    FYMessageFieldExt                      = (1<<12),
+};
+
+/*
+ Define accessors of a field, whose getter reads the value on first access from userInfo. Once a field was read or
+ set, its own value is used.
  */
-+ (NSDate *)dateWithRFC3339String:(NSString *)dateString;
-
-@end
-
-
-@implementation NSDate (Helper)
-
-+ (NSDate *)dateWithRFC3339String:(NSString *)dateString {
-	static NSDateFormatter *formatter;
-    if (!formatter) {
-        formatter = [NSDateFormatter new];
-        formatter.locale = [[NSLocale alloc] initWithLocaleIdentifier:@"en_US_POSIX"];
-        formatter.dateFormat = @"yyyy-MM-dd'T'HH:mm:ssz";
+#define FYMessageLazyField(Type, name, Name, key, field) \
+    - (Type)name { \
+        if (!(_resolvedFields & field)) { \
+            _##name = _userInfo[key]; \
+            _resolvedFields |= field; \
+        } \
+        return _##name; \
+    } \
+    - (void)set##Name:(Type)name { \
+        _##name = name; \
+        _resolvedFields |= field; \
     }
-    return [formatter dateFromString:dateString];
-}
 
-@end
 
 
-
-@implementation FYMessage
+@implementation FYMessage {
+    FYMessageField _resolvedFields;
+    
+    NSString *_channel;
+    NSString *_version;
+    NSString *_minimumVersion;
+    NSArray *_supportedConnectionTypes;
+    NSString *_clientId;
+    NSDictionary *_advice;
+    NSString *_fayeId;
+    NSDate *_timestamp;
+    NSDictionary *_data;
+    NSNumber *_successful;
+    NSString *_subscription;
+    NSString *_error;
+    NSObject *_ext;
+}
 
 static NSSet* FYMessageKeySet;
 
@@ -81,37 +105,79 @@ static NSSet* FYMessageKeySet;
      ]];
 }
 
+- (id)init {
+    return [self initWithUserInfo:nil];
+}
+
 - (id)initWithUserInfo:(NSDictionary *)userInfo {
     self = [super init];
     if (self) {
-        self.fayeId = userInfo[@"id"];
-        
+        // Don't copy the dictionary. It was created by the decoder for this message only.
+        _userInfo = userInfo;
+    }
+    return self;
+}
+
+
+#pragma mark - Lazy field accessors
+
+FYMessageLazyField(NSString *,     channel,                  Channel,                  @"channel",                  FYMessageFieldChannel)
+FYMessageLazyField(NSString *,     version,                  Version,                  @"version",                  FYMessageFieldVersion)
+FYMessageLazyField(NSString *,     minimumVersion,           MinimumVersion,           @"minimumVersion",           FYMessageFieldMinimumVersion)
+FYMessageLazyField(NSArray *,      supportedConnectionTypes, SupportedConnectionTypes, @"supportedConnectionTypes", FYMessageFieldSupportedConnectionTypes)
+FYMessageLazyField(NSString *,     clientId,                 ClientId,                 @"clientId",                 FYMessageFieldClientId)
+FYMessageLazyField(NSDictionary *, advice,                   Advice,                   @"advice",                   FYMessageFieldAdvice)
+FYMessageLazyField(NSString *,     fayeId,                   FayeId,                   @"id",                       FYMessageFieldFayeId)
+FYMessageLazyField(NSDictionary *, data,                     Data,                     @"data",                     FYMessageFieldData)
+FYMessageLazyField(NSNumber *,     successful,               Successful,               @"successful",               FYMessageFieldSuccessful)
+FYMessageLazyField(NSString *,     subscription,             Subscription,             @"subscription",             FYMessageFieldSubscription)
+FYMessageLazyField(NSString *,     error,                    Error,                    @"error",                    FYMessageFieldError)
+FYMessageLazyField(NSObject *,     ext,                      Ext,                      @"ext",                      FYMessageFieldExt)
+
+- (NSDate *)timestamp {
+    if (!(_resolvedFields & FYMessageFieldTimestamp)) {
         // Parse timestamp, if needed
-        id timestamp = userInfo[@"timestamp"];
-        if (timestamp) {
-            if ([timestamp isKindOfClass:NSDate.class]) {
-                self.timestamp = timestamp;
-            } else if ([timestamp isKindOfClass:NSString.class]) {
-                self.timestamp = [NSDate dateWithRFC3339String:timestamp];
-            } else {
-                NSAssert(@"Timestamp '%@' is from unexpected class %@. Expected NSDate or NSString.",
-                         timestamp, [timestamp class]);
+        id timestamp = _userInfo[@"timestamp"];
+        if ([timestamp isKindOfClass:NSDate.class]) {
+            _timestamp = timestamp;
+        } else if ([timestamp isKindOfClass:NSString.class]) {
+            NSTimeInterval timeInterval;
+            if (FYTimestampParseRFC3339String(timestamp, &timeInterval)) {
+                _timestamp = [NSDate dateWithTimeIntervalSince1970:timeInterval];
             }
+        } else {
+            NSAssert(!timestamp, @"Timestamp '%@' is from unexpected class %@. Expected NSDate or NSString.",
+                     timestamp, [timestamp class]);
         }
-        
-        // Filter keys
-        NSMutableDictionary *filteredUserInfo = userInfo.mutableCopy;
-        for (NSString* key in userInfo) {
-            if (![FYMessageKeySet containsObject:key]) {
-                [filteredUserInfo removeObjectForKey:key];
-            }
-        }
-        
-        [self setValuesForKeysWithDictionary:filteredUserInfo];
+        _resolvedFields |= FYMessageFieldTimestamp;
     }
-    return self;
+    return _timestamp;
 }
 
+- (void)setTimestamp:(NSDate *)timestamp {
+    _timestamp = timestamp;
+    _resolvedFields |= FYMessageFieldTimestamp;
+}
+
+- (NSTimeInterval)timeIntervalSince1970 {
+    if (_resolvedFields & FYMessageFieldTimestamp) {
+        return _timestamp ? _timestamp.timeIntervalSince1970 : NAN;
+    }
+    
+    // Parse the raw timestamp without creating a date.
+    id timestamp = _userInfo[@"timestamp"];
+    NSTimeInterval timeInterval;
+    if ([timestamp isKindOfClass:NSString.class] && FYTimestampParseRFC3339String(timestamp, &timeInterval)) {
+        return timeInterval;
+    } else if ([timestamp isKindOfClass:NSDate.class]) {
+        return [timestamp timeIntervalSince1970];
+    }
+    return NAN;
+}
+
+
+#pragma mark - Description
+
 - (NSString *)description {
     NSMutableString* description = super.description.mutableCopy;
     [description appendString:@"{\n"];
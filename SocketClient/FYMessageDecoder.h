@@ -0,0 +1,145 @@
+//
+//  FYMessageDecoder.h
+//  SocketClient
+//
+//  Created by agent on 17.10.26.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+
+@class FYMessageDecoder;
+
+
+/**
+ The `FYMessageDecoderDelegate` protocol is used by <FYMessageDecoder> to emit decoded messages and to decide which
+ payloads have to be decoded.
+ */
+@protocol FYMessageDecoderDelegate <NSObject>
+
+/**
+ Ask whether the `data` field of a message on the given channel should be decoded.
+ 
+ The payload of messages for which this returns NO is skipped and not represented by any object.
+ 
+ @param decoder  The decoder which is decoding the message.
+ 
+ @param channel  The channel of the message or nil, if the message has no channel.
+ */
+- (BOOL)decoder:(FYMessageDecoder *)decoder shouldDecodePayloadOfChannel:(NSString *)channel;
+
+/**
+ A message was decoded.
+ 
+ This is sent as soon as the message is decoded, before the following messages of the same frame are decoded.
+ 
+ @param decoder   The decoder which decoded the message.
+ 
+ @param userInfo  The decoded message.
+ */
+- (void)decoder:(FYMessageDecoder *)decoder decodedMessage:(NSDictionary *)userInfo;
+
+@optional
+
+/**
+ Ask whether a message, whose payload is not wanted, should be emitted at all.
+ 
+ Before a JSON message is decoded, its fields `channel`, `successful` and `id` are prescanned on the raw bytes. This is
+ only asked if decoder:shouldDecodePayloadOfChannel: returned NO. Messages for which this returns NO are skipped as a
+ whole and are not represented by any object. If this is not implemented, all messages are emitted.
+ 
+ @param decoder     The decoder which is decoding the message.
+ 
+ @param channel     The channel of the message.
+ 
+ @param responseId  The id of the message, if it has the field `successful` and so is a response to a message which
+                    was sent before, otherwise nil.
+ */
+- (BOOL)decoder:(FYMessageDecoder *)decoder shouldEmitMessageOfChannel:(NSString *)channel
+     responseId:(NSString *)responseId;
+
+@end
+
+
+/**
+ Incremental decoder for frames of Bayeux messages.
+ 
+ A frame is a JSON or MessagePack array of messages. Instead of building the object tree of the whole frame, each
+ message is emitted to the delegate as soon as it was read. The `data` field of a message is only decoded into
+ Foundation objects if the delegate asks for, otherwise it is skipped by a plain structural scan. Messages nobody is
+ interested in can be skipped as a whole, see decoder:shouldEmitMessageOfChannel:responseId:.
+ */
+@interface FYMessageDecoder : NSObject
+
+/**
+ Delegate to emit decoded messages to.
+ */
+@property (nonatomic, weak) id<FYMessageDecoderDelegate> delegate;
+
+/**
+ Initializer
+ 
+ @param delegate  The value for the property delegate.
+ */
+- (id)initWithDelegate:(id<FYMessageDecoderDelegate>)delegate;
+
+/**
+ Decode a frame from UTF-8 encoded bytes.
+ 
+ Messages which were decoded before a malformed part of the frame was encountered are already emitted to the delegate.
+ 
+ @param bytes   UTF-8 encoded JSON array of messages.
+ 
+ @param length  Count of bytes.
+ 
+ @param error   Set if the frame is malformed.
+ 
+ @return Whether the whole frame was decoded.
+ */
+- (BOOL)decodeBytes:(const char *)bytes length:(NSUInteger)length error:(NSError **)error;
+
+/**
+ Decode a frame from UTF-8 encoded data.
+ 
+ See decodeBytes:length:error:.
+ */
+- (BOOL)decodeData:(NSData *)data error:(NSError **)error;
+
+/**
+ Decode a frame from MessagePack encoded bytes, which is used by the binary payload encoding.
+ 
+ Messages which were decoded before a malformed part of the frame was encountered are already emitted to the delegate.
+ 
+ @param bytes   MessagePack encoded array of messages.
+ 
+ @param length  Count of bytes.
+ 
+ @param error   Set if the frame is malformed.
+ 
+ @return Whether the whole frame was decoded.
+ */
+- (BOOL)decodePackedBytes:(const void *)bytes length:(NSUInteger)length error:(NSError **)error;
+
+@end
@@ -0,0 +1,866 @@
+//
+//  FYMessageDecoder.m
+//  SocketClient
+//
+//  Created by agent on 17.10.26.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "FYMessageDecoder.h"
+#import "FYMessagePack.h"
+#import "FYError.h"
+
+#if defined(__SSE2__)
+#import <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#import <arm_neon.h>
+#endif
+
+
+/*
+ Maximum nesting depth of JSON values. Deeper values are treated as malformed instead of risking a stack overflow.
+ */
+static const NSUInteger FYJSONMaximumDepth = 512;
+
+
+#pragma mark - JSON scanner
+
+/*
+ The scanner works directly on the UTF-8 encoded bytes of a frame. It only finds the boundaries of JSON values and does
+ not create any objects, so skipping a value is cheap.
+ */
+typedef struct {
+    const uint8_t *start;
+    const uint8_t *cursor;
+    const uint8_t *end;
+    const char *error;
+} FYJSONCursor;
+
+static inline void FYJSONSkipWhitespace(FYJSONCursor *c) {
+    while (c->cursor < c->end) {
+        switch (*c->cursor) {
+            case ' ': case '\t': case '\n': case '\r':
+                c->cursor++;
+                break;
+            default:
+                return;
+        }
+    }
+}
+
+static inline BOOL FYJSONConsume(FYJSONCursor *c, uint8_t byte) {
+    FYJSONSkipWhitespace(c);
+    if (c->cursor < c->end && *c->cursor == byte) {
+        c->cursor++;
+        return YES;
+    }
+    return NO;
+}
+
+static inline BOOL FYJSONFail(FYJSONCursor *c, const char *error) {
+    if (!c->error) {
+        c->error = error;
+    }
+    return NO;
+}
+
+static inline int FYJSONHexValue(uint8_t byte) {
+    if (byte >= '0' && byte <= '9') return byte - '0';
+    if (byte >= 'a' && byte <= 'f') return byte - 'a' + 10;
+    if (byte >= 'A' && byte <= 'F') return byte - 'A' + 10;
+    return -1;
+}
+
+/*
+ Find the first byte at or after p, which ends the plain contents of a string: a quote, a backslash or an unescaped
+ control character. Returns end if there is none.
+ 
+ Blocks of 16 bytes are compared at once with SSE2 on x86 and with NEON on arm64, which are part of the baseline of
+ these architectures. Other architectures and the tail of the data are scanned byte by byte.
+ */
+static inline const uint8_t *FYJSONFindStringDelimiter(const uint8_t *p, const uint8_t *end) {
+#if defined(__SSE2__)
+    const __m128i quote     = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control   = _mm_set1_epi8(0x1F);
+    for (; end - p >= 16; p += 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i *)p);
+        __m128i matches = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(bytes, quote), _mm_cmpeq_epi8(bytes, backslash)),
+                                       _mm_cmpeq_epi8(_mm_min_epu8(bytes, control), bytes));
+        int mask = _mm_movemask_epi8(matches);
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const uint8x16_t quote     = vdupq_n_u8('"');
+    const uint8x16_t backslash = vdupq_n_u8('\\');
+    const uint8x16_t control   = vdupq_n_u8(0x20);
+    for (; end - p >= 16; p += 16) {
+        uint8x16_t bytes = vld1q_u8(p);
+        uint8x16_t matches = vorrq_u8(vorrq_u8(vceqq_u8(bytes, quote), vceqq_u8(bytes, backslash)),
+                                      vcltq_u8(bytes, control));
+        if (vmaxvq_u8(matches)) {
+            // The exact position within the block is found below.
+            break;
+        }
+    }
+#endif
+    while (p < end && *p != '"' && *p != '\\' && *p >= 0x20) {
+        p++;
+    }
+    return p;
+}
+
+/*
+ Find the first quote or bracket at or after p. Returns end if there is none.
+ 
+ Brackets only differ by 0x20 from each other: '[' is 0x5B and '{' is 0x7B, ']' is 0x5D and '}' is 0x7D. So setting
+ that bit leaves two comparisons for all four of them.
+ */
+static inline const uint8_t *FYJSONFindStructural(const uint8_t *p, const uint8_t *end) {
+#if defined(__SSE2__)
+    const __m128i quote   = _mm_set1_epi8('"');
+    const __m128i opening = _mm_set1_epi8('{');
+    const __m128i closing = _mm_set1_epi8('}');
+    const __m128i fold    = _mm_set1_epi8(0x20);
+    for (; end - p >= 16; p += 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i *)p);
+        __m128i folded = _mm_or_si128(bytes, fold);
+        __m128i matches = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(folded, opening), _mm_cmpeq_epi8(folded, closing)),
+                                       _mm_cmpeq_epi8(bytes, quote));
+        int mask = _mm_movemask_epi8(matches);
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const uint8x16_t quote   = vdupq_n_u8('"');
+    const uint8x16_t opening = vdupq_n_u8('{');
+    const uint8x16_t closing = vdupq_n_u8('}');
+    const uint8x16_t fold    = vdupq_n_u8(0x20);
+    for (; end - p >= 16; p += 16) {
+        uint8x16_t bytes = vld1q_u8(p);
+        uint8x16_t folded = vorrq_u8(bytes, fold);
+        uint8x16_t matches = vorrq_u8(vorrq_u8(vceqq_u8(folded, opening), vceqq_u8(folded, closing)),
+                                      vceqq_u8(bytes, quote));
+        if (vmaxvq_u8(matches)) {
+            break;
+        }
+    }
+#endif
+    while (p < end && *p != '"' && (*p | 0x20) != '{' && (*p | 0x20) != '}') {
+        p++;
+    }
+    return p;
+}
+
+/*
+ Scan a string, the cursor has to point at the opening quote. On success the range of the raw contents is returned
+ and the cursor points behind the closing quote.
+ */
+static BOOL FYJSONScanString(FYJSONCursor *c, const uint8_t **contentStart, const uint8_t **contentEnd, BOOL *escaped) {
+    if (c->cursor >= c->end || *c->cursor != '"') {
+        return FYJSONFail(c, "Expected a string");
+    }
+    const uint8_t *p = ++c->cursor;
+    *escaped = NO;
+    while ((p = FYJSONFindStringDelimiter(p, c->end)) < c->end) {
+        uint8_t byte = *p;
+        if (byte == '"') {
+            *contentStart = c->cursor;
+            *contentEnd = p;
+            c->cursor = p + 1;
+            return YES;
+        } else if (byte == '\\') {
+            *escaped = YES;
+            p += 2;
+        } else {
+            return FYJSONFail(c, "Unescaped control character in string");
+        }
+    }
+    return FYJSONFail(c, "Unterminated string");
+}
+
+static inline size_t FYJSONEncodeUTF8(uint32_t codepoint, uint8_t *out) {
+    if (codepoint < 0x80) {
+        out[0] = codepoint;
+        return 1;
+    } else if (codepoint < 0x800) {
+        out[0] = 0xC0 | (codepoint >> 6);
+        out[1] = 0x80 | (codepoint & 0x3F);
+        return 2;
+    } else if (codepoint < 0x10000) {
+        out[0] = 0xE0 | (codepoint >> 12);
+        out[1] = 0x80 | ((codepoint >> 6) & 0x3F);
+        out[2] = 0x80 | (codepoint & 0x3F);
+        return 3;
+    } else {
+        out[0] = 0xF0 | (codepoint >> 18);
+        out[1] = 0x80 | ((codepoint >> 12) & 0x3F);
+        out[2] = 0x80 | ((codepoint >> 6) & 0x3F);
+        out[3] = 0x80 | (codepoint & 0x3F);
+        return 4;
+    }
+}
+
+/*
+ Unescape the raw contents of a string into UTF-8. The output never needs more bytes than the input. Returns the count
+ of written bytes or -1 if an escape sequence is malformed.
+ */
+static ssize_t FYJSONUnescapeString(const uint8_t *p, const uint8_t *end, uint8_t *out) {
+    uint8_t *o = out;
+    while (p < end) {
+        if (*p != '\\') {
+            *o++ = *p++;
+            continue;
+        }
+        if (++p >= end) {
+            return -1;
+        }
+        switch (*p++) {
+            case '"':  *o++ = '"';  break;
+            case '\\': *o++ = '\\'; break;
+            case '/':  *o++ = '/';  break;
+            case 'b':  *o++ = '\b'; break;
+            case 'f':  *o++ = '\f'; break;
+            case 'n':  *o++ = '\n'; break;
+            case 'r':  *o++ = '\r'; break;
+            case 't':  *o++ = '\t'; break;
+            case 'u': {
+                uint32_t codepoint = 0;
+                for (int i=0; i<4; i++) {
+                    int hex = p < end ? FYJSONHexValue(*p++) : -1;
+                    if (hex < 0) {
+                        return -1;
+                    }
+                    codepoint = (codepoint << 4) | hex;
+                }
+                if (codepoint >= 0xD800 && codepoint <= 0xDBFF) {
+                    // High surrogate, which has to be followed by an escaped low surrogate.
+                    uint32_t low = 0;
+                    if (end - p < 6 || p[0] != '\\' || p[1] != 'u') {
+                        return -1;
+                    }
+                    for (int i=2; i<6; i++) {
+                        int hex = FYJSONHexValue(p[i]);
+                        if (hex < 0) {
+                            return -1;
+                        }
+                        low = (low << 4) | hex;
+                    }
+                    if (low < 0xDC00 || low > 0xDFFF) {
+                        return -1;
+                    }
+                    p += 6;
+                    codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+                } else if (codepoint >= 0xDC00 && codepoint <= 0xDFFF) {
+                    return -1;
+                }
+                o += FYJSONEncodeUTF8(codepoint, o);
+                break;
+            }
+            default:
+                return -1;
+        }
+    }
+    return o - out;
+}
+
+/*
+ Scan a number. If it is an integer, which fits without loss into a long long, it is returned by integerValue.
+ */
+static BOOL FYJSONScanNumber(FYJSONCursor *c, BOOL *isInteger, long long *integerValue) {
+    const uint8_t *p = c->cursor;
+    BOOL negative = NO;
+    unsigned long long value = 0;
+    int digits = 0;
+    
+    if (p < c->end && *p == '-') {
+        negative = YES;
+        p++;
+    }
+    if (p >= c->end || *p < '0' || *p > '9') {
+        return FYJSONFail(c, "Expected a digit");
+    }
+    if (*p == '0') {
+        p++;
+        digits = 1;
+    } else {
+        while (p < c->end && *p >= '0' && *p <= '9') {
+            value = value * 10 + (*p++ - '0');
+            digits++;
+        }
+    }
+    
+    *isInteger = digits <= 18;
+    if (p < c->end && *p == '.') {
+        *isInteger = NO;
+        if (++p >= c->end || *p < '0' || *p > '9') {
+            return FYJSONFail(c, "Expected a digit after decimal point");
+        }
+        while (p < c->end && *p >= '0' && *p <= '9') {
+            p++;
+        }
+    }
+    if (p < c->end && (*p == 'e' || *p == 'E')) {
+        *isInteger = NO;
+        p++;
+        if (p < c->end && (*p == '+' || *p == '-')) {
+            p++;
+        }
+        if (p >= c->end || *p < '0' || *p > '9') {
+            return FYJSONFail(c, "Expected a digit in exponent");
+        }
+        while (p < c->end && *p >= '0' && *p <= '9') {
+            p++;
+        }
+    }
+    
+    if (*isInteger) {
+        *integerValue = negative ? -(long long)value : (long long)value;
+    }
+    c->cursor = p;
+    return YES;
+}
+
+static inline BOOL FYJSONScanLiteral(FYJSONCursor *c, const char *literal, size_t length) {
+    if ((size_t)(c->end - c->cursor) < length || memcmp(c->cursor, literal, length) != 0) {
+        return FYJSONFail(c, "Unexpected character");
+    }
+    c->cursor += length;
+    return YES;
+}
+
+/*
+ Skip an object or array, the cursor has to point at its opening bracket.
+ 
+ Only strings and brackets are looked at, everything in between is passed over in blocks. So the skipped value is
+ checked for matching brackets and well-formed strings, but not for the grammar in between. Nothing of it is ever used,
+ while the fields around it are still fully checked.
+ */
+static BOOL FYJSONSkipContainer(FYJSONCursor *c) {
+    // One bit per level, which is set for arrays, to match closing brackets with opening ones. Bits are written on
+    // opening a level, before they are read.
+    uint64_t arrays[8];
+    NSUInteger depth = 0;
+    const uint8_t *p = c->cursor;
+    
+    while ((p = FYJSONFindStructural(p, c->end)) < c->end) {
+        uint8_t byte = *p++;
+        if (byte == '"') {
+            while ((p = FYJSONFindStringDelimiter(p, c->end)) < c->end && *p == '\\') {
+                p += 2;
+            }
+            if (p >= c->end) {
+                break;
+            } else if (*p != '"') {
+                c->cursor = p;
+                return FYJSONFail(c, "Unescaped control character in string");
+            }
+            p++;
+        } else if ((byte | 0x20) == '{') {
+            if (depth >= FYJSONMaximumDepth || depth >= sizeof(arrays) * 8) {
+                c->cursor = p - 1;
+                return FYJSONFail(c, "Maximum nesting depth exceeded");
+            }
+            if (byte == '[') {
+                arrays[depth / 64] |= 1ULL << (depth % 64);
+            } else {
+                arrays[depth / 64] &= ~(1ULL << (depth % 64));
+            }
+            depth++;
+        } else {
+            depth--;
+            BOOL isArray = (arrays[depth / 64] >> (depth % 64)) & 1;
+            if (isArray != (byte == ']')) {
+                c->cursor = p - 1;
+                return FYJSONFail(c, "Mismatched closing bracket");
+            }
+            if (depth == 0) {
+                c->cursor = p;
+                return YES;
+            }
+        }
+    }
+    c->cursor = c->end;
+    return FYJSONFail(c, "Unexpected end of data");
+}
+
+/*
+ Skip a value without creating any objects.
+ */
+static BOOL FYJSONSkipValue(FYJSONCursor *c) {
+    FYJSONSkipWhitespace(c);
+    if (c->cursor >= c->end) {
+        return FYJSONFail(c, "Unexpected end of data");
+    }
+    
+    switch (*c->cursor) {
+        case '"': {
+            const uint8_t *start, *end;
+            BOOL escaped;
+            return FYJSONScanString(c, &start, &end, &escaped);
+        }
+        case '{':
+        case '[':
+            return FYJSONSkipContainer(c);
+        case 't':
+            return FYJSONScanLiteral(c, "true", 4);
+        case 'f':
+            return FYJSONScanLiteral(c, "false", 5);
+        case 'n':
+            return FYJSONScanLiteral(c, "null", 4);
+        default: {
+            BOOL isInteger;
+            long long integerValue;
+            return FYJSONScanNumber(c, &isInteger, &integerValue);
+        }
+    }
+}
+
+
+#pragma mark - JSON object builder
+
+static NSString *FYJSONParseString(FYJSONCursor *c) {
+    const uint8_t *start, *end;
+    BOOL escaped;
+    if (!FYJSONScanString(c, &start, &end, &escaped)) {
+        return nil;
+    }
+    
+    NSString *string;
+    if (!escaped) {
+        string = [[NSString alloc] initWithBytes:start length:end - start encoding:NSUTF8StringEncoding];
+    } else {
+        NSMutableData *buffer = [[NSMutableData alloc] initWithLength:end - start];
+        ssize_t length = FYJSONUnescapeString(start, end, buffer.mutableBytes);
+        if (length < 0) {
+            FYJSONFail(c, "Malformed escape sequence");
+            return nil;
+        }
+        string = [[NSString alloc] initWithBytes:buffer.bytes length:length encoding:NSUTF8StringEncoding];
+    }
+    if (!string) {
+        FYJSONFail(c, "Invalid UTF-8 in string");
+    }
+    return string;
+}
+
+static inline BOOL FYJSONBytesEqual(const uint8_t *start, const uint8_t *end, const char *literal, size_t length) {
+    return (size_t)(end - start) == length && memcmp(start, literal, length) == 0;
+}
+
+/*
+ Fields of Bayeux messages, whose keys are shared by all decoded messages instead of creating a string per message.
+ */
+static const struct {
+    const char *bytes;
+    size_t length;
+    __unsafe_unretained NSString *key;
+} FYJSONMessageKeys[] = {
+    { "channel",        7,  @"channel" },
+    { "data",           4,  @"data" },
+    { "id",             2,  @"id" },
+    { "clientId",       8,  @"clientId" },
+    { "successful",     10, @"successful" },
+    { "ext",            3,  @"ext" },
+    { "advice",         6,  @"advice" },
+    { "error",          5,  @"error" },
+    { "subscription",   12, @"subscription" },
+    { "connectionType", 14, @"connectionType" },
+};
+
+static NSString *FYJSONParseMessageKey(FYJSONCursor *c) {
+    FYJSONCursor scan = *c;
+    const uint8_t *start, *end;
+    BOOL escaped;
+    if (FYJSONScanString(&scan, &start, &end, &escaped) && !escaped) {
+        for (size_t i=0; i<sizeof(FYJSONMessageKeys) / sizeof(*FYJSONMessageKeys); i++) {
+            if (FYJSONBytesEqual(start, end, FYJSONMessageKeys[i].bytes, FYJSONMessageKeys[i].length)) {
+                c->cursor = scan.cursor;
+                return FYJSONMessageKeys[i].key;
+            }
+        }
+    }
+    return FYJSONParseString(c);
+}
+
+static NSNumber *FYJSONParseNumber(FYJSONCursor *c) {
+    const uint8_t *start = c->cursor;
+    BOOL isInteger;
+    long long integerValue;
+    if (!FYJSONScanNumber(c, &isInteger, &integerValue)) {
+        return nil;
+    }
+    if (isInteger) {
+        return @(integerValue);
+    }
+    
+    // Let strtod deal with the precision, it needs a terminated string.
+    size_t length = c->cursor - start;
+    char buffer[64];
+    if (length < sizeof(buffer)) {
+        memcpy(buffer, start, length);
+        buffer[length] = '\0';
+        return @(strtod(buffer, NULL));
+    }
+    NSString *string = [[NSString alloc] initWithBytes:start length:length encoding:NSASCIIStringEncoding];
+    return @(string.doubleValue);
+}
+
+/*
+ Parse a value into Foundation objects like NSJSONSerialization would do with NSJSONReadingAllowFragments.
+ */
+static id FYJSONParseValue(FYJSONCursor *c, NSUInteger depth) {
+    if (depth > FYJSONMaximumDepth) {
+        FYJSONFail(c, "Maximum nesting depth exceeded");
+        return nil;
+    }
+    FYJSONSkipWhitespace(c);
+    if (c->cursor >= c->end) {
+        FYJSONFail(c, "Unexpected end of data");
+        return nil;
+    }
+    
+    switch (*c->cursor) {
+        case '"':
+            return FYJSONParseString(c);
+        case '{': {
+            c->cursor++;
+            NSMutableDictionary *object = [NSMutableDictionary new];
+            if (FYJSONConsume(c, '}')) {
+                return object;
+            }
+            do {
+                FYJSONSkipWhitespace(c);
+                NSString *key = FYJSONParseString(c);
+                if (!key || !(FYJSONConsume(c, ':') || FYJSONFail(c, "Expected ':'"))) {
+                    return nil;
+                }
+                id value = FYJSONParseValue(c, depth + 1);
+                if (!value) {
+                    return nil;
+                }
+                object[key] = value;
+            } while (FYJSONConsume(c, ','));
+            return FYJSONConsume(c, '}') || FYJSONFail(c, "Expected ',' or '}'") ? object : nil;
+        }
+        case '[': {
+            c->cursor++;
+            NSMutableArray *array = [NSMutableArray new];
+            if (FYJSONConsume(c, ']')) {
+                return array;
+            }
+            do {
+                id value = FYJSONParseValue(c, depth + 1);
+                if (!value) {
+                    return nil;
+                }
+                [array addObject:value];
+            } while (FYJSONConsume(c, ','));
+            return FYJSONConsume(c, ']') || FYJSONFail(c, "Expected ',' or ']'") ? array : nil;
+        }
+        case 't':
+            return FYJSONScanLiteral(c, "true", 4) ? @YES : nil;
+        case 'f':
+            return FYJSONScanLiteral(c, "false", 5) ? @NO : nil;
+        case 'n':
+            return FYJSONScanLiteral(c, "null", 4) ? NSNull.null : nil;
+        default:
+            return FYJSONParseNumber(c);
+    }
+}
+
+
+
+@interface FYMessageDecoder ()
+
+// Decode one message and emit it to the delegate
+- (BOOL)decodeMessageWithCursor:(FYJSONCursor *)cursor;
+
+// Decode one MessagePack encoded message and emit it to the delegate
+- (BOOL)decodePackedMessageWithCursor:(FYMessagePackCursor *)cursor;
+
+@end
+
+
+@implementation FYMessageDecoder
+
+- (id)initWithDelegate:(id<FYMessageDecoderDelegate>)delegate {
+    self = [super init];
+    if (self) {
+        self.delegate = delegate;
+    }
+    return self;
+}
+
+- (BOOL)decodeData:(NSData *)data error:(NSError **)error {
+    return [self decodeBytes:data.bytes length:data.length error:error];
+}
+
+- (BOOL)decodeBytes:(const char *)bytes length:(NSUInteger)length error:(NSError **)error {
+    FYJSONCursor cursor = {
+        .start  = (const uint8_t *)bytes,
+        .cursor = (const uint8_t *)bytes,
+        .end    = (const uint8_t *)bytes + length,
+        .error  = NULL,
+    };
+    FYJSONCursor *c = &cursor;
+    
+    if (!FYJSONConsume(c, '[')) {
+        FYJSONFail(c, "Expected an array of messages");
+    } else if (!FYJSONConsume(c, ']')) {
+        do {
+            if (![self decodeMessageWithCursor:c]) {
+                break;
+            }
+        } while (FYJSONConsume(c, ','));
+        
+        if (!c->error && !FYJSONConsume(c, ']')) {
+            FYJSONFail(c, "Expected ',' or ']'");
+        }
+    }
+    
+    if (!c->error) {
+        FYJSONSkipWhitespace(c);
+        if (c->cursor != c->end) {
+            FYJSONFail(c, "Unexpected data after array of messages");
+        }
+    }
+    
+    if (c->error) {
+        if (error) {
+            *error = [NSError errorWithDomain:FYErrorDomain code:FYErrorMalformedJSONData userInfo:@{
+                NSLocalizedDescriptionKey:        @"JSON data is malformed.",
+                NSLocalizedFailureReasonErrorKey: [NSString stringWithFormat:@"%s at offset %d.", c->error,
+                                                   (int)(c->cursor - c->start)],
+             }];
+        }
+        return NO;
+    }
+    return YES;
+}
+
+- (BOOL)decodeMessageWithCursor:(FYJSONCursor *)c {
+    if (!FYJSONConsume(c, '{')) {
+        return FYJSONFail(c, "Expected a message object");
+    }
+    
+    id<FYMessageDecoderDelegate> delegate = self.delegate;
+    if (FYJSONConsume(c, '}')) {
+        [delegate decoder:self decodedMessage:[NSMutableDictionary new]];
+        return YES;
+    }
+    BOOL asksToEmit = [delegate respondsToSelector:@selector(decoder:shouldEmitMessageOfChannel:responseId:)];
+    
+    // Prescan the fields, which decide how the message is decoded, by comparing the raw bytes of the keys. Only the
+    // channel is decoded. If its payload is not wanted, the fields successful and id are looked for, too, to ask
+    // whether the message is wanted at all. All other values are skipped.
+    FYJSONCursor scan = *c;
+    NSString *channel = nil;
+    const uint8_t *channelValue = NULL;
+    const uint8_t *channelValueEnd = NULL;
+    const uint8_t *idValue = NULL;
+    BOOL isResponse = NO;
+    BOOL decodesPayload = NO;
+    
+    do {
+        const uint8_t *key, *keyEnd;
+        BOOL escaped;
+        FYJSONSkipWhitespace(&scan);
+        if (!FYJSONScanString(&scan, &key, &keyEnd, &escaped)
+            || !(FYJSONConsume(&scan, ':') || FYJSONFail(&scan, "Expected ':'"))) {
+            *c = scan;
+            return NO;
+        }
+        FYJSONSkipWhitespace(&scan);
+        
+        if (!channel && FYJSONBytesEqual(key, keyEnd, "channel", 7) && scan.cursor < scan.end && *scan.cursor == '"') {
+            channelValue = scan.cursor;
+            channel = FYJSONParseString(&scan);
+            if (!channel) {
+                *c = scan;
+                return NO;
+            }
+            channelValueEnd = scan.cursor;
+            decodesPayload = [delegate decoder:self shouldDecodePayloadOfChannel:channel];
+            if (decodesPayload || !asksToEmit) {
+                break;
+            }
+        } else {
+            if (FYJSONBytesEqual(key, keyEnd, "id", 2)) {
+                idValue = scan.cursor;
+            } else if (FYJSONBytesEqual(key, keyEnd, "successful", 10)) {
+                isResponse = YES;
+            }
+            if (!FYJSONSkipValue(&scan)) {
+                *c = scan;
+                return NO;
+            }
+        }
+    } while (FYJSONConsume(&scan, ','));
+    
+    if (!channel) {
+        decodesPayload = [delegate decoder:self shouldDecodePayloadOfChannel:nil];
+    } else if (!decodesPayload && asksToEmit) {
+        NSString *responseId = nil;
+        if (isResponse && idValue && *idValue == '"') {
+            FYJSONCursor idCursor = scan;
+            idCursor.cursor = idValue;
+            responseId = FYJSONParseString(&idCursor);
+        }
+        if (![delegate decoder:self shouldEmitMessageOfChannel:channel responseId:responseId]) {
+            // All fields were already prescanned, so only the end of the message is left.
+            *c = scan;
+            return FYJSONConsume(c, '}') || FYJSONFail(c, "Expected ',' or '}'");
+        }
+    }
+    
+    NSMutableDictionary *userInfo = [NSMutableDictionary new];
+    do {
+        FYJSONSkipWhitespace(c);
+        NSString *key = FYJSONParseMessageKey(c);
+        if (!key || !(FYJSONConsume(c, ':') || FYJSONFail(c, "Expected ':'"))) {
+            return NO;
+        }
+        FYJSONSkipWhitespace(c);
+        
+        if (c->cursor == channelValue) {
+            // Reuse the channel, which was decoded by the prescan.
+            userInfo[key] = channel;
+            c->cursor = channelValueEnd;
+        } else if (!decodesPayload && [key isEqualToString:@"data"]) {
+            if (!FYJSONSkipValue(c)) {
+                return NO;
+            }
+        } else {
+            id value = FYJSONParseValue(c, 1);
+            if (!value) {
+                return NO;
+            }
+            userInfo[key] = value;
+        }
+    } while (FYJSONConsume(c, ','));
+    
+    if (!FYJSONConsume(c, '}')) {
+        return FYJSONFail(c, "Expected ',' or '}'");
+    }
+    
+    [delegate decoder:self decodedMessage:userInfo];
+    return YES;
+}
+
+- (BOOL)decodePackedBytes:(const void *)bytes length:(NSUInteger)length error:(NSError **)error {
+    FYMessagePackCursor cursor = {
+        .start  = bytes,
+        .cursor = bytes,
+        .end    = (const uint8_t *)bytes + length,
+        .error  = NULL,
+    };
+    FYMessagePackCursor *c = &cursor;
+    
+    NSUInteger count = 0;
+    if (FYMessagePackReadArrayHeader(c, &count)) {
+        for (NSUInteger i=0; i<count; i++) {
+            if (![self decodePackedMessageWithCursor:c]) {
+                break;
+            }
+        }
+        if (!c->error && c->cursor != c->end) {
+            c->error = "Unexpected data after array of messages";
+        }
+    }
+    
+    if (c->error) {
+        if (error) {
+            *error = [NSError errorWithDomain:FYErrorDomain code:FYErrorMalformedMessagePackData userInfo:@{
+                NSLocalizedDescriptionKey:        @"MessagePack data is malformed.",
+                NSLocalizedFailureReasonErrorKey: [NSString stringWithFormat:@"%s at offset %d.", c->error,
+                                                   (int)(c->cursor - c->start)],
+             }];
+        }
+        return NO;
+    }
+    return YES;
+}
+
+- (BOOL)decodePackedMessageWithCursor:(FYMessagePackCursor *)c {
+    NSUInteger count = 0;
+    if (!FYMessagePackReadMapHeader(c, &count)) {
+        return NO;
+    }
+    
+    id<FYMessageDecoderDelegate> delegate = self.delegate;
+    NSMutableDictionary *userInfo = [NSMutableDictionary new];
+    NSString *channel = nil;
+    const uint8_t *deferredPayload = NULL;
+    
+    for (NSUInteger i=0; i<count; i++) {
+        NSString *key = FYMessagePackParseValue(c);
+        if (!key) {
+            return NO;
+        } else if (![key isKindOfClass:NSString.class]) {
+            c->error = "Expected a string key";
+            return NO;
+        }
+        
+        if ([key isEqualToString:@"data"]
+            && !(channel && [delegate decoder:self shouldDecodePayloadOfChannel:channel])) {
+            // Lengths are encoded up front, so skipping the payload doesn't need to look at its contents. If the
+            // channel is not known yet, remember where the payload starts and decide when the whole message was read.
+            if (!channel) {
+                deferredPayload = c->cursor;
+            }
+            if (!FYMessagePackSkipValue(c)) {
+                return NO;
+            }
+        } else {
+            id value = FYMessagePackParseValue(c);
+            if (!value) {
+                return NO;
+            }
+            userInfo[key] = value;
+            if ([key isEqualToString:@"channel"] && [value isKindOfClass:NSString.class]) {
+                channel = value;
+            }
+        }
+    }
+    
+    if (deferredPayload && [delegate decoder:self shouldDecodePayloadOfChannel:channel]) {
+        FYMessagePackCursor payloadCursor = *c;
+        payloadCursor.cursor = deferredPayload;
+        id value = FYMessagePackParseValue(&payloadCursor);
+        if (!value) {
+            c->error = payloadCursor.error;
+            return NO;
+        }
+        userInfo[@"data"] = value;
+    }
+    
+    [delegate decoder:self decodedMessage:userInfo];
+    return YES;
+}
+
+@end
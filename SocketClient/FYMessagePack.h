@@ -0,0 +1,122 @@
+//
+//  FYMessagePack.h
+//  SocketClient
+//
+//  Created by agent on 17.10.26.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+
+/**
+ Cursor over the bytes of MessagePack encoded data, which is used to decode values one by one.
+ */
+typedef struct {
+    const uint8_t *start;
+    const uint8_t *cursor;
+    const uint8_t *end;
+    const char *error;
+} FYMessagePackCursor;
+
+/**
+ Read the header of an array and advance the cursor to its first element.
+ 
+ @return NO, if the value at the cursor is not an array. The error of the cursor is set.
+ */
+extern BOOL FYMessagePackReadArrayHeader(FYMessagePackCursor *cursor, NSUInteger *count);
+
+/**
+ Read the header of a map and advance the cursor to its first key.
+ 
+ @return NO, if the value at the cursor is not a map. The error of the cursor is set.
+ */
+extern BOOL FYMessagePackReadMapHeader(FYMessagePackCursor *cursor, NSUInteger *count);
+
+/**
+ Decode the value at the cursor into Foundation objects and advance the cursor behind it.
+ 
+ @return The decoded value or nil, if it is malformed. The error of the cursor is set.
+ */
+extern id FYMessagePackParseValue(FYMessagePackCursor *cursor);
+
+/**
+ Advance the cursor behind the value at the cursor without creating any objects.
+ 
+ @return NO, if the value is malformed. The error of the cursor is set.
+ */
+extern BOOL FYMessagePackSkipValue(FYMessagePackCursor *cursor);
+
+
+/**
+ Encoder and decoder of MessagePack, a binary serialization format with the data model of JSON.
+ 
+ Numbers are encoded in their binary representation instead of decimal text, so numeric-heavy payloads are faster to
+ encode and to decode and smaller on the wire. Encodeable objects are NSDictionary with NSString keys, NSArray,
+ NSString, NSNumber, NSNull and NSData, which is encoded as binary and decoded as NSData.
+ */
+@interface FYMessagePack : NSObject
+
+/**
+ Encode an object.
+ 
+ @param  object  An encodeable object.
+ 
+ @return The encoded data or nil, if the object or one of its children is not encodeable.
+ */
++ (NSData *)dataWithObject:(id)object;
+
+/**
+ Append an encoded object to data.
+ 
+ @param  object  An encodeable object.
+ 
+ @param  data    The data to append to.
+ 
+ @return NO, if the object or one of its children is not encodeable. Nothing is appended in this case.
+ */
++ (BOOL)appendObject:(id)object toData:(NSMutableData *)data;
+
+/**
+ Append the header of an array to data, which has to be followed by the given count of encoded elements.
+ */
++ (void)appendArrayHeaderWithCount:(NSUInteger)count toData:(NSMutableData *)data;
+
+/**
+ Append the header of a map to data, which has to be followed by the given count of encoded key-value pairs.
+ */
++ (void)appendMapHeaderWithCount:(NSUInteger)count toData:(NSMutableData *)data;
+
+/**
+ Decode an object.
+ 
+ @param  data   MessagePack encoded data of exactly one value.
+ 
+ @param  error  Set if the data is malformed.
+ 
+ @return The decoded object or nil, if the data is malformed.
+ */
++ (id)objectWithData:(NSData *)data error:(NSError **)error;
+
+@end
@@ -0,0 +1,589 @@
+//
+//  FYMessagePack.m
+//  SocketClient
+//
+//  Created by agent on 17.10.26.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "FYMessagePack.h"
+#import "FYError.h"
+
+
+/*
+ Maximum nesting depth of values. Deeper values are treated as malformed instead of risking a stack overflow.
+ */
+static const NSUInteger FYMessagePackMaximumDepth = 512;
+
+/*
+ Strings, binaries, arrays and maps share the layout of their headers: small counts are embedded into the type byte of
+ the fix variant, larger counts follow the type byte of the 8-, 16- or 32-bit variant in big-endian order.
+ */
+typedef struct {
+    uint8_t fix;
+    NSUInteger fixLimit;
+    uint8_t type8;
+    uint8_t type16;
+    uint8_t type32;
+} FYMessagePackFamily;
+
+static const FYMessagePackFamily FYMessagePackString = { 0xa0, 32, 0xd9, 0xda, 0xdb };
+static const FYMessagePackFamily FYMessagePackBinary = { 0x00,  0, 0xc4, 0xc5, 0xc6 };
+static const FYMessagePackFamily FYMessagePackArray  = { 0x90, 16, 0x00, 0xdc, 0xdd };
+static const FYMessagePackFamily FYMessagePackMap    = { 0x80, 16, 0x00, 0xde, 0xdf };
+
+static inline BOOL FYMessagePackIsOfFamily(uint8_t type, FYMessagePackFamily family) {
+    return (family.fixLimit > 0 && (type & ~(family.fixLimit - 1)) == family.fix)
+        || (family.type8 && type == family.type8)
+        || type == family.type16
+        || type == family.type32;
+}
+
+static inline void FYMessagePackStoreBigEndian(uint8_t *bytes, uint64_t value, size_t size) {
+    for (size_t i=0; i<size; i++) {
+        bytes[i] = (uint8_t)(value >> (8 * (size - 1 - i)));
+    }
+}
+
+static size_t FYMessagePackStoreHeader(uint8_t *bytes, FYMessagePackFamily family, NSUInteger count) {
+    if (count < family.fixLimit) {
+        bytes[0] = family.fix | (uint8_t)count;
+        return 1;
+    } else if (family.type8 && count <= UINT8_MAX) {
+        bytes[0] = family.type8;
+        bytes[1] = (uint8_t)count;
+        return 2;
+    } else if (count <= UINT16_MAX) {
+        bytes[0] = family.type16;
+        FYMessagePackStoreBigEndian(bytes + 1, count, 2);
+        return 3;
+    } else {
+        bytes[0] = family.type32;
+        FYMessagePackStoreBigEndian(bytes + 1, count, 4);
+        return 5;
+    }
+}
+
+
+#pragma mark - Writer
+
+/*
+ Values are written into a plain growing buffer, which is handed over to NSData without copying it.
+ */
+typedef struct {
+    uint8_t *bytes;
+    size_t length;
+    size_t capacity;
+} FYMessagePackWriter;
+
+static BOOL FYMessagePackReserve(FYMessagePackWriter *w, size_t count) {
+    if (w->length + count <= w->capacity) {
+        return YES;
+    }
+    size_t capacity = MAX(MAX(w->capacity * 2, w->length + count), (size_t)256);
+    uint8_t *bytes = realloc(w->bytes, capacity);
+    if (!bytes) {
+        return NO;
+    }
+    w->bytes = bytes;
+    w->capacity = capacity;
+    return YES;
+}
+
+static inline BOOL FYMessagePackWriteByte(FYMessagePackWriter *w, uint8_t byte) {
+    if (!FYMessagePackReserve(w, 1)) {
+        return NO;
+    }
+    w->bytes[w->length++] = byte;
+    return YES;
+}
+
+static inline BOOL FYMessagePackWriteTypeAndValue(FYMessagePackWriter *w, uint8_t type, uint64_t value, size_t size) {
+    if (!FYMessagePackReserve(w, 1 + size)) {
+        return NO;
+    }
+    w->bytes[w->length] = type;
+    FYMessagePackStoreBigEndian(w->bytes + w->length + 1, value, size);
+    w->length += 1 + size;
+    return YES;
+}
+
+static inline BOOL FYMessagePackWriteHeader(FYMessagePackWriter *w, FYMessagePackFamily family, NSUInteger count) {
+    if ((uint64_t)count > UINT32_MAX || !FYMessagePackReserve(w, 5)) {
+        return NO;
+    }
+    w->length += FYMessagePackStoreHeader(w->bytes + w->length, family, count);
+    return YES;
+}
+
+static BOOL FYMessagePackWriteUnsignedInteger(FYMessagePackWriter *w, unsigned long long value) {
+    if (value <= 0x7f) {
+        return FYMessagePackWriteByte(w, (uint8_t)value);
+    } else if (value <= UINT8_MAX) {
+        return FYMessagePackWriteTypeAndValue(w, 0xcc, value, 1);
+    } else if (value <= UINT16_MAX) {
+        return FYMessagePackWriteTypeAndValue(w, 0xcd, value, 2);
+    } else if (value <= UINT32_MAX) {
+        return FYMessagePackWriteTypeAndValue(w, 0xce, value, 4);
+    }
+    return FYMessagePackWriteTypeAndValue(w, 0xcf, value, 8);
+}
+
+static BOOL FYMessagePackWriteInteger(FYMessagePackWriter *w, long long value) {
+    if (value >= 0) {
+        return FYMessagePackWriteUnsignedInteger(w, (unsigned long long)value);
+    } else if (value >= -32) {
+        return FYMessagePackWriteByte(w, (uint8_t)(int8_t)value);
+    } else if (value >= INT8_MIN) {
+        return FYMessagePackWriteTypeAndValue(w, 0xd0, (uint8_t)(int8_t)value, 1);
+    } else if (value >= INT16_MIN) {
+        return FYMessagePackWriteTypeAndValue(w, 0xd1, (uint16_t)(int16_t)value, 2);
+    } else if (value >= INT32_MIN) {
+        return FYMessagePackWriteTypeAndValue(w, 0xd2, (uint32_t)(int32_t)value, 4);
+    }
+    return FYMessagePackWriteTypeAndValue(w, 0xd3, (uint64_t)value, 8);
+}
+
+static BOOL FYMessagePackWriteNumber(FYMessagePackWriter *w, NSNumber *number) {
+    // Booleans are instances of an own private class, which is the only way to tell them apart from 0 and 1 as chars.
+    static Class booleanClass;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        booleanClass = [@YES class];
+    });
+    if ([number isKindOfClass:booleanClass]) {
+        return FYMessagePackWriteByte(w, number.boolValue ? 0xc3 : 0xc2);
+    }
+    
+    switch (number.objCType[0]) {
+        case 'f': {
+            union { float f; uint32_t i; } value = { .f = number.floatValue };
+            return FYMessagePackWriteTypeAndValue(w, 0xca, value.i, 4);
+        }
+        case 'd': {
+            union { double d; uint64_t i; } value = { .d = number.doubleValue };
+            return FYMessagePackWriteTypeAndValue(w, 0xcb, value.i, 8);
+        }
+        case 'Q':
+            return FYMessagePackWriteUnsignedInteger(w, number.unsignedLongLongValue);
+        default:
+            return FYMessagePackWriteInteger(w, number.longLongValue);
+    }
+}
+
+static BOOL FYMessagePackWriteString(FYMessagePackWriter *w, NSString *string) {
+    // Convert directly into the buffer behind a header for the maximum length, which is moved up if the actual length
+    // needs a shorter header.
+    NSUInteger maximumLength = [string maximumLengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+    uint8_t header[5];
+    size_t maximumHeaderSize = FYMessagePackStoreHeader(header, FYMessagePackString, maximumLength);
+    if (!FYMessagePackReserve(w, maximumHeaderSize + maximumLength)) {
+        return NO;
+    }
+    
+    uint8_t *content = w->bytes + w->length + maximumHeaderSize;
+    NSUInteger usedLength = 0;
+    NSRange remainingRange;
+    [string getBytes:content maxLength:maximumLength usedLength:&usedLength encoding:NSUTF8StringEncoding options:0
+               range:NSMakeRange(0, string.length) remainingRange:&remainingRange];
+    if (remainingRange.length > 0 || (uint64_t)usedLength > UINT32_MAX) {
+        return NO;
+    }
+    
+    size_t headerSize = FYMessagePackStoreHeader(header, FYMessagePackString, usedLength);
+    if (headerSize < maximumHeaderSize) {
+        memmove(w->bytes + w->length + headerSize, content, usedLength);
+    }
+    memcpy(w->bytes + w->length, header, headerSize);
+    w->length += headerSize + usedLength;
+    return YES;
+}
+
+static BOOL FYMessagePackWriteData(FYMessagePackWriter *w, NSData *data) {
+    NSUInteger length = data.length;
+    if (!FYMessagePackWriteHeader(w, FYMessagePackBinary, length) || !FYMessagePackReserve(w, length)) {
+        return NO;
+    }
+    memcpy(w->bytes + w->length, data.bytes, length);
+    w->length += length;
+    return YES;
+}
+
+static BOOL FYMessagePackWriteValue(FYMessagePackWriter *w, id value, NSUInteger depth) {
+    if (depth > FYMessagePackMaximumDepth) {
+        return NO;
+    }
+    
+    if ([value isKindOfClass:NSString.class]) {
+        return FYMessagePackWriteString(w, value);
+    } else if ([value isKindOfClass:NSNumber.class]) {
+        return FYMessagePackWriteNumber(w, value);
+    } else if ([value isKindOfClass:NSDictionary.class]) {
+        NSDictionary *dictionary = value;
+        if (!FYMessagePackWriteHeader(w, FYMessagePackMap, dictionary.count)) {
+            return NO;
+        }
+        __block BOOL written = YES;
+        [dictionary enumerateKeysAndObjectsUsingBlock:^(id key, id object, BOOL *stop) {
+            written = [key isKindOfClass:NSString.class]
+                && FYMessagePackWriteString(w, key)
+                && FYMessagePackWriteValue(w, object, depth + 1);
+            *stop = !written;
+         }];
+        return written;
+    } else if ([value isKindOfClass:NSArray.class]) {
+        NSArray *array = value;
+        if (!FYMessagePackWriteHeader(w, FYMessagePackArray, array.count)) {
+            return NO;
+        }
+        for (id element in array) {
+            if (!FYMessagePackWriteValue(w, element, depth + 1)) {
+                return NO;
+            }
+        }
+        return YES;
+    } else if ([value isKindOfClass:NSNull.class]) {
+        return FYMessagePackWriteByte(w, 0xc0);
+    } else if ([value isKindOfClass:NSData.class]) {
+        return FYMessagePackWriteData(w, value);
+    }
+    return NO;
+}
+
+
+#pragma mark - Reader
+
+static inline BOOL FYMessagePackFail(FYMessagePackCursor *c, const char *error) {
+    if (!c->error) {
+        c->error = error;
+    }
+    return NO;
+}
+
+static inline BOOL FYMessagePackAdvance(FYMessagePackCursor *c, uint64_t size) {
+    if ((uint64_t)(c->end - c->cursor) < size) {
+        return FYMessagePackFail(c, "Unexpected end of data");
+    }
+    c->cursor += size;
+    return YES;
+}
+
+static inline BOOL FYMessagePackReadBigEndian(FYMessagePackCursor *c, size_t size, uint64_t *value) {
+    const uint8_t *bytes = c->cursor;
+    if (!FYMessagePackAdvance(c, size)) {
+        return NO;
+    }
+    uint64_t result = 0;
+    for (size_t i=0; i<size; i++) {
+        result = (result << 8) | bytes[i];
+    }
+    *value = result;
+    return YES;
+}
+
+static BOOL FYMessagePackReadHeader(FYMessagePackCursor *c, FYMessagePackFamily family, NSUInteger *count) {
+    if (c->cursor >= c->end) {
+        return FYMessagePackFail(c, "Unexpected end of data");
+    }
+    uint8_t type = *c->cursor;
+    size_t size;
+    if (family.fixLimit > 0 && (type & ~(family.fixLimit - 1)) == family.fix) {
+        c->cursor++;
+        *count = type & (family.fixLimit - 1);
+        return YES;
+    } else if (family.type8 && type == family.type8) {
+        size = 1;
+    } else if (type == family.type16) {
+        size = 2;
+    } else if (type == family.type32) {
+        size = 4;
+    } else {
+        return NO;
+    }
+    c->cursor++;
+    uint64_t value;
+    if (!FYMessagePackReadBigEndian(c, size, &value)) {
+        return NO;
+    }
+    *count = (NSUInteger)value;
+    return YES;
+}
+
+BOOL FYMessagePackReadArrayHeader(FYMessagePackCursor *c, NSUInteger *count) {
+    return FYMessagePackReadHeader(c, FYMessagePackArray, count) || FYMessagePackFail(c, "Expected an array");
+}
+
+BOOL FYMessagePackReadMapHeader(FYMessagePackCursor *c, NSUInteger *count) {
+    return FYMessagePackReadHeader(c, FYMessagePackMap, count) || FYMessagePackFail(c, "Expected a map");
+}
+
+static BOOL FYMessagePackSkipValueAtDepth(FYMessagePackCursor *c, NSUInteger depth) {
+    if (depth > FYMessagePackMaximumDepth) {
+        return FYMessagePackFail(c, "Maximum nesting depth exceeded");
+    } else if (c->cursor >= c->end) {
+        return FYMessagePackFail(c, "Unexpected end of data");
+    }
+    
+    uint8_t type = *c->cursor;
+    NSUInteger count;
+    if (type <= 0x7f || type >= 0xe0) {
+        c->cursor++;
+        return YES;
+    } else if (FYMessagePackIsOfFamily(type, FYMessagePackString)) {
+        return FYMessagePackReadHeader(c, FYMessagePackString, &count) && FYMessagePackAdvance(c, count);
+    } else if (FYMessagePackIsOfFamily(type, FYMessagePackBinary)) {
+        return FYMessagePackReadHeader(c, FYMessagePackBinary, &count) && FYMessagePackAdvance(c, count);
+    } else if (FYMessagePackIsOfFamily(type, FYMessagePackArray)) {
+        if (!FYMessagePackReadHeader(c, FYMessagePackArray, &count)) {
+            return NO;
+        }
+        for (NSUInteger i=0; i<count; i++) {
+            if (!FYMessagePackSkipValueAtDepth(c, depth + 1)) {
+                return NO;
+            }
+        }
+        return YES;
+    } else if (FYMessagePackIsOfFamily(type, FYMessagePackMap)) {
+        if (!FYMessagePackReadHeader(c, FYMessagePackMap, &count)) {
+            return NO;
+        }
+        for (NSUInteger i=0; i<count; i++) {
+            if (!FYMessagePackSkipValueAtDepth(c, depth + 1) || !FYMessagePackSkipValueAtDepth(c, depth + 1)) {
+                return NO;
+            }
+        }
+        return YES;
+    }
+    
+    uint64_t length;
+    switch (type) {
+        case 0xc0: case 0xc2: case 0xc3:
+            return FYMessagePackAdvance(c, 1);
+        case 0xcc: case 0xd0:
+            return FYMessagePackAdvance(c, 2);
+        case 0xcd: case 0xd1:
+            return FYMessagePackAdvance(c, 3);
+        case 0xca: case 0xce: case 0xd2:
+            return FYMessagePackAdvance(c, 5);
+        case 0xcb: case 0xcf: case 0xd3:
+            return FYMessagePackAdvance(c, 9);
+        // Extension types are never decoded, but can be skipped
+        case 0xd4: case 0xd5: case 0xd6: case 0xd7: case 0xd8:
+            return FYMessagePackAdvance(c, 2 + (1 << (type - 0xd4)));
+        case 0xc7: case 0xc8: case 0xc9:
+            c->cursor++;
+            return FYMessagePackReadBigEndian(c, 1 << (type - 0xc7), &length) && FYMessagePackAdvance(c, 1 + length);
+        default:
+            return FYMessagePackFail(c, "Unsupported type");
+    }
+}
+
+BOOL FYMessagePackSkipValue(FYMessagePackCursor *c) {
+    return FYMessagePackSkipValueAtDepth(c, 0);
+}
+
+static id FYMessagePackParseValueAtDepth(FYMessagePackCursor *c, NSUInteger depth) {
+    if (depth > FYMessagePackMaximumDepth) {
+        FYMessagePackFail(c, "Maximum nesting depth exceeded");
+        return nil;
+    } else if (c->cursor >= c->end) {
+        FYMessagePackFail(c, "Unexpected end of data");
+        return nil;
+    }
+    
+    uint8_t type = *c->cursor;
+    NSUInteger count;
+    if (type <= 0x7f) {
+        c->cursor++;
+        return [NSNumber numberWithInt:type];
+    } else if (type >= 0xe0) {
+        c->cursor++;
+        return [NSNumber numberWithInt:(int8_t)type];
+    } else if (FYMessagePackIsOfFamily(type, FYMessagePackString)) {
+        if (!FYMessagePackReadHeader(c, FYMessagePackString, &count)) {
+            return nil;
+        }
+        const uint8_t *bytes = c->cursor;
+        if (!FYMessagePackAdvance(c, count)) {
+            return nil;
+        }
+        NSString *string = [[NSString alloc] initWithBytes:bytes length:count encoding:NSUTF8StringEncoding];
+        if (!string) {
+            c->cursor = bytes;
+            FYMessagePackFail(c, "Invalid UTF-8 string");
+        }
+        return string;
+    } else if (FYMessagePackIsOfFamily(type, FYMessagePackBinary)) {
+        if (!FYMessagePackReadHeader(c, FYMessagePackBinary, &count)) {
+            return nil;
+        }
+        const uint8_t *bytes = c->cursor;
+        if (!FYMessagePackAdvance(c, count)) {
+            return nil;
+        }
+        return [[NSData alloc] initWithBytes:bytes length:count];
+    } else if (FYMessagePackIsOfFamily(type, FYMessagePackArray)) {
+        if (!FYMessagePackReadHeader(c, FYMessagePackArray, &count)) {
+            return nil;
+        }
+        // Each element needs atleast one byte, so a malformed count can't trigger a huge allocation.
+        NSMutableArray *array = [[NSMutableArray alloc] initWithCapacity:MIN(count, (NSUInteger)(c->end - c->cursor))];
+        for (NSUInteger i=0; i<count; i++) {
+            id element = FYMessagePackParseValueAtDepth(c, depth + 1);
+            if (!element) {
+                return nil;
+            }
+            [array addObject:element];
+        }
+        return array;
+    } else if (FYMessagePackIsOfFamily(type, FYMessagePackMap)) {
+        if (!FYMessagePackReadHeader(c, FYMessagePackMap, &count)) {
+            return nil;
+        }
+        NSMutableDictionary *dictionary = [[NSMutableDictionary alloc] initWithCapacity:MIN(count, (NSUInteger)(c->end - c->cursor) / 2)];
+        for (NSUInteger i=0; i<count; i++) {
+            id key = FYMessagePackParseValueAtDepth(c, depth + 1);
+            if (!key) {
+                return nil;
+            } else if (![key isKindOfClass:NSString.class]) {
+                FYMessagePackFail(c, "Expected a string key");
+                return nil;
+            }
+            id value = FYMessagePackParseValueAtDepth(c, depth + 1);
+            if (!value) {
+                return nil;
+            }
+            dictionary[key] = value;
+        }
+        return dictionary;
+    }
+    
+    uint64_t value;
+    c->cursor++;
+    switch (type) {
+        case 0xc0:
+            return NSNull.null;
+        case 0xc2:
+            return @NO;
+        case 0xc3:
+            return @YES;
+        case 0xca: {
+            if (!FYMessagePackReadBigEndian(c, 4, &value)) {
+                return nil;
+            }
+            union { uint32_t i; float f; } number = { .i = (uint32_t)value };
+            return [NSNumber numberWithFloat:number.f];
+        }
+        case 0xcb: {
+            if (!FYMessagePackReadBigEndian(c, 8, &value)) {
+                return nil;
+            }
+            union { uint64_t i; double d; } number = { .i = value };
+            return [NSNumber numberWithDouble:number.d];
+        }
+        case 0xcc: case 0xcd: case 0xce: case 0xcf:
+            if (!FYMessagePackReadBigEndian(c, 1 << (type - 0xcc), &value)) {
+                return nil;
+            }
+            return value <= LLONG_MAX
+                ? [NSNumber numberWithLongLong:(long long)value]
+                : [NSNumber numberWithUnsignedLongLong:value];
+        case 0xd0:
+            return FYMessagePackReadBigEndian(c, 1, &value) ? [NSNumber numberWithInt:(int8_t)value] : nil;
+        case 0xd1:
+            return FYMessagePackReadBigEndian(c, 2, &value) ? [NSNumber numberWithInt:(int16_t)value] : nil;
+        case 0xd2:
+            return FYMessagePackReadBigEndian(c, 4, &value) ? [NSNumber numberWithInt:(int32_t)value] : nil;
+        case 0xd3:
+            return FYMessagePackReadBigEndian(c, 8, &value) ? [NSNumber numberWithLongLong:(int64_t)value] : nil;
+        default:
+            c->cursor--;
+            FYMessagePackFail(c, "Unsupported type");
+            return nil;
+    }
+}
+
+id FYMessagePackParseValue(FYMessagePackCursor *c) {
+    return FYMessagePackParseValueAtDepth(c, 0);
+}
+
+
+
+@implementation FYMessagePack
+
++ (NSData *)dataWithObject:(id)object {
+    FYMessagePackWriter writer = { NULL, 0, 0 };
+    if (!FYMessagePackWriteValue(&writer, object, 0)) {
+        free(writer.bytes);
+        return nil;
+    }
+    return [[NSData alloc] initWithBytesNoCopy:writer.bytes length:writer.length freeWhenDone:YES];
+}
+
++ (BOOL)appendObject:(id)object toData:(NSMutableData *)data {
+    NSData *encodedData = [self dataWithObject:object];
+    if (!encodedData) {
+        return NO;
+    }
+    [data appendData:encodedData];
+    return YES;
+}
+
++ (void)appendArrayHeaderWithCount:(NSUInteger)count toData:(NSMutableData *)data {
+    NSParameterAssert((uint64_t)count <= UINT32_MAX);
+    uint8_t header[5];
+    [data appendBytes:header length:FYMessagePackStoreHeader(header, FYMessagePackArray, count)];
+}
+
++ (void)appendMapHeaderWithCount:(NSUInteger)count toData:(NSMutableData *)data {
+    NSParameterAssert((uint64_t)count <= UINT32_MAX);
+    uint8_t header[5];
+    [data appendBytes:header length:FYMessagePackStoreHeader(header, FYMessagePackMap, count)];
+}
+
++ (id)objectWithData:(NSData *)data error:(NSError **)error {
+    FYMessagePackCursor cursor = {
+        .start  = data.bytes,
+        .cursor = data.bytes,
+        .end    = (const uint8_t *)data.bytes + data.length,
+        .error  = NULL,
+    };
+    FYMessagePackCursor *c = &cursor;
+    
+    id object = FYMessagePackParseValue(c);
+    if (object && c->cursor != c->end) {
+        FYMessagePackFail(c, "Unexpected data after value");
+        object = nil;
+    }
+    if (!object && error) {
+        *error = [NSError errorWithDomain:FYErrorDomain code:FYErrorMalformedMessagePackData userInfo:@{
+            NSLocalizedDescriptionKey:        @"MessagePack data is malformed.",
+            NSLocalizedFailureReasonErrorKey: [NSString stringWithFormat:@"%s at offset %d.", c->error,
+                                               (int)(c->cursor - c->start)],
+         }];
+    }
+    return object;
+}
+
+@end
@@ -0,0 +1,91 @@
+//
+//  FYMessageTemplate.h
+//  SocketClient
+//
+//  Created by agent on 17.10.26.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+
+/**
+ A message, whose fixed fields are serialized once and which is sent many times with a few varying fields.
+ 
+ Messages to meta channels have a fixed shape per session: e.g. each /meta/connect message has the same channel,
+ clientId, connectionType and ext, only its id differs. A template serializes the fixed fields once, so that building
+ the encoded message only needs to splice in the varying fields. This works the same way for JSON and MessagePack.
+ */
+@interface FYMessageTemplate : NSObject
+
+/**
+ Initializer
+ 
+ @param message  The fixed fields of the message as an arbitrary JSON encodeable dictionary.
+ */
+- (id)initWithMessage:(NSDictionary *)message;
+
+/**
+ Initializer
+ 
+ @param message  The fixed fields of the message as an arbitrary JSON encodeable dictionary.
+ 
+ @param packed   The value for the property packed.
+ */
+- (id)initWithMessage:(NSDictionary *)message packed:(BOOL)packed;
+
+/**
+ Initializer with fixed fields, which were already serialized, e.g. to measure their size, so that they aren't
+ serialized again.
+ 
+ @param data    The fixed fields as UTF-8 encoded JSON object without trailing whitespace, or as MessagePack encoded map.
+ 
+ @param packed  The value for the property packed, which tells how data is encoded.
+ 
+ @return nil, if data is no encoded object or map.
+ */
+- (id)initWithData:(NSData *)data packed:(BOOL)packed;
+
+/**
+ Whether messages are built as MessagePack encoded maps instead of UTF-8 encoded JSON objects.
+ */
+@property (nonatomic, assign, readonly, getter=isPacked) BOOL packed;
+
+/**
+ Build the encoded message with the fixed fields and a message id.
+ 
+ @param messageId  The value of the field `id`, may be nil.
+ */
+- (NSData *)dataWithMessageId:(NSString *)messageId;
+
+/**
+ Build the encoded message with the fixed fields, a message id and further fields.
+ 
+ @param messageId  The value of the field `id`, may be nil.
+ 
+ @param fields     Further fields as an arbitrary JSON encodeable dictionary, which must not contain any fixed field.
+ */
+- (NSData *)dataWithMessageId:(NSString *)messageId fields:(NSDictionary *)fields;
+
+@end
@@ -0,0 +1,201 @@
+//
+//  FYMessageTemplate.m
+//  SocketClient
+//
+//  Created by agent on 17.10.26.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "FYMessageTemplate.h"
+#import "FYMessagePack.h"
+
+
+/*
+ Append a string as JSON string literal. Message ids and channel names mostly don't need any escaping, so they are
+ copied directly. Others are serialized by NSJSONSerialization.
+ */
+static void FYMessageTemplateAppendString(NSMutableData *data, NSString *string) {
+    char buffer[128];
+    if ([string getCString:buffer maxLength:sizeof(buffer) encoding:NSASCIIStringEncoding]) {
+        size_t length = strlen(buffer);
+        BOOL plain = YES;
+        for (size_t i=0; i<length && plain; i++) {
+            plain = buffer[i] >= 0x20 && buffer[i] != '"' && buffer[i] != '\\';
+        }
+        if (plain) {
+            [data appendBytes:"\"" length:1];
+            [data appendBytes:buffer length:length];
+            [data appendBytes:"\"" length:1];
+            return;
+        }
+    }
+    
+    // Wrap into an array, because NSJSONSerialization only accepts containers, and strip the brackets.
+    NSData *array = [NSJSONSerialization dataWithJSONObject:@[string] options:0 error:NULL];
+    [data appendBytes:(const char *)array.bytes + 1 length:array.length - 2];
+}
+
+static void FYMessageTemplateAppendValue(NSMutableData *data, id value) {
+    if ([value isKindOfClass:NSString.class]) {
+        FYMessageTemplateAppendString(data, value);
+    } else {
+        NSData *array = [NSJSONSerialization dataWithJSONObject:@[value] options:0 error:NULL];
+        NSCAssert(array, @"Field value %@ is not JSON encodeable.", value);
+        [data appendBytes:(const char *)array.bytes + 1 length:array.length - 2];
+    }
+}
+
+
+
+@interface FYMessageTemplate ()
+
+@property (nonatomic, assign, readwrite, getter=isPacked) BOOL packed;
+
+// Serialized fixed fields without the closing brace, or the packed key-value pairs without the map header
+@property (nonatomic, retain) NSData *prefix;
+
+// Count of fixed fields. If the prefix contains atleast one field, further JSON fields need a leading comma.
+@property (nonatomic, assign) NSUInteger fixedFieldCount;
+
+// Build a MessagePack encoded message
+- (NSData *)packedDataWithMessageId:(NSString *)messageId fields:(NSDictionary *)fields;
+
+@end
+
+
+@implementation FYMessageTemplate
+
+- (id)initWithMessage:(NSDictionary *)message {
+    return [self initWithMessage:message packed:NO];
+}
+
+- (id)initWithMessage:(NSDictionary *)message packed:(BOOL)packed {
+    self = [super init];
+    if (self) {
+        self.packed = packed;
+        self.fixedFieldCount = message.count;
+        
+        if (packed) {
+            // The map header contains the count of all fields, so it is written when the message is built.
+            NSMutableData *data = [NSMutableData new];
+            [message enumerateKeysAndObjectsUsingBlock:^(NSString *key, id value, BOOL *stop) {
+                if (![FYMessagePack appendObject:key toData:data] || ![FYMessagePack appendObject:value toData:data]) {
+                    NSCAssert(NO, @"Field %@ of template is not MessagePack encodeable.", key);
+                }
+             }];
+            self.prefix = data;
+        } else {
+            NSError *error = nil;
+            NSData *data = [NSJSONSerialization dataWithJSONObject:message options:0 error:&error];
+            NSAssert(data, @"Message %@ of template is not JSON encodeable: %@", message, error);
+            
+            // NSJSONSerialization writes no trailing whitespace, so the last byte is the closing brace.
+            self.prefix = [data subdataWithRange:NSMakeRange(0, data.length - 1)];
+        }
+    }
+    return self;
+}
+
+- (id)initWithData:(NSData *)data packed:(BOOL)packed {
+    self = [super init];
+    if (self) {
+        self.packed = packed;
+        
+        if (packed) {
+            // Strip the map header, which is written with the count of all fields, when the message is built.
+            FYMessagePackCursor cursor = { data.bytes, data.bytes, (const uint8_t *)data.bytes + data.length, NULL };
+            NSUInteger count;
+            if (!FYMessagePackReadMapHeader(&cursor, &count)) {
+                return nil;
+            }
+            self.fixedFieldCount = count;
+            self.prefix = [data subdataWithRange:NSMakeRange(cursor.cursor - cursor.start, cursor.end - cursor.cursor)];
+        } else {
+            const char *bytes = data.bytes;
+            if (data.length < 2 || bytes[0] != '{' || bytes[data.length - 1] != '}') {
+                return nil;
+            }
+            
+            // Only the emptiness of the object matters for the commas of further fields
+            self.fixedFieldCount = data.length > 2 ? 1 : 0;
+            self.prefix = [data subdataWithRange:NSMakeRange(0, data.length - 1)];
+        }
+    }
+    return self;
+}
+
+- (NSData *)dataWithMessageId:(NSString *)messageId {
+    return [self dataWithMessageId:messageId fields:nil];
+}
+
+- (NSData *)dataWithMessageId:(NSString *)messageId fields:(NSDictionary *)fields {
+    if (self.isPacked) {
+        return [self packedDataWithMessageId:messageId fields:fields];
+    }
+    
+    NSMutableData *data = [[NSMutableData alloc] initWithCapacity:self.prefix.length + 64];
+    [data appendData:self.prefix];
+    
+    __block BOOL needsComma = self.fixedFieldCount > 0;
+    void(^appendKey)(NSString *) = ^(NSString *key) {
+        if (needsComma) {
+            [data appendBytes:"," length:1];
+        }
+        FYMessageTemplateAppendString(data, key);
+        [data appendBytes:":" length:1];
+        needsComma = YES;
+    };
+    
+    if (messageId) {
+        appendKey(@"id");
+        FYMessageTemplateAppendString(data, messageId);
+    }
+    [fields enumerateKeysAndObjectsUsingBlock:^(NSString *key, id value, BOOL *stop) {
+        appendKey(key);
+        FYMessageTemplateAppendValue(data, value);
+     }];
+    
+    [data appendBytes:"}" length:1];
+    return data;
+}
+
+- (NSData *)packedDataWithMessageId:(NSString *)messageId fields:(NSDictionary *)fields {
+    NSMutableData *data = [[NSMutableData alloc] initWithCapacity:self.prefix.length + 64];
+    [FYMessagePack appendMapHeaderWithCount:self.fixedFieldCount + (messageId ? 1 : 0) + fields.count toData:data];
+    [data appendData:self.prefix];
+    
+    if (messageId) {
+        [FYMessagePack appendObject:@"id" toData:data];
+        [FYMessagePack appendObject:messageId toData:data];
+    }
+    [fields enumerateKeysAndObjectsUsingBlock:^(NSString *key, id value, BOOL *stop) {
+        if (![FYMessagePack appendObject:key toData:data] || ![FYMessagePack appendObject:value toData:data]) {
+            NSCAssert(NO, @"Field %@ is not MessagePack encodeable.", key);
+        }
+     }];
+    
+    return data;
+}
+
+@end
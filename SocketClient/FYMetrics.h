@@ -0,0 +1,234 @@
+//
+//  FYMetrics.h
+//  SocketClient
+//
+//  Created by agent on 17.10.26.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+
+/**
+ Count of buckets of a <FYLatencyHistogram>.
+ */
+extern const NSUInteger FYLatencyHistogramBucketCount;
+
+
+/**
+ Snapshot of a histogram of durations with HDR-style buckets.
+ 
+ Durations are counted in microseconds. Each power of two is divided into 8 linear sub-buckets, so percentiles have a
+ relative error of at most 12.5% over the whole range from 1 microsecond to several minutes. The last bucket counts all
+ longer durations.
+ */
+@interface FYLatencyHistogram : NSObject
+
+/**
+ Upper bound of the durations counted in a bucket.
+ 
+ @param  index  Index of the bucket.
+ */
++ (NSTimeInterval)upperBoundOfBucketAtIndex:(NSUInteger)index;
+
+/**
+ Count of recorded durations.
+ */
+@property (nonatomic, assign, readonly) NSUInteger count;
+
+/**
+ Sum of recorded durations in seconds.
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval sum;
+
+/**
+ Mean of recorded durations in seconds, or 0 if nothing was recorded.
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval mean;
+
+/**
+ Longest recorded duration in seconds.
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval maximum;
+
+/**
+ Counts of recorded durations per bucket as NSNumbers.
+ */
+@property (nonatomic, copy, readonly) NSArray *bucketCounts;
+
+/**
+ Estimate a percentile by the upper bound of the bucket, which contains it.
+ 
+ @param  percentile  Percentile between 0 and 100, e.g. 99.
+ 
+ @return Duration in seconds, or 0 if nothing was recorded.
+ */
+- (NSTimeInterval)valueAtPercentile:(double)percentile;
+
+@end
+
+
+/**
+ Latencies of traced messages of one channel, see [traceSamplingRate]([FYClient traceSamplingRate]).
+ 
+ Each traced message passes the trace points: receipt of its frame, parse done, route done, callback start and callback
+ end. The durations between them are recorded separately.
+ */
+@interface FYMessageTraceReport : NSObject
+
+/**
+ Channel of the traced messages.
+ */
+@property (nonatomic, copy, readonly) NSString *channel;
+
+/**
+ Durations from receipt of the frame until the message was decoded.
+ */
+@property (nonatomic, retain, readonly) FYLatencyHistogram *parseTime;
+
+/**
+ Durations from decoded message until its callbacks were looked up.
+ */
+@property (nonatomic, retain, readonly) FYLatencyHistogram *routeTime;
+
+/**
+ Durations from lookup until the callback started, which is the time spent waiting for the callbackQueue.
+ */
+@property (nonatomic, retain, readonly) FYLatencyHistogram *queueTime;
+
+/**
+ Durations of the callbacks.
+ */
+@property (nonatomic, retain, readonly) FYLatencyHistogram *callbackTime;
+
+/**
+ Durations from receipt of the frame until the callback ended.
+ */
+@property (nonatomic, retain, readonly) FYLatencyHistogram *totalTime;
+
+/**
+ Durations from the `timestamp`, which the server stamped on the message, until the callback started, corrected by the
+ estimated [serverClockOffset]([FYClient serverClockOffset]). Empty, if the server doesn't stamp messages.
+ */
+@property (nonatomic, retain, readonly) FYLatencyHistogram *publishToDeliveryTime;
+
+/**
+ Export as property list of count, mean and percentiles p50, p90, p99 and p99.9 in seconds per histogram, e.g. to store
+ it as JSON.
+ */
+- (NSDictionary *)dictionaryRepresentation;
+
+@end
+
+
+/**
+ Snapshot of the metrics of an <FYClient>, which are counted since its initialization.
+ */
+@interface FYClientMetrics : NSObject
+
+/**
+ System uptime, when the snapshot was taken.
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval uptime;
+
+/**
+ Count of received web socket frames and HTTP responses.
+ */
+@property (nonatomic, assign, readonly) uint64_t framesReceived;
+
+/**
+ Count of received bytes of frames and responses.
+ */
+@property (nonatomic, assign, readonly) uint64_t bytesReceived;
+
+/**
+ Count of sent web socket frames and HTTP messages.
+ */
+@property (nonatomic, assign, readonly) uint64_t framesSent;
+
+/**
+ Count of sent bytes of frames and messages.
+ */
+@property (nonatomic, assign, readonly) uint64_t bytesSent;
+
+/**
+ Count of received messages on all channels including meta channels.
+ */
+@property (nonatomic, assign, readonly) uint64_t messagesReceived;
+
+/**
+ Counts of received messages as NSNumbers by channel. Only the first channels up to a fixed limit are counted
+ separately, further channels are only included in messagesReceived.
+ */
+@property (nonatomic, copy, readonly) NSDictionary *messagesReceivedByChannel;
+
+/**
+ Count of received messages, which were skipped without decoding them, because nobody was subscribed to their channel.
+ They are included in messagesReceived.
+ */
+@property (nonatomic, assign, readonly) uint64_t messagesSkipped;
+
+/**
+ Count of callbacks, which were dispatched, but not executed yet.
+ */
+@property (nonatomic, assign, readonly) int64_t callbackQueueDepth;
+
+/**
+ Count of reconnects.
+ */
+@property (nonatomic, assign, readonly) uint64_t reconnectCount;
+
+/**
+ Count of messages, which were dropped instead of sent, e.g. because the connection was not open or the offline queue
+ overflowed.
+ */
+@property (nonatomic, assign, readonly) uint64_t droppedSendCount;
+
+/**
+ Durations of decoding received frames.
+ */
+@property (nonatomic, retain, readonly) FYLatencyHistogram *parseTime;
+
+/**
+ Round trip times of handshakes.
+ */
+@property (nonatomic, retain, readonly) FYLatencyHistogram *handshakeRoundTripTime;
+
+/**
+ Round trip times of connects.
+ */
+@property (nonatomic, retain, readonly) FYLatencyHistogram *connectRoundTripTime;
+
+/**
+ Bytes, which were saved on the wire by compressing outgoing and by sending compressed incoming messages. May be
+ negative, if payloads were incompressible. Stays 0, as long as SocketRocket doesn't support message codecs.
+ */
+@property (nonatomic, assign, readonly) int64_t bytesSavedByCompression;
+
+/**
+ Durations of compressing and decompressing a message, which is the CPU cost of bytesSavedByCompression.
+ */
+@property (nonatomic, retain, readonly) FYLatencyHistogram *compressionTime;
+
+@end
@@ -0,0 +1,565 @@
+//
+//  FYMetrics.m
+//  SocketClient
+//
+//  Created by agent on 17.10.26.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "FYMetrics.h"
+#import "FYMetricsRecorder.h"
+#import "FYTimestamp.h"
+#import "SocketClient_Private.h"
+
+
+const NSUInteger FYLatencyHistogramBucketCount = FYHistogramCountersBucketCount;
+const NSUInteger FYMetricsRecorderMaximumChannelCount = 1024;
+const NSUInteger FYMessageTracerMaximumChannelCount = 256;
+
+
+/*
+ Counter of one channel. Slots are only appended by a single writer and never removed, so that readers can take all
+ published slots without a lock.
+ */
+typedef struct FYChannelSlot {
+    CFStringRef channel;
+    _Atomic(int64_t) count;   // used by FYMetricsRecorder
+    void *object;             // retained, used by FYMessageTracer
+} FYChannelSlot;
+
+
+void FYHistogramCountersRecord(FYHistogramCounters *counters, NSTimeInterval duration) {
+    int64_t microseconds = duration > 0 ? (int64_t)(duration * 1e6) : 0;
+    
+    // Values below 8 have an own bucket each. Larger values are indexed by their magnitude, which is the index of the
+    // highest set bit, and the next 3 bits as sub-bucket.
+    NSUInteger index = (NSUInteger)microseconds;
+    if (microseconds >= 8) {
+        NSUInteger magnitude = 63 - __builtin_clzll((uint64_t)microseconds);
+        NSUInteger subBucket = (NSUInteger)(microseconds >> (magnitude - 3)) & 7;
+        index = (magnitude - 2) * 8 + subBucket;
+    }
+    index = MIN(index, FYLatencyHistogramBucketCount - 1);
+    
+    // Counters are independent of each other, so they don't need to be ordered
+    atomic_fetch_add_explicit(&counters->buckets[index], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&counters->count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&counters->sum, microseconds, memory_order_relaxed);
+    
+    int64_t maximum = atomic_load_explicit(&counters->maximum, memory_order_relaxed);
+    while (microseconds > maximum
+           && !atomic_compare_exchange_weak_explicit(&counters->maximum, &maximum, microseconds,
+                                                     memory_order_relaxed, memory_order_relaxed)) {
+        // maximum was reloaded by the failed exchange
+    }
+}
+
+
+
+@interface FYLatencyHistogram ()
+
+@property (nonatomic, assign, readwrite) NSUInteger count;
+@property (nonatomic, assign, readwrite) NSTimeInterval sum;
+@property (nonatomic, assign, readwrite) NSTimeInterval maximum;
+@property (nonatomic, copy, readwrite) NSArray *bucketCounts;
+
+- (id)initWithCounters:(const FYHistogramCounters *)counters;
+
+@end
+
+
+@implementation FYLatencyHistogram
+
++ (NSTimeInterval)upperBoundOfBucketAtIndex:(NSUInteger)index {
+    if (index >= FYLatencyHistogramBucketCount - 1) {
+        return INFINITY;
+    }
+    if (index < 8) {
+        return (index + 1) / 1e6;
+    }
+    NSUInteger magnitude = index / 8 + 2, subBucket = index % 8;
+    return ldexp(9 + subBucket, (int)magnitude - 3) / 1e6;
+}
+
+- (id)initWithCounters:(const FYHistogramCounters *)counters {
+    self = [super init];
+    if (self) {
+        NSMutableArray *bucketCounts = [[NSMutableArray alloc] initWithCapacity:FYLatencyHistogramBucketCount];
+        for (NSUInteger i=0; i<FYLatencyHistogramBucketCount; i++) {
+            [bucketCounts addObject:@(atomic_load_explicit(&counters->buckets[i], memory_order_relaxed))];
+        }
+        self.bucketCounts = bucketCounts;
+        self.count   = (NSUInteger)atomic_load_explicit(&counters->count, memory_order_relaxed);
+        self.sum     = atomic_load_explicit(&counters->sum, memory_order_relaxed) / 1e6;
+        self.maximum = atomic_load_explicit(&counters->maximum, memory_order_relaxed) / 1e6;
+    }
+    return self;
+}
+
+- (NSTimeInterval)mean {
+    return self.count > 0 ? self.sum / self.count : 0;
+}
+
+- (NSTimeInterval)valueAtPercentile:(double)percentile {
+    // Sum of the buckets may differ slightly from count, because they are read one after another
+    uint64_t total = 0;
+    for (NSNumber *bucketCount in self.bucketCounts) {
+        total += bucketCount.unsignedLongLongValue;
+    }
+    if (total == 0) {
+        return 0;
+    }
+    
+    uint64_t rank = (uint64_t)ceil(total * MIN(MAX(percentile, 0), 100) / 100.0), seen = 0;
+    for (NSUInteger i=0; i<self.bucketCounts.count; i++) {
+        seen += [self.bucketCounts[i] unsignedLongLongValue];
+        if (seen >= MAX(rank, 1)) {
+            return MIN([self.class upperBoundOfBucketAtIndex:i], self.maximum);
+        }
+    }
+    return self.maximum;
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"<%@: %p> count: %d, mean: %.6fs, p99: %.6fs, max: %.6fs", self.class, self,
+            (int)self.count, self.mean, [self valueAtPercentile:99], self.maximum];
+}
+
+@end
+
+
+
+@interface FYMessageTraceReport ()
+
+@property (nonatomic, copy,   readwrite) NSString *channel;
+@property (nonatomic, retain, readwrite) FYLatencyHistogram *parseTime;
+@property (nonatomic, retain, readwrite) FYLatencyHistogram *routeTime;
+@property (nonatomic, retain, readwrite) FYLatencyHistogram *queueTime;
+@property (nonatomic, retain, readwrite) FYLatencyHistogram *callbackTime;
+@property (nonatomic, retain, readwrite) FYLatencyHistogram *totalTime;
+@property (nonatomic, retain, readwrite) FYLatencyHistogram *publishToDeliveryTime;
+
+@end
+
+
+@implementation FYMessageTraceReport
+
+- (NSDictionary *)dictionaryRepresentation {
+    NSDictionary *histograms = @{
+        @"parseTime":             self.parseTime,
+        @"routeTime":             self.routeTime,
+        @"queueTime":             self.queueTime,
+        @"callbackTime":          self.callbackTime,
+        @"totalTime":             self.totalTime,
+        @"publishToDeliveryTime": self.publishToDeliveryTime,
+     };
+    NSMutableDictionary *representation = [NSMutableDictionary new];
+    representation[@"channel"] = self.channel;
+    [histograms enumerateKeysAndObjectsUsingBlock:^(NSString *key, FYLatencyHistogram *histogram, BOOL *stop) {
+        representation[key] = @{
+            @"count": @(histogram.count),
+            @"mean":  @(histogram.mean),
+            @"p50":   @([histogram valueAtPercentile:50]),
+            @"p90":   @([histogram valueAtPercentile:90]),
+            @"p99":   @([histogram valueAtPercentile:99]),
+            @"p999":  @([histogram valueAtPercentile:99.9]),
+            @"max":   @(histogram.maximum),
+         };
+     }];
+    return representation;
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"<%@: %p> %@", self.class, self, self.dictionaryRepresentation];
+}
+
+@end
+
+
+@interface FYClientMetrics ()
+
+@property (nonatomic, assign, readwrite) NSTimeInterval uptime;
+@property (nonatomic, assign, readwrite) uint64_t framesReceived;
+@property (nonatomic, assign, readwrite) uint64_t bytesReceived;
+@property (nonatomic, assign, readwrite) uint64_t framesSent;
+@property (nonatomic, assign, readwrite) uint64_t bytesSent;
+@property (nonatomic, assign, readwrite) uint64_t messagesReceived;
+@property (nonatomic, copy,   readwrite) NSDictionary *messagesReceivedByChannel;
+@property (nonatomic, assign, readwrite) uint64_t messagesSkipped;
+@property (nonatomic, assign, readwrite) int64_t callbackQueueDepth;
+@property (nonatomic, assign, readwrite) uint64_t reconnectCount;
+@property (nonatomic, assign, readwrite) uint64_t droppedSendCount;
+@property (nonatomic, retain, readwrite) FYLatencyHistogram *parseTime;
+@property (nonatomic, retain, readwrite) FYLatencyHistogram *handshakeRoundTripTime;
+@property (nonatomic, retain, readwrite) FYLatencyHistogram *connectRoundTripTime;
+@property (nonatomic, assign, readwrite) int64_t bytesSavedByCompression;
+@property (nonatomic, retain, readwrite) FYLatencyHistogram *compressionTime;
+
+@end
+
+
+@implementation FYClientMetrics
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"<%@: %p> frames in: %llu (%llu bytes), frames out: %llu (%llu bytes), "
+            "messages: %llu (%llu skipped), callback queue depth: %lld, reconnects: %llu, dropped sends: %llu, "
+            "parse time: %@, handshake RTT: %@, connect RTT: %@, saved by compression: %lld bytes, "
+            "compression time: %@", self.class,
+            self, self.framesReceived, self.bytesReceived, self.framesSent, self.bytesSent, self.messagesReceived,
+            self.messagesSkipped, self.callbackQueueDepth, self.reconnectCount, self.droppedSendCount, self.parseTime,
+            self.handshakeRoundTripTime, self.connectRoundTripTime, self.bytesSavedByCompression,
+            self.compressionTime];
+}
+
+@end
+
+
+
+@implementation FYMetricsRecorder {
+    _Atomic(int64_t) _framesReceived;
+    _Atomic(int64_t) _bytesReceived;
+    _Atomic(int64_t) _framesSent;
+    _Atomic(int64_t) _bytesSent;
+    _Atomic(int64_t) _messagesReceived;
+    _Atomic(int64_t) _messagesSkipped;
+    _Atomic(int64_t) _callbackQueueDepth;
+    _Atomic(int64_t) _reconnectCount;
+    _Atomic(int64_t) _droppedSendCount;
+    _Atomic(int64_t) _bytesSavedByCompression;
+    FYHistogramCounters _parseTime;
+    FYHistogramCounters _handshakeRoundTripTime;
+    FYHistogramCounters _connectRoundTripTime;
+    FYHistogramCounters _compressionTime;
+    
+    // Counts by channel: slots are appended by the workerQueue and published by their count. The index of the slots
+    // is only accessed on the workerQueue.
+    FYChannelSlot *_channelSlots;
+    _Atomic(NSUInteger) _channelSlotCount;
+    CFMutableDictionaryRef _channelSlotIndexes;
+}
+
+- (id)init {
+    self = [super init];
+    if (self) {
+        _channelSlots = calloc(FYMetricsRecorderMaximumChannelCount, sizeof(FYChannelSlot));
+        atomic_init(&_channelSlotCount, 0);
+        _channelSlotIndexes = CFDictionaryCreateMutable(NULL, 0, &kCFTypeDictionaryKeyCallBacks, NULL);
+    }
+    return self;
+}
+
+- (void)dealloc {
+    NSUInteger count = atomic_load_explicit(&_channelSlotCount, memory_order_relaxed);
+    for (NSUInteger i=0; i<count; i++) {
+        CFRelease(_channelSlots[i].channel);
+    }
+    free(_channelSlots);
+    CFRelease(_channelSlotIndexes);
+}
+
+- (void)recordFrameReceivedWithLength:(NSUInteger)length {
+    atomic_fetch_add_explicit(&_framesReceived, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&_bytesReceived, length, memory_order_relaxed);
+}
+
+- (void)recordFrameSentWithLength:(NSUInteger)length {
+    atomic_fetch_add_explicit(&_framesSent, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&_bytesSent, length, memory_order_relaxed);
+}
+
+- (void)recordMessageOnChannel:(NSString *)channel {
+    atomic_fetch_add_explicit(&_messagesReceived, 1, memory_order_relaxed);
+    if (!channel) {
+        return;
+    }
+    
+    // The workerQueue is the only writer, so the slot of a known channel is only counted up
+    const void *index;
+    if (CFDictionaryGetValueIfPresent(_channelSlotIndexes, (__bridge CFStringRef)channel, &index)) {
+        atomic_fetch_add_explicit(&_channelSlots[(uintptr_t)index].count, 1, memory_order_relaxed);
+        return;
+    }
+    
+    NSUInteger count = atomic_load_explicit(&_channelSlotCount, memory_order_relaxed);
+    if (count >= FYMetricsRecorderMaximumChannelCount) {
+        return;
+    }
+    FYChannelSlot *slot = &_channelSlots[count];
+    slot->channel = CFStringCreateCopy(NULL, (__bridge CFStringRef)channel);
+    atomic_store_explicit(&slot->count, 1, memory_order_relaxed);
+    CFDictionarySetValue(_channelSlotIndexes, slot->channel, (const void *)(uintptr_t)count);
+    
+    // Publish the filled slot
+    atomic_store_explicit(&_channelSlotCount, count + 1, memory_order_release);
+}
+
+- (void)recordSkippedMessageOnChannel:(NSString *)channel {
+    atomic_fetch_add_explicit(&_messagesSkipped, 1, memory_order_relaxed);
+    [self recordMessageOnChannel:channel];
+}
+
+- (void)recordParseTime:(NSTimeInterval)duration {
+    FYHistogramCountersRecord(&_parseTime, duration);
+}
+
+- (void)recordHandshakeRoundTripTime:(NSTimeInterval)duration {
+    FYHistogramCountersRecord(&_handshakeRoundTripTime, duration);
+}
+
+- (void)recordConnectRoundTripTime:(NSTimeInterval)duration {
+    FYHistogramCountersRecord(&_connectRoundTripTime, duration);
+}
+
+- (void)recordReconnect {
+    atomic_fetch_add_explicit(&_reconnectCount, 1, memory_order_relaxed);
+}
+
+- (void)recordDroppedSendCount:(NSUInteger)count {
+    atomic_fetch_add_explicit(&_droppedSendCount, count, memory_order_relaxed);
+}
+
+- (void)recordCallbacksDispatched:(NSUInteger)count {
+    atomic_fetch_add_explicit(&_callbackQueueDepth, count, memory_order_relaxed);
+}
+
+- (void)recordCallbacksExecuted:(NSUInteger)count {
+    atomic_fetch_add_explicit(&_callbackQueueDepth, -(int64_t)count, memory_order_relaxed);
+}
+
+- (void)recordCompressionOfLength:(NSUInteger)length toLength:(NSUInteger)compressedLength duration:(NSTimeInterval)duration {
+    int64_t saved = (int64_t)length - (int64_t)compressedLength;
+    atomic_fetch_add_explicit(&_bytesSavedByCompression, saved, memory_order_relaxed);
+    FYHistogramCountersRecord(&_compressionTime, duration);
+}
+
+- (FYClientMetrics *)snapshot {
+    FYClientMetrics *metrics = [FYClientMetrics new];
+    metrics.uptime           = NSProcessInfo.processInfo.systemUptime;
+    metrics.framesReceived   = atomic_load_explicit(&_framesReceived, memory_order_relaxed);
+    metrics.bytesReceived    = atomic_load_explicit(&_bytesReceived, memory_order_relaxed);
+    metrics.framesSent       = atomic_load_explicit(&_framesSent, memory_order_relaxed);
+    metrics.bytesSent        = atomic_load_explicit(&_bytesSent, memory_order_relaxed);
+    metrics.messagesReceived = atomic_load_explicit(&_messagesReceived, memory_order_relaxed);
+    metrics.messagesSkipped  = atomic_load_explicit(&_messagesSkipped, memory_order_relaxed);
+    metrics.callbackQueueDepth = atomic_load_explicit(&_callbackQueueDepth, memory_order_relaxed);
+    metrics.reconnectCount   = atomic_load_explicit(&_reconnectCount, memory_order_relaxed);
+    metrics.droppedSendCount = atomic_load_explicit(&_droppedSendCount, memory_order_relaxed);
+    metrics.bytesSavedByCompression = atomic_load_explicit(&_bytesSavedByCompression, memory_order_relaxed);
+    metrics.parseTime              = [[FYLatencyHistogram alloc] initWithCounters:&_parseTime];
+    metrics.handshakeRoundTripTime = [[FYLatencyHistogram alloc] initWithCounters:&_handshakeRoundTripTime];
+    metrics.connectRoundTripTime   = [[FYLatencyHistogram alloc] initWithCounters:&_connectRoundTripTime];
+    metrics.compressionTime        = [[FYLatencyHistogram alloc] initWithCounters:&_compressionTime];
+    
+    NSUInteger channelCount = atomic_load_explicit(&_channelSlotCount, memory_order_acquire);
+    NSMutableDictionary *messagesReceivedByChannel = [[NSMutableDictionary alloc] initWithCapacity:channelCount];
+    for (NSUInteger i=0; i<channelCount; i++) {
+        int64_t count = atomic_load_explicit(&_channelSlots[i].count, memory_order_relaxed);
+        messagesReceivedByChannel[(__bridge NSString *)_channelSlots[i].channel] = @(count);
+    }
+    metrics.messagesReceivedByChannel = messagesReceivedByChannel;
+    
+    return metrics;
+}
+
+@end
+
+
+
+/*
+ Histograms of the trace points of one channel
+ */
+@interface FYMessageTraceCounters : NSObject {
+    @public
+    FYHistogramCounters _parseTime;
+    FYHistogramCounters _routeTime;
+    FYHistogramCounters _queueTime;
+    FYHistogramCounters _callbackTime;
+    FYHistogramCounters _totalTime;
+    FYHistogramCounters _publishToDeliveryTime;
+}
+@end
+
+@implementation FYMessageTraceCounters
+@end
+
+
+
+@interface FYMessageTrace ()
+
+// Histograms of the channel, which are looked up once, when the message is sampled
+@property (nonatomic, retain, readonly) FYMessageTraceCounters *counters;
+
+- (id)initWithChannel:(NSString *)channel receivedUptime:(NSTimeInterval)receivedUptime
+         parsedUptime:(NSTimeInterval)parsedUptime counters:(FYMessageTraceCounters *)counters;
+
+@end
+
+
+@implementation FYMessageTrace
+
+- (id)initWithChannel:(NSString *)channel receivedUptime:(NSTimeInterval)receivedUptime
+         parsedUptime:(NSTimeInterval)parsedUptime counters:(FYMessageTraceCounters *)counters {
+    self = [super init];
+    if (self) {
+        _channel        = channel;
+        _receivedUptime = receivedUptime;
+        _parsedUptime   = parsedUptime;
+        _serverTime     = NAN;
+        _counters       = counters;
+    }
+    return self;
+}
+
+@end
+
+
+
+@interface FYMessageTracer ()
+
+- (FYMessageTraceCounters *)countersOfChannel:(NSString *)channel;
+
+@end
+
+
+@implementation FYMessageTracer {
+    // Credit for the next sample, only accessed on the workerQueue
+    double _samplingCredit;
+    
+    // Counters by channel: slots are appended by the workerQueue and published by their count. The index of the slots
+    // is only accessed on the workerQueue.
+    FYChannelSlot *_channelSlots;
+    _Atomic(NSUInteger) _channelSlotCount;
+    CFMutableDictionaryRef _channelSlotIndexes;
+}
+
+- (id)init {
+    self = [super init];
+    if (self) {
+        _channelSlots = calloc(FYMessageTracerMaximumChannelCount, sizeof(FYChannelSlot));
+        atomic_init(&_channelSlotCount, 0);
+        _channelSlotIndexes = CFDictionaryCreateMutable(NULL, 0, &kCFTypeDictionaryKeyCallBacks, NULL);
+    }
+    return self;
+}
+
+- (void)dealloc {
+    NSUInteger count = atomic_load_explicit(&_channelSlotCount, memory_order_relaxed);
+    for (NSUInteger i=0; i<count; i++) {
+        CFRelease(_channelSlots[i].channel);
+        CFBridgingRelease(_channelSlots[i].object);
+    }
+    free(_channelSlots);
+    CFRelease(_channelSlotIndexes);
+}
+
+- (FYMessageTrace *)sampleMessageOnChannel:(NSString *)channel receivedUptime:(NSTimeInterval)receivedUptime {
+    if (self.samplingRate <= 0 || !channel) {
+        return nil;
+    }
+    
+    // Sample deterministically every 1/samplingRate-th message, which avoids calling a random number generator
+    _samplingCredit += self.samplingRate;
+    if (_samplingCredit < 1) {
+        return nil;
+    }
+    _samplingCredit -= 1;
+    
+    FYMessageTraceCounters *counters = [self countersOfChannel:channel];
+    if (!counters) {
+        // Too many channels are traced already
+        return nil;
+    }
+    return [[FYMessageTrace alloc] initWithChannel:channel receivedUptime:receivedUptime
+                                      parsedUptime:NSProcessInfo.processInfo.systemUptime counters:counters];
+}
+
+- (FYMessageTraceCounters *)countersOfChannel:(NSString *)channel {
+    // Has to be called on the workerQueue, which is the only writer of the slots
+    const void *index;
+    if (CFDictionaryGetValueIfPresent(_channelSlotIndexes, (__bridge CFStringRef)channel, &index)) {
+        return (__bridge FYMessageTraceCounters *)_channelSlots[(uintptr_t)index].object;
+    }
+    
+    NSUInteger count = atomic_load_explicit(&_channelSlotCount, memory_order_relaxed);
+    if (count >= FYMessageTracerMaximumChannelCount) {
+        return nil;
+    }
+    FYMessageTraceCounters *counters = [FYMessageTraceCounters new];
+    FYChannelSlot *slot = &_channelSlots[count];
+    slot->channel = CFStringCreateCopy(NULL, (__bridge CFStringRef)channel);
+    slot->object  = (__bridge_retained void *)counters;
+    CFDictionarySetValue(_channelSlotIndexes, slot->channel, (const void *)(uintptr_t)count);
+    
+    // Publish the filled slot
+    atomic_store_explicit(&_channelSlotCount, count + 1, memory_order_release);
+    return counters;
+}
+
+- (void)recordRoutedTrace:(FYMessageTrace *)trace {
+    FYMessageTraceCounters *counters = trace.counters;
+    if (!counters) {
+        return;
+    }
+    FYHistogramCountersRecord(&counters->_parseTime, trace.parsedUptime - trace.receivedUptime);
+    FYHistogramCountersRecord(&counters->_routeTime, trace.routedUptime - trace.parsedUptime);
+}
+
+- (void)recordTrace:(FYMessageTrace *)trace callbackStartUptime:(NSTimeInterval)startUptime
+    callbackEndUptime:(NSTimeInterval)endUptime {
+    FYMessageTraceCounters *counters = trace.counters;
+    if (!counters) {
+        return;
+    }
+    FYHistogramCountersRecord(&counters->_parseTime,    trace.parsedUptime - trace.receivedUptime);
+    FYHistogramCountersRecord(&counters->_routeTime,    trace.routedUptime - trace.parsedUptime);
+    FYHistogramCountersRecord(&counters->_queueTime,    startUptime - trace.routedUptime);
+    FYHistogramCountersRecord(&counters->_callbackTime, endUptime - startUptime);
+    FYHistogramCountersRecord(&counters->_totalTime,    endUptime - trace.receivedUptime);
+    if (!isnan(trace.serverTime)) {
+        // Convert the server time to uptime by the current offset between wall clock and uptime
+        NSTimeInterval uptimeOffset = FYTimestampNow() - NSProcessInfo.processInfo.systemUptime;
+        FYHistogramCountersRecord(&counters->_publishToDeliveryTime, startUptime + uptimeOffset - trace.serverTime);
+    }
+}
+
+- (NSDictionary *)reports {
+    NSUInteger channelCount = atomic_load_explicit(&_channelSlotCount, memory_order_acquire);
+    NSMutableDictionary *reports = [[NSMutableDictionary alloc] initWithCapacity:channelCount];
+    for (NSUInteger i=0; i<channelCount; i++) {
+        NSString *channel = (__bridge NSString *)_channelSlots[i].channel;
+        FYMessageTraceCounters *counters = (__bridge FYMessageTraceCounters *)_channelSlots[i].object;
+        FYMessageTraceReport *report = [FYMessageTraceReport new];
+        report.channel               = channel;
+        report.parseTime             = [[FYLatencyHistogram alloc] initWithCounters:&counters->_parseTime];
+        report.routeTime             = [[FYLatencyHistogram alloc] initWithCounters:&counters->_routeTime];
+        report.queueTime             = [[FYLatencyHistogram alloc] initWithCounters:&counters->_queueTime];
+        report.callbackTime          = [[FYLatencyHistogram alloc] initWithCounters:&counters->_callbackTime];
+        report.totalTime             = [[FYLatencyHistogram alloc] initWithCounters:&counters->_totalTime];
+        report.publishToDeliveryTime = [[FYLatencyHistogram alloc] initWithCounters:&counters->_publishToDeliveryTime];
+        reports[channel] = report;
+    }
+    return reports;
+}
+
+@end
@@ -0,0 +1,164 @@
+//
+//  FYMetricsRecorder.h
+//  SocketClient
+//
+//  Created by agent on 17.10.26.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+#import <stdatomic.h>
+#import "FYMetrics.h"
+
+
+/**
+ Maximum count of channels, whose messages are counted separately.
+ */
+extern const NSUInteger FYMetricsRecorderMaximumChannelCount;
+
+
+/**
+ Maximum count of channels, whose messages are traced.
+ */
+extern const NSUInteger FYMessageTracerMaximumChannelCount;
+
+
+/**
+ Count of buckets of FYHistogramCounters: 8 linear ones below 8 microseconds and 8 sub-buckets for each further power of
+ two up to 2^28 microseconds.
+ */
+enum {
+    FYHistogramCountersBucketCount = 216,
+};
+
+
+/**
+ Atomic counters of a histogram, see <FYLatencyHistogram>.
+ */
+typedef struct FYHistogramCounters {
+    _Atomic(int64_t) buckets[FYHistogramCountersBucketCount];
+    _Atomic(int64_t) count;
+    _Atomic(int64_t) sum;      // in microseconds
+    _Atomic(int64_t) maximum;  // in microseconds
+} FYHistogramCounters;
+
+
+/**
+ Record a duration into histogram counters. This is thread-safe and doesn't block.
+ 
+ @param  counters  The counters of the histogram.
+ 
+ @param  duration  Duration in seconds. Negative durations are counted as 0.
+ */
+extern void FYHistogramCountersRecord(FYHistogramCounters *counters, NSTimeInterval duration);
+
+
+/**
+ Records the metrics of an FYClient.
+ 
+ All counters are updated by atomic operations, so recording is thread-safe and doesn't block. The per-channel
+ counts have a single writer: recordMessageOnChannel: and recordSkippedMessageOnChannel: have to be called on the
+ workerQueue, while snapshot may be taken on any thread.
+ */
+@interface FYMetricsRecorder : NSObject
+
+- (void)recordFrameReceivedWithLength:(NSUInteger)length;
+- (void)recordFrameSentWithLength:(NSUInteger)length;
+- (void)recordMessageOnChannel:(NSString *)channel;
+- (void)recordSkippedMessageOnChannel:(NSString *)channel;
+- (void)recordParseTime:(NSTimeInterval)duration;
+- (void)recordHandshakeRoundTripTime:(NSTimeInterval)duration;
+- (void)recordConnectRoundTripTime:(NSTimeInterval)duration;
+- (void)recordReconnect;
+- (void)recordDroppedSendCount:(NSUInteger)count;
+- (void)recordCallbacksDispatched:(NSUInteger)count;
+- (void)recordCallbacksExecuted:(NSUInteger)count;
+- (void)recordCompressionOfLength:(NSUInteger)length toLength:(NSUInteger)compressedLength duration:(NSTimeInterval)duration;
+
+/**
+ Take a consistent snapshot of each counter. Counters are read one after another, so counters may be off by the
+ updates, which were recorded meanwhile.
+ */
+- (FYClientMetrics *)snapshot;
+
+@end
+
+
+
+/**
+ Trace points of a sampled message. Uptimes are 0 for points, which weren't passed yet.
+ */
+@interface FYMessageTrace : NSObject
+
+@property (nonatomic, retain, readonly) NSString *channel;
+@property (nonatomic, assign, readonly) NSTimeInterval receivedUptime;
+@property (nonatomic, assign, readonly) NSTimeInterval parsedUptime;
+@property (nonatomic, assign) NSTimeInterval routedUptime;
+
+/**
+ Time, when the server stamped the message, corrected to the local clock. NAN if not stamped, or if the server's clock
+ offset is not known.
+ */
+@property (nonatomic, assign) NSTimeInterval serverTime;
+
+@end
+
+
+/**
+ Samples received messages and records their trace points per channel.
+ 
+ sampleMessageOnChannel:... has to be called on the workerQueue. recordTrace:... is thread-safe and doesn't block, as a
+ trace carries the counters of its channel, which are looked up once when the message is sampled.
+ */
+@interface FYMessageTracer : NSObject
+
+/**
+ Fraction of messages to trace between 0 and 1. A value of 0 disables tracing.
+ */
+@property (nonatomic, assign) double samplingRate;
+
+/**
+ Decide whether to trace a decoded message and start its trace. The parse is done at the time of the call.
+ 
+ @return A trace, if the message was sampled, otherwise nil. Its route and server time have to be set by the caller.
+ */
+- (FYMessageTrace *)sampleMessageOnChannel:(NSString *)channel receivedUptime:(NSTimeInterval)receivedUptime;
+
+/**
+ Record the trace of a message, whose callback was executed.
+ */
+- (void)recordTrace:(FYMessageTrace *)trace callbackStartUptime:(NSTimeInterval)startUptime
+    callbackEndUptime:(NSTimeInterval)endUptime;
+
+/**
+ Record the trace of a message, which was delivered through a batch or a delivery queue, up to its routing.
+ */
+- (void)recordRoutedTrace:(FYMessageTrace *)trace;
+
+/**
+ Snapshot of the traces as FYMessageTraceReport by channel.
+ */
+- (NSDictionary *)reports;
+
+@end
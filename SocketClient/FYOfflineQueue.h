@@ -0,0 +1,102 @@
+//
+//  FYOfflineQueue.h
+//  SocketClient
+//
+//  Created by agent on 17.10.26.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+
+/**
+ Policy, which decides which objects are dropped, when an <FYOfflineQueue> would exceed its limits.
+ */
+typedef NS_ENUM(NSUInteger, FYOfflineQueueOverflowPolicy) {
+    /// Drop the oldest objects to make room for the new object.
+    FYOfflineQueueOverflowPolicyDropOldest = 0,
+    
+    /// Drop the new object and keep the queued objects.
+    FYOfflineQueueOverflowPolicyDropNewest,
+    
+    /// Replace an object queued with the same key by the new object, and drop the oldest objects if this doesn't
+    /// suffice. Use this to keep only the latest state per channel.
+    FYOfflineQueueOverflowPolicyCoalesceByKey,
+};
+
+
+/**
+ A FIFO queue bounded by count and by size in bytes of its objects, which holds outgoing messages while the client has
+ no open connection.
+ 
+ The queue is not thread-safe.
+ */
+@interface FYOfflineQueue : NSObject
+
+/**
+ Maximum count of queued objects. A value of 0 doesn't limit the count.
+ */
+@property (nonatomic, assign) NSUInteger maximumCount;
+
+/**
+ Maximum sum of the sizes of queued objects. A value of 0 doesn't limit the size.
+ */
+@property (nonatomic, assign) NSUInteger maximumSize;
+
+/**
+ Policy, which is applied on enqueue, when the limits would be exceeded.
+ */
+@property (nonatomic, assign) FYOfflineQueueOverflowPolicy overflowPolicy;
+
+/**
+ Count of queued objects.
+ */
+@property (nonatomic, assign, readonly) NSUInteger count;
+
+/**
+ Sum of the sizes of queued objects.
+ */
+@property (nonatomic, assign, readonly) NSUInteger size;
+
+/**
+ Append an object to the queue and apply the overflow policy.
+ 
+ @param object  The object to queue.
+ 
+ @param size    The size of the object in bytes, which is accounted against maximumSize.
+ 
+ @param key     The key used by FYOfflineQueueOverflowPolicyCoalesceByKey, e.g. a channel name. May be nil.
+ 
+ @return The objects, which were dropped, in the order they were queued. This may contain the given object itself.
+ */
+- (NSArray *)enqueueObject:(id)object size:(NSUInteger)size key:(NSString *)key;
+
+/**
+ Remove all objects from the queue.
+ 
+ @return The removed objects in the order they were queued.
+ */
+- (NSArray *)dequeueAllObjects;
+
+@end
@@ -0,0 +1,132 @@
+//
+//  FYOfflineQueue.m
+//  SocketClient
+//
+//  Created by agent on 17.10.26.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "FYOfflineQueue.h"
+
+
+/*
+ Entry of the queue, which holds the accounting information of an object
+ */
+@interface FYOfflineQueueEntry : NSObject {
+    @public
+    id _object;
+    NSUInteger _size;
+    NSString *_key;
+}
+@end
+
+@implementation FYOfflineQueueEntry
+@end
+
+
+
+@interface FYOfflineQueue ()
+
+@property (nonatomic, retain) NSMutableArray *entries;
+@property (nonatomic, assign, readwrite) NSUInteger size;
+
+- (BOOL)exceedsLimitsWithSize:(NSUInteger)size;
+
+@end
+
+
+@implementation FYOfflineQueue
+
+- (id)init {
+    self = [super init];
+    if (self) {
+        self.entries = [NSMutableArray new];
+    }
+    return self;
+}
+
+- (NSUInteger)count {
+    return self.entries.count;
+}
+
+- (BOOL)exceedsLimitsWithSize:(NSUInteger)size {
+    return (self.maximumCount > 0 && self.entries.count + 1 > self.maximumCount)
+        || (self.maximumSize  > 0 && self.size + size > self.maximumSize);
+}
+
+- (NSArray *)enqueueObject:(id)object size:(NSUInteger)size key:(NSString *)key {
+    NSParameterAssert(object);
+    NSMutableArray *droppedObjects = [NSMutableArray new];
+    
+    if (self.overflowPolicy == FYOfflineQueueOverflowPolicyCoalesceByKey && key) {
+        // Replace the older object with the same key, regardless whether the limits are reached.
+        NSUInteger index = [self.entries indexOfObjectPassingTest:^BOOL(FYOfflineQueueEntry *entry, NSUInteger idx, BOOL *stop) {
+            return [entry->_key isEqualToString:key];
+         }];
+        if (index != NSNotFound) {
+            FYOfflineQueueEntry *entry = self.entries[index];
+            [droppedObjects addObject:entry->_object];
+            self.size -= entry->_size;
+            [self.entries removeObjectAtIndex:index];
+        }
+    }
+    
+    if ([self exceedsLimitsWithSize:size]) {
+        if (self.overflowPolicy == FYOfflineQueueOverflowPolicyDropNewest
+            || (self.maximumSize > 0 && size > self.maximumSize)) {
+            // The new object is dropped, and also if it would never fit.
+            [droppedObjects addObject:object];
+            return droppedObjects;
+        }
+        
+        // Drop the oldest objects until the new object fits
+        while (self.entries.count > 0 && [self exceedsLimitsWithSize:size]) {
+            FYOfflineQueueEntry *entry = self.entries[0];
+            [droppedObjects addObject:entry->_object];
+            self.size -= entry->_size;
+            [self.entries removeObjectAtIndex:0];
+        }
+    }
+    
+    FYOfflineQueueEntry *entry = [FYOfflineQueueEntry new];
+    entry->_object = object;
+    entry->_size   = size;
+    entry->_key    = key;
+    [self.entries addObject:entry];
+    self.size += size;
+    
+    return droppedObjects;
+}
+
+- (NSArray *)dequeueAllObjects {
+    NSMutableArray *objects = [[NSMutableArray alloc] initWithCapacity:self.entries.count];
+    for (FYOfflineQueueEntry *entry in self.entries) {
+        [objects addObject:entry->_object];
+    }
+    [self.entries removeAllObjects];
+    self.size = 0;
+    return objects;
+}
+
+@end
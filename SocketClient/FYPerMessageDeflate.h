@@ -0,0 +1,125 @@
+//
+//  FYPerMessageDeflate.h
+//  SocketClient
+//
+//  Created by agent on 17.10.26.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+@class FYMetricsRecorder;
+
+
+/**
+ Token of the extension in the header Sec-WebSocket-Extensions.
+ */
+extern NSString *const FYPerMessageDeflateExtensionName;
+
+
+/**
+ Transforms the payloads of messages by a negotiated WebSocket extension.
+ 
+ This is the seam to the WebSocket implementation: it sends extensionOffer in the opening handshake, passes the
+ accepted extensions of the server's response to acceptExtensionResponse:, sets the RSV1 bit of frames of encoded
+ messages and passes it on for received messages. It is assigned by `-[SRWebSocket setMessageCodec:]`, if the
+ implementation supports it.
+ */
+@protocol FYWebSocketMessageCodec <NSObject>
+
+/**
+ Value of Sec-WebSocket-Extensions for the opening handshake.
+ */
+- (NSString *)extensionOffer;
+
+/**
+ Apply the parameters of the server's response. If the server didn't accept the extension, messages pass unchanged.
+ 
+ @param  response  Value of Sec-WebSocket-Extensions of the response, may be nil.
+ 
+ @return NO, if the response is invalid and the connection has to be failed.
+ */
+- (BOOL)acceptExtensionResponse:(NSString *)response;
+
+/**
+ Encode the payload of an outgoing message.
+ 
+ @param  data        Payload of the message.
+ 
+ @param  compressed  Is set to YES, if the RSV1 bit of the first frame has to be set.
+ */
+- (NSData *)encodeMessageData:(NSData *)data compressed:(BOOL *)compressed;
+
+/**
+ Decode the payload of an incoming message.
+ 
+ @param  data        Payload of the message.
+ 
+ @param  compressed  YES, if the RSV1 bit of the first frame was set.
+ 
+ @param  error       Is set, if the payload couldn't be decoded.
+ 
+ @return The decoded payload or nil, if it couldn't be decoded.
+ */
+- (NSData *)decodeMessageData:(NSData *)data compressed:(BOOL)compressed error:(NSError **)error;
+
+@end
+
+
+/**
+ Compression of messages by the WebSocket extension permessage-deflate as specified by RFC 7692.
+ 
+ Encoding and decoding each use their own stream, so they may be called on different threads, but not concurrently
+ with themselves.
+ */
+@interface FYPerMessageDeflate : NSObject <FYWebSocketMessageCodec>
+
+/**
+ Offer to reset the compression context after each outgoing message. This saves memory of the server, but compresses
+ repetitive messages worse. Default is NO.
+ */
+@property (nonatomic, assign) BOOL clientNoContextTakeover;
+
+/**
+ Request the server to reset its compression context after each message. This saves memory of the client, but
+ compresses repetitive messages worse. Default is NO.
+ */
+@property (nonatomic, assign) BOOL serverNoContextTakeover;
+
+/**
+ Outgoing messages, whose payload is shorter than this count of bytes, are sent uncompressed.
+ */
+@property (nonatomic, assign) NSUInteger compressionThreshold;
+
+/**
+ Recorder of the saved bytes and the time spent for compression. May be nil.
+ */
+@property (nonatomic, retain) FYMetricsRecorder *metricsRecorder;
+
+/**
+ YES, if the server accepted the extension.
+ */
+@property (nonatomic, assign, readonly, getter=isNegotiated) BOOL negotiated;
+
+@end
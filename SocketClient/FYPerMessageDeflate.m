@@ -0,0 +1,307 @@
+//
+//  FYPerMessageDeflate.m
+//  SocketClient
+//
+//  Created by agent on 17.10.26.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import <zlib.h>
+#import "FYPerMessageDeflate.h"
+#import "FYError.h"
+#import "FYMetricsRecorder.h"
+
+
+NSString *const FYPerMessageDeflateExtensionName = @"permessage-deflate";
+
+
+/*
+ Empty stored block, which ends each message flushed by Z_SYNC_FLUSH. It is removed by the sender and appended by the
+ receiver, see RFC 7692 section 7.2.1.
+ */
+static const uint8_t FYPerMessageDeflateTail[] = { 0x00, 0x00, 0xff, 0xff };
+
+/*
+ Window sizes allowed by RFC 7692. zlib can't produce raw deflate streams with a window of 2^8, so a server, which
+ limits the client to this, is refused.
+ */
+#define FYPerMessageDeflateMaximumWindowBits 15
+#define FYPerMessageDeflateMinimumWindowBits 9
+
+
+/*
+ Parse the value of a *_max_window_bits parameter, which may be a quoted-string.
+ */
+static int FYPerMessageDeflateParseWindowBits(NSString *value) {
+    value = [value stringByTrimmingCharactersInSet:[NSCharacterSet characterSetWithCharactersInString:@"\""]];
+    if (value.length == 0 || value.length > 2
+        || [value rangeOfCharacterFromSet:NSCharacterSet.decimalDigitCharacterSet.invertedSet].location != NSNotFound) {
+        return 0;
+    }
+    int bits = value.intValue;
+    return bits >= 8 && bits <= FYPerMessageDeflateMaximumWindowBits ? bits : 0;
+}
+
+
+
+@interface FYPerMessageDeflate ()
+
+@property (nonatomic, assign, readwrite, getter=isNegotiated) BOOL negotiated;
+
+// Negotiated parameters
+@property (nonatomic, assign) BOOL resetsDeflaterAfterMessage;
+@property (nonatomic, assign) int deflaterWindowBits;
+
+@end
+
+
+@implementation FYPerMessageDeflate {
+    z_stream _deflater;
+    BOOL _deflaterInitialized;
+    z_stream _inflater;
+    BOOL _inflaterInitialized;
+}
+
+- (void)dealloc {
+    if (_deflaterInitialized) {
+        deflateEnd(&_deflater);
+    }
+    if (_inflaterInitialized) {
+        inflateEnd(&_inflater);
+    }
+}
+
+- (id)init {
+    self = [super init];
+    if (self) {
+        self.deflaterWindowBits = FYPerMessageDeflateMaximumWindowBits;
+    }
+    return self;
+}
+
+
+#pragma mark - Negotiation
+
+- (NSString *)extensionOffer {
+    NSMutableString *offer = [FYPerMessageDeflateExtensionName mutableCopy];
+    
+    // Announce that the server may limit our window
+    [offer appendString:@"; client_max_window_bits"];
+    if (self.clientNoContextTakeover) {
+        [offer appendString:@"; client_no_context_takeover"];
+    }
+    if (self.serverNoContextTakeover) {
+        [offer appendString:@"; server_no_context_takeover"];
+    }
+    return offer;
+}
+
+- (BOOL)acceptExtensionResponse:(NSString *)response {
+    NSCharacterSet *whitespace = NSCharacterSet.whitespaceCharacterSet;
+    self.negotiated = NO;
+    
+    for (NSString *extension in [response componentsSeparatedByString:@","]) {
+        NSArray *parameters = [extension componentsSeparatedByString:@";"];
+        if (![[parameters[0] stringByTrimmingCharactersInSet:whitespace] isEqualToString:FYPerMessageDeflateExtensionName]) {
+            continue;
+        }
+        if (self.isNegotiated) {
+            // The extension must not be accepted twice
+            return NO;
+        }
+        
+        BOOL resetsDeflater = self.clientNoContextTakeover;
+        int windowBits = FYPerMessageDeflateMaximumWindowBits;
+        NSMutableSet *names = [NSMutableSet new];
+        for (NSString *parameter in [parameters subarrayWithRange:NSMakeRange(1, parameters.count - 1)]) {
+            NSRange separator = [parameter rangeOfString:@"="];
+            NSString *name = parameter;
+            NSString *value = nil;
+            if (separator.location != NSNotFound) {
+                name  = [parameter substringToIndex:separator.location];
+                value = [[parameter substringFromIndex:NSMaxRange(separator)] stringByTrimmingCharactersInSet:whitespace];
+            }
+            name = [name stringByTrimmingCharactersInSet:whitespace];
+            
+            if ([names containsObject:name]) {
+                return NO;
+            }
+            [names addObject:name];
+            
+            if ([name isEqualToString:@"client_no_context_takeover"] && !value) {
+                resetsDeflater = YES;
+            } else if ([name isEqualToString:@"server_no_context_takeover"] && !value) {
+                // The inflater can keep its window, the server won't refer to it anymore
+            } else if ([name isEqualToString:@"server_max_window_bits"]) {
+                // The inflater always uses the maximum window, which can decode any smaller window
+                if (!FYPerMessageDeflateParseWindowBits(value)) {
+                    return NO;
+                }
+            } else if ([name isEqualToString:@"client_max_window_bits"]) {
+                windowBits = FYPerMessageDeflateParseWindowBits(value);
+                if (windowBits < FYPerMessageDeflateMinimumWindowBits) {
+                    return NO;
+                }
+            } else {
+                return NO;
+            }
+        }
+        
+        self.resetsDeflaterAfterMessage = resetsDeflater;
+        self.deflaterWindowBits = windowBits;
+        self.negotiated = YES;
+    }
+    return YES;
+}
+
+
+#pragma mark - Compression
+
+- (NSData *)encodeMessageData:(NSData *)data compressed:(BOOL *)compressed {
+    *compressed = NO;
+    if (!self.isNegotiated || data.length < self.compressionThreshold) {
+        return data;
+    }
+    
+    NSTimeInterval startUptime = NSProcessInfo.processInfo.systemUptime;
+    if (!_deflaterInitialized) {
+        if (deflateInit2(&_deflater, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -self.deflaterWindowBits, 8,
+                         Z_DEFAULT_STRATEGY) != Z_OK) {
+            return data;
+        }
+        _deflaterInitialized = YES;
+    }
+    
+    // Repetitive payloads compress well, so start with the input length and grow only if needed
+    NSMutableData *output = [NSMutableData dataWithLength:data.length + 64];
+    _deflater.next_in  = (Bytef *)data.bytes;
+    _deflater.avail_in = (uInt)data.length;
+    size_t length = 0;
+    do {
+        if (output.length - length < 64) {
+            output.length *= 2;
+        }
+        _deflater.next_out  = (Bytef *)output.mutableBytes + length;
+        _deflater.avail_out = (uInt)(output.length - length);
+        int status = deflate(&_deflater, Z_SYNC_FLUSH);
+        length = output.length - _deflater.avail_out;
+        if (status != Z_OK && status != Z_BUF_ERROR) {
+            // Start over with a fresh context, the peer didn't see any of this message
+            deflateEnd(&_deflater);
+            _deflaterInitialized = NO;
+            return data;
+        }
+    } while (_deflater.avail_out == 0);
+    
+    if (length >= sizeof(FYPerMessageDeflateTail)
+        && memcmp((uint8_t *)output.bytes + length - sizeof(FYPerMessageDeflateTail), FYPerMessageDeflateTail,
+                  sizeof(FYPerMessageDeflateTail)) == 0) {
+        length -= sizeof(FYPerMessageDeflateTail);
+    }
+    output.length = length;
+    
+    if (self.resetsDeflaterAfterMessage) {
+        deflateReset(&_deflater);
+        
+        // Without a shared context, incompressible payloads can still be sent as they are
+        if (length >= data.length) {
+            return data;
+        }
+    }
+    
+    [self.metricsRecorder recordCompressionOfLength:data.length toLength:length
+                                           duration:NSProcessInfo.processInfo.systemUptime - startUptime];
+    *compressed = YES;
+    return output;
+}
+
+- (NSData *)decodeMessageData:(NSData *)data compressed:(BOOL)compressed error:(NSError **)error {
+    if (!compressed) {
+        return data;
+    }
+    
+    NSString *reason = nil;
+    if (!self.isNegotiated) {
+        reason = @"Received a compressed message, but the extension wasn't negotiated.";
+    } else if (!_inflaterInitialized) {
+        if (inflateInit2(&_inflater, -FYPerMessageDeflateMaximumWindowBits) == Z_OK) {
+            _inflaterInitialized = YES;
+        } else {
+            reason = @"The inflater couldn't be initialized.";
+        }
+    }
+    
+    NSTimeInterval startUptime = NSProcessInfo.processInfo.systemUptime;
+    NSMutableData *output = [NSMutableData dataWithLength:data.length * 4 + 64];
+    size_t length = 0;
+    
+    // Inflate the payload and then the tail, which was removed by the sender
+    const struct { const void *bytes; size_t length; } inputs[] = {
+        { data.bytes,              data.length                      },
+        { FYPerMessageDeflateTail, sizeof(FYPerMessageDeflateTail)  },
+    };
+    for (size_t i=0; i<sizeof(inputs)/sizeof(inputs[0]) && !reason; i++) {
+        _inflater.next_in  = (Bytef *)inputs[i].bytes;
+        _inflater.avail_in = (uInt)inputs[i].length;
+        int status;
+        do {
+            if (output.length - length < 64) {
+                output.length *= 2;
+            }
+            _inflater.next_out  = (Bytef *)output.mutableBytes + length;
+            _inflater.avail_out = (uInt)(output.length - length);
+            status = inflate(&_inflater, Z_SYNC_FLUSH);
+            length = output.length - _inflater.avail_out;
+        } while (status == Z_OK && (_inflater.avail_in > 0 || _inflater.avail_out == 0));
+        
+        if (status == Z_STREAM_END) {
+            // The sender finished the stream by a final block, so the following message starts a new one
+            inflateReset(&_inflater);
+            break;
+        } else if (status != Z_OK && status != Z_BUF_ERROR) {
+            reason = [NSString stringWithFormat:@"Inflate failed with %d: %s", status, _inflater.msg ?: "unknown"];
+        }
+    }
+    
+    if (reason) {
+        if (_inflaterInitialized) {
+            // The context is corrupt, so the connection has to be failed by the caller
+            inflateReset(&_inflater);
+        }
+        if (error) {
+            *error = [NSError errorWithDomain:FYErrorDomain code:FYErrorSocketDecompressionFailed userInfo:@{
+                NSLocalizedDescriptionKey:        @"A received message couldn't be decompressed.",
+                NSLocalizedFailureReasonErrorKey: reason,
+             }];
+        }
+        return nil;
+    }
+    
+    output.length = length;
+    [self.metricsRecorder recordCompressionOfLength:length toLength:data.length
+                                           duration:NSProcessInfo.processInfo.systemUptime - startUptime];
+    return output;
+}
+
+@end
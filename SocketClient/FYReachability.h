@@ -0,0 +1,72 @@
+//
+//  FYReachability.h
+//  SocketClient
+//
+//  Created by agent on 17.10.26.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+
+/**
+ Awaits that the network becomes reachable again, after a connection failed because of it.
+ 
+ On Apple platforms this is backed by SystemConfiguration's SCNetworkReachability for the host. On Linux it watches
+ the kernel's routing tables via a netlink socket, and the network is considered reachable as soon as there is a
+ default route or a non-loopback link comes up. The handler is called at most once.
+ 
+ The receiver is retained while it watches, until the handler was called or it was cancelled.
+ */
+@interface FYReachability : NSObject
+
+/**
+ The host, whose reachability is awaited.
+ */
+@property (nonatomic, retain, readonly) NSString *host;
+
+/**
+ Initializer
+ 
+ @param  host  The host, whose reachability should be awaited.
+ */
+- (id)initWithHost:(NSString *)host;
+
+/**
+ Start to watch. If the network is already reachable, the handler will be called soon. Must be called on the queue.
+ 
+ @param  queue    Queue, on which the handler is called.
+ 
+ @param  handler  Block, which is called once the network is reachable.
+ 
+ @return NO, if the watcher could not be set up.
+ */
+- (BOOL)notifyWhenReachableOnQueue:(dispatch_queue_t)queue handler:(void(^)(void))handler;
+
+/**
+ Stop to watch. The handler won't be called anymore, if this is called on the queue.
+ */
+- (void)cancel;
+
+@end
@@ -0,0 +1,262 @@
+//
+//  FYReachability.m
+//  SocketClient
+//
+//  Created by agent on 17.10.26.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "FYReachability.h"
+#import "SocketClient_Private.h"
+
+#if defined(__APPLE__)
+    #import <SystemConfiguration/SystemConfiguration.h>
+#elif defined(__linux__)
+    #import <linux/netlink.h>
+    #import <linux/rtnetlink.h>
+    #import <net/if.h>
+    #import <sys/socket.h>
+    #import <unistd.h>
+#endif
+
+
+@interface FYReachability ()
+
+@property (nonatomic, retain, readwrite) NSString *host;
+@property (nonatomic, copy) void(^handler)(void);
+
+- (void)fire;
+
+@end
+
+
+#if defined(__APPLE__)
+
+/*
+ Adapt SystemConfiguration rechability's callback as C function pointer to the watching instance.
+ */
+static void FYReachabilityCallback(SCNetworkReachabilityRef target, SCNetworkReachabilityFlags flags, void *info) {
+    if (!(flags & kSCNetworkReachabilityFlagsReachable)
+        || (   flags & kSCNetworkReachabilityFlagsConnectionRequired
+            && flags & kSCNetworkReachabilityFlagsTransientConnection
+        )) {
+        return;
+    }
+    [(__bridge FYReachability *)info fire];
+}
+
+#elif defined(__linux__)
+
+/*
+ Size of the buffer, into which netlink messages are received. Route dumps are split by the kernel into multiple
+ datagrams of at most a page.
+ */
+#define FYReachabilityNetlinkBufferSize 8192
+
+/*
+ Check if a netlink message announces, that the network could be reachable: either a default route of the main table
+ was added or a non-loopback link came up and is running.
+ */
+static BOOL FYReachabilityIsReachableMessage(const struct nlmsghdr *header) {
+    switch (header->nlmsg_type) {
+        case RTM_NEWROUTE: {
+            const struct rtmsg *route = NLMSG_DATA(header);
+            return route->rtm_table == RT_TABLE_MAIN && route->rtm_type == RTN_UNICAST && route->rtm_dst_len == 0;
+        }
+            
+        case RTM_NEWLINK: {
+            const struct ifinfomsg *link = NLMSG_DATA(header);
+            const unsigned int flags = IFF_UP | IFF_RUNNING;
+            return (link->ifi_flags & flags) == flags
+                && (link->ifi_change & flags)
+                && !(link->ifi_flags & IFF_LOOPBACK);
+        }
+            
+        default:
+            return NO;
+    }
+}
+
+#endif
+
+
+@implementation FYReachability {
+#if defined(__APPLE__)
+    SCNetworkReachabilityRef _target;
+#elif defined(__linux__)
+    dispatch_source_t _source;
+#endif
+}
+
+- (void)dealloc {
+    [self cancel];
+}
+
+- (id)initWithHost:(NSString *)host {
+    self = [super init];
+    if (self) {
+        self.host = host;
+    }
+    return self;
+}
+
+- (void)fire {
+    void(^handler)(void) = self.handler;
+    [self cancel];
+    if (handler) {
+        handler();
+    }
+}
+
+
+#if defined(__APPLE__)
+
+#pragma mark - SystemConfiguration backend
+
+- (BOOL)notifyWhenReachableOnQueue:(dispatch_queue_t)queue handler:(void(^)(void))handler {
+    NSParameterAssert(!_target);
+    
+    _target = SCNetworkReachabilityCreateWithName(NULL, self.host.UTF8String);
+    if (!_target) {
+        return NO;
+    }
+    
+    self.handler = handler;
+    
+    // The target retains the receiver by its context until it is cancelled
+    SCNetworkReachabilityContext context = {
+        .info    = (__bridge void *)self,
+        .retain  = CFRetain,
+        .release = CFRelease,
+    };
+    if (!SCNetworkReachabilitySetCallback(_target, FYReachabilityCallback, &context)
+        || !SCNetworkReachabilitySetDispatchQueue(_target, queue)) {
+        [self cancel];
+        return NO;
+    }
+    return YES;
+}
+
+- (void)cancel {
+    self.handler = nil;
+    if (_target) {
+        SCNetworkReachabilitySetCallback(_target, NULL, NULL);
+        SCNetworkReachabilitySetDispatchQueue(_target, NULL);
+        CFRelease(_target);
+        _target = NULL;
+    }
+}
+
+
+#elif defined(__linux__)
+
+#pragma mark - Netlink backend
+
+- (BOOL)notifyWhenReachableOnQueue:(dispatch_queue_t)queue handler:(void(^)(void))handler {
+    NSParameterAssert(!_source);
+    
+    int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_ROUTE);
+    if (fd < 0) {
+        return NO;
+    }
+    
+    // Subscribe to changes of links and routes
+    struct sockaddr_nl address = {
+        .nl_family = AF_NETLINK,
+        .nl_groups = RTMGRP_LINK | RTMGRP_IPV4_ROUTE | RTMGRP_IPV6_ROUTE,
+    };
+    if (bind(fd, (struct sockaddr *)&address, sizeof(address)) < 0) {
+        close(fd);
+        return NO;
+    }
+    
+    // Request a dump of the current routes, because the network may be reachable meanwhile. If this fails, changes
+    // will still be noticed.
+    struct {
+        struct nlmsghdr header;
+        struct rtmsg    route;
+    } request = {
+        .header = {
+            .nlmsg_len   = NLMSG_LENGTH(sizeof(struct rtmsg)),
+            .nlmsg_type  = RTM_GETROUTE,
+            .nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP,
+            .nlmsg_seq   = 1,
+        },
+        .route = {
+            .rtm_family  = AF_UNSPEC,
+        },
+    };
+    send(fd, &request, request.header.nlmsg_len, 0);
+    
+    self.handler = handler;
+    
+    // The source retains the receiver by its event handler until it is cancelled
+    _source = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, fd, 0, queue);
+    dispatch_source_set_event_handler(_source, ^{
+        char buffer[FYReachabilityNetlinkBufferSize] __attribute__((aligned(NLMSG_ALIGNTO)));
+        ssize_t length;
+        while ((length = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+            int remaining = (int)length;
+            for (struct nlmsghdr *header = (struct nlmsghdr *)buffer;
+                 NLMSG_OK(header, remaining);
+                 header = NLMSG_NEXT(header, remaining)) {
+                if (FYReachabilityIsReachableMessage(header)) {
+                    [self fire];
+                    return;
+                }
+            }
+        }
+    });
+    dispatch_source_set_cancel_handler(_source, ^{
+        close(fd);
+    });
+    dispatch_resume(_source);
+    return YES;
+}
+
+- (void)cancel {
+    self.handler = nil;
+    if (_source) {
+        dispatch_source_cancel(_source);
+        fy_dispatch_release(_source);
+        _source = NULL;
+    }
+}
+
+
+#else
+
+#pragma mark - Unsupported platforms
+
+- (BOOL)notifyWhenReachableOnQueue:(dispatch_queue_t)queue handler:(void(^)(void))handler {
+    return NO;
+}
+
+- (void)cancel {
+    self.handler = nil;
+}
+
+#endif
+
+@end
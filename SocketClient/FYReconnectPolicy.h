@@ -0,0 +1,95 @@
+//
+//  FYReconnectPolicy.h
+//  SocketClient
+//
+//  Created by agent on 17.10.26.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+
+/**
+ The `FYReconnectPolicy` protocol is used by <FYClient> to decide how long to wait before it tries to reconnect, after
+ the connection was lost.
+ */
+@protocol FYReconnectPolicy <NSObject>
+
+/**
+ Time interval to wait before the next reconnect attempt.
+ 
+ @param advisedInterval  The last interval advised by the server in seconds, or 0 if there was no advice.
+ 
+ @param sessionDuration  Time interval in seconds, which the last session was established, before the connection was
+ lost, or 0 if the last attempt failed before a session was established.
+ 
+ @return A time interval in seconds.
+ */
+- (NSTimeInterval)reconnectDelayWithAdvisedInterval:(NSTimeInterval)advisedInterval
+                                    sessionDuration:(NSTimeInterval)sessionDuration;
+
+/**
+ Forget about prior attempts, e.g. because the client was explicitly disconnected.
+ */
+- (void)reset;
+
+@end
+
+
+/**
+ Exponential backoff with decorrelated jitter.
+ 
+ Each delay is drawn uniformly between the lower bound and three times the previous delay, and is capped by
+ maximumInterval. So the delays of many clients, which lost their connection at the same instant, are spread out
+ quickly and don't hit a restarted server at the same time again. The lower bound is minimumInterval or the interval
+ advised by the server, if it is greater. The backoff starts again from the lower bound, once a session was established
+ for at least stableSessionInterval.
+ */
+@interface FYBackoffReconnectPolicy : NSObject <FYReconnectPolicy>
+
+/**
+ Lower bound of the delay in seconds.
+ */
+@property (nonatomic, assign) NSTimeInterval minimumInterval;
+
+/**
+ Upper bound of the delay in seconds.
+ */
+@property (nonatomic, assign) NSTimeInterval maximumInterval;
+
+/**
+ Minimum duration in seconds of a session, after which the backoff starts again from the lower bound.
+ */
+@property (nonatomic, assign) NSTimeInterval stableSessionInterval;
+
+/**
+ Initializer
+ 
+ @param minimumInterval  Lower bound of the delay in seconds.
+ 
+ @param maximumInterval  Upper bound of the delay in seconds.
+ */
+- (id)initWithMinimumInterval:(NSTimeInterval)minimumInterval maximumInterval:(NSTimeInterval)maximumInterval;
+
+@end
@@ -0,0 +1,82 @@
+//
+//  FYReconnectPolicy.m
+//  SocketClient
+//
+//  Created by agent on 17.10.26.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "FYReconnectPolicy.h"
+
+#if FY_USE_LIBBSD
+#import <bsd/stdlib.h>
+#endif
+
+
+@interface FYBackoffReconnectPolicy ()
+
+// Last returned delay, or 0 if the backoff starts from the lower bound
+@property (nonatomic, assign) NSTimeInterval previousInterval;
+
+@end
+
+
+@implementation FYBackoffReconnectPolicy
+
+- (id)init {
+    return [self initWithMinimumInterval:1 maximumInterval:45];
+}
+
+- (id)initWithMinimumInterval:(NSTimeInterval)minimumInterval maximumInterval:(NSTimeInterval)maximumInterval {
+    self = [super init];
+    if (self) {
+        self.minimumInterval       = minimumInterval;
+        self.maximumInterval       = maximumInterval;
+        self.stableSessionInterval = maximumInterval;
+    }
+    return self;
+}
+
+- (NSTimeInterval)reconnectDelayWithAdvisedInterval:(NSTimeInterval)advisedInterval
+                                    sessionDuration:(NSTimeInterval)sessionDuration {
+    if (sessionDuration >= self.stableSessionInterval) {
+        [self reset];
+    }
+    
+    NSTimeInterval lowerBound = MIN(MAX(self.minimumInterval, advisedInterval), self.maximumInterval);
+    // The first delay is already jittered, otherwise all clients would retry after the lower bound at once.
+    NSTimeInterval upperBound = MAX(lowerBound, self.previousInterval) * 3;
+    
+    double random = (double)arc4random() / UINT32_MAX;
+    NSTimeInterval interval = MIN(lowerBound + (upperBound - lowerBound) * random, self.maximumInterval);
+    
+    self.previousInterval = interval;
+    return interval;
+}
+
+- (void)reset {
+    self.previousInterval = 0;
+}
+
+@end
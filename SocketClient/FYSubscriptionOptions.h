@@ -0,0 +1,111 @@
+//
+//  FYSubscriptionOptions.h
+//  SocketClient
+//
+//  Created by agent on 17.10.26.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+
+/**
+ Policy, which decides what happens, when a subscription's delivery queue is full.
+ */
+typedef NS_ENUM(NSUInteger, FYDeliveryOverflowPolicy) {
+    /// Block reading further messages until the callback consumed queued messages. This delays all channels.
+    FYDeliveryOverflowPolicyBlock = 0,
+    
+    /// Drop the oldest queued messages to make room for the new message.
+    FYDeliveryOverflowPolicyDropOldest,
+    
+    /// Replace a queued message with the same conflation key by the new message, and drop the oldest messages if this
+    /// doesn't suffice. The newest message per key is never dropped.
+    FYDeliveryOverflowPolicyConflate,
+};
+
+
+/**
+ Options of a channel subscription, which control how received messages are delivered to its callback.
+ */
+@interface FYSubscriptionOptions : NSObject <NSCopying>
+
+/**
+ Options, which deliver only the newest message of each subscribed channel, which was not consumed yet by the callback.
+ Use this for channels, which carry state like prices, where only the latest value is of interest.
+ */
++ (instancetype)latestValueOptions;
+
+/**
+ Factory method for options with a bounded delivery queue.
+ 
+ @param  capacity        Maximum count of messages, which are queued per channel for delivery.
+ 
+ @param  overflowPolicy  Policy, which is applied if the capacity is exceeded.
+ */
++ (instancetype)optionsWithCapacity:(NSUInteger)capacity overflowPolicy:(FYDeliveryOverflowPolicy)overflowPolicy;
+
+/**
+ Maximum count of messages, which are queued per subscribed channel and were not consumed yet by the callback. A value
+ of 0 doesn't bound the queue.
+ 
+ Default is 0.
+ */
+@property (nonatomic, assign) NSUInteger capacity;
+
+/**
+ Policy, which is applied if capacity is exceeded.
+ 
+ Default is FYDeliveryOverflowPolicyBlock.
+ */
+@property (nonatomic, assign) FYDeliveryOverflowPolicy overflowPolicy;
+
+/**
+ Key of message payloads, whose value is used to conflate messages with FYDeliveryOverflowPolicyConflate. If nil, or
+ if a payload has no value for the key, the name of the channel is used.
+ 
+ Default is nil.
+ */
+@property (nonatomic, copy) NSString *conflationKey;
+
+/**
+ Count of queued messages, which causes that the delegate is notified by
+ [client:deliveryQueueOfChannel:reachedHighWatermark:]([FYClientDelegate client:deliveryQueueOfChannel:reachedHighWatermark:]).
+ The delegate is notified again, after the queue was drained. A value of 0 disables notifications.
+ 
+ Default is 0.
+ */
+@property (nonatomic, assign) NSUInteger highWatermark;
+
+/**
+ Name of a serial lane, on which the callback is executed instead of the callbackQueue. All subscriptions with the same
+ lane are executed in order, while different lanes run in parallel on the client's
+ [laneTargetQueue]([FYClient laneTargetQueue]). Use e.g. the channel name to get a lane per channel. If nil, the
+ callback is executed on the callbackQueue.
+ 
+ Default is nil.
+ */
+@property (nonatomic, copy) NSString *lane;
+
+@end
@@ -0,0 +1,56 @@
+//
+//  FYSubscriptionOptions.m
+//  SocketClient
+//
+//  Created by agent on 17.10.26.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "FYSubscriptionOptions.h"
+
+
+@implementation FYSubscriptionOptions
+
++ (instancetype)latestValueOptions {
+    return [self optionsWithCapacity:1 overflowPolicy:FYDeliveryOverflowPolicyConflate];
+}
+
++ (instancetype)optionsWithCapacity:(NSUInteger)capacity overflowPolicy:(FYDeliveryOverflowPolicy)overflowPolicy {
+    FYSubscriptionOptions *options = [self new];
+    options.capacity = capacity;
+    options.overflowPolicy = overflowPolicy;
+    return options;
+}
+
+- (id)copyWithZone:(NSZone *)zone {
+    FYSubscriptionOptions *options = [[self.class allocWithZone:zone] init];
+    options.capacity       = self.capacity;
+    options.overflowPolicy = self.overflowPolicy;
+    options.conflationKey  = self.conflationKey;
+    options.highWatermark  = self.highWatermark;
+    options.lane           = self.lane;
+    return options;
+}
+
+@end
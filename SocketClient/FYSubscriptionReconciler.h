@@ -0,0 +1,129 @@
+//
+//  FYSubscriptionReconciler.h
+//  SocketClient
+//
+//  Created by agent on 17.10.26.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+
+/**
+ Callback to enumerate the pending changes of an <FYSubscriptionReconciler>.
+ */
+typedef void(^FYSubscriptionChangeBlock)(NSArray *channels, NSDictionary *extension, BOOL subscribe);
+
+
+/**
+ Keeps the set of channels, which should be subscribed, and reconciles it with the set of channels, whose subscription
+ was confirmed by the server.
+ 
+ Changes aren't sent one by one. Instead all pending changes are collected on flush and grouped into array-valued
+ /meta/subscribe and /meta/unsubscribe messages, one per distinct extension. Channels are tracked as in-flight until
+ their confirmation arrives, so that they are not requested twice.
+ 
+ The reconciler is not thread-safe.
+ */
+@interface FYSubscriptionReconciler : NSObject
+
+/**
+ Channels, which should be subscribed.
+ */
+@property (nonatomic, copy, readonly) NSSet *desiredChannels;
+
+/**
+ Channels, whose subscription was confirmed by the server.
+ */
+@property (nonatomic, copy, readonly) NSSet *confirmedChannels;
+
+/**
+ Check if there are changes, which were not requested yet.
+ */
+@property (nonatomic, assign, readonly) BOOL hasChanges;
+
+/**
+ Mark a channel to be subscribed.
+ 
+ @param channel    A channel name or a channel pattern.
+ 
+ @param extension  An extension, which is sent with the subscription. May be nil.
+ */
+- (void)addChannel:(NSString *)channel extension:(NSDictionary *)extension;
+
+/**
+ Mark a channel to be unsubscribed.
+ 
+ @param channel  A channel name or a channel pattern.
+ */
+- (void)removeChannel:(NSString *)channel;
+
+/**
+ Mark all channels to be unsubscribed.
+ */
+- (void)removeAllChannels;
+
+/**
+ The server confirmed the subscription of a channel.
+ 
+ @param channel  A channel name or a channel pattern.
+ */
+- (void)confirmSubscriptionOfChannel:(NSString *)channel;
+
+/**
+ The server confirmed the unsubscription of a channel.
+ 
+ @param channel  A channel name or a channel pattern.
+ */
+- (void)confirmUnsubscriptionOfChannel:(NSString *)channel;
+
+/**
+ The server rejected the subscription of a channel. The channel will not be requested again.
+ 
+ @param channel  A channel name or a channel pattern.
+ */
+- (void)failSubscriptionOfChannel:(NSString *)channel;
+
+/**
+ The server rejected the unsubscription of a channel. The channel is considered as unsubscribed.
+ 
+ @param channel  A channel name or a channel pattern.
+ */
+- (void)failUnsubscriptionOfChannel:(NSString *)channel;
+
+/**
+ Forget all confirmed and in-flight requests, because the subscriptions of the server-side session were lost. All
+ desired channels will be requested again on the next flush.
+ */
+- (void)reset;
+
+/**
+ Enumerate all changes, which were not requested yet, grouped by kind and by extension, and mark them as in-flight.
+ 
+ @param block  Called once per group with the channels, their extension, and whether they should be subscribed or
+ unsubscribed.
+ */
+- (void)dequeueChangesUsingBlock:(FYSubscriptionChangeBlock)block;
+
+@end
@@ -0,0 +1,154 @@
+//
+//  FYSubscriptionReconciler.m
+//  SocketClient
+//
+//  Created by agent on 17.10.26.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "FYSubscriptionReconciler.h"
+
+
+@interface FYSubscriptionReconciler ()
+
+// Extension by desired channel, NSNull if there is none
+@property (nonatomic, retain) NSMutableDictionary *desired;
+@property (nonatomic, retain) NSMutableSet *confirmed;
+@property (nonatomic, retain) NSMutableSet *subscribing;
+@property (nonatomic, retain) NSMutableSet *unsubscribing;
+
+- (void)dequeueChanges:(BOOL)dequeue usingBlock:(FYSubscriptionChangeBlock)block;
+
+@end
+
+
+@implementation FYSubscriptionReconciler
+
+- (id)init {
+    self = [super init];
+    if (self) {
+        self.desired       = [NSMutableDictionary new];
+        self.confirmed     = [NSMutableSet new];
+        self.subscribing   = [NSMutableSet new];
+        self.unsubscribing = [NSMutableSet new];
+    }
+    return self;
+}
+
+- (NSSet *)desiredChannels {
+    return [NSSet setWithArray:self.desired.allKeys];
+}
+
+- (NSSet *)confirmedChannels {
+    return self.confirmed.copy;
+}
+
+- (BOOL)hasChanges {
+    __block BOOL hasChanges = NO;
+    [self dequeueChanges:NO usingBlock:^(NSArray *channels, NSDictionary *extension, BOOL subscribe) {
+        hasChanges = YES;
+     }];
+    return hasChanges;
+}
+
+- (void)addChannel:(NSString *)channel extension:(NSDictionary *)extension {
+    self.desired[channel] = extension ?: NSNull.null;
+}
+
+- (void)removeChannel:(NSString *)channel {
+    [self.desired removeObjectForKey:channel];
+}
+
+- (void)removeAllChannels {
+    [self.desired removeAllObjects];
+}
+
+- (void)confirmSubscriptionOfChannel:(NSString *)channel {
+    [self.subscribing removeObject:channel];
+    [self.confirmed addObject:channel];
+}
+
+- (void)confirmUnsubscriptionOfChannel:(NSString *)channel {
+    [self.unsubscribing removeObject:channel];
+    [self.confirmed removeObject:channel];
+}
+
+- (void)failSubscriptionOfChannel:(NSString *)channel {
+    [self.subscribing removeObject:channel];
+    [self.desired removeObjectForKey:channel];
+}
+
+- (void)failUnsubscriptionOfChannel:(NSString *)channel {
+    [self confirmUnsubscriptionOfChannel:channel];
+}
+
+- (void)reset {
+    [self.confirmed removeAllObjects];
+    [self.subscribing removeAllObjects];
+    [self.unsubscribing removeAllObjects];
+}
+
+- (void)dequeueChangesUsingBlock:(FYSubscriptionChangeBlock)block {
+    [self dequeueChanges:YES usingBlock:block];
+}
+
+- (void)dequeueChanges:(BOOL)dequeue usingBlock:(FYSubscriptionChangeBlock)block {
+    // Group subscriptions by extension. Most subscriptions have none, so they are all sent in one message.
+    NSMutableDictionary *subscriptionsByExtension = [NSMutableDictionary new];
+    [self.desired enumerateKeysAndObjectsUsingBlock:^(NSString *channel, id extension, BOOL *stop) {
+        if ([self.confirmed containsObject:channel] || [self.subscribing containsObject:channel]) {
+            return;
+        }
+        NSMutableArray *channels = subscriptionsByExtension[extension];
+        if (!channels) {
+            channels = [NSMutableArray new];
+            subscriptionsByExtension[extension] = channels;
+        }
+        [channels addObject:channel];
+     }];
+    
+    NSMutableArray *unsubscriptions = [NSMutableArray new];
+    NSSet *subscribed = [self.confirmed setByAddingObjectsFromSet:self.subscribing];
+    for (NSString *channel in subscribed) {
+        if (!self.desired[channel] && ![self.unsubscribing containsObject:channel]) {
+            [unsubscriptions addObject:channel];
+        }
+    }
+    
+    [subscriptionsByExtension enumerateKeysAndObjectsUsingBlock:^(id extension, NSArray *channels, BOOL *stop) {
+        if (dequeue) {
+            [self.subscribing addObjectsFromArray:channels];
+        }
+        block(channels, extension != NSNull.null ? extension : nil, YES);
+     }];
+    
+    if (unsubscriptions.count > 0) {
+        if (dequeue) {
+            [self.unsubscribing addObjectsFromArray:unsubscriptions];
+        }
+        block(unsubscriptions, nil, NO);
+    }
+}
+
+@end
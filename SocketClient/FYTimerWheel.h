@@ -0,0 +1,105 @@
+//
+//  FYTimerWheel.h
+//  SocketClient
+//
+//  Created by agent on 17.10.26.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+
+/**
+ Default resolution of the shared timer wheel.
+ */
+extern const NSTimeInterval FYTimerWheelDefaultTickInterval;
+
+
+/**
+ A timer, which was scheduled on a <FYTimerWheel>. Timers fire once and can't be rescheduled.
+ */
+@interface FYTimer : NSObject
+
+/**
+ YES, if the timer was cancelled before it fired.
+ */
+@property (atomic, assign, readonly, getter=isCancelled) BOOL cancelled;
+
+/**
+ Remove the timer from its wheel. If this is called on the queue of the timer, its block is guaranteed not to be
+ executed anymore. It is safe to cancel a timer, which already fired.
+ */
+- (void)cancel;
+
+@end
+
+
+/**
+ A hierarchical timer wheel, which serves the timers of all clients of the process by a single dispatch source.
+ 
+ Timers are kept in 4 levels of 64 slots each, where a slot of a level spans 64 slots of the level below. Timers of
+ higher levels are cascaded down, when the wheel turns over their slot. So scheduling and cancelling are O(1), and each
+ timer is moved at most 3 times, regardless how many timers are scheduled. The source is suspended, while the wheel is
+ empty.
+ 
+ Timers fire with the resolution of the tick interval, and never earlier than their delay. The wheel is thread-safe.
+ */
+@interface FYTimerWheel : NSObject
+
+/**
+ The resolution of the wheel.
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval tickInterval;
+
+/**
+ Count of scheduled timers, which didn't fire and were not cancelled.
+ */
+@property (nonatomic, assign, readonly) NSUInteger count;
+
+/**
+ Process-wide wheel with the default tick interval, which is used by all instances of FYClient.
+ */
++ (FYTimerWheel *)sharedTimerWheel;
+
+/**
+ Initializer
+ 
+ @param  tickInterval  Resolution of the wheel, must be greater than 0.
+ */
+- (id)initWithTickInterval:(NSTimeInterval)tickInterval;
+
+/**
+ Schedule a timer.
+ 
+ @param  delay  Time interval in seconds, after which the block is executed.
+ 
+ @param  queue  Queue, on which the block is executed.
+ 
+ @param  block  Block to execute.
+ 
+ @return The timer, which can be used to cancel it.
+ */
+- (FYTimer *)scheduleTimerWithDelay:(NSTimeInterval)delay queue:(dispatch_queue_t)queue block:(dispatch_block_t)block;
+
+@end
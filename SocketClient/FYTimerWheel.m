@@ -0,0 +1,347 @@
+//
+//  FYTimerWheel.m
+//  SocketClient
+//
+//  Created by agent on 17.10.26.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "FYTimerWheel.h"
+#import "SocketClient_Private.h"
+
+
+const NSTimeInterval FYTimerWheelDefaultTickInterval = 0.05;
+
+NSString *const FYTimerWheelQueueName = @"com.paij.SocketClient.FYTimerWheel";
+
+
+/*
+ Geometry of the wheel: 4 levels of 64 slots cover 2^24 ticks, which are about 9.7 days with the default tick
+ interval. Timers with longer delays are parked in the last slot of the top level, until they come into range.
+ */
+#define FYTimerWheelLevelCount 4
+#define FYTimerWheelSlotBits   6
+#define FYTimerWheelSlotCount  (1 << FYTimerWheelSlotBits)
+#define FYTimerWheelSlotMask   (FYTimerWheelSlotCount - 1)
+#define FYTimerWheelMaximumTicks ((1ull << (FYTimerWheelLevelCount * FYTimerWheelSlotBits)) - 1)
+
+
+
+@interface FYTimer ()
+
+@property (atomic, assign, readwrite, getter=isCancelled) BOOL cancelled;
+@property (nonatomic, weak) FYTimerWheel *wheel;
+@property (nonatomic, copy) dispatch_block_t block;
+@property (nonatomic, assign) uint64_t expirationTick;
+
+// Timers of a slot form a circular doubly-linked list around a sentinel, guarded by the lock of the wheel
+@property (nonatomic, retain) FYTimer *next;
+@property (nonatomic, unsafe_unretained) FYTimer *previous;
+
+- (id)initWithWheel:(FYTimerWheel *)wheel queue:(dispatch_queue_t)queue block:(dispatch_block_t)block;
+- (id)initSentinel;
+- (dispatch_queue_t)queue;
+
+- (BOOL)isLinked;
+- (void)unlink;
+- (void)insertBefore:(FYTimer *)sentinel;
+
+@end
+
+
+@interface FYTimerWheel ()
+
+@property (nonatomic, assign, readwrite) NSUInteger count;
+
+- (void)cancelTimer:(FYTimer *)timer;
+
+@end
+
+
+
+@implementation FYTimer {
+    dispatch_queue_t _queue;
+}
+
+- (void)dealloc {
+    if (_queue) {
+        fy_dispatch_release(_queue);
+    }
+}
+
+- (id)initWithWheel:(FYTimerWheel *)wheel queue:(dispatch_queue_t)queue block:(dispatch_block_t)block {
+    self = [super init];
+    if (self) {
+        self.wheel = wheel;
+        self.block = block;
+        if (queue) {
+            fy_dispatch_retain(queue);
+            _queue = queue;
+        }
+    }
+    return self;
+}
+
+- (id)initSentinel {
+    self = [self initWithWheel:nil queue:NULL block:nil];
+    if (self) {
+        self.next = self;
+        self.previous = self;
+    }
+    return self;
+}
+
+- (dispatch_queue_t)queue {
+    return _queue;
+}
+
+- (void)cancel {
+    self.cancelled = YES;
+    [self.wheel cancelTimer:self];
+}
+
+- (BOOL)isLinked {
+    return self.next != nil;
+}
+
+- (void)unlink {
+    self.next.previous = self.previous;
+    self.previous.next = self.next;
+    self.previous = nil;
+    self.next = nil;
+}
+
+- (void)insertBefore:(FYTimer *)sentinel {
+    self.next = sentinel;
+    self.previous = sentinel.previous;
+    sentinel.previous.next = self;
+    sentinel.previous = self;
+}
+
+@end
+
+
+
+@implementation FYTimerWheel {
+    NSArray *_slots;
+    uint64_t _currentTick;
+    NSTimeInterval _startUptime;
+    dispatch_queue_t _queue;
+    dispatch_source_t _source;
+    BOOL _running;
+}
+
++ (FYTimerWheel *)sharedTimerWheel {
+    static FYTimerWheel *sharedTimerWheel;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedTimerWheel = [[FYTimerWheel alloc] initWithTickInterval:FYTimerWheelDefaultTickInterval];
+    });
+    return sharedTimerWheel;
+}
+
+- (void)dealloc {
+    dispatch_source_cancel(_source);
+    if (!_running) {
+        // A suspended source is never cancelled and released
+        dispatch_resume(_source);
+    }
+    fy_dispatch_release(_source);
+    fy_dispatch_release(_queue);
+    
+    // Break the retain cycles of the circular lists
+    for (FYTimer *sentinel in _slots) {
+        while (sentinel.next != sentinel) {
+            FYTimer *timer = sentinel.next;
+            [timer unlink];
+        }
+        sentinel.next = nil;
+    }
+}
+
+- (id)init {
+    return [self initWithTickInterval:FYTimerWheelDefaultTickInterval];
+}
+
+- (id)initWithTickInterval:(NSTimeInterval)tickInterval {
+    NSParameterAssert(tickInterval > 0);
+    self = [super init];
+    if (self) {
+        _tickInterval = tickInterval;
+        
+        NSMutableArray *slots = [NSMutableArray arrayWithCapacity:FYTimerWheelLevelCount * FYTimerWheelSlotCount];
+        for (NSUInteger i=0; i<FYTimerWheelLevelCount * FYTimerWheelSlotCount; i++) {
+            [slots addObject:[[FYTimer alloc] initSentinel]];
+        }
+        _slots = slots.copy;
+        
+        NSString *queueName = [FYTimerWheelQueueName stringByAppendingFormat:@"_%d", (int)self];
+        _queue = dispatch_queue_create([queueName cStringUsingEncoding:NSASCIIStringEncoding], NULL);
+        
+        // The source is created suspended and runs only while timers are scheduled
+        uint64_t interval = tickInterval * NSEC_PER_SEC;
+        _source = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, _queue);
+        dispatch_source_set_timer(_source, dispatch_time(DISPATCH_TIME_NOW, interval), interval, interval / 2);
+        __weak FYTimerWheel *wheel = self;
+        dispatch_source_set_event_handler(_source, ^{
+            [wheel turn];
+         });
+    }
+    return self;
+}
+
+- (NSUInteger)count {
+    @synchronized (self) {
+        return _count;
+    }
+}
+
+- (FYTimer *)scheduleTimerWithDelay:(NSTimeInterval)delay queue:(dispatch_queue_t)queue block:(dispatch_block_t)block {
+    NSParameterAssert(queue);
+    NSParameterAssert(block);
+    
+    FYTimer *timer = [[FYTimer alloc] initWithWheel:self queue:queue block:block];
+    uint64_t ticks = MAX(1, (uint64_t)ceil(MAX(delay, 0) / self.tickInterval));
+    
+    @synchronized (self) {
+        NSTimeInterval now = NSProcessInfo.processInfo.systemUptime;
+        if (!_running) {
+            // Continue to count from the current tick, the wheel didn't turn while it was suspended
+            _startUptime = now - _currentTick * self.tickInterval;
+            [self resume];
+        }
+        
+        // The wheel may lag behind, so the delay is measured from now
+        uint64_t nowTick = MAX(_currentTick, (uint64_t)((now - _startUptime) / self.tickInterval));
+        timer.expirationTick = nowTick + ticks;
+        [self insertTimer:timer];
+        _count++;
+    }
+    return timer;
+}
+
+- (void)cancelTimer:(FYTimer *)timer {
+    @synchronized (self) {
+        if (timer.isLinked) {
+            [timer unlink];
+            _count--;
+        }
+    }
+}
+
+
+#pragma mark - Helper methods, which have to be called with the lock held
+
+- (void)resume {
+    _running = YES;
+    dispatch_resume(_source);
+}
+
+- (void)suspend {
+    _running = NO;
+    dispatch_suspend(_source);
+}
+
+- (FYTimer *)sentinelAtLevel:(NSUInteger)level slot:(uint64_t)slot {
+    return _slots[level * FYTimerWheelSlotCount + (slot & FYTimerWheelSlotMask)];
+}
+
+- (void)insertTimer:(FYTimer *)timer {
+    uint64_t delta = timer.expirationTick > _currentTick ? timer.expirationTick - _currentTick : 0;
+    uint64_t expirationTick = timer.expirationTick;
+    if (delta > FYTimerWheelMaximumTicks) {
+        // Park the timer in the farthest slot, it is inserted again with its real expiration, when it is cascaded.
+        delta = FYTimerWheelMaximumTicks;
+        expirationTick = _currentTick + delta;
+    }
+    
+    NSUInteger level = 0;
+    while (level < FYTimerWheelLevelCount - 1 && delta >= (1ull << ((level + 1) * FYTimerWheelSlotBits))) {
+        level++;
+    }
+    [timer insertBefore:[self sentinelAtLevel:level slot:expirationTick >> (level * FYTimerWheelSlotBits)]];
+}
+
+- (void)cascadeLevel:(NSUInteger)level {
+    FYTimer *sentinel = [self sentinelAtLevel:level slot:_currentTick >> (level * FYTimerWheelSlotBits)];
+    while (sentinel.next != sentinel) {
+        FYTimer *timer = sentinel.next;
+        [timer unlink];
+        [self insertTimer:timer];
+    }
+}
+
+- (void)advanceCollectingExpiredTimers:(NSMutableArray *)expiredTimers {
+    _currentTick++;
+    
+    // Cascade the slots of the upper levels, which the wheel turned over
+    for (NSUInteger level=1; level<FYTimerWheelLevelCount; level++) {
+        if (_currentTick & ((1ull << (level * FYTimerWheelSlotBits)) - 1)) {
+            break;
+        }
+        [self cascadeLevel:level];
+    }
+    
+    FYTimer *sentinel = [self sentinelAtLevel:0 slot:_currentTick];
+    while (sentinel.next != sentinel) {
+        FYTimer *timer = sentinel.next;
+        [timer unlink];
+        [expiredTimers addObject:timer];
+        _count--;
+    }
+}
+
+
+#pragma mark - Timer source event handler
+
+- (void)turn {
+    NSMutableArray *expiredTimers = [NSMutableArray new];
+    
+    @synchronized (self) {
+        uint64_t nowTick = (uint64_t)((NSProcessInfo.processInfo.systemUptime - _startUptime) / self.tickInterval);
+        while (_currentTick < nowTick && _count > 0) {
+            [self advanceCollectingExpiredTimers:expiredTimers];
+        }
+        
+        if (_count == 0) {
+            // Nothing left to do, so let the process sleep, until a timer is scheduled
+            _currentTick = MAX(_currentTick, nowTick);
+            if (_running) {
+                [self suspend];
+            }
+        }
+    }
+    
+    for (FYTimer *timer in expiredTimers) {
+        dispatch_async(timer.queue, ^{
+            // The timer may be cancelled on its queue, after it was removed from the wheel
+            if (!timer.isCancelled) {
+                timer.block();
+            }
+            timer.block = nil;
+         });
+    }
+}
+
+@end
@@ -0,0 +1,127 @@
+//
+//  FYTimestamp.h
+//  SocketClient
+//
+//  Created by agent on 17.10.26.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+/** @refs
+//  [RFC3339] http://tools.ietf.org/html/rfc3339#section-5.6
+*/
+
+#import <Foundation/Foundation.h>
+
+
+/**
+ Parse a [RFC3339][RFC3339] / ISO-8601 timestamp into seconds since 1970.
+ 
+ Accepted are timestamps like ```2013-05-07T12:30:05Z```, ```2013-05-07 12:30:05.250+02:00``` or
+ ```2013-05-07T12:30:05.25```. Fractional seconds may have any precision. A missing offset is treated as UTC, as
+ timestamps in Bayeux messages are given in GMT.
+ 
+ This doesn't allocate any memory and is thread-safe. The result can be compared directly to other results and to
+ `[NSDate timeIntervalSince1970]`.
+ 
+ @param string     The bytes of the timestamp, not necessarily terminated.
+ 
+ @param length     Count of bytes.
+ 
+ @param timestamp  Set to the parsed seconds since 1970, if the timestamp is valid.
+ 
+ @return Whether the timestamp was valid.
+ */
+extern BOOL FYTimestampParseRFC3339(const char *string, size_t length, NSTimeInterval *timestamp);
+
+/**
+ Parse a [RFC3339][RFC3339] timestamp given as string. See FYTimestampParseRFC3339.
+ */
+extern BOOL FYTimestampParseRFC3339String(NSString *string, NSTimeInterval *timestamp);
+
+/**
+ Current wall clock time in seconds since 1970.
+ */
+extern NSTimeInterval FYTimestampNow(void);
+
+
+/**
+ Estimates the offset of a server's clock and the latency to the server by round trips.
+ 
+ Each sample consists of the local time when a request was sent, the round trip time until its response was received
+ and the server time, which was stamped on the response. Assuming a symmetric path, the server stamped its time at
+ half of the round trip, so the offset of a sample is ```serverTime - (sentTime + roundTripTime / 2)```.
+ 
+ Responses which were held back by the server or delayed by the network make bad samples. So of the recent samples,
+ the one with the shortest round trip is used as estimate.
+ */
+@interface FYClockOffsetEstimator : NSObject
+
+/**
+ Estimated offset in seconds, which has to be added to the local clock to get the server's clock.
+ 
+ Is 0 until a sample with a server time was added.
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval offset;
+
+/**
+ Check if a sample with a server time was added, so that offset is an estimate.
+ */
+@property (nonatomic, assign, readonly, getter=isOffsetEstimated) BOOL offsetEstimated;
+
+/**
+ Shortest recent round trip time in seconds.
+ 
+ Is 0 until a sample was added.
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval roundTripTime;
+
+/**
+ Estimated one-way latency in seconds, which is the half of roundTripTime.
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval latency;
+
+/**
+ Count of samples added since initialization or the last reset.
+ */
+@property (nonatomic, assign, readonly) NSUInteger sampleCount;
+
+/**
+ Add a sample of a round trip.
+ 
+ @param roundTripTime  Time in seconds between sending the request and receiving the response.
+ 
+ @param sentTime       Local wall clock time in seconds since 1970, when the request was sent.
+ 
+ @param serverTime     Server time in seconds since 1970, which was stamped on the response, or NAN if the response
+ was not stamped.
+ */
+- (void)addSampleWithRoundTripTime:(NSTimeInterval)roundTripTime
+                          sentTime:(NSTimeInterval)sentTime
+                        serverTime:(NSTimeInterval)serverTime;
+
+/**
+ Forget all samples, e.g. because the connection was established to another server.
+ */
+- (void)reset;
+
+@end
@@ -0,0 +1,201 @@
+//
+//  FYTimestamp.m
+//  SocketClient
+//
+//  Created by agent on 17.10.26.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import <sys/time.h>
+#import "FYTimestamp.h"
+
+
+/*
+ Count of recent samples from which the estimate is chosen.
+ */
+#define FYClockOffsetEstimatorWindowSize 8
+
+
+static inline BOOL FYTimestampParseDigits(const char **p, const char *end, int count, int *value) {
+    int result = 0;
+    for (int i=0; i<count; i++) {
+        if (*p >= end || **p < '0' || **p > '9') {
+            return NO;
+        }
+        result = result * 10 + (*(*p)++ - '0');
+    }
+    *value = result;
+    return YES;
+}
+
+static inline BOOL FYTimestampExpect(const char **p, const char *end, char byte) {
+    if (*p < end && **p == byte) {
+        (*p)++;
+        return YES;
+    }
+    return NO;
+}
+
+/*
+ Days since 1970-01-01 of a date in the proleptic gregorian calendar.
+ See http://howardhinnant.github.io/date_algorithms.html#days_from_civil
+ */
+static inline long FYTimestampDaysFromCivil(int year, int month, int day) {
+    year -= month <= 2;
+    long era = (year >= 0 ? year : year - 399) / 400;
+    long yearOfEra = year - era * 400;
+    long dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    long dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+BOOL FYTimestampParseRFC3339(const char *string, size_t length, NSTimeInterval *timestamp) {
+    const char *p = string, *end = string + length;
+    int year, month, day, hour, minute, second;
+    
+    if (!FYTimestampParseDigits(&p, end, 4, &year)   || !FYTimestampExpect(&p, end, '-')
+     || !FYTimestampParseDigits(&p, end, 2, &month)  || !FYTimestampExpect(&p, end, '-')
+     || !FYTimestampParseDigits(&p, end, 2, &day)) {
+        return NO;
+    }
+    if (!FYTimestampExpect(&p, end, 'T') && !FYTimestampExpect(&p, end, 't') && !FYTimestampExpect(&p, end, ' ')) {
+        return NO;
+    }
+    if (!FYTimestampParseDigits(&p, end, 2, &hour)   || !FYTimestampExpect(&p, end, ':')
+     || !FYTimestampParseDigits(&p, end, 2, &minute) || !FYTimestampExpect(&p, end, ':')
+     || !FYTimestampParseDigits(&p, end, 2, &second)) {
+        return NO;
+    }
+    
+    // Leap seconds are accepted and counted as the following second.
+    if (month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60) {
+        return NO;
+    }
+    
+    double fraction = 0;
+    if (FYTimestampExpect(&p, end, '.')) {
+        double scale = 0.1;
+        const char *digits = p;
+        while (p < end && *p >= '0' && *p <= '9') {
+            fraction += (*p++ - '0') * scale;
+            scale /= 10;
+        }
+        if (p == digits) {
+            return NO;
+        }
+    }
+    
+    int offset = 0;
+    if (p < end && (*p == '+' || *p == '-')) {
+        int sign = *p++ == '-' ? -1 : 1;
+        int offsetHour, offsetMinute;
+        if (!FYTimestampParseDigits(&p, end, 2, &offsetHour)) {
+            return NO;
+        }
+        FYTimestampExpect(&p, end, ':');
+        if (!FYTimestampParseDigits(&p, end, 2, &offsetMinute) || offsetHour > 23 || offsetMinute > 59) {
+            return NO;
+        }
+        offset = sign * (offsetHour * 3600 + offsetMinute * 60);
+    } else if (!FYTimestampExpect(&p, end, 'Z')) {
+        // No offset means UTC
+        FYTimestampExpect(&p, end, 'z');
+    }
+    
+    if (p != end) {
+        return NO;
+    }
+    
+    long days = FYTimestampDaysFromCivil(year, month, day);
+    *timestamp = (double)days * 86400 + (hour * 3600 + minute * 60 + second - offset) + fraction;
+    return YES;
+}
+
+BOOL FYTimestampParseRFC3339String(NSString *string, NSTimeInterval *timestamp) {
+    // Timestamps are short, so copy them into a buffer on the stack instead of creating any objects.
+    char buffer[64];
+    if (![string getCString:buffer maxLength:sizeof(buffer) encoding:NSASCIIStringEncoding]) {
+        return NO;
+    }
+    return FYTimestampParseRFC3339(buffer, strlen(buffer), timestamp);
+}
+
+NSTimeInterval FYTimestampNow(void) {
+    struct timeval time;
+    gettimeofday(&time, NULL);
+    return time.tv_sec + time.tv_usec / 1e6;
+}
+
+
+
+@implementation FYClockOffsetEstimator {
+    NSTimeInterval _roundTripTimes[FYClockOffsetEstimatorWindowSize];
+    NSTimeInterval _offsets[FYClockOffsetEstimatorWindowSize];
+}
+
+- (id)init {
+    self = [super init];
+    if (self) {
+        [self reset];
+    }
+    return self;
+}
+
+- (NSTimeInterval)latency {
+    return self.roundTripTime / 2;
+}
+
+- (void)addSampleWithRoundTripTime:(NSTimeInterval)roundTripTime
+                          sentTime:(NSTimeInterval)sentTime
+                        serverTime:(NSTimeInterval)serverTime {
+    if (roundTripTime < 0) {
+        return;
+    }
+    
+    NSUInteger index = _sampleCount++ % FYClockOffsetEstimatorWindowSize;
+    _roundTripTimes[index] = roundTripTime;
+    _offsets[index] = isnan(serverTime) ? NAN : serverTime - (sentTime + roundTripTime / 2);
+    
+    // Choose the shortest round trip of the window, and the offset of the shortest round trip with a server time.
+    NSUInteger count = MIN(_sampleCount, (NSUInteger)FYClockOffsetEstimatorWindowSize);
+    NSTimeInterval bestRoundTripTime = INFINITY, bestOffsetRoundTripTime = INFINITY;
+    for (NSUInteger i=0; i<count; i++) {
+        bestRoundTripTime = MIN(bestRoundTripTime, _roundTripTimes[i]);
+        if (!isnan(_offsets[i]) && _roundTripTimes[i] < bestOffsetRoundTripTime) {
+            bestOffsetRoundTripTime = _roundTripTimes[i];
+            _offset = _offsets[i];
+            _offsetEstimated = YES;
+        }
+    }
+    _roundTripTime = bestRoundTripTime;
+}
+
+- (void)reset {
+    _sampleCount = 0;
+    _offset = 0;
+    _offsetEstimated = NO;
+    _roundTripTime = 0;
+}
+
+@end
@@ -40,7 +40,17 @@
 #else
     #define fy_dispatch_retain(x) dispatch_retain(x)
     #define fy_dispatch_release(x) dispatch_release(x)
-    #define fymaybe_bridge(x) (x)
+    #define fy_maybe_bridge(x) (x)
+#endif
+
+
+/**
+ Lifecycle hooks are only available where UIKit is, headless builds can opt out explicitly by defining `FY_HEADLESS`.
+ */
+#if TARGET_OS_IPHONE && !defined(FY_HEADLESS)
+    #define FY_OBSERVES_APPLICATION_STATE 1
+#else
+    #define FY_OBSERVES_APPLICATION_STATE 0
 #endif
 
 
@@ -0,0 +1,146 @@
+//
+//  SenTestingKit.h
+//  SocketClientTests
+//
+//  Created by agent on 17.10.26.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+#import <math.h>
+#import <string.h>
+
+
+/**
+ Minimal stand-in for SenTestingKit on platforms, where it isn't available, so that the tests and benchmarks can be
+ built headless, see GNUstepMakefile. Only the assertions, which are used by them, are provided.
+ 
+ Failures are logged and counted, but don't abort the test method, like in SenTestingKit.
+ */
+@interface SenTestCase : NSObject
+
+/**
+ Count of failed assertions of all test cases.
+ */
++ (NSUInteger)failureCount;
+
+/**
+ Record a failed assertion.
+ 
+ @param  description  Description of the failure.
+ 
+ @param  file         Source file of the assertion.
+ 
+ @param  line         Line of the assertion.
+ */
++ (void)failWithDescription:(NSString *)description inFile:(const char *)file atLine:(int)line;
+
+/**
+ Called before each test method.
+ */
+- (void)setUp;
+
+/**
+ Called after each test method.
+ */
+- (void)tearDown;
+
+@end
+
+
+#define STFail(description, ...) \
+    [SenTestCase failWithDescription:[NSString stringWithFormat:description, ##__VA_ARGS__] \
+                              inFile:__FILE__ \
+                              atLine:__LINE__]
+
+#define STAssertTrue(expression, description, ...) \
+    do { \
+        if (!(expression)) { \
+            STFail(@"\"%s\" should be true. %@", #expression, [NSString stringWithFormat:description, ##__VA_ARGS__]); \
+        } \
+    } while (0)
+
+#define STAssertFalse(expression, description, ...) \
+    STAssertTrue(!(expression), description, ##__VA_ARGS__)
+
+#define STAssertEqualObjects(a1, a2, description, ...) \
+    do { \
+        id fy_a1 = (a1), fy_a2 = (a2); \
+        if (fy_a1 != fy_a2 && ![fy_a1 isEqual:fy_a2]) { \
+            STFail(@"'%@' should be equal to '%@'. %@", fy_a1, fy_a2, [NSString stringWithFormat:description, ##__VA_ARGS__]); \
+        } \
+    } while (0)
+
+#define STAssertNil(a1, description, ...) \
+    do { \
+        id fy_a1 = (a1); \
+        if (fy_a1 != nil) { \
+            STFail(@"'%@' should be nil. %@", fy_a1, [NSString stringWithFormat:description, ##__VA_ARGS__]); \
+        } \
+    } while (0)
+
+#define STAssertNotNil(a1, description, ...) \
+    do { \
+        if ((a1) == nil) { \
+            STFail(@"\"%s\" should not be nil. %@", #a1, [NSString stringWithFormat:description, ##__VA_ARGS__]); \
+        } \
+    } while (0)
+
+// Values of scalar types are compared bytewise like in SenTestingKit, so both must have the same type
+#define STAssertEquals(a1, a2, description, ...) \
+    do { \
+        __typeof__(a1) fy_a1 = (a1); \
+        __typeof__(a2) fy_a2 = (a2); \
+        if (strcmp(@encode(__typeof__(a1)), @encode(__typeof__(a2))) != 0) { \
+            STFail(@"Type mismatch of \"%s\" and \"%s\". %@", #a1, #a2, \
+                   [NSString stringWithFormat:description, ##__VA_ARGS__]); \
+        } else if (memcmp(&fy_a1, &fy_a2, sizeof(fy_a1)) != 0) { \
+            STFail(@"'%@' should be equal to '%@'. %@", \
+                   [NSValue valueWithBytes:&fy_a1 objCType:@encode(__typeof__(a1))], \
+                   [NSValue valueWithBytes:&fy_a2 objCType:@encode(__typeof__(a2))], \
+                   [NSString stringWithFormat:description, ##__VA_ARGS__]); \
+        } \
+    } while (0)
+
+#define STAssertEqualsWithAccuracy(a1, a2, accuracy, description, ...) \
+    do { \
+        double fy_a1 = (a1), fy_a2 = (a2); \
+        if (fabs(fy_a1 - fy_a2) > (accuracy)) { \
+            STFail(@"'%g' should be equal to '%g' +/- '%g'. %@", fy_a1, fy_a2, (double)(accuracy), \
+                   [NSString stringWithFormat:description, ##__VA_ARGS__]); \
+        } \
+    } while (0)
+
+#define STAssertThrows(expression, description, ...) \
+    do { \
+        BOOL fy_caught = NO; \
+        @try { \
+            (expression); \
+        } @catch (id exception) { \
+            fy_caught = YES; \
+        } \
+        if (!fy_caught) { \
+            STFail(@"\"%s\" should raise. %@", #expression, [NSString stringWithFormat:description, ##__VA_ARGS__]); \
+        } \
+    } while (0)
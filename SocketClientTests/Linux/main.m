@@ -0,0 +1,119 @@
+//
+//  main.m
+//  SocketClientTests
+//
+//  Created by agent on 17.10.26.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import <objc/runtime.h>
+#import <SenTestingKit/SenTestingKit.h>
+
+
+static NSUInteger SenTestCaseFailureCount = 0;
+
+
+@implementation SenTestCase
+
++ (NSUInteger)failureCount {
+    @synchronized (SenTestCase.class) {
+        return SenTestCaseFailureCount;
+    }
+}
+
++ (void)failWithDescription:(NSString *)description inFile:(const char *)file atLine:(int)line {
+    @synchronized (SenTestCase.class) {
+        SenTestCaseFailureCount++;
+    }
+    fprintf(stderr, "%s:%d: error: %s\n", file, line, description.UTF8String);
+}
+
+- (void)setUp {
+}
+
+- (void)tearDown {
+}
+
+@end
+
+
+/*
+ Runs all methods prefixed with `test` of one test case class in the order of their names.
+ */
+static void SenTestCaseRunClass(Class testClass) {
+    unsigned int count = 0;
+    Method *methods = class_copyMethodList(testClass, &count);
+    NSMutableArray *selectorNames = [NSMutableArray arrayWithCapacity:count];
+    for (unsigned int i=0; i<count; i++) {
+        NSString *name = NSStringFromSelector(method_getName(methods[i]));
+        if ([name hasPrefix:@"test"] && ![name hasSuffix:@":"]) {
+            [selectorNames addObject:name];
+        }
+    }
+    free(methods);
+    
+    for (NSString *name in [selectorNames sortedArrayUsingSelector:@selector(compare:)]) {
+        @autoreleasepool {
+            NSUInteger failureCount = SenTestCase.failureCount;
+            NSLog(@"Test Case '-[%@ %@]' started.", NSStringFromClass(testClass), name);
+            
+            SenTestCase *testCase = [testClass new];
+            [testCase setUp];
+            #pragma clang diagnostic push
+            #pragma clang diagnostic ignored "-Warc-performSelector-leaks"
+            [testCase performSelector:NSSelectorFromString(name)];
+            #pragma clang diagnostic pop
+            [testCase tearDown];
+            
+            NSLog(@"Test Case '-[%@ %@]' %@.", NSStringFromClass(testClass), name,
+                  SenTestCase.failureCount == failureCount ? @"passed" : @"failed");
+        }
+    }
+}
+
+
+/*
+ Runs the test case classes, which are linked into the tool, i.e. the tests or the benchmarks, see GNUstepMakefile.
+ The exit status is the count of failures, so that it can be used by make.
+ */
+int main(int argc, const char *argv[]) {
+    @autoreleasepool {
+        int classCount = objc_getClassList(NULL, 0);
+        __unsafe_unretained Class *classes = (__unsafe_unretained Class *)malloc(classCount * sizeof(Class));
+        classCount = MIN(objc_getClassList(classes, classCount), classCount);
+        NSMutableArray *testClassNames = [NSMutableArray new];
+        for (int i=0; i<classCount; i++) {
+            if (class_getSuperclass(classes[i]) == SenTestCase.class) {
+                [testClassNames addObject:NSStringFromClass(classes[i])];
+            }
+        }
+        free(classes);
+        
+        for (NSString *name in [testClassNames sortedArrayUsingSelector:@selector(compare:)]) {
+            SenTestCaseRunClass(NSClassFromString(name));
+        }
+        
+        return (int)MIN(SenTestCase.failureCount, 255);
+    }
+}
@@ -0,0 +1,50 @@
+//
+//  SocketClientBenchmarks.h
+//  SocketClientTests
+//
+//  Created by agent on 17.10.26.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import <SenTestingKit/SenTestingKit.h>
+
+
+/**
+ Benchmarks of the receive path against the sample server and the publisher in Server/, see `make benchmark`.
+ 
+ The benchmarks are skipped, unless the environment variable `FY_BENCHMARK` is set. They are configured by further
+ environment variables:
+ 
+ - `FY_BENCHMARK_CLIENTS`:       count of clients, default 4
+ - `FY_BENCHMARK_RATE`:          messages per second, which are published, default 1000
+ - `FY_BENCHMARK_PAYLOAD_SIZE`:  bytes of padding per message, default 256
+ - `FY_BENCHMARK_CHANNELS`:      count of channels, on which is published round-robin, default 10
+ - `FY_BENCHMARK_DURATION`:      seconds to publish, default 10
+ - `FY_BENCHMARK_RESULTS`:       path to write the results as JSON to
+ - `FY_BENCHMARK_BASELINE`:      path of stored results, which must not be regressed. The benchmark fails, if there
+                                   are no results stored at this path, see `make benchmark-baseline`.
+ */
+@interface SocketClientBenchmarks : SenTestCase
+
+@end
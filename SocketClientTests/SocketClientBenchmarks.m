@@ -0,0 +1,541 @@
+//
+//  SocketClientBenchmarks.m
+//  SocketClientTests
+//
+//  Created by agent on 17.10.26.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import <math.h>
+#import <stdatomic.h>
+#import <sys/resource.h>
+#import <unistd.h>
+#import "SocketClientBenchmarks.h"
+#import "FYClient.h"
+#import "FYMessage.h"
+#import "FYMessageDecoder.h"
+#import "FYMessagePack.h"
+#import "FYReconnectPolicy.h"
+
+#if defined(__APPLE__)
+    #import <mach/mach.h>
+    #import <malloc/malloc.h>
+#endif
+
+
+// Tolerances for regressions against the baseline
+static const double FYBenchmarkThroughputTolerance = 0.9;
+static const double FYBenchmarkLatencyTolerance    = 1.25;
+
+
+/*
+ Estimate a percentile over the merged buckets of multiple histograms.
+ */
+static NSTimeInterval FYBenchmarkPercentile(NSArray *histograms, double percentile) {
+    NSMutableArray *bucketCounts = [NSMutableArray new];
+    uint64_t total = 0;
+    for (NSUInteger i=0; i<FYLatencyHistogramBucketCount; i++) {
+        uint64_t count = 0;
+        for (FYLatencyHistogram *histogram in histograms) {
+            count += [histogram.bucketCounts[i] unsignedLongLongValue];
+        }
+        [bucketCounts addObject:@(count)];
+        total += count;
+    }
+    if (total == 0) {
+        return 0;
+    }
+    
+    uint64_t rank = MAX((uint64_t)ceil(total * percentile / 100.0), 1), seen = 0;
+    for (NSUInteger i=0; i<bucketCounts.count; i++) {
+        seen += [bucketCounts[i] unsignedLongLongValue];
+        if (seen >= rank) {
+            return [FYLatencyHistogram upperBoundOfBucketAtIndex:i];
+        }
+    }
+    return INFINITY;
+}
+
+/*
+ Consumed CPU time of the process in seconds.
+ */
+static NSTimeInterval FYBenchmarkCPUTime(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+/*
+ Resident memory of the process in bytes.
+ */
+static uint64_t FYBenchmarkResidentSize(void) {
+#if defined(__APPLE__)
+    struct task_basic_info info;
+    mach_msg_type_number_t count = TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS) {
+        return 0;
+    }
+    return info.resident_size;
+#else
+    // Second field of statm is the resident set size in pages
+    unsigned long long size, resident;
+    FILE *statm = fopen("/proc/self/statm", "r");
+    if (!statm) {
+        return 0;
+    }
+    int matched = fscanf(statm, "%llu %llu", &size, &resident);
+    fclose(statm);
+    return matched == 2 ? resident * (uint64_t)sysconf(_SC_PAGESIZE) : 0;
+#endif
+}
+
+
+
+@interface FYClient ()
+
+@property (nonatomic) dispatch_queue_t workerQueue;
+
+- (void)handleMessage:(NSDictionary *)userInfo;
+
+@end
+
+
+@interface SocketClientBenchmarks () <FYClientDelegate, FYMessageDecoderDelegate>
+
+@property (nonatomic, retain) NSDictionary *environment;
+@property (nonatomic, assign) NSUInteger subscribedCount;
+@property (nonatomic, assign, getter=isFinished) BOOL finished;
+@property (nonatomic, assign) NSUInteger decodedCount;
+
+- (double)doubleFromEnvironment:(NSString *)name defaultValue:(double)defaultValue;
+- (void)runRunLoopUntil:(BOOL(^)(void))condition timeout:(NSTimeInterval)timeout;
+- (NSTimeInterval)measureDeliveryOfMessageCount:(NSUInteger)count toChannelCount:(NSUInteger)channelCount
+                                     usingLanes:(BOOL)usesLanes;
+- (NSArray *)simulateReconnectsOfClientCount:(NSUInteger)clientCount policy:(id<FYReconnectPolicy>(^)(void))makePolicy
+                               fixedInterval:(NSTimeInterval)fixedInterval;
+
+@end
+
+
+@implementation SocketClientBenchmarks
+
+- (void)setUp {
+    [super setUp];
+    
+    self.environment = NSProcessInfo.processInfo.environment;
+}
+
+- (double)doubleFromEnvironment:(NSString *)name defaultValue:(double)defaultValue {
+    NSString *value = self.environment[name];
+    return value ? value.doubleValue : defaultValue;
+}
+
+- (void)runRunLoopUntil:(BOOL(^)(void))condition timeout:(NSTimeInterval)timeout {
+    NSDate *timeoutDate = [NSDate dateWithTimeIntervalSinceNow:timeout];
+    while (!condition() && [timeoutDate timeIntervalSinceNow] > 0) {
+        [NSRunLoop.currentRunLoop runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+    }
+}
+
+- (void)testBenchmarkReceivePath {
+    if (!self.environment[@"FY_BENCHMARK"]) {
+        NSLog(@"%@: skipped, set FY_BENCHMARK or run `make benchmark`.", NSStringFromSelector(_cmd));
+        return;
+    }
+    
+    NSUInteger clientCount  = [self doubleFromEnvironment:@"FY_BENCHMARK_CLIENTS" defaultValue:4];
+    double rate             = [self doubleFromEnvironment:@"FY_BENCHMARK_RATE" defaultValue:1000];
+    NSUInteger payloadSize  = [self doubleFromEnvironment:@"FY_BENCHMARK_PAYLOAD_SIZE" defaultValue:256];
+    NSUInteger channelCount = [self doubleFromEnvironment:@"FY_BENCHMARK_CHANNELS" defaultValue:10];
+    NSTimeInterval duration = [self doubleFromEnvironment:@"FY_BENCHMARK_DURATION" defaultValue:10];
+    
+    // Connect all clients and subscribe to all data channels. Callbacks are executed off the main thread, so that the
+    // run loop of the test doesn't distort the results.
+    dispatch_queue_t callbackQueue = dispatch_queue_create("SocketClientBenchmarks.callbackQueue", NULL);
+    __block _Atomic(int64_t) receivedCount = 0;
+    NSMutableArray *clients = [NSMutableArray new];
+    for (NSUInteger i=0; i<clientCount; i++) {
+        FYClient *client = [[FYClient alloc] initWithURL:[NSURL URLWithString:@"ws://localhost:8000/faye"]];
+        client.delegate = self;
+        client.callbackQueue = callbackQueue;
+        client.traceSamplingRate = 0.1;
+        [client connectOnSuccess:^(FYClient *client) {
+            [client subscribeChannel:@"/benchmark/data/**" callback:^(NSDictionary *userInfo) {
+                atomic_fetch_add_explicit(&receivedCount, 1, memory_order_relaxed);
+             }];
+         }];
+        [clients addObject:client];
+    }
+    FYClient *controller = clients[0];
+    [controller subscribeChannel:@"/benchmark/control" callback:^(NSDictionary *userInfo) {
+        if ([userInfo[@"command"] isEqualToString:@"finished"]) {
+            self.finished = YES;
+        }
+     }];
+    
+    __weak SocketClientBenchmarks *this = self;
+    [self runRunLoopUntil:^BOOL{
+        return this.subscribedCount >= clientCount + 1;
+     } timeout:10];
+    STAssertTrue(self.subscribedCount >= clientCount + 1, @"All clients must subscribe, is the server running?");
+    
+    // Let the publisher start and wait until it finished, or timed out
+    NSTimeInterval startUptime = NSProcessInfo.processInfo.systemUptime;
+    NSTimeInterval startCPUTime = FYBenchmarkCPUTime();
+    [controller publish:@{
+        @"command":  @"start",
+        @"rate":     @(rate),
+        @"size":     @(payloadSize),
+        @"channels": @(channelCount),
+        @"duration": @(duration),
+     } onChannel:@"/benchmark/control"];
+    [self runRunLoopUntil:^BOOL{
+        return this.isFinished;
+     } timeout:duration * 2 + 5];
+    
+    // Let the last messages arrive
+    [self runRunLoopUntil:^BOOL{ return NO; } timeout:1];
+    NSTimeInterval elapsed = NSProcessInfo.processInfo.systemUptime - startUptime;
+    NSTimeInterval cpuTime = FYBenchmarkCPUTime() - startCPUTime;
+    int64_t receivedMessageCount = atomic_load(&receivedCount);
+    
+    // Merge latencies of all clients and channels
+    NSMutableArray *latencies = [NSMutableArray new];
+    NSMutableArray *totalTimes = [NSMutableArray new];
+    for (FYClient *client in clients) {
+        for (FYMessageTraceReport *report in client.traceReports.allValues) {
+            [latencies addObject:report.publishToDeliveryTime];
+            [totalTimes addObject:report.totalTime];
+        }
+        [client disconnect];
+    }
+    
+    NSDictionary *results = @{
+        @"clients":              @(clientCount),
+        @"rate":                 @(rate),
+        @"payloadSize":          @(payloadSize),
+        @"channels":             @(channelCount),
+        @"receivedMessages":     @(receivedMessageCount),
+        @"messagesPerSecond":    @(receivedMessageCount / elapsed),
+        @"latencyP50":           @(FYBenchmarkPercentile(latencies, 50)),
+        @"latencyP99":           @(FYBenchmarkPercentile(latencies, 99)),
+        @"latencyP999":          @(FYBenchmarkPercentile(latencies, 99.9)),
+        @"receivePathP50":       @(FYBenchmarkPercentile(totalTimes, 50)),
+        @"receivePathP99":       @(FYBenchmarkPercentile(totalTimes, 99)),
+        @"receivePathP999":      @(FYBenchmarkPercentile(totalTimes, 99.9)),
+        @"cpuUtilization":       @(cpuTime / elapsed),
+        @"residentSize":         @(FYBenchmarkResidentSize()),
+     };
+    NSLog(@"%@: %@", NSStringFromSelector(_cmd), results);
+    STAssertTrue(receivedMessageCount > 0, @"Must receive published messages, is the publisher running?");
+    
+    NSString *resultsPath = self.environment[@"FY_BENCHMARK_RESULTS"];
+    if (resultsPath) {
+        NSData *data = [NSJSONSerialization dataWithJSONObject:results options:NSJSONWritingPrettyPrinted error:NULL];
+        [data writeToFile:resultsPath atomically:YES];
+    }
+    
+    // Compare to the baseline, which was measured with the same configuration
+    NSString *baselinePath = self.environment[@"FY_BENCHMARK_BASELINE"];
+    if (!baselinePath) {
+        NSLog(@"%@: not compared, set FY_BENCHMARK_BASELINE or run `make benchmark`.", NSStringFromSelector(_cmd));
+        return;
+    }
+    NSData *baselineData = [NSData dataWithContentsOfFile:baselinePath];
+    NSDictionary *baseline = baselineData ? [NSJSONSerialization JSONObjectWithData:baselineData options:0 error:NULL] : nil;
+    if (![baseline isKindOfClass:NSDictionary.class]) {
+        // Regressions would pass unnoticed otherwise
+        STFail(@"No baseline at %@ to compare to. Store these results by `make benchmark-baseline` on the reference "
+               "machine and commit the file.", baselinePath);
+    } else {
+        for (NSString *key in @[@"clients", @"rate", @"payloadSize", @"channels"]) {
+            STAssertEqualObjects(results[key], baseline[key], @"Baseline was measured with another configuration.");
+        }
+        STAssertTrue([results[@"messagesPerSecond"] doubleValue]
+                     >= [baseline[@"messagesPerSecond"] doubleValue] * FYBenchmarkThroughputTolerance,
+                     @"Throughput regressed from %@ to %@ messages per second.",
+                     baseline[@"messagesPerSecond"], results[@"messagesPerSecond"]);
+        for (NSString *key in @[@"receivePathP50", @"receivePathP99", @"latencyP99", @"latencyP999"]) {
+            STAssertTrue([results[key] doubleValue] <= [baseline[key] doubleValue] * FYBenchmarkLatencyTolerance,
+                         @"Latency %@ regressed from %@ to %@ seconds.", key, baseline[key], results[key]);
+        }
+    }
+}
+
+- (void)client:(FYClient *)client subscriptionSucceedToChannel:(NSString *)channel {
+    self.subscribedCount++;
+}
+
+- (void)testBenchmarkPayloadEncoding {
+    if (!self.environment[@"FY_BENCHMARK"]) {
+        NSLog(@"%@: skipped, set FY_BENCHMARK or run `make benchmark`.", NSStringFromSelector(_cmd));
+        return;
+    }
+    
+    NSUInteger frameCount  = [self doubleFromEnvironment:@"FY_BENCHMARK_CODEC_FRAMES" defaultValue:200];
+    NSUInteger sampleCount = [self doubleFromEnvironment:@"FY_BENCHMARK_CODEC_SAMPLES" defaultValue:64];
+    const NSUInteger messageCount = 100;
+    
+    // Numeric-heavy telemetry: a few identifying fields and many readings per message
+    NSMutableArray *messages = [NSMutableArray new];
+    for (NSUInteger i=0; i<messageCount; i++) {
+        NSMutableArray *readings = [NSMutableArray new];
+        for (NSUInteger j=0; j<sampleCount; j++) {
+            [readings addObject:@(sin(i * sampleCount + j) * 1000)];
+        }
+        [messages addObject:@{
+            @"channel": [NSString stringWithFormat:@"/telemetry/sensor%d", (int)(i % 10)],
+            @"id":      [NSString stringWithFormat:@"%x", (int)i],
+            @"data":    @{
+                @"sequence":  @(i),
+                @"timestamp": @(1792224000000 + i * 10),
+                @"status":    @(i % 3),
+                @"readings":  readings,
+            },
+         }];
+    }
+    
+    // Encode each message on its own like the client, and join them to frames like flushSocketMessages
+    NSData *(^encodeJSON)(void) = ^NSData *{
+        NSMutableData *frame = [NSMutableData dataWithBytes:"[" length:1];
+        for (NSDictionary *message in messages) {
+            if (frame.length > 1) {
+                [frame appendBytes:"," length:1];
+            }
+            [frame appendData:[NSJSONSerialization dataWithJSONObject:message options:0 error:NULL]];
+        }
+        [frame appendBytes:"]" length:1];
+        return frame;
+    };
+    NSData *(^encodePacked)(void) = ^NSData *{
+        NSMutableData *frame = [NSMutableData new];
+        [FYMessagePack appendArrayHeaderWithCount:messages.count toData:frame];
+        for (NSDictionary *message in messages) {
+            [frame appendData:[FYMessagePack dataWithObject:message]];
+        }
+        return frame;
+    };
+    NSTimeInterval (^measure)(void(^)(void)) = ^NSTimeInterval(void(^block)(void)) {
+        NSTimeInterval startUptime = NSProcessInfo.processInfo.systemUptime;
+        for (NSUInteger i=0; i<frameCount; i++) {
+            @autoreleasepool {
+                block();
+            }
+        }
+        return (NSProcessInfo.processInfo.systemUptime - startUptime) / (frameCount * messageCount);
+    };
+    
+    NSData *jsonFrame = encodeJSON();
+    NSData *packedFrame = encodePacked();
+    FYMessageDecoder *decoder = [[FYMessageDecoder alloc] initWithDelegate:self];
+    self.decodedCount = 0;
+    
+    NSDictionary *results = @{
+        @"messages":           @(messageCount),
+        @"readings":           @(sampleCount),
+        @"jsonSize":           @(jsonFrame.length / messageCount),
+        @"packedSize":         @(packedFrame.length / messageCount),
+        @"jsonEncodeTime":     @(measure(^{ encodeJSON(); })),
+        @"packedEncodeTime":   @(measure(^{ encodePacked(); })),
+        @"jsonDecodeTime":     @(measure(^{ [decoder decodeData:jsonFrame error:NULL]; })),
+        @"packedDecodeTime":   @(measure(^{ [decoder decodePackedBytes:packedFrame.bytes length:packedFrame.length
+                                                                 error:NULL]; })),
+     };
+    NSLog(@"%@: %@", NSStringFromSelector(_cmd), results);
+    
+    STAssertEquals(self.decodedCount, 2 * frameCount * messageCount, @"Each message of both encodings must be decoded.");
+    STAssertTrue(packedFrame.length < jsonFrame.length, @"MessagePack must be smaller than JSON for numeric payloads.");
+}
+
+/*
+ Deliver messages round-robin to channels, whose callbacks each take 1 ms, and return the time until all callbacks were
+ executed.
+ */
+- (NSTimeInterval)measureDeliveryOfMessageCount:(NSUInteger)count toChannelCount:(NSUInteger)channelCount
+                                     usingLanes:(BOOL)usesLanes {
+    FYClient *client = [[FYClient alloc] initWithURL:[NSURL URLWithString:@"http://localhost"]];
+    client.callbackQueue = dispatch_queue_create("SocketClientBenchmarks.callbackQueue", NULL);
+    
+    dispatch_semaphore_t finished = dispatch_semaphore_create(0);
+    __block _Atomic(int32_t) remaining = (int32_t)count;
+    for (NSUInteger i=0; i<channelCount; i++) {
+        NSString *channel = [NSString stringWithFormat:@"/lanes/%d", (int)i];
+        FYSubscriptionOptions *options = [FYSubscriptionOptions new];
+        options.lane = usesLanes ? channel : nil;
+        [client subscribeChannel:channel callback:^(NSDictionary *userInfo) {
+            usleep(1000);
+            if (atomic_fetch_sub(&remaining, 1) == 1) {
+                dispatch_semaphore_signal(finished);
+            }
+         } extension:nil options:options];
+    }
+    
+    NSTimeInterval startUptime = NSProcessInfo.processInfo.systemUptime;
+    dispatch_async(client.workerQueue, ^{
+        for (NSUInteger i=0; i<count; i++) {
+            [client handleMessage:@{
+                @"channel": [NSString stringWithFormat:@"/lanes/%d", (int)(i % channelCount)],
+                @"data":    @{ @"number": @(i) },
+             }];
+        }
+     });
+    long timedOut = dispatch_semaphore_wait(finished, dispatch_time(DISPATCH_TIME_NOW, 30 * NSEC_PER_SEC));
+    NSTimeInterval duration = NSProcessInfo.processInfo.systemUptime - startUptime;
+    
+    STAssertEquals(timedOut, (long)0, @"Must deliver all messages, %d left.", (int)atomic_load(&remaining));
+    return duration;
+}
+
+- (void)testBenchmarkSerialLanes {
+    if (!self.environment[@"FY_BENCHMARK"]) {
+        NSLog(@"%@: skipped, set FY_BENCHMARK or run `make benchmark`.", NSStringFromSelector(_cmd));
+        return;
+    }
+    
+    const NSUInteger count = 400, channelCount = 4;
+    NSTimeInterval singleQueueDuration = [self measureDeliveryOfMessageCount:count toChannelCount:channelCount usingLanes:NO];
+    NSTimeInterval lanesDuration = [self measureDeliveryOfMessageCount:count toChannelCount:channelCount usingLanes:YES];
+    
+    NSLog(@"%@: single queue %.3fs, %d lanes %.3fs.", NSStringFromSelector(_cmd), singleQueueDuration,
+          (int)channelCount, lanesDuration);
+    STAssertTrue(lanesDuration < singleQueueDuration, @"Independent channels must be delivered in parallel.");
+}
+
+/*
+ Simulate N clients, which lost their connection at the same instant, against a stand-in server, which is down for 10
+ seconds and then accepts a limited count of handshakes per second. Returns the count of handshake attempts per second.
+ */
+- (NSArray *)simulateReconnectsOfClientCount:(NSUInteger)clientCount policy:(id<FYReconnectPolicy>(^)(void))makePolicy
+                               fixedInterval:(NSTimeInterval)fixedInterval {
+    const NSUInteger serverDownTime = 10, serverCapacity = 200, duration = 300;
+    
+    NSMutableArray *policies = [NSMutableArray new];
+    double *nextAttempts = calloc(clientCount, sizeof(double));
+    for (NSUInteger i = 0; i < clientCount; i++) {
+        id<FYReconnectPolicy> policy = makePolicy ? makePolicy() : nil;
+        [policies addObject:policy ?: NSNull.null];
+        nextAttempts[i] = policy ? [policy reconnectDelayWithAdvisedInterval:0 sessionDuration:0] : fixedInterval;
+    }
+    
+    NSMutableArray *handshakeRates = [NSMutableArray new];
+    for (NSUInteger second = 0; second < duration; second++) {
+        NSUInteger attempts = 0, accepted = 0;
+        for (NSUInteger i = 0; i < clientCount; i++) {
+            if (nextAttempts[i] < second || nextAttempts[i] >= second + 1) {
+                continue;
+            }
+            attempts++;
+            if (second >= serverDownTime && accepted < serverCapacity) {
+                accepted++;
+                nextAttempts[i] = INFINITY;
+            } else {
+                id<FYReconnectPolicy> policy = policies[i];
+                nextAttempts[i] += policy != (id)NSNull.null
+                    ? [policy reconnectDelayWithAdvisedInterval:0 sessionDuration:0]
+                    : fixedInterval;
+            }
+        }
+        [handshakeRates addObject:@(attempts)];
+    }
+    
+    for (NSUInteger i = 0; i < clientCount; i++) {
+        STAssertTrue(isinf(nextAttempts[i]), @"Each client must have reconnected within the simulated time.");
+    }
+    free(nextAttempts);
+    return handshakeRates;
+}
+
+- (void)testBenchmarkReconnectPolicySpreadsHandshakes {
+    if (!self.environment[@"FY_BENCHMARK"]) {
+        NSLog(@"%@: skipped, set FY_BENCHMARK or run `make benchmark`.", NSStringFromSelector(_cmd));
+        return;
+    }
+    
+    NSUInteger clientCount = [self doubleFromEnvironment:@"FY_BENCHMARK_RECONNECT_CLIENTS" defaultValue:1000];
+    
+    NSArray *fixedRates = [self simulateReconnectsOfClientCount:clientCount policy:nil fixedInterval:45];
+    NSArray *backoffRates = [self simulateReconnectsOfClientCount:clientCount policy:^id<FYReconnectPolicy>{
+        return [[FYBackoffReconnectPolicy alloc] initWithMinimumInterval:1 maximumInterval:45];
+     } fixedInterval:0];
+    
+    // Compare the peaks, which hit the server after it came back
+    NSRange recovered = NSMakeRange(10, fixedRates.count - 10);
+    NSNumber *fixedPeak = [[fixedRates subarrayWithRange:recovered] valueForKeyPath:@"@max.self"];
+    NSNumber *backoffPeak = [[backoffRates subarrayWithRange:recovered] valueForKeyPath:@"@max.self"];
+    NSLog(@"Handshakes per second of %d clients with fixed interval: %@", (int)clientCount,
+          [fixedRates componentsJoinedByString:@" "]);
+    NSLog(@"Handshakes per second of %d clients with backoff policy: %@", (int)clientCount,
+          [backoffRates componentsJoinedByString:@" "]);
+    
+    STAssertTrue(backoffPeak.unsignedIntegerValue * 3 < fixedPeak.unsignedIntegerValue,
+                 @"Backoff with jitter must flatten the peak handshake rate (%@ vs. %@).", backoffPeak, fixedPeak);
+}
+
+// Allocations are only counted by the malloc zones of Darwin
+#if defined(__APPLE__)
+- (void)testBenchmarkMessageAllocations {
+    if (!self.environment[@"FY_BENCHMARK"]) {
+        NSLog(@"%@: skipped, set FY_BENCHMARK or run `make benchmark`.", NSStringFromSelector(_cmd));
+        return;
+    }
+    
+    // Count the allocations, which stay alive per message on the delivery path: a message is created for a decoded
+    // userInfo and only its channel and data are read.
+    const NSUInteger count = 10000;
+    NSDictionary *userInfo = @{
+        @"channel":  @"/prices/eur",
+        @"clientId": @"client",
+        @"id":       @"1",
+        @"data":     @{ @"price": @1.5 },
+     };
+    NSMutableArray *messages = [[NSMutableArray alloc] initWithCapacity:count];
+    
+    malloc_statistics_t before, after;
+    malloc_zone_statistics(NULL, &before);
+    @autoreleasepool {
+        for (NSUInteger i=0; i<count; i++) {
+            FYMessage *message = [[FYMessage alloc] initWithUserInfo:userInfo];
+            (void)message.channel;
+            (void)message.data;
+            [messages addObject:message];
+        }
+    }
+    malloc_zone_statistics(NULL, &after);
+    
+    double allocationsPerMessage = (double)(after.blocks_in_use - before.blocks_in_use) / count;
+    NSLog(@"%@: %.2f allocations per message.", NSStringFromSelector(_cmd), allocationsPerMessage);
+    STAssertTrue(allocationsPerMessage < 1.5, @"A message must not copy its userInfo, but needed %.2f allocations.",
+                 allocationsPerMessage);
+}
+#endif
+
+- (BOOL)decoder:(FYMessageDecoder *)decoder shouldDecodePayloadOfChannel:(NSString *)channel {
+    return YES;
+}
+
+- (void)decoder:(FYMessageDecoder *)decoder decodedMessage:(NSDictionary *)userInfo {
+    self.decodedCount++;
+}
+
+@end
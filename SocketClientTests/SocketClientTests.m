@@ -27,22 +27,298 @@
 //  THE SOFTWARE.
 //
 
+#import <netinet/in.h>
+#import <stdatomic.h>
+#import <sys/socket.h>
+#import <unistd.h>
 #import "SocketClientTests.h"
+#import "FYChannelRouter.h"
 #import "FYClient.h"
+#import "FYDelegateProxy.h"
+#import "FYDeliveryQueue.h"
+#import "FYHTTPTransport.h"
+#import "FYMessage.h"
+#import "FYMessageDecoder.h"
+#import "FYMessagePack.h"
+#import "FYMessageTemplate.h"
+#import "FYMetricsRecorder.h"
+#import "FYOfflineQueue.h"
+#import "FYPerMessageDeflate.h"
+#import "FYReconnectPolicy.h"
+#import "FYSubscriptionReconciler.h"
+#import "FYTimerWheel.h"
+#import "FYTimestamp.h"
 
 
 
+/*
+ Methods of the private delegate proxy of FYClient, which reply asynchronously to methods with inout-arguments
+ */
+@protocol SocketClientTestsDelegateProxy <FYClientDelegate>
+
+- (void)clientWasAdvisedToRetry:(FYClient *)client retryInterval:(NSTimeInterval)interval
+                   replyOnQueue:(dispatch_queue_t)queue reply:(void(^)(NSTimeInterval interval))reply;
+- (void)clientWasAdvisedToHandshake:(FYClient *)client replyOnQueue:(dispatch_queue_t)queue
+                              reply:(void(^)(BOOL retry))reply;
+
+@end
+
+
 @interface FYClient ()
 
+@property (nonatomic) dispatch_queue_t workerQueue;
+@property (nonatomic, retain) FYDelegateProxy<SocketClientTestsDelegateProxy> *clientDelegateProxy;
+@property (nonatomic, assign) NSUInteger state;
+@property (nonatomic, retain) FYTimer *reconnectTimer;
+@property (nonatomic, retain) FYHTTPTransport *httpTransport;
+@property (nonatomic, retain, readwrite) NSString *connectionType;
+@property (nonatomic, retain, readwrite) NSString *clientId;
+@property (nonatomic, retain) FYMessageTemplate *handshakeTemplate;
+@property (nonatomic, assign) NSUInteger compressionThreshold;
+@property (nonatomic, assign) BOOL compressesWithContextTakeover;
+@property (nonatomic, retain) FYClockOffsetEstimator *clockOffsetEstimator;
+
 - (NSString *)generateMessageId;
+- (void)handleMessage:(NSDictionary *)userInfo;
+- (void)dropSocketMessages:(NSArray *)messages withError:(NSError *)error;
+- (void)sendOfflinePublishes;
+- (void)webSocket:(id)webSocket didFailWithError:(NSError *)error;
+- (void)transport:(id)transport receivedData:(NSData *)data;
+- (void)transport:(id)transport failedWithError:(NSError *)error;
+- (FYPerMessageDeflate *)makeMessageCodec;
+- (NSString *)agreedPayloadEncodingOfMessage:(FYMessage *)message;
+
+@end
+
+
+@interface FYChannelRouter ()
+
+- (NSUInteger)internedSegmentCount;
 
 @end
 
 
 
-@interface SocketClientTests ()
+/*
+ Records the messages, which are sent by long-polling, instead of posting them. Responses are injected by the tests.
+ */
+@interface SocketClientTestsTransport : FYHTTPTransport
+
+@property (nonatomic, retain) NSMutableArray *sentMessages;
+@property (nonatomic, retain) NSMutableArray *polledMessages;
+@property (nonatomic, assign, getter=isPolling) BOOL polling;
+
+@end
+
+
+@implementation SocketClientTestsTransport
+
+- (id)initWithURL:(NSURL *)URL queue:(dispatch_queue_t)queue {
+    self = [super initWithURL:URL queue:queue];
+    if (self) {
+        self.sentMessages = [NSMutableArray new];
+        self.polledMessages = [NSMutableArray new];
+    }
+    return self;
+}
+
+- (void)sendMessage:(NSData *)message {
+    [self.sentMessages addObject:[NSJSONSerialization JSONObjectWithData:message options:0 error:NULL]];
+}
+
+- (void)pollWithMessage:(NSData *)message timeoutInterval:(NSTimeInterval)timeoutInterval {
+    [self.polledMessages addObject:[NSJSONSerialization JSONObjectWithData:message options:0 error:NULL]];
+    self.polling = YES;
+}
+
+- (void)cancel {
+    self.polling = NO;
+}
+
+@end
+
+
+
+/*
+ Holds back requests to the host `fyhttptransport.test`, until the test responds to them with a chunked response.
+ */
+@interface SocketClientTestsURLProtocol : NSURLProtocol
+
+@property (nonatomic, retain) NSThread *clientThread;
+
++ (void)reset;
++ (NSArray *)startedRequestBodies;
++ (void)respondToRequestAtIndex:(NSUInteger)index withChunks:(NSArray *)chunks;
+
+@end
+
+
+@implementation SocketClientTestsURLProtocol
+
+static NSMutableArray *SocketClientTestsStartedProtocols;
+
++ (BOOL)canInitWithRequest:(NSURLRequest *)request {
+    return [request.URL.host isEqualToString:@"fyhttptransport.test"];
+}
+
++ (NSURLRequest *)canonicalRequestForRequest:(NSURLRequest *)request {
+    return request;
+}
+
++ (void)reset {
+    @synchronized(self) {
+        SocketClientTestsStartedProtocols = [NSMutableArray new];
+    }
+}
+
++ (NSArray *)startedRequestBodies {
+    @synchronized(self) {
+        return [SocketClientTestsStartedProtocols valueForKeyPath:@"request.HTTPBody"];
+    }
+}
+
++ (void)respondToRequestAtIndex:(NSUInteger)index withChunks:(NSArray *)chunks {
+    SocketClientTestsURLProtocol *protocol;
+    @synchronized(self) {
+        protocol = SocketClientTestsStartedProtocols[index];
+    }
+    // The client expects to be called on the thread, which started loading
+    [protocol performSelector:@selector(sendChunks:) onThread:protocol.clientThread withObject:chunks waitUntilDone:NO];
+}
+
+- (void)startLoading {
+    self.clientThread = NSThread.currentThread;
+    @synchronized(self.class) {
+        [SocketClientTestsStartedProtocols addObject:self];
+    }
+}
+
+- (void)stopLoading {
+}
+
+- (void)sendChunks:(NSArray *)chunks {
+    NSHTTPURLResponse *response = [[NSHTTPURLResponse alloc] initWithURL:self.request.URL statusCode:200
+                                                             HTTPVersion:@"HTTP/1.1"
+                                                            headerFields:@{ @"Transfer-Encoding": @"chunked" }];
+    [self.client URLProtocol:self didReceiveResponse:response cacheStoragePolicy:NSURLCacheStorageNotAllowed];
+    for (NSString *chunk in chunks) {
+        [self.client URLProtocol:self didLoadData:[chunk dataUsingEncoding:NSUTF8StringEncoding]];
+    }
+    [self.client URLProtocolDidFinishLoading:self];
+}
+
+@end
+
+
+
+/*
+ Records the responses and errors of a FYHTTPTransport. Only accessed on the queue of the transport.
+ */
+@interface SocketClientTestsTransportDelegate : NSObject <FYHTTPTransportDelegate>
+
+@property (nonatomic, retain) NSMutableArray *receivedData;
+@property (nonatomic, retain) NSMutableArray *errors;
+
+@end
+
+
+@implementation SocketClientTestsTransportDelegate
+
+- (id)init {
+    self = [super init];
+    if (self) {
+        self.receivedData = [NSMutableArray new];
+        self.errors = [NSMutableArray new];
+    }
+    return self;
+}
+
+- (void)transport:(FYHTTPTransport *)transport receivedData:(NSData *)data {
+    [self.receivedData addObject:data];
+}
+
+- (void)transport:(FYHTTPTransport *)transport failedWithError:(NSError *)error {
+    [self.errors addObject:error];
+}
+
+@end
+
+
+
+/*
+ Implements only some methods of FYClientDelegate and records their calls
+ */
+@interface SocketClientTestsPartialDelegate : NSObject <FYClientDelegate>
+
+@property (nonatomic, retain) NSMutableArray *calls;
+
+@end
+
+
+@implementation SocketClientTestsPartialDelegate
+
+- (id)init {
+    self = [super init];
+    if (self) {
+        self.calls = [NSMutableArray new];
+    }
+    return self;
+}
+
+- (void)clientConnected:(FYClient *)client {
+    [self.calls addObject:@"clientConnected:"];
+}
+
+- (void)clientWasAdvisedToRetry:(FYClient *)client retryInterval:(inout NSTimeInterval *)interval {
+    [self.calls addObject:@"clientWasAdvisedToRetry:retryInterval:"];
+    *interval = 5;
+}
+
+@end
+
+
+/*
+ Implements the methods of FYClientDelegate, which SocketClientTestsPartialDelegate doesn't implement
+ */
+@interface SocketClientTestsOtherDelegate : SocketClientTestsPartialDelegate
+@end
+
+
+@implementation SocketClientTestsOtherDelegate
+
+- (BOOL)respondsToSelector:(SEL)selector {
+    if (selector == @selector(clientConnected:) || selector == @selector(clientWasAdvisedToRetry:retryInterval:)) {
+        return NO;
+    }
+    return [super respondsToSelector:selector];
+}
+
+- (void)client:(FYClient *)client failedWithError:(NSError *)error {
+    [self.calls addObject:@"client:failedWithError:"];
+}
+
+- (void)clientWasAdvisedToHandshake:(FYClient *)client shouldRetry:(inout BOOL *)retry {
+    [self.calls addObject:@"clientWasAdvisedToHandshake:shouldRetry:"];
+    *retry = YES;
+}
+
+@end
+
+
+
+@interface SocketClientTests () <FYClientDelegate, FYMessageDecoderDelegate>
 
 @property (nonatomic, retain) FYClient *client;
+@property (nonatomic, retain) NSMutableArray *decodedMessages;
+@property (nonatomic, retain) NSMutableArray *askedResponseIds;
+@property (nonatomic, assign) BOOL skipsUnwantedMessages;
+@property (nonatomic, retain) NSNumber *countedNumber;
+
+- (BOOL)isLocalServerRunningForTest:(SEL)test;
+- (BOOL)runRunLoopUntil:(BOOL(^)(void))condition timeout:(NSTimeInterval)timeout;
+- (void)client:(FYClient *)client receiveMessages:(NSArray *)messages;
+- (FYClient *)clientWithStubSession;
+- (NSArray *)publishesSentByClient:(FYClient *)client;
 
 @end
 
@@ -75,6 +351,14 @@
                   @"Two generated message ids by %@ may not be equal.", NSStringFromSelector(@selector(generateMessageId)));
 }
 
+- (void)testGenerateMessageIdAreUniqueWithinShortTime {
+    NSMutableSet *messageIds = [NSMutableSet new];
+    for (NSUInteger i = 0; i < 10000; i++) {
+        [messageIds addObject:[self.client generateMessageId]];
+    }
+    STAssertEquals(messageIds.count, (NSUInteger)10000, @"Message ids generated in a tight loop may not collide.");
+}
+
 - (void)testPersistDoesNotAllowRelease {
     // Store weak ref and release our own reference.
     __weak FYClient *weakClient = self.client;
@@ -93,4 +377,1289 @@
      });
 }
 
+- (void)testChannelRouterMatchesExactAndWildcardChannels {
+    FYChannelRouter *router = [FYChannelRouter new];
+    router[@"/prices/eur"]    = @"exact";
+    router[@"/prices/*"]      = @"wildcard";
+    router[@"/prices/**"]     = @"globbing";
+    router[@"/orders/**"]     = @"orders";
+    
+    NSMutableDictionary *matches = [NSMutableDictionary new];
+    FYChannelRouterMatchBlock collect = ^(NSString *pattern, id object) {
+        matches[pattern] = object;
+     };
+    
+    STAssertTrue([router enumerateObjectsMatchingChannel:@"/prices/eur" usingBlock:collect], @"Expected a match.");
+    STAssertEqualObjects(matches, (@{ @"/prices/eur": @"exact", @"/prices/*": @"wildcard", @"/prices/**": @"globbing" }),
+                         @"Exact, wildcard and globbing patterns must match.");
+    
+    [matches removeAllObjects];
+    STAssertTrue([router enumerateObjectsMatchingChannel:@"/prices/eur/usd" usingBlock:collect], @"Expected a match.");
+    STAssertEqualObjects(matches, (@{ @"/prices/**": @"globbing" }), @"Only globbing pattern must match deeper channels.");
+    
+    [matches removeAllObjects];
+    STAssertFalse([router enumerateObjectsMatchingChannel:@"/prices" usingBlock:collect], @"Expected no match.");
+    STAssertFalse([router enumerateObjectsMatchingChannel:@"/news/eur" usingBlock:collect], @"Expected no match.");
+    STAssertEquals(matches.count, (NSUInteger)0, @"Patterns must not match their parent or unrelated channels.");
+}
+
+- (void)testChannelRouterRemovesChannels {
+    FYChannelRouter *router = [FYChannelRouter new];
+    router[@"/a/b/c"] = @"exact";
+    router[@"/a/*"]   = @"wildcard";
+    FYChannelRouter *copy = router.copy;
+    
+    [router removeObjectsForChannels:@[@"/a/b/c", @"/a/*"]];
+    STAssertEquals(router.count, (NSUInteger)0, @"All channels must be removed.");
+    STAssertFalse([router enumerateObjectsMatchingChannel:@"/a/b/c" usingBlock:^(NSString *pattern, id object) {}],
+                  @"Removed channels must not match.");
+    
+    STAssertEquals(copy.count, (NSUInteger)2, @"Copy must be independent.");
+    STAssertEqualObjects(copy[@"/a/b/c"], @"exact", @"Copy must keep registrations.");
+}
+
+- (void)testChannelRouterSnapshotsAreImmutable {
+    FYChannelRouter *router = [FYChannelRouter new];
+    router[@"/prices/eur"] = @"eur";
+    router[@"/prices/*"]   = @"wildcard";
+    FYChannelRouter *snapshot = [router snapshot];
+    
+    router[@"/prices/usd"] = @"usd";
+    router[@"/prices/eur"] = @"replaced";
+    [router removeObjectForChannel:@"/prices/*"];
+    STAssertTrue([snapshot isSnapshot], @"Snapshot must be immutable.");
+    STAssertEquals(snapshot.count, (NSUInteger)2, @"Snapshot must not see later writes.");
+    STAssertEqualObjects(snapshot[@"/prices/eur"], @"eur", @"Snapshot must keep replaced objects.");
+    STAssertEqualObjects(snapshot[@"/prices/*"], @"wildcard", @"Snapshot must keep removed objects.");
+    STAssertFalse([snapshot hasObjectsMatchingChannel:@"/prices/usd/x"], @"Snapshot must not see added channels.");
+    STAssertEqualObjects(router[@"/prices/eur"], @"replaced", @"Router must see its writes.");
+    STAssertEquals(router.count, (NSUInteger)2, @"Router must count its writes.");
+    
+    for (NSUInteger i = 0; i < 100; i++) {
+        NSString *channel = [NSString stringWithFormat:@"/churn/%d", (int)i];
+        router[channel] = @"churn";
+        [router removeObjectForChannel:channel];
+    }
+    STAssertEquals(router.internedSegmentCount, (NSUInteger)3, @"Segments of removed channels must be released.");
+}
+
+- (BOOL)decoder:(FYMessageDecoder *)decoder shouldDecodePayloadOfChannel:(NSString *)channel {
+    return [channel isEqualToString:@"/wanted"];
+}
+
+- (void)decoder:(FYMessageDecoder *)decoder decodedMessage:(NSDictionary *)userInfo {
+    [self.decodedMessages addObject:userInfo];
+}
+
+- (BOOL)decoder:(FYMessageDecoder *)decoder shouldEmitMessageOfChannel:(NSString *)channel
+     responseId:(NSString *)responseId {
+    [self.askedResponseIds addObject:responseId ?: NSNull.null];
+    return !self.skipsUnwantedMessages || responseId;
+}
+
+- (void)testMessageDecoderDecodesOnlyWantedPayloads {
+    self.decodedMessages = [NSMutableArray new];
+    FYMessageDecoder *decoder = [[FYMessageDecoder alloc] initWithDelegate:self];
+    NSData *frame = [@"[{\"channel\":\"/wanted\",\"data\":{\"a\":[1,2.5,\"\\u00e9\"]}},"
+                      "{\"data\":{\"b\":true},\"channel\":\"/unwanted\",\"id\":\"1\"}]"
+                     dataUsingEncoding:NSUTF8StringEncoding];
+    
+    NSError *error = nil;
+    STAssertTrue([decoder decodeData:frame error:&error], @"Frame must be decoded, but failed with: %@.", error);
+    STAssertEquals(self.decodedMessages.count, (NSUInteger)2, @"Each message must be emitted.");
+    STAssertEqualObjects(self.decodedMessages[0], [NSJSONSerialization JSONObjectWithData:[@"{\"channel\":\"/wanted\","
+                                                   "\"data\":{\"a\":[1,2.5,\"\\u00e9\"]}}" dataUsingEncoding:NSUTF8StringEncoding]
+                                                                                  options:0 error:NULL],
+                         @"Wanted payload must be decoded like NSJSONSerialization does.");
+    STAssertEqualObjects(self.decodedMessages[1], (@{ @"channel": @"/unwanted", @"id": @"1" }),
+                         @"Unwanted payload must be skipped.");
+    
+    STAssertFalse([decoder decodeData:[@"[{\"channel\":}]" dataUsingEncoding:NSUTF8StringEncoding] error:&error],
+                  @"Malformed frame must fail.");
+}
+
+- (void)testMessageDecoderSkipsUnwantedMessages {
+    self.decodedMessages = [NSMutableArray new];
+    self.askedResponseIds = [NSMutableArray new];
+    self.skipsUnwantedMessages = YES;
+    FYMessageDecoder *decoder = [[FYMessageDecoder alloc] initWithDelegate:self];
+    NSData *frame = [@"[{\"data\":{\"text\":\"0123456789abcdef \\\"quoted\\\" [not] {structure} \\\\\","
+                      "\"list\":[[],{}]},"
+                      "\"channel\":\"/unwanted\",\"id\":\"1\"},"
+                      "{\"channel\":\"/unwanted\",\"successful\":true,\"id\":\"2\"},"
+                      "{\"id\":\"3\",\"channel\":\"/wanted\",\"data\":\"0123456789abcdef0123456789abcdef\\n\"}]"
+                     dataUsingEncoding:NSUTF8StringEncoding];
+    
+    NSError *error = nil;
+    STAssertTrue([decoder decodeData:frame error:&error], @"Frame must be decoded, but failed with: %@.", error);
+    STAssertEqualObjects(self.askedResponseIds, (@[NSNull.null, @"2"]), @"Only unwanted messages must be asked for.");
+    STAssertEquals(self.decodedMessages.count, (NSUInteger)2, @"Skipped message must not be emitted.");
+    STAssertEqualObjects(self.decodedMessages[0], (@{ @"channel": @"/unwanted", @"successful": @YES, @"id": @"2" }),
+                         @"Acknowledgement must still be emitted.");
+    STAssertEqualObjects(self.decodedMessages[1], (@{ @"id": @"3", @"channel": @"/wanted",
+                                                      @"data": @"0123456789abcdef0123456789abcdef\n" }),
+                         @"Wanted message must be decoded.");
+    
+    STAssertFalse([decoder decodeData:[@"[{\"channel\":\"/unwanted\",\"data\":{\"a\":[1}}]"
+                                       dataUsingEncoding:NSUTF8StringEncoding] error:&error],
+                  @"Mismatched brackets in a skipped payload must fail.");
+}
+
+- (void)testMessageTemplateMatchesSerializedMessage {
+    NSDictionary *fixed = @{@"channel": @"/meta/subscribe", @"clientId": @"abc\"def"};
+    FYMessageTemplate *template = [[FYMessageTemplate alloc] initWithMessage:fixed];
+    NSData *data = [template dataWithMessageId:@"msg_1" fields:@{@"subscription": @"/föö"}];
+    NSDictionary *message = [NSJSONSerialization JSONObjectWithData:data options:0 error:NULL];
+    NSDictionary *expected = @{@"channel": @"/meta/subscribe", @"clientId": @"abc\"def", @"id": @"msg_1",
+                               @"subscription": @"/föö"};
+    STAssertEqualObjects(message, expected, @"Template must produce the same message as the serializer.");
+    
+    template = [[FYMessageTemplate alloc] initWithMessage:@{}];
+    message = [NSJSONSerialization JSONObjectWithData:[template dataWithMessageId:@"msg_2"] options:0 error:NULL];
+    STAssertEqualObjects(message, @{@"id": @"msg_2"}, @"Template without fixed fields must be valid JSON.");
+}
+
+- (void)testMessageTemplateReusesSerializedData {
+    NSDictionary *fixed = @{@"channel": @"/prices", @"data": @{@"price": @1.5}};
+    NSDictionary *expected = @{@"channel": @"/prices", @"data": @{@"price": @1.5}, @"id": @"msg_1", @"clientId": @"abc"};
+    
+    NSData *data = [NSJSONSerialization dataWithJSONObject:fixed options:0 error:NULL];
+    FYMessageTemplate *template = [[FYMessageTemplate alloc] initWithData:data packed:NO];
+    data = [template dataWithMessageId:@"msg_1" fields:@{@"clientId": @"abc"}];
+    STAssertEqualObjects([NSJSONSerialization JSONObjectWithData:data options:0 error:NULL], expected,
+                         @"Must splice fields into serialized JSON.");
+    
+    template = [[FYMessageTemplate alloc] initWithData:[FYMessagePack dataWithObject:fixed] packed:YES];
+    data = [template dataWithMessageId:@"msg_1" fields:@{@"clientId": @"abc"}];
+    STAssertEqualObjects([FYMessagePack objectWithData:data error:NULL], expected,
+                         @"Must splice fields into serialized MessagePack.");
+    
+    STAssertNil([[FYMessageTemplate alloc] initWithData:[@"[]" dataUsingEncoding:NSUTF8StringEncoding] packed:NO],
+                 @"Must only accept objects.");
+}
+
+- (void)testOfflineQueueAppliesOverflowPolicies {
+    FYOfflineQueue *queue = [FYOfflineQueue new];
+    queue.maximumCount = 2;
+    queue.maximumSize  = 100;
+    
+    STAssertEqualObjects([queue enqueueObject:@1 size:10 key:@"/a"], @[], @"Must not drop below the limits.");
+    STAssertEqualObjects([queue enqueueObject:@2 size:10 key:@"/b"], @[], @"Must not drop below the limits.");
+    STAssertEqualObjects([queue enqueueObject:@3 size:10 key:@"/c"], @[@1], @"Must drop the oldest object by default.");
+    STAssertEqualObjects([queue enqueueObject:@4 size:200 key:@"/d"], @[@4], @"Must drop an object, which never fits.");
+    STAssertEquals(queue.size, (NSUInteger)20, @"Must account the sizes of queued objects.");
+    
+    queue.overflowPolicy = FYOfflineQueueOverflowPolicyDropNewest;
+    STAssertEqualObjects([queue enqueueObject:@5 size:10 key:@"/e"], @[@5], @"Must drop the newest object.");
+    
+    queue.overflowPolicy = FYOfflineQueueOverflowPolicyCoalesceByKey;
+    STAssertEqualObjects([queue enqueueObject:@6 size:10 key:@"/b"], @[@2], @"Must replace the object of the same key.");
+    STAssertEqualObjects([queue dequeueAllObjects], (@[@3, @6]), @"Must keep the order of queued objects.");
+    STAssertEquals(queue.count, (NSUInteger)0, @"Must be empty after dequeue.");
+}
+
+- (void)testDeliveryQueueConflatesToLatestValue {
+    FYSubscriptionOptions *options = [FYSubscriptionOptions latestValueOptions];
+    options.highWatermark = 1;
+    FYDeliveryQueue *queue = [[FYDeliveryQueue alloc] initWithOptions:options];
+    
+    BOOL reachedHighWatermark = NO;
+    STAssertTrue([queue enqueuePayload:@{@"price": @1} channel:@"/ticks/a" reachedHighWatermark:&reachedHighWatermark],
+                 @"Must request a drain for the first payload.");
+    STAssertTrue(reachedHighWatermark, @"Must report the high watermark.");
+    STAssertFalse([queue enqueuePayload:@{@"price": @2} channel:@"/ticks/a" reachedHighWatermark:&reachedHighWatermark],
+                  @"Must not request a second drain.");
+    STAssertFalse(reachedHighWatermark, @"Must report the high watermark only once.");
+    STAssertEqualObjects([queue dequeueAllPayloads], @[@{@"price": @2}], @"Must deliver only the latest value.");
+    [queue finishDelivery];
+    
+    options = [FYSubscriptionOptions optionsWithCapacity:2 overflowPolicy:FYDeliveryOverflowPolicyConflate];
+    options.conflationKey = @"symbol";
+    queue = [[FYDeliveryQueue alloc] initWithOptions:options];
+    [queue enqueuePayload:@{@"symbol": @"A", @"price": @1} channel:@"/ticks" reachedHighWatermark:NULL];
+    [queue enqueuePayload:@{@"symbol": @"B", @"price": @2} channel:@"/ticks" reachedHighWatermark:NULL];
+    [queue enqueuePayload:@{@"symbol": @"A", @"price": @3} channel:@"/ticks" reachedHighWatermark:NULL];
+    STAssertEqualObjects([queue dequeueAllPayloads], (@[@{@"symbol": @"B", @"price": @2}, @{@"symbol": @"A", @"price": @3}]),
+                         @"Must keep the latest value per conflation key.");
+    STAssertEquals(queue.droppedCount, (NSUInteger)1, @"Must count the conflated payload.");
+}
+
+- (void)testMetricsRecorderCountsAndHistograms {
+    FYMetricsRecorder *recorder = [FYMetricsRecorder new];
+    [recorder recordFrameReceivedWithLength:100];
+    [recorder recordFrameReceivedWithLength:50];
+    [recorder recordMessageOnChannel:@"/a"];
+    [recorder recordMessageOnChannel:@"/a"];
+    [recorder recordMessageOnChannel:@"/b"];
+    [recorder recordCallbacksDispatched:3];
+    [recorder recordCallbacksExecuted:1];
+    for (NSUInteger i=1; i<=100; i++) {
+        [recorder recordConnectRoundTripTime:i / 1000.0];
+    }
+    
+    FYClientMetrics *metrics = [recorder snapshot];
+    STAssertEquals(metrics.framesReceived, (uint64_t)2, @"Must count frames.");
+    STAssertEquals(metrics.bytesReceived, (uint64_t)150, @"Must count bytes.");
+    STAssertEquals(metrics.messagesReceived, (uint64_t)3, @"Must count messages.");
+    STAssertEqualObjects(metrics.messagesReceivedByChannel, (@{@"/a": @2, @"/b": @1}), @"Must count messages by channel.");
+    STAssertEquals(metrics.callbackQueueDepth, (int64_t)2, @"Must gauge the callbacks, which weren't executed yet.");
+    
+    FYLatencyHistogram *histogram = metrics.connectRoundTripTime;
+    STAssertEquals(histogram.count, (NSUInteger)100, @"Must count samples.");
+    STAssertEqualsWithAccuracy(histogram.mean, 0.0505, 0.0001, @"Must sum samples.");
+    STAssertEqualsWithAccuracy(histogram.maximum, 0.1, 0.0001, @"Must keep the maximum.");
+    NSTimeInterval median = [histogram valueAtPercentile:50];
+    STAssertTrue(median >= 0.05 && median <= 0.1, @"Percentile must be within factor 2, but was %f.", median);
+}
+
+- (void)testMessageTracerSamplesAndReportsPerChannel {
+    FYMessageTracer *tracer = [FYMessageTracer new];
+    STAssertNil([tracer sampleMessageOnChannel:@"/a" receivedUptime:0], @"Must not sample, if disabled.");
+    
+    tracer.samplingRate = 0.25;
+    NSUInteger sampledCount = 0;
+    for (NSUInteger i=0; i<100; i++) {
+        NSTimeInterval received = NSProcessInfo.processInfo.systemUptime;
+        FYMessageTrace *trace = [tracer sampleMessageOnChannel:@"/a" receivedUptime:received];
+        if (trace) {
+            sampledCount++;
+            trace.routedUptime = received + 0.002;
+            [tracer recordTrace:trace callbackStartUptime:received + 0.010 callbackEndUptime:received + 0.020];
+        }
+    }
+    STAssertEquals(sampledCount, (NSUInteger)25, @"Must sample according to the rate.");
+    
+    FYMessageTraceReport *report = tracer.reports[@"/a"];
+    STAssertEquals(report.totalTime.count, (NSUInteger)25, @"Must record each sampled trace.");
+    STAssertEqualsWithAccuracy([report.queueTime valueAtPercentile:99], 0.008, 0.008 / 8, @"Must be precise to 12.5%%.");
+    STAssertEqualsWithAccuracy([report.totalTime valueAtPercentile:50], 0.020, 0.020 / 8, @"Must be precise to 12.5%%.");
+    STAssertEquals(report.publishToDeliveryTime.count, (NSUInteger)0, @"Must not record messages without timestamp.");
+    STAssertNotNil(report.dictionaryRepresentation[@"totalTime"][@"p999"], @"Must export percentiles.");
+}
+
+- (void)testBackoffReconnectPolicySpreadsDelays {
+    const NSUInteger clientCount = 1000;
+    
+    // Delays are random, but always within their bounds. The chance, that 1000 first delays miss both outer quarters of
+    // their range, is below 1e-100.
+    NSTimeInterval minimumDelay = INFINITY, maximumDelay = 0;
+    for (NSUInteger i=0; i<clientCount; i++) {
+        FYBackoffReconnectPolicy *policy = [[FYBackoffReconnectPolicy alloc] initWithMinimumInterval:1 maximumInterval:45];
+        NSTimeInterval delay = [policy reconnectDelayWithAdvisedInterval:0 sessionDuration:0];
+        STAssertTrue(delay >= 1 && delay <= 3, @"First delay must be between the lower bound and three times of it.");
+        minimumDelay = MIN(minimumDelay, delay);
+        maximumDelay = MAX(maximumDelay, delay);
+        
+        NSTimeInterval previousDelay = delay;
+        for (NSUInteger attempt=0; attempt<10; attempt++) {
+            delay = [policy reconnectDelayWithAdvisedInterval:0 sessionDuration:0];
+            STAssertTrue(delay >= 1 && delay <= MIN(previousDelay * 3, 45) + 1e-9,
+                         @"Delay must be bounded by the previous one.");
+            previousDelay = delay;
+        }
+        STAssertTrue([policy reconnectDelayWithAdvisedInterval:10 sessionDuration:0] >= 10,
+                     @"Advised interval must raise the lower bound.");
+        STAssertTrue([policy reconnectDelayWithAdvisedInterval:0 sessionDuration:45] <= 3,
+                     @"Backoff must start again after a stable session.");
+    }
+    STAssertTrue(minimumDelay < 1.5 && maximumDelay > 2.5,
+                 @"First delays of clients must be spread, but were between %f and %f.", minimumDelay, maximumDelay);
+}
+
+- (void)testFailedConnectSchedulesReconnect {
+    // Mirrors the private FYClientStateHandshaking
+    const NSUInteger handshaking = (1<<2) | (1<<0);
+    FYClient *client = self.client;
+    client.connectionTypes = FYSupportedConnectionTypes();
+    NSError *refused = [NSError errorWithDomain:NSPOSIXErrorDomain code:ECONNREFUSED userInfo:nil];
+    NSError *rejected = [NSError errorWithDomain:@"SRWebSocketErrorDomain" code:2132 userInfo:nil];
+    
+    __block FYTimer *afterRejectedUpgrade, *afterRefusedSocket, *afterFailedHandshake;
+    dispatch_sync(client.workerQueue, ^{
+        client.state = handshaking;
+        [client webSocket:nil didFailWithError:rejected];
+        afterRejectedUpgrade = client.reconnectTimer;
+        
+        [client webSocket:nil didFailWithError:refused];
+        afterRefusedSocket = client.reconnectTimer;
+        
+        [client.reconnectTimer cancel];
+        client.reconnectTimer = nil;
+        [client transport:nil failedWithError:refused];
+        afterFailedHandshake = client.reconnectTimer;
+     });
+    
+    STAssertNil(afterRejectedUpgrade, @"Rejected upgrade must fall back to long-polling instead of reconnecting.");
+    STAssertNotNil(afterRefusedSocket, @"Refused socket connection must schedule a reconnect.");
+    STAssertNotNil(afterFailedHandshake, @"Failed handshake request must schedule a reconnect.");
+    STAssertFalse(afterFailedHandshake.isCancelled, @"Reconnect must be outstanding.");
+}
+
+- (void)testSubscriptionReconcilerBatchesChanges {
+    FYSubscriptionReconciler *reconciler = [FYSubscriptionReconciler new];
+    NSMutableArray *requests = [NSMutableArray new];
+    FYSubscriptionChangeBlock record = ^(NSArray *channels, NSDictionary *extension, BOOL subscribe) {
+        [requests addObject:@[@(subscribe), [NSSet setWithArray:channels]]];
+    };
+    
+    for (NSUInteger i = 0; i < 1000; i++) {
+        [reconciler addChannel:[NSString stringWithFormat:@"/channel/%d", (int)i] extension:nil];
+    }
+    [reconciler removeChannel:@"/channel/0"];
+    [reconciler dequeueChangesUsingBlock:record];
+    STAssertEquals(requests.count, (NSUInteger)1, @"All subscriptions must be sent in one request.");
+    STAssertEquals([requests[0][1] count], (NSUInteger)999, @"Removed channels must not be subscribed.");
+    STAssertFalse(reconciler.hasChanges, @"In-flight subscriptions must not be requested again.");
+    
+    [reconciler confirmSubscriptionOfChannel:@"/channel/1"];
+    [reconciler confirmSubscriptionOfChannel:@"/channel/2"];
+    [reconciler removeChannel:@"/channel/1"];
+    [reconciler removeChannel:@"/channel/2"];
+    [requests removeAllObjects];
+    [reconciler dequeueChangesUsingBlock:record];
+    STAssertEqualObjects(requests, (@[@[@NO, [NSSet setWithObjects:@"/channel/1", @"/channel/2", nil]]]),
+                         @"All unsubscriptions must be sent in one request.");
+    
+    [reconciler reset];
+    [requests removeAllObjects];
+    [reconciler dequeueChangesUsingBlock:record];
+    STAssertEquals([requests[0][1] count], (NSUInteger)997, @"All desired channels must be restored after reset.");
+}
+
+- (BOOL)isLocalServerRunningForTest:(SEL)test {
+    struct sockaddr_in address = {0};
+    address.sin_family      = AF_INET;
+    address.sin_port        = htons(8000);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    BOOL running = fd >= 0 && connect(fd, (struct sockaddr *)&address, sizeof(address)) == 0;
+    if (fd >= 0) {
+        close(fd);
+    }
+    if (!running) {
+        NSLog(@"%@: skipped, the sample server isn't running on localhost:8000, see `make test`.",
+              NSStringFromSelector(test));
+    }
+    return running;
+}
+
+- (BOOL)runRunLoopUntil:(BOOL(^)(void))condition timeout:(NSTimeInterval)timeout {
+    NSDate *timeoutDate = [NSDate dateWithTimeIntervalSinceNow:timeout];
+    while (!condition() && [timeoutDate timeIntervalSinceNow] > 0) {
+        [NSRunLoop.currentRunLoop runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+    return condition();
+}
+
+- (void)client:(FYClient *)client receiveMessages:(NSArray *)messages {
+    NSData *data = [NSJSONSerialization dataWithJSONObject:messages options:0 error:NULL];
+    dispatch_sync(client.workerQueue, ^{
+        [client transport:client.httpTransport receivedData:data];
+     });
+}
+
+- (void)testHTTPTransportBuffersChunkedResponses {
+    [SocketClientTestsURLProtocol reset];
+    [NSURLProtocol registerClass:SocketClientTestsURLProtocol.class];
+    dispatch_queue_t queue = dispatch_queue_create("SocketClientTests.transportQueue", NULL);
+    NSURL *URL = [NSURL URLWithString:@"http://fyhttptransport.test/faye"];
+    FYHTTPTransport *transport = [[FYHTTPTransport alloc] initWithURL:URL queue:queue];
+    SocketClientTestsTransportDelegate *delegate = [SocketClientTestsTransportDelegate new];
+    transport.delegate = delegate;
+    
+    dispatch_sync(queue, ^{
+        [transport sendMessage:[@"{\"channel\":\"/meta/subscribe\"}" dataUsingEncoding:NSUTF8StringEncoding]];
+     });
+    STAssertTrue([self runRunLoopUntil:^BOOL{ return SocketClientTestsURLProtocol.startedRequestBodies.count == 1; }
+                               timeout:2], @"Must post the message.");
+    
+    [SocketClientTestsURLProtocol respondToRequestAtIndex:0 withChunks:@[@"[{\"channel\":", @"\"/meta/subscribe\",",
+                                                                         @"\"successful\":true}]"]];
+    __block NSArray *receivedData;
+    STAssertTrue([self runRunLoopUntil:^BOOL{
+        dispatch_sync(queue, ^{
+            receivedData = delegate.receivedData.copy;
+         });
+        return receivedData.count > 0;
+     } timeout:2], @"Must emit the response.");
+    STAssertEquals(receivedData.count, (NSUInteger)1, @"Must emit the response once, when it was received completely.");
+    STAssertEqualObjects([[NSString alloc] initWithData:receivedData.firstObject encoding:NSUTF8StringEncoding],
+                         @"[{\"channel\":\"/meta/subscribe\",\"successful\":true}]", @"Must join all chunks.");
+    
+    dispatch_sync(queue, ^{
+        [transport cancel];
+     });
+    [NSURLProtocol unregisterClass:SocketClientTestsURLProtocol.class];
+}
+
+- (void)testHTTPTransportCoalescesQueuedMessages {
+    [SocketClientTestsURLProtocol reset];
+    [NSURLProtocol registerClass:SocketClientTestsURLProtocol.class];
+    dispatch_queue_t queue = dispatch_queue_create("SocketClientTests.transportQueue", NULL);
+    NSURL *URL = [NSURL URLWithString:@"http://fyhttptransport.test/faye"];
+    FYHTTPTransport *transport = [[FYHTTPTransport alloc] initWithURL:URL queue:queue];
+    SocketClientTestsTransportDelegate *delegate = [SocketClientTestsTransportDelegate new];
+    transport.delegate = delegate;
+    NSData *(^message)(int) = ^NSData *(int number) {
+        return [[NSString stringWithFormat:@"{\"id\":\"%d\"}", number] dataUsingEncoding:NSUTF8StringEncoding];
+    };
+    
+    // Both connections are busy with the first two messages, so the further messages are queued
+    __block NSUInteger activeConnectionCount;
+    dispatch_sync(queue, ^{
+        for (int i=1; i<=4; i++) {
+            [transport sendMessage:message(i)];
+        }
+        activeConnectionCount = transport.activeConnectionCount;
+     });
+    STAssertEquals(activeConnectionCount, (NSUInteger)2, @"Must not exceed the connection limit.");
+    STAssertTrue([self runRunLoopUntil:^BOOL{ return SocketClientTestsURLProtocol.startedRequestBodies.count == 2; }
+                               timeout:2], @"Must post a request on each connection.");
+    
+    [SocketClientTestsURLProtocol respondToRequestAtIndex:0 withChunks:@[@"[]"]];
+    STAssertTrue([self runRunLoopUntil:^BOOL{ return SocketClientTestsURLProtocol.startedRequestBodies.count == 3; }
+                               timeout:2], @"Must post the queued messages, when a connection became available.");
+    NSArray *bodies = SocketClientTestsURLProtocol.startedRequestBodies;
+    STAssertEqualObjects([NSJSONSerialization JSONObjectWithData:bodies[2] options:0 error:NULL],
+                         (@[@{ @"id": @"3" }, @{ @"id": @"4" }]), @"Must coalesce the queued messages into one POST.");
+    
+    dispatch_sync(queue, ^{
+        [transport cancel];
+     });
+    [NSURLProtocol unregisterClass:SocketClientTestsURLProtocol.class];
+}
+
+- (void)testHTTPTransportKeepsPollOutOfConnectionLimit {
+    [SocketClientTestsURLProtocol reset];
+    [NSURLProtocol registerClass:SocketClientTestsURLProtocol.class];
+    dispatch_queue_t queue = dispatch_queue_create("SocketClientTests.transportQueue", NULL);
+    NSURL *URL = [NSURL URLWithString:@"http://fyhttptransport.test/faye"];
+    FYHTTPTransport *transport = [[FYHTTPTransport alloc] initWithURL:URL queue:queue];
+    SocketClientTestsTransportDelegate *delegate = [SocketClientTestsTransportDelegate new];
+    transport.delegate = delegate;
+    
+    __block BOOL polling;
+    __block NSUInteger activeConnectionCount;
+    dispatch_sync(queue, ^{
+        [transport pollWithMessage:[@"{\"channel\":\"/meta/connect\"}" dataUsingEncoding:NSUTF8StringEncoding]
+                   timeoutInterval:30];
+        [transport sendMessage:[@"{\"id\":\"1\"}" dataUsingEncoding:NSUTF8StringEncoding]];
+        [transport sendMessage:[@"{\"id\":\"2\"}" dataUsingEncoding:NSUTF8StringEncoding]];
+        polling = transport.isPolling;
+        activeConnectionCount = transport.activeConnectionCount;
+     });
+    STAssertTrue(polling, @"Must hold the poll.");
+    STAssertEquals(activeConnectionCount, (NSUInteger)2, @"Poll must not count against the connection limit.");
+    STAssertTrue([self runRunLoopUntil:^BOOL{ return SocketClientTestsURLProtocol.startedRequestBodies.count == 3; }
+                               timeout:2], @"Messages must be posted alongside the held poll.");
+    
+    [SocketClientTestsURLProtocol respondToRequestAtIndex:0 withChunks:@[@"[]"]];
+    STAssertTrue([self runRunLoopUntil:^BOOL{
+        dispatch_sync(queue, ^{
+            polling = transport.isPolling;
+            activeConnectionCount = transport.activeConnectionCount;
+         });
+        return !polling;
+     } timeout:2], @"Poll must finish with its response.");
+    STAssertEquals(activeConnectionCount, (NSUInteger)2, @"Messages must still be running.");
+    
+    dispatch_sync(queue, ^{
+        [transport cancel];
+     });
+    [NSURLProtocol unregisterClass:SocketClientTestsURLProtocol.class];
+}
+
+- (FYClient *)clientWithStubSession {
+    FYClient *client = [[FYClient alloc] initWithURL:[NSURL URLWithString:@"http://localhost/faye"]];
+    client.callbackQueue = dispatch_queue_create("SocketClientTests.callbackQueue", NULL);
+    SocketClientTestsTransport *transport = [[SocketClientTestsTransport alloc] initWithURL:client.baseURL
+                                                                                      queue:client.workerQueue];
+    dispatch_sync(client.workerQueue, ^{
+        // Session established by long-polling, whose messages are recorded
+        client.httpTransport  = transport;
+        client.connectionType = FYConnectionTypes.LongPolling;
+        client.clientId       = @"stub";
+        client.state          = 1<<3;  // FYClientStateConnected
+     });
+    return client;
+}
+
+- (NSArray *)publishesSentByClient:(FYClient *)client {
+    __block NSArray *publishes;
+    dispatch_sync(client.workerQueue, ^{
+        NSArray *sentMessages = ((SocketClientTestsTransport *)client.httpTransport).sentMessages;
+        publishes = [sentMessages filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"channel == '/stub'"]];
+     });
+    return publishes;
+}
+
+- (void)testLongPollingEstablishesSessionByTransport {
+    FYClient *client = [[FYClient alloc] initWithURL:[NSURL URLWithString:@"http://localhost/faye"]];
+    client.connectionTypes = @[FYConnectionTypes.LongPolling];
+    client.callbackQueue = dispatch_queue_create("SocketClientTests.callbackQueue", NULL);
+    SocketClientTestsTransport *transport = [[SocketClientTestsTransport alloc] initWithURL:client.baseURL
+                                                                                      queue:client.workerQueue];
+    dispatch_sync(client.workerQueue, ^{
+        client.httpTransport = transport;
+     });
+    
+    // The stub is only accessed on the workerQueue
+    NSArray *(^sentMessages)(void) = ^NSArray *{
+        __block NSArray *messages;
+        dispatch_sync(client.workerQueue, ^{
+            messages = transport.sentMessages.copy;
+         });
+        return messages;
+    };
+    NSArray *(^polledMessages)(void) = ^NSArray *{
+        __block NSArray *messages;
+        dispatch_sync(client.workerQueue, ^{
+            messages = transport.polledMessages.copy;
+         });
+        return messages;
+    };
+    
+    [client connect];
+    STAssertTrue([self runRunLoopUntil:^BOOL{ return sentMessages().count > 0; } timeout:2],
+                 @"Must post the handshake.");
+    NSDictionary *handshake = sentMessages().firstObject;
+    STAssertEqualObjects(handshake[@"channel"], @"/meta/handshake", @"Must start with a handshake.");
+    STAssertEqualObjects(handshake[@"supportedConnectionTypes"], @[FYConnectionTypes.LongPolling],
+                         @"Must only offer long-polling.");
+    
+    [self client:client receiveMessages:@[@{
+        @"channel":                  @"/meta/handshake",
+        @"id":                       handshake[@"id"] ?: @"",
+        @"successful":               @YES,
+        @"version":                  @"1.0",
+        @"clientId":                 @"stub",
+        @"supportedConnectionTypes": @[FYConnectionTypes.LongPolling, FYConnectionTypes.WebSocket],
+     }]];
+    STAssertTrue([self runRunLoopUntil:^BOOL{ return polledMessages().count > 0; } timeout:2],
+                 @"Must hang a connect on the transport.");
+    NSDictionary *connect = polledMessages().firstObject;
+    STAssertEqualObjects(connect[@"channel"], @"/meta/connect", @"Must poll by connect messages.");
+    STAssertEqualObjects(connect[@"connectionType"], FYConnectionTypes.LongPolling, @"Must connect by long-polling.");
+    STAssertEqualObjects(connect[@"clientId"], @"stub", @"Must connect with the client id of the handshake.");
+    STAssertEqualObjects(connect[@"advice"], (@{@"timeout": @0}), @"First connect must ask not to be held.");
+    STAssertEqualObjects(client.connectionType, FYConnectionTypes.LongPolling, @"Must choose long-polling.");
+    STAssertTrue(client.isConnected, @"Session must be established.");
+    
+    // Messages, which are answered on the hanging connect, are delivered to the subscriber
+    NSMutableArray *received = [NSMutableArray new];
+    [client subscribeChannel:@"/stub" callback:^(NSDictionary *userInfo) {
+        [received addObject:userInfo];
+     }];
+    BOOL (^isSubscribing)(void) = ^BOOL{
+        return [[sentMessages() valueForKey:@"channel"] containsObject:@"/meta/subscribe"];
+    };
+    STAssertTrue([self runRunLoopUntil:isSubscribing timeout:2], @"Must post the subscription.");
+    [self client:client receiveMessages:@[
+        @{ @"channel": @"/meta/connect", @"successful": @YES, @"clientId": @"stub" },
+        @{ @"channel": @"/stub", @"data": @{ @"number": @1 } },
+     ]];
+    STAssertTrue([self runRunLoopUntil:^BOOL{
+        __block NSUInteger count;
+        dispatch_sync(client.callbackQueue, ^{
+            count = received.count;
+         });
+        return count > 0;
+     } timeout:2], @"Must deliver the message.");
+    [client disconnect];
+}
+
+- (void)testClockOffsetIsSampledOnlyByUnheldRoundTrips {
+    FYClient *client = [[FYClient alloc] initWithURL:[NSURL URLWithString:@"http://localhost/faye"]];
+    client.connectionTypes = @[FYConnectionTypes.LongPolling];
+    SocketClientTestsTransport *transport = [[SocketClientTestsTransport alloc] initWithURL:client.baseURL
+                                                                                      queue:client.workerQueue];
+    dispatch_sync(client.workerQueue, ^{
+        client.httpTransport = transport;
+     });
+    
+    __block NSDictionary *lastMessage;
+    NSUInteger (^polledCount)(void) = ^NSUInteger{
+        __block NSUInteger count;
+        dispatch_sync(client.workerQueue, ^{
+            count = transport.polledMessages.count;
+            lastMessage = transport.polledMessages.lastObject ?: transport.sentMessages.lastObject;
+         });
+        return count;
+    };
+    NSUInteger (^sampleCount)(void) = ^NSUInteger{
+        __block NSUInteger count;
+        dispatch_sync(client.workerQueue, ^{
+            count = client.clockOffsetEstimator.sampleCount;
+         });
+        return count;
+    };
+    
+    // The server clock is 100 seconds ahead
+    NSString *(^serverTimestamp)(void) = ^NSString *{
+        time_t seconds = (time_t)(FYTimestampNow() + 100);
+        struct tm time;
+        gmtime_r(&seconds, &time);
+        char buffer[32];
+        strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", &time);
+        return @(buffer);
+    };
+    
+    [client connect];
+    STAssertTrue([self runRunLoopUntil:^BOOL{ polledCount(); return lastMessage != nil; } timeout:2],
+                 @"Must post the handshake.");
+    [self client:client receiveMessages:@[@{
+        @"channel":                  @"/meta/handshake",
+        @"id":                       lastMessage[@"id"] ?: @"",
+        @"successful":               @YES,
+        @"clientId":                 @"stub",
+        @"supportedConnectionTypes": @[FYConnectionTypes.LongPolling],
+        @"timestamp":                serverTimestamp(),
+     }]];
+    STAssertEquals(sampleCount(), (NSUInteger)1, @"Handshake must be sampled.");
+    
+    STAssertTrue([self runRunLoopUntil:^BOOL{ return polledCount() == 1; } timeout:2], @"Must send the first connect.");
+    [self client:client receiveMessages:@[@{ @"channel": @"/meta/connect", @"successful": @YES,
+                                             @"timestamp": serverTimestamp() }]];
+    STAssertEquals(sampleCount(), (NSUInteger)2, @"First connect must be sampled.");
+    
+    // The next connect is held by the server
+    dispatch_sync(client.workerQueue, ^{
+        transport.polling = NO;
+     });
+    STAssertTrue([self runRunLoopUntil:^BOOL{ return polledCount() == 2; } timeout:2], @"Must poll again.");
+    STAssertNil(lastMessage[@"advice"], @"Further connects must be held.");
+    [NSThread sleepForTimeInterval:0.5];
+    [self client:client receiveMessages:@[@{ @"channel": @"/meta/connect", @"successful": @YES,
+                                             @"timestamp": serverTimestamp() }]];
+    STAssertEquals(sampleCount(), (NSUInteger)2, @"Held connect must not be sampled.");
+    
+    STAssertEqualsWithAccuracy(client.serverClockOffset, 100.0, 1.5, @"Must estimate the offset by whole seconds.");
+    STAssertTrue(client.latency < 0.25, @"Latency must not include the hold time, but was %f.", client.latency);
+    [client disconnect];
+}
+
+- (void)testDroppedMessagesFailTheirPublishes {
+    FYClient *client = [[FYClient alloc] initWithURL:[NSURL URLWithString:@"http://localhost/faye"]];
+    client.callbackQueue = dispatch_queue_create("SocketClientTests.callbackQueue", NULL);
+    SocketClientTestsTransport *transport = [[SocketClientTestsTransport alloc] initWithURL:client.baseURL
+                                                                                      queue:client.workerQueue];
+    dispatch_sync(client.workerQueue, ^{
+        // Session established by long-polling, whose messages are recorded
+        client.httpTransport  = transport;
+        client.connectionType = FYConnectionTypes.LongPolling;
+        client.clientId       = @"stub";
+        client.state          = 1<<3;  // FYClientStateConnected
+     });
+    
+    __block NSError *publishError = nil;
+    dispatch_semaphore_t finished = dispatch_semaphore_create(0);
+    [client publish:@{ @"number": @1 } onChannel:@"/stub" completion:^(NSError *error) {
+        publishError = error;
+        dispatch_semaphore_signal(finished);
+     }];
+    dispatch_sync(client.workerQueue, ^{
+        NSData *publish = [NSJSONSerialization dataWithJSONObject:transport.sentMessages.lastObject options:0 error:NULL];
+        NSData *connect = [@"{\"channel\":\"/meta/connect\",\"id\":\"0\"}" dataUsingEncoding:NSUTF8StringEncoding];
+        [client dropSocketMessages:@[connect, publish]
+                         withError:[NSError errorWithDomain:FYErrorDomain code:FYErrorSocketFramingFailed userInfo:nil]];
+     });
+    
+    STAssertEquals(dispatch_semaphore_wait(finished, dispatch_time(DISPATCH_TIME_NOW, 2 * NSEC_PER_SEC)), (long)0,
+                   @"Publish of a dropped message must complete without waiting for its timeout.");
+    STAssertEquals(publishError.code, (NSInteger)FYErrorSocketFramingFailed, @"Publish must fail with the drop.");
+    STAssertEquals(client.metrics.droppedSendCount, (uint64_t)2, @"Each dropped message must be counted.");
+}
+
+- (void)testPublishesCompleteOnAcknowledgement {
+    FYClient *client = [self clientWithStubSession];
+    NSMutableArray *errors = [NSMutableArray new];
+    [client publish:@{ @"number": @1 } onChannel:@"/stub" completion:^(NSError *error) {
+        [errors addObject:error ?: NSNull.null];
+     }];
+    [client publish:@{ @"number": @2 } onChannel:@"/stub" completion:^(NSError *error) {
+        [errors addObject:error ?: NSNull.null];
+     }];
+    NSArray *publishes = [self publishesSentByClient:client];
+    STAssertEquals(publishes.count, (NSUInteger)2, @"Must send both publishes.");
+    
+    [self client:client receiveMessages:@[
+        @{ @"channel": @"/stub", @"id": publishes[0][@"id"] ?: @"", @"successful": @YES },
+        @{ @"channel": @"/stub", @"id": publishes[1][@"id"] ?: @"", @"successful": @NO, @"error": @"403::Forbidden" },
+     ]];
+    dispatch_sync(client.callbackQueue, ^{});
+    STAssertEquals(errors.count, (NSUInteger)2, @"Each publish must complete on its response.");
+    STAssertEqualObjects(errors.firstObject, NSNull.null, @"Acknowledged publish must succeed.");
+    STAssertEquals([errors.lastObject code], (NSInteger)FYErrorPublishFailed, @"Rejected publish must fail.");
+    STAssertEqualObjects([errors.lastObject localizedFailureReason], @"403::Forbidden", @"Must pass the server's error.");
+}
+
+- (void)testPublishesBeyondWindowAreDeferredUntilAcknowledged {
+    FYClient *client = [self clientWithStubSession];
+    client.maximumUnacknowledgedPublishCount = 2;
+    for (NSUInteger i=1; i<=3; i++) {
+        [client publish:@{ @"number": @(i) } onChannel:@"/stub"];
+    }
+    NSArray *publishes = [self publishesSentByClient:client];
+    STAssertEqualObjects([publishes valueForKeyPath:@"data.number"], (@[@1, @2]), @"Must defer publishes beyond the window.");
+    
+    [self client:client receiveMessages:@[@{ @"channel": @"/stub", @"id": publishes[1][@"id"] ?: @"", @"successful": @YES }]];
+    publishes = [self publishesSentByClient:client];
+    STAssertEqualObjects([publishes valueForKeyPath:@"data.number"], (@[@1, @2, @3]),
+                         @"Must release a deferred publish by each acknowledgement.");
+}
+
+- (void)testPublishTimesOutWithoutAcknowledgement {
+    FYClient *client = [self clientWithStubSession];
+    client.publishTimeInterval = 0.2;
+    client.maximumUnacknowledgedPublishCount = 1;
+    
+    __block NSError *publishError = nil;
+    dispatch_semaphore_t finished = dispatch_semaphore_create(0);
+    [client publish:@{ @"number": @1 } onChannel:@"/stub" completion:^(NSError *error) {
+        publishError = error;
+        dispatch_semaphore_signal(finished);
+     }];
+    [client publish:@{ @"number": @2 } onChannel:@"/stub"];
+    STAssertEquals([self publishesSentByClient:client].count, (NSUInteger)1, @"Must defer the second publish.");
+    
+    STAssertEquals(dispatch_semaphore_wait(finished, dispatch_time(DISPATCH_TIME_NOW, 2 * NSEC_PER_SEC)), (long)0,
+                   @"Publish must complete after its timeout.");
+    STAssertEquals(publishError.code, (NSInteger)FYErrorPublishTimedOut, @"Publish must fail by timeout.");
+    STAssertEquals([self publishesSentByClient:client].count, (NSUInteger)2, @"Timeout must free the window.");
+}
+
+- (void)testDisconnectFailsPendingAndDeferredPublishes {
+    FYClient *client = [self clientWithStubSession];
+    client.maximumUnacknowledgedPublishCount = 1;
+    NSMutableArray *errors = [NSMutableArray new];
+    for (NSUInteger i=1; i<=2; i++) {
+        [client publish:@{ @"number": @(i) } onChannel:@"/stub" completion:^(NSError *error) {
+            [errors addObject:error ?: NSNull.null];
+         }];
+    }
+    STAssertEquals([self publishesSentByClient:client].count, (NSUInteger)1, @"Must defer the second publish.");
+    
+    [client disconnect];
+    [self client:client receiveMessages:@[@{ @"channel": @"/meta/disconnect", @"successful": @YES }]];
+    dispatch_sync(client.callbackQueue, ^{});
+    STAssertEquals(errors.count, (NSUInteger)2, @"Sent and deferred publish must complete on disconnect.");
+    STAssertEqualObjects([errors valueForKey:@"code"], (@[@(FYErrorPublishInterrupted), @(FYErrorPublishInterrupted)]),
+                         @"Publishes must fail as interrupted.");
+    STAssertEquals([self publishesSentByClient:client].count, (NSUInteger)1, @"Deferred publish must not be sent.");
+}
+
+- (void)testHeldBackPublishIsSentWithClientIdOfNewSession {
+    FYClient *client = [self clientWithStubSession];
+    dispatch_sync(client.workerQueue, ^{
+        client.clientId = nil;
+        client.state    = (1<<2) | (1<<0);  // FYClientStateHandshaking
+     });
+    [client publish:@{ @"number": @1 } onChannel:@"/stub"];
+    STAssertEquals([self publishesSentByClient:client].count, (NSUInteger)0, @"Must hold back the publish.");
+    
+    dispatch_sync(client.workerQueue, ^{
+        client.clientId = @"new";
+        client.state    = 1<<3;  // FYClientStateConnected
+        [client sendOfflinePublishes];
+     });
+    NSArray *publishes = [self publishesSentByClient:client];
+    STAssertEquals(publishes.count, (NSUInteger)1, @"Must send the held back publish.");
+    STAssertEqualObjects(publishes.lastObject[@"clientId"], @"new", @"Must send the publish with the new clientId.");
+    STAssertEqualObjects(publishes.lastObject[@"data"], @{ @"number": @1 }, @"Must send the serialized data.");
+    STAssertNotNil(publishes.lastObject[@"id"], @"Must send the publish with its id.");
+}
+
+- (void)testLongPollingAgainstLocalServer {
+    if (![self isLocalServerRunningForTest:_cmd]) {
+        return;
+    }
+    
+    FYClient *client = [[FYClient alloc] initWithURL:[NSURL URLWithString:@"http://localhost:8000/faye"]];
+    client.connectionTypes = @[FYConnectionTypes.LongPolling];
+    client.delegate = self;
+    
+    __weak SocketClientTests *this = self;
+    [client connectOnSuccess:^(FYClient *client) {
+        [client subscribeChannel:@"/count" callback:^(NSDictionary *userInfo) {
+            if ([userInfo[@"sender"] isEqualToString:@"server"]) {
+                this.countedNumber = userInfo[@"number"];
+            }
+         }];
+     }];
+    
+    NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow:10];
+    while (!self.countedNumber && [timeout timeIntervalSinceNow] > 0) {
+        [NSRunLoop.currentRunLoop runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+    }
+    
+    STAssertEqualObjects(client.connectionType, FYConnectionTypes.LongPolling, @"Must connect by long-polling.");
+    STAssertEqualObjects(self.countedNumber, @2, @"Must receive the answer of the server by long-polling.");
+    STAssertTrue([client latencyOfConnectionType:FYConnectionTypes.LongPolling] > 0, @"Must measure the latency.");
+    [client disconnect];
+}
+
+- (void)client:(FYClient *)client subscriptionSucceedToChannel:(NSString *)channel {
+    // Publish after the subscription was confirmed, so that the answer of the server can't be missed
+    [client publish:@{@"sender": @"test", @"number": @1} onChannel:channel];
+}
+
+- (void)testDelegateProxyCallsOnlyMethodsOfCurrentDelegate {
+    FYClient *client = [[FYClient alloc] initWithURL:[NSURL URLWithString:@"http://localhost/faye"]];
+    dispatch_queue_t delegateQueue = dispatch_queue_create("SocketClientTests.delegateQueue", NULL);
+    dispatch_queue_t replyQueue = dispatch_queue_create("SocketClientTests.replyQueue", NULL);
+    client.delegateQueue = delegateQueue;
+    FYDelegateProxy<SocketClientTestsDelegateProxy> *proxy = client.clientDelegateProxy;
+    
+    __block NSTimeInterval interval = 0;
+    __block BOOL retry = NO;
+    void (^callEachMethod)(void) = ^{
+        dispatch_semaphore_t replied = dispatch_semaphore_create(0);
+        [proxy clientConnected:client];
+        [proxy client:client failedWithError:nil];
+        [proxy clientWasAdvisedToRetry:client retryInterval:1 replyOnQueue:replyQueue reply:^(NSTimeInterval customInterval) {
+            interval = customInterval;
+            dispatch_semaphore_signal(replied);
+         }];
+        [proxy clientWasAdvisedToHandshake:client replyOnQueue:replyQueue reply:^(BOOL shouldRetry) {
+            retry = shouldRetry;
+            dispatch_semaphore_signal(replied);
+         }];
+        for (NSUInteger i=0; i<2; i++) {
+            STAssertEquals(dispatch_semaphore_wait(replied, dispatch_time(DISPATCH_TIME_NOW, 2 * NSEC_PER_SEC)), (long)0,
+                           @"Must reply, whether the delegate implements the method or not.");
+        }
+        dispatch_sync(delegateQueue, ^{});
+    };
+    
+    // Methods, which are not implemented, are skipped and replied with the defaults
+    SocketClientTestsPartialDelegate *partialDelegate = [SocketClientTestsPartialDelegate new];
+    client.delegate = partialDelegate;
+    callEachMethod();
+    STAssertEqualObjects(partialDelegate.calls, (@[@"clientConnected:", @"clientWasAdvisedToRetry:retryInterval:"]),
+                         @"Must call only the implemented methods.");
+    STAssertEquals(interval, (NSTimeInterval)5, @"Must reply the interval of the delegate.");
+    STAssertFalse(retry, @"Must not retry, if the delegate doesn't decide.");
+    
+    // Swapping the delegate updates which methods are called
+    SocketClientTestsOtherDelegate *otherDelegate = [SocketClientTestsOtherDelegate new];
+    client.delegate = otherDelegate;
+    callEachMethod();
+    STAssertEqualObjects(otherDelegate.calls, (@[@"client:failedWithError:", @"clientWasAdvisedToHandshake:shouldRetry:"]),
+                         @"Must call only the implemented methods of the new delegate.");
+    STAssertEquals(partialDelegate.calls.count, (NSUInteger)2, @"Must not call the previous delegate anymore.");
+    STAssertEquals(interval, (NSTimeInterval)1, @"Must reply the unchanged interval.");
+    STAssertTrue(retry, @"Must reply the decision of the delegate.");
+}
+
+- (void)testDelegateProxyDoesNotBlockOnDelegateQueue {
+    FYClient *client = [[FYClient alloc] initWithURL:[NSURL URLWithString:@"http://localhost/faye"]];
+    SocketClientTestsPartialDelegate *delegate = [SocketClientTestsPartialDelegate new];
+    client.delegate = delegate;  // on the main queue
+    
+    // The main thread waits for the workerQueue, while the delegate is asked, which would deadlock a synchronous call
+    __block NSTimeInterval interval = 0;
+    dispatch_sync(client.workerQueue, ^{
+        [client.clientDelegateProxy clientWasAdvisedToRetry:client retryInterval:1 replyOnQueue:client.workerQueue
+                                                      reply:^(NSTimeInterval customInterval) {
+            interval = customInterval;
+         }];
+     });
+    STAssertTrue([self runRunLoopUntil:^BOOL{
+        __block NSTimeInterval replied;
+        dispatch_sync(client.workerQueue, ^{
+            replied = interval;
+         });
+        return replied == 5;
+     } timeout:2], @"Must reply on the workerQueue after the delegate was called on the main queue.");
+}
+
+- (void)testSerialLanesKeepOrderPerChannel {
+    const NSUInteger count = 400, channelCount = 4;
+    for (NSNumber *usesLanes in @[@NO, @YES]) {
+        FYClient *client = [[FYClient alloc] initWithURL:[NSURL URLWithString:@"http://localhost"]];
+        client.callbackQueue = dispatch_queue_create("SocketClientTests.callbackQueue", NULL);
+        
+        // Callbacks of one channel never overlap, so each of them owns its slot of lastNumbers
+        dispatch_semaphore_t finished = dispatch_semaphore_create(0);
+        __block _Atomic(int32_t) remaining = (int32_t)count;
+        __block _Atomic(bool) outOfOrder = false;
+        int *lastNumbers = malloc(channelCount * sizeof(int));
+        for (NSUInteger i=0; i<channelCount; i++) {
+            NSString *channel = [NSString stringWithFormat:@"/lanes/%d", (int)i];
+            FYSubscriptionOptions *options = [FYSubscriptionOptions new];
+            options.lane = usesLanes.boolValue ? channel : nil;
+            lastNumbers[i] = -1;
+            [client subscribeChannel:channel callback:^(NSDictionary *userInfo) {
+                int number = [userInfo[@"number"] intValue];
+                if (number <= lastNumbers[i]) {
+                    atomic_store(&outOfOrder, true);
+                }
+                lastNumbers[i] = number;
+                if (atomic_fetch_sub(&remaining, 1) == 1) {
+                    dispatch_semaphore_signal(finished);
+                }
+             } extension:nil options:options];
+        }
+        
+        dispatch_async(client.workerQueue, ^{
+            for (NSUInteger i=0; i<count; i++) {
+                [client handleMessage:@{
+                    @"channel": [NSString stringWithFormat:@"/lanes/%d", (int)(i % channelCount)],
+                    @"data":    @{ @"number": @(i) },
+                 }];
+            }
+         });
+        long timedOut = dispatch_semaphore_wait(finished, dispatch_time(DISPATCH_TIME_NOW, 10 * NSEC_PER_SEC));
+        
+        STAssertEquals(timedOut, (long)0, @"Must deliver all messages in time, lanes: %@, %d left.", usesLanes,
+                       (int)atomic_load(&remaining));
+        STAssertFalse(atomic_load(&outOfOrder), @"Must keep the order per channel, lanes: %@.", usesLanes);
+        if (!timedOut) {
+            // Late callbacks would still write to it otherwise
+            free(lastNumbers);
+        }
+    }
+}
+
+- (void)testBatchCallbackReceivesMessagesOfFrameInOrder {
+    FYClient *client = [self clientWithStubSession];
+    NSMutableArray *batches = [NSMutableArray new];
+    [client subscribeChannel:@"/stub" batchCallback:^(NSArray *payloads) {
+        [batches addObject:[payloads valueForKey:@"number"]];
+     }];
+    
+    [self client:client receiveMessages:@[
+        @{ @"channel": @"/stub",  @"data": @{ @"number": @1 } },
+        @{ @"channel": @"/other", @"data": @{ @"number": @2 } },
+        @{ @"channel": @"/stub",  @"data": @{ @"number": @3 } },
+        @{ @"channel": @"/stub",  @"data": @{ @"number": @4 } },
+     ]];
+    [self client:client receiveMessages:@[@{ @"channel": @"/stub", @"data": @{ @"number": @5 } }]];
+    dispatch_sync(client.callbackQueue, ^{});
+    STAssertEqualObjects(batches, (@[@[@1, @3, @4], @[@5]]), @"Must deliver each frame in one batch in order.");
+}
+
+- (void)testBatchDeliveryTimeIntervalCollectsFrames {
+    FYClient *client = [self clientWithStubSession];
+    client.batchDeliveryTimeInterval = 0.3;
+    NSMutableArray *batches = [NSMutableArray new];
+    __block NSTimeInterval deliveredUptime = 0;
+    [client subscribeChannel:@"/stub" batchCallback:^(NSArray *payloads) {
+        [batches addObject:[payloads valueForKey:@"number"]];
+        deliveredUptime = NSProcessInfo.processInfo.systemUptime;
+     }];
+    NSUInteger (^batchCount)(void) = ^NSUInteger{
+        __block NSUInteger count;
+        dispatch_sync(client.callbackQueue, ^{
+            count = batches.count;
+         });
+        return count;
+    };
+    
+    NSTimeInterval receivedUptime = NSProcessInfo.processInfo.systemUptime;
+    [self client:client receiveMessages:@[@{ @"channel": @"/stub", @"data": @{ @"number": @1 } }]];
+    [self client:client receiveMessages:@[@{ @"channel": @"/stub", @"data": @{ @"number": @2 } }]];
+    STAssertEquals(batchCount(), (NSUInteger)0, @"Must hold back the batch within the interval.");
+    
+    STAssertTrue([self runRunLoopUntil:^BOOL{ return batchCount() > 0; } timeout:2], @"Must deliver the batch.");
+    dispatch_sync(client.callbackQueue, ^{
+        STAssertEqualObjects(batches, (@[@[@1, @2]]), @"Must collect the frames within the interval into one batch.");
+        STAssertTrue(deliveredUptime - receivedUptime >= 0.3, @"Must not deliver before the interval elapsed, but "
+                     "delivered after %f seconds.", deliveredUptime - receivedUptime);
+     });
+}
+
+- (void)testFramesAreDeliveredInSingleDispatch {
+    FYClient *client = [self clientWithStubSession];
+    client.deliversFramesInSingleDispatch = YES;
+    dispatch_queue_t callbackQueue = client.callbackQueue;
+    
+    // Suspending the callbackQueue holds back further dispatches, but not the rest of the current one
+    NSMutableArray *received = [NSMutableArray new];
+    dispatch_semaphore_t deliveredFrame = dispatch_semaphore_create(0);
+    FYMessageCallback callback = ^(NSDictionary *userInfo) {
+        if (received.count == 0) {
+            dispatch_suspend(callbackQueue);
+        }
+        [received addObject:userInfo[@"number"]];
+        if (received.count == 3) {
+            dispatch_semaphore_signal(deliveredFrame);
+        }
+    };
+    [client subscribeChannel:@"/a" callback:callback];
+    [client subscribeChannel:@"/b" callback:callback];
+    
+    [self client:client receiveMessages:@[
+        @{ @"channel": @"/a", @"data": @{ @"number": @1 } },
+        @{ @"channel": @"/b", @"data": @{ @"number": @2 } },
+        @{ @"channel": @"/a", @"data": @{ @"number": @3 } },
+     ]];
+    long timedOut = dispatch_semaphore_wait(deliveredFrame, dispatch_time(DISPATCH_TIME_NOW, 1 * NSEC_PER_SEC));
+    dispatch_resume(callbackQueue);
+    dispatch_sync(callbackQueue, ^{});
+    STAssertEquals(timedOut, (long)0, @"Must deliver all messages of a frame in one dispatch.");
+    STAssertEqualObjects(received, (@[@1, @2, @3]), @"Must deliver the messages of a frame in order.");
+}
+
+- (void)testPerMessageDeflateNegotiatesAndCompresses {
+    FYPerMessageDeflate *codec = [FYPerMessageDeflate new];
+    STAssertEqualObjects(codec.extensionOffer, @"permessage-deflate; client_max_window_bits", @"Must offer extension.");
+    STAssertFalse([codec acceptExtensionResponse:@"permessage-deflate; client_max_window_bits=8"],
+                  @"Must refuse a window, which zlib can't produce.");
+    STAssertFalse([codec acceptExtensionResponse:@"permessage-deflate; foo"], @"Must refuse unknown parameters.");
+    STAssertTrue([codec acceptExtensionResponse:nil], @"Server may decline the extension.");
+    STAssertFalse(codec.isNegotiated, @"Must not compress, if the server declined.");
+    
+    STAssertTrue([codec acceptExtensionResponse:@"x-webkit-foo, permessage-deflate; server_max_window_bits=\"10\""],
+                 @"Must accept parameters of the server.");
+    STAssertTrue(codec.isNegotiated, @"Must compress, if the server accepted.");
+    
+    // Examples of RFC 7692 section 7.2.3.1 and 7.2.3.2: the second message refers to the first one
+    BOOL compressed = NO;
+    NSData *hello = [@"Hello" dataUsingEncoding:NSUTF8StringEncoding];
+    const uint8_t firstBytes[]  = { 0xf2, 0x48, 0xcd, 0xc9, 0xc9, 0x07, 0x00 };
+    const uint8_t secondBytes[] = { 0xf2, 0x00, 0x11, 0x00, 0x00 };
+    NSData *first = [codec encodeMessageData:hello compressed:&compressed];
+    STAssertTrue(compressed, @"Must set RSV1 of compressed messages.");
+    STAssertEqualObjects(first, [NSData dataWithBytes:firstBytes length:sizeof(firstBytes)], @"Must strip tail.");
+    NSData *second = [codec encodeMessageData:hello compressed:&compressed];
+    STAssertEqualObjects(second, [NSData dataWithBytes:secondBytes length:sizeof(secondBytes)], @"Must take over context.");
+    
+    NSError *error = nil;
+    STAssertEqualObjects([codec decodeMessageData:first compressed:YES error:&error], hello, @"Must inflate.");
+    STAssertEqualObjects([codec decodeMessageData:second compressed:YES error:&error], hello, @"Must keep context.");
+    STAssertNil([codec decodeMessageData:hello compressed:YES error:&error], @"Must fail on invalid data.");
+    STAssertEquals(error.code, (NSInteger)FYErrorSocketDecompressionFailed, @"Must report decompression failure.");
+    
+    codec.compressionThreshold = 6;
+    STAssertEqualObjects([codec encodeMessageData:hello compressed:&compressed], hello, @"Must skip short messages.");
+    STAssertFalse(compressed, @"Must not set RSV1 of uncompressed messages.");
+}
+
+- (void)testPerMessageDeflateIsNegotiatedByClientOptions {
+    FYClient *client = [[FYClient alloc] initWithURL:[NSURL URLWithString:@"ws://localhost/faye"]];
+    client.compressionThreshold = 6;
+    client.compressesWithContextTakeover = NO;
+    FYPerMessageDeflate *codec = [client makeMessageCodec];
+    STAssertEqualObjects(codec.extensionOffer, @"permessage-deflate; client_max_window_bits; "
+                         "client_no_context_takeover; server_no_context_takeover",
+                         @"Must offer to reset the contexts, if context takeover is disabled.");
+    
+    // A stub server agrees to the offer and inflates what the client sends
+    STAssertTrue([codec acceptExtensionResponse:@"permessage-deflate; client_no_context_takeover; "
+                  "server_no_context_takeover"], @"Must accept the agreed offer.");
+    STAssertTrue(codec.isNegotiated, @"Must compress after the server agreed.");
+    FYPerMessageDeflate *server = [FYPerMessageDeflate new];
+    [server acceptExtensionResponse:FYPerMessageDeflateExtensionName];
+    
+    BOOL compressed = NO;
+    NSError *error = nil;
+    NSData *message = [@"{\"channel\":\"/prices\",\"data\":{\"channel\":\"/prices\"}}"
+                       dataUsingEncoding:NSUTF8StringEncoding];
+    NSData *first = [codec encodeMessageData:message compressed:&compressed];
+    STAssertTrue(compressed, @"Must compress messages above the threshold.");
+    NSData *second = [codec encodeMessageData:message compressed:&compressed];
+    STAssertEqualObjects(second, first, @"Must not refer to previous messages without context takeover.");
+    STAssertEqualObjects([server decodeMessageData:first compressed:YES error:&error], message, @"Must inflate.");
+    STAssertEqualObjects([server decodeMessageData:second compressed:YES error:&error], message, @"Must inflate.");
+    STAssertTrue(client.metrics.bytesSavedByCompression > 0, @"Must record the saved bytes to the client.");
+    
+    NSData *shortMessage = [@"[]" dataUsingEncoding:NSUTF8StringEncoding];
+    STAssertEqualObjects([codec encodeMessageData:shortMessage compressed:&compressed], shortMessage,
+                         @"Must send messages below the threshold of the client uncompressed.");
+    STAssertFalse(compressed, @"Must not set RSV1 of uncompressed messages.");
+}
+
+- (void)testMessagePackRoundTripsAndDecodesOnlyWantedPayloads {
+    const uint8_t mapBytes[] = { 0x81, 0xa1, 0x61, 0xd1, 0xff, 0x7f };
+    STAssertEqualObjects([FYMessagePack dataWithObject:@{@"a": @(-129)}],
+                         [NSData dataWithBytes:mapBytes length:sizeof(mapBytes)], @"Must use the smallest integer type.");
+    
+    NSDictionary *object = @{
+        @"integers": @[@0, @127, @(-32), @(-129), @65536, @(-4294967296), @(UINT64_MAX)],
+        @"double":   @2.5,
+        @"boolean":  @YES,
+        @"null":     NSNull.null,
+        @"string":   [@"" stringByPaddingToLength:300 withString:@"föö" startingAtIndex:0],
+        @"binary":   [NSData dataWithBytes:mapBytes length:sizeof(mapBytes)],
+     };
+    NSError *error = nil;
+    STAssertEqualObjects([FYMessagePack objectWithData:[FYMessagePack dataWithObject:object] error:&error], object,
+                         @"Must decode what was encoded, but failed with: %@.", error);
+    STAssertNil([FYMessagePack dataWithObject:@{@"date": NSDate.date}], @"Must refuse unencodeable objects.");
+    
+    // Packed templates build the same message as the encoder
+    FYMessageTemplate *template = [[FYMessageTemplate alloc] initWithMessage:@{@"channel": @"/meta/subscribe"}
+                                                                      packed:YES];
+    NSData *data = [template dataWithMessageId:@"msg_1" fields:@{@"subscription": @"/föö"}];
+    STAssertEqualObjects([FYMessagePack objectWithData:data error:NULL],
+                         (@{@"channel": @"/meta/subscribe", @"id": @"msg_1", @"subscription": @"/föö"}),
+                         @"Template must produce a valid map.");
+    
+    // Frames are arrays of messages, unwanted payloads are skipped
+    self.decodedMessages = [NSMutableArray new];
+    FYMessageDecoder *decoder = [[FYMessageDecoder alloc] initWithDelegate:self];
+    NSMutableData *frame = [NSMutableData new];
+    [FYMessagePack appendArrayHeaderWithCount:2 toData:frame];
+    [frame appendData:[FYMessagePack dataWithObject:@{@"channel": @"/wanted", @"data": @{@"a": @[@1, @2.5]}}]];
+    [FYMessagePack appendMapHeaderWithCount:3 toData:frame];
+    [FYMessagePack appendObject:@"data" toData:frame];
+    [FYMessagePack appendObject:object toData:frame];
+    [FYMessagePack appendObject:@"channel" toData:frame];
+    [FYMessagePack appendObject:@"/unwanted" toData:frame];
+    [FYMessagePack appendObject:@"id" toData:frame];
+    [FYMessagePack appendObject:@"1" toData:frame];
+    
+    STAssertTrue([decoder decodePackedBytes:frame.bytes length:frame.length error:&error],
+                 @"Frame must be decoded, but failed with: %@.", error);
+    STAssertEquals(self.decodedMessages.count, (NSUInteger)2, @"Each message must be emitted.");
+    STAssertEqualObjects(self.decodedMessages[0], (@{@"channel": @"/wanted", @"data": @{@"a": @[@1, @2.5]}}),
+                         @"Wanted payload must be decoded.");
+    STAssertEqualObjects(self.decodedMessages[1], (@{@"channel": @"/unwanted", @"id": @"1"}),
+                         @"Unwanted payload must be skipped.");
+    
+    STAssertFalse([decoder decodePackedBytes:frame.bytes length:frame.length - 1 error:&error],
+                  @"Truncated frame must fail.");
+    STAssertEquals(error.code, (NSInteger)FYErrorMalformedMessagePackData, @"Must report malformed data.");
+}
+
+- (void)testMessagePackIsAgreedByHandshakeExtension {
+    FYClient *client = [[FYClient alloc] initWithURL:[NSURL URLWithString:@"ws://localhost/faye"]];
+    NSDictionary *handshake = [NSJSONSerialization JSONObjectWithData:[client.handshakeTemplate dataWithMessageId:@"1"]
+                                                              options:0 error:NULL];
+    STAssertNil(handshake[@"ext"], @"Must not offer encodings, if only JSON is allowed.");
+    
+    client.payloadEncodings = @[FYPayloadEncodings.MessagePack, FYPayloadEncodings.JSON];
+    handshake = [NSJSONSerialization JSONObjectWithData:[client.handshakeTemplate dataWithMessageId:@"1"]
+                                                options:0 error:NULL];
+    STAssertEqualObjects(handshake[@"ext"][@"payloadEncodings"], (@[@"msgpack", @"json"]),
+                         @"Must offer the encodings in order of preference.");
+    
+    // Responses of a stub server
+    FYMessage *(^response)(id) = ^FYMessage *(id payloadEncoding) {
+        NSMutableDictionary *userInfo = [@{ @"channel": @"/meta/handshake", @"successful": @YES } mutableCopy];
+        if (payloadEncoding) {
+            userInfo[@"ext"] = @{ @"payloadEncoding": payloadEncoding };
+        }
+        return [[FYMessage alloc] initWithUserInfo:userInfo];
+    };
+    client.connectionType = FYConnectionTypes.WebSocket;
+    STAssertEqualObjects([client agreedPayloadEncodingOfMessage:response(@"msgpack")], FYPayloadEncodings.MessagePack,
+                         @"Must use the encoding, which the server agreed to.");
+    STAssertEqualObjects([client agreedPayloadEncodingOfMessage:response(nil)], FYPayloadEncodings.JSON,
+                         @"Must keep JSON, if the server ignored the offer.");
+    STAssertEqualObjects([client agreedPayloadEncodingOfMessage:response(@"cbor")], FYPayloadEncodings.JSON,
+                         @"Must keep JSON, if the server answered with an encoding, which wasn't offered.");
+    STAssertEqualObjects([client agreedPayloadEncodingOfMessage:response(@[@"msgpack"])], FYPayloadEncodings.JSON,
+                         @"Must keep JSON on a malformed answer.");
+    
+    client.connectionType = FYConnectionTypes.LongPolling;
+    STAssertEqualObjects([client agreedPayloadEncodingOfMessage:response(@"msgpack")], FYPayloadEncodings.JSON,
+                         @"Must keep JSON on long-polling, which has no binary frames.");
+}
+
+- (void)testMessagePackAgainstLocalServer {
+    // Requires the payload encoding extension of the sample server
+    if (![self isLocalServerRunningForTest:_cmd]) {
+        return;
+    }
+    
+    FYClient *client = [[FYClient alloc] initWithURL:[NSURL URLWithString:@"ws://localhost:8000/faye"]];
+    client.connectionTypes = @[FYConnectionTypes.WebSocket];
+    client.payloadEncodings = @[FYPayloadEncodings.MessagePack, FYPayloadEncodings.JSON];
+    client.delegate = self;  // Publishes to /count, when subscribed
+    
+    __weak SocketClientTests *this = self;
+    [client connectOnSuccess:^(FYClient *client) {
+        [client subscribeChannel:@"/count" callback:^(NSDictionary *userInfo) {
+            if ([userInfo[@"sender"] isEqualToString:@"server"]) {
+                this.countedNumber = userInfo[@"number"];
+            }
+         }];
+     }];
+    
+    NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow:10];
+    while (!self.countedNumber && [timeout timeIntervalSinceNow] > 0) {
+        [NSRunLoop.currentRunLoop runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+    }
+    
+    STAssertEqualObjects(client.payloadEncoding, FYPayloadEncodings.MessagePack, @"Server must agree to MessagePack.");
+    STAssertEqualObjects(self.countedNumber, @2, @"Must receive the counted number.");
+    [client disconnect];
+}
+
+- (void)testTimerWheelFiresInOrderAndCancels {
+    // A tick of 1 ms needs cascades from the second level for delays above 64 ms
+    FYTimerWheel *wheel = [[FYTimerWheel alloc] initWithTickInterval:0.001];
+    dispatch_queue_t queue = dispatch_queue_create("SocketClientTests.timerQueue", NULL);
+    NSMutableArray *fired = [NSMutableArray new];
+    NSMutableArray *elapsedTimes = [NSMutableArray new];
+    dispatch_semaphore_t finished = dispatch_semaphore_create(0);
+    
+    // Fire times are only recorded on the queue and checked after all timers fired
+    NSTimeInterval startUptime = NSProcessInfo.processInfo.systemUptime;
+    for (NSNumber *delay in @[@0.2, @0.01, @0.1, @0.07]) {
+        [wheel scheduleTimerWithDelay:delay.doubleValue queue:queue block:^{
+            [fired addObject:delay];
+            [elapsedTimes addObject:@(NSProcessInfo.processInfo.systemUptime - startUptime)];
+            if (fired.count == 4) {
+                dispatch_semaphore_signal(finished);
+            }
+         }];
+    }
+    FYTimer *cancelledTimer = [wheel scheduleTimerWithDelay:0.05 queue:queue block:^{
+        [fired addObject:@0.05];
+     }];
+    STAssertEquals(wheel.count, (NSUInteger)5, @"Must count scheduled timers.");
+    
+    [cancelledTimer cancel];
+    STAssertTrue(cancelledTimer.isCancelled, @"Must be cancelled.");
+    STAssertEquals(wheel.count, (NSUInteger)4, @"Cancelled timer must be removed.");
+    
+    long timedOut = dispatch_semaphore_wait(finished, dispatch_time(DISPATCH_TIME_NOW, 5 * NSEC_PER_SEC));
+    STAssertEquals(timedOut, (long)0, @"All timers must fire within 5 seconds.");
+    
+    __block NSArray *firedDelays, *firedElapsedTimes;
+    dispatch_sync(queue, ^{
+        firedDelays = fired.copy;
+        firedElapsedTimes = elapsedTimes.copy;
+     });
+    STAssertEqualObjects(firedDelays, (@[@0.01, @0.07, @0.1, @0.2]), @"Must fire all timers in order of their delays.");
+    for (NSUInteger i=0; i<MIN(firedDelays.count, firedElapsedTimes.count); i++) {
+        STAssertTrue([firedElapsedTimes[i] doubleValue] >= [firedDelays[i] doubleValue],
+                     @"Timer with delay %@ must not fire before, but fired after %@.", firedDelays[i],
+                     firedElapsedTimes[i]);
+    }
+    STAssertEquals(wheel.count, (NSUInteger)0, @"Fired timers must be removed.");
+}
+
+- (void)testParseRFC3339Timestamps {
+    NSTimeInterval timestamp;
+    STAssertTrue(FYTimestampParseRFC3339String(@"2013-05-07T12:30:05Z", &timestamp), @"Must parse UTC timestamp.");
+    STAssertEquals(timestamp, 1367929805.0, @"Must parse UTC timestamp.");
+    
+    STAssertTrue(FYTimestampParseRFC3339String(@"2013-05-07T14:30:05.250+02:00", &timestamp), @"Must parse offset.");
+    STAssertEquals(timestamp, 1367929805.25, @"Must parse fractional seconds and offset.");
+    
+    STAssertTrue(FYTimestampParseRFC3339String(@"2013-05-07T12:30:05.25", &timestamp), @"Must parse Bayeux timestamp.");
+    STAssertEquals(timestamp, 1367929805.25, @"Timestamp without offset must be treated as UTC.");
+    
+    STAssertFalse(FYTimestampParseRFC3339String(@"2013-13-07T12:30:05Z", &timestamp), @"Must reject invalid month.");
+    STAssertFalse(FYTimestampParseRFC3339String(@"2013-05-07T12:30", &timestamp), @"Must reject missing seconds.");
+}
+
+- (void)testClockOffsetEstimatorPrefersShortestRoundTrip {
+    FYClockOffsetEstimator *estimator = [FYClockOffsetEstimator new];
+    [estimator addSampleWithRoundTripTime:0.1 sentTime:50 serverTime:NAN];
+    STAssertFalse(estimator.isOffsetEstimated, @"Offset must not be estimated without a server time.");
+    [estimator addSampleWithRoundTripTime:2.0 sentTime:100 serverTime:111];  // Held back response: offset 10
+    [estimator addSampleWithRoundTripTime:0.2 sentTime:200 serverTime:205.1];  // offset 5
+    [estimator addSampleWithRoundTripTime:0.1 sentTime:300 serverTime:NAN];    // No server time
+    
+    STAssertTrue(estimator.isOffsetEstimated, @"Offset must be estimated by stamped round trips.");
+    STAssertEqualsWithAccuracy(estimator.offset, 5.0, 1e-9, @"Offset of shortest stamped round trip must be used.");
+    STAssertEqualsWithAccuracy(estimator.latency, 0.05, 1e-9, @"Latency must be half of shortest round trip.");
+}
+
 @end